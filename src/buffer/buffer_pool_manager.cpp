@@ -3,11 +3,15 @@
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
 
-static const char EMPTY_PAGE_DATA[PAGE_SIZE] = {0};
-
 BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager)
     : pool_size_(pool_size), disk_manager_(disk_manager) {
   pages_ = new Page[pool_size_];
+  // 帧的大小跟随数据库文件的页大小
+  if (disk_manager_->GetPageSize() != PAGE_SIZE) {
+    for (size_t i = 0; i < pool_size_; i++) {
+      pages_[i].Resize(disk_manager_->GetPageSize());
+    }
+  }
   replacer_ = new LRUReplacer(pool_size_);
   for (size_t i = 0; i < pool_size_; i++) {
     free_list_.emplace_back(i);
@@ -33,8 +37,9 @@ Page *BufferPoolManager::FetchPage(page_id_t page_id) {
   // 2.     If R is dirty, write it back to the disk.
   // 3.     Delete R from the page table and insert P.
   // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
+  auto lock = LockPool();
   frame_id_t tmp;
-  if(page_id > MAX_VALID_PAGE_ID) return nullptr;
+  if(page_id > disk_manager_->GetMaxValidPageId()) return nullptr;
   if(page_id <= INVALID_PAGE_ID) return nullptr;
 
   // 查询page_table_，如果存在则直接返回
@@ -43,6 +48,7 @@ Page *BufferPoolManager::FetchPage(page_id_t page_id) {
     tmp = it->second;
     replacer_->Pin(tmp);
     pages_[tmp].pin_count_++;
+    fetch_hits_.fetch_add(1, memory_order_relaxed);
     return &pages_[tmp];
   }
   // 处理空闲列表
@@ -54,8 +60,10 @@ Page *BufferPoolManager::FetchPage(page_id_t page_id) {
     pages_[tmp].ResetMemory(); 
     pages_[tmp].page_id_ = page_id;
     pages_[tmp].pin_count_ = 1;
+    pages_[tmp].is_dirty_ = false;
   
-    disk_manager_->ReadPage(page_id, pages_[tmp].data_);
+    disk_manager_->ReadPage(page_id, pages_[tmp].GetData());
+    fetch_misses_.fetch_add(1, memory_order_relaxed);
     return &pages_[tmp];
   }
 
@@ -64,19 +72,17 @@ Page *BufferPoolManager::FetchPage(page_id_t page_id) {
     return nullptr;
   }
 
-  // 处理脏页写回
-  if (pages_[tmp].IsDirty()) {
-    disk_manager_->WritePage(pages_[tmp].GetPageId(), pages_[tmp].GetData());
-  }
+  // 处理脏页写回，并移除旧映射
+  EvictFrame(tmp);
 
   // 更新页表和页面元数据
-  page_table_.erase(pages_[tmp].page_id_); // 移除旧映射
   pages_[tmp].ResetMemory(); // 重置页面内容
   pages_[tmp].page_id_ = page_id;
   pages_[tmp].pin_count_ = 1;
   page_table_[page_id] = tmp;
 
-  disk_manager_->ReadPage(page_id, pages_[tmp].data_);
+  disk_manager_->ReadPage(page_id, pages_[tmp].GetData());
+  fetch_misses_.fetch_add(1, memory_order_relaxed);
   return &pages_[tmp];
 
   }
@@ -89,6 +95,7 @@ Page *BufferPoolManager::NewPage(page_id_t &page_id) {
   // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
   // 3.   Update P's metadata, zero out memory and add P to the page table.
   // 4.   Set the page ID output parameter. Return a pointer to P.
+  auto lock = LockPool();
   page_id = 0;
   frame_id_t tmp;
   //如果free_list_不为空，则从free_list_中获取一个空闲页
@@ -105,18 +112,16 @@ Page *BufferPoolManager::NewPage(page_id_t &page_id) {
   else{
     
     page_id = AllocatePage();
-    //如果替换页是脏页，则写回磁盘
-    if(pages_[tmp].IsDirty()){
-      disk_manager_->WritePage(pages_[tmp].GetPageId(),pages_[tmp].GetData());
-    }
-    //从page_table_中删除替换页
-    page_table_.erase(pages_[tmp].page_id_);
+    //如果替换页是脏页，则写回磁盘，并从page_table_中删除替换页
+    EvictFrame(tmp);
   }
   //更新元数据
   pages_[tmp].ResetMemory();
   pages_[tmp].page_id_ = page_id;
   pages_[tmp].pin_count_ = 1;
+  pages_[tmp].is_dirty_ = false;
   page_table_[page_id] = tmp;
+  new_pages_.fetch_add(1, memory_order_relaxed);
   return &pages_[tmp];
 }
 
@@ -129,6 +134,7 @@ bool BufferPoolManager::DeletePage(page_id_t page_id) {
   // 1.   If P does not exist, return true.
   // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
   // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
+  auto lock = LockPool();
   if(page_table_.find(page_id) == page_table_.end())
     return true;
   //从page_table_中获取页号
@@ -153,6 +159,7 @@ bool BufferPoolManager::DeletePage(page_id_t page_id) {
  * TODO: Student Implement
  */
 bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
+  auto lock = LockPool();
   //查询page_table_，如果不存在则返回false
   auto it = page_table_.find(page_id);
   if (it == page_table_.end()) {
@@ -178,21 +185,76 @@ bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
  * TODO: Student Implement
  */
 bool BufferPoolManager::FlushPage(page_id_t page_id) {
-  latch_.lock();//加锁
+  auto lock = LockPool();//加锁
   // 快速检查：页表中不存在则直接返回
   auto it = page_table_.find(page_id);
   if (it == page_table_.end()) {
-    latch_.unlock();
     return false;
   }
 
   // 获取帧ID并写入磁盘
   frame_id_t tmp = it->second;
-  disk_manager_->WritePage(page_id, pages_[tmp].data_);
-  latch_.unlock();
+  disk_manager_->WritePage(page_id, pages_[tmp].GetData());
+  pages_[tmp].is_dirty_ = false;
   return true;
   }
 
+BasicPageGuard BufferPoolManager::FetchPageBasic(page_id_t page_id) {
+  return BasicPageGuard(this, FetchPage(page_id));
+}
+
+ReadPageGuard BufferPoolManager::FetchPageRead(page_id_t page_id) {
+  return ReadPageGuard(this, FetchPage(page_id));
+}
+
+WritePageGuard BufferPoolManager::FetchPageWrite(page_id_t page_id) {
+  return WritePageGuard(this, FetchPage(page_id));
+}
+
+BasicPageGuard BufferPoolManager::NewPageGuarded(page_id_t &page_id) {
+  return BasicPageGuard(this, NewPage(page_id));
+}
+
+void BufferPoolManager::EvictFrame(frame_id_t frame_id) {
+  Page &victim = pages_[frame_id];
+  if (victim.IsDirty()) {
+    disk_manager_->WritePage(victim.GetPageId(), victim.GetData());
+    victim.is_dirty_ = false;
+    dirty_evictions_.fetch_add(1, memory_order_relaxed);
+  } else {
+    clean_evictions_.fetch_add(1, memory_order_relaxed);
+  }
+  page_table_.erase(victim.page_id_);
+}
+
+BufferPoolStats BufferPoolManager::GetStats() {
+  BufferPoolStats stats;
+  stats.pool_size_ = pool_size_;
+  stats.page_size_ = GetPageSize();
+  {
+    scoped_lock<recursive_mutex> lock(latch_);
+    stats.pages_cached_ = page_table_.size();
+  }
+  stats.fetch_hits_ = fetch_hits_.load(memory_order_relaxed);
+  stats.fetch_misses_ = fetch_misses_.load(memory_order_relaxed);
+  stats.new_pages_ = new_pages_.load(memory_order_relaxed);
+  stats.clean_evictions_ = clean_evictions_.load(memory_order_relaxed);
+  stats.dirty_evictions_ = dirty_evictions_.load(memory_order_relaxed);
+  stats.latch_wait_ns_ = latch_wait_ns_.load(memory_order_relaxed);
+  stats.disk_ = disk_manager_->GetIOStats();
+  return stats;
+}
+
+void BufferPoolManager::ResetStats() {
+  fetch_hits_.store(0, memory_order_relaxed);
+  fetch_misses_.store(0, memory_order_relaxed);
+  new_pages_.store(0, memory_order_relaxed);
+  clean_evictions_.store(0, memory_order_relaxed);
+  dirty_evictions_.store(0, memory_order_relaxed);
+  latch_wait_ns_.store(0, memory_order_relaxed);
+  disk_manager_->ResetIOStats();
+}
+
 page_id_t BufferPoolManager::AllocatePage() {
   int next_page_id = disk_manager_->AllocatePage();
   return next_page_id;
@@ -208,6 +270,7 @@ bool BufferPoolManager::IsPageFree(page_id_t page_id) {
 
 // Only used for debug
 bool BufferPoolManager::CheckAllUnpinned() {
+  scoped_lock<recursive_mutex> lock(latch_);
   bool res = true;
   for (size_t i = 0; i < pool_size_; i++) {
     if (pages_[i].pin_count_ != 0) {
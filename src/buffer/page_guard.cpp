@@ -0,0 +1,104 @@
+#include "buffer/page_guard.h"
+
+#include <chrono>
+#include <utility>
+
+#include "buffer/buffer_pool_manager.h"
+
+BasicPageGuard::BasicPageGuard(BasicPageGuard &&that) noexcept
+    : bpm_(that.bpm_), page_(that.page_), is_dirty_(that.is_dirty_) {
+  that.bpm_ = nullptr;
+  that.page_ = nullptr;
+  that.is_dirty_ = false;
+}
+
+BasicPageGuard &BasicPageGuard::operator=(BasicPageGuard &&that) noexcept {
+  if (this != &that) {
+    Drop();
+    bpm_ = that.bpm_;
+    page_ = that.page_;
+    is_dirty_ = that.is_dirty_;
+    that.bpm_ = nullptr;
+    that.page_ = nullptr;
+    that.is_dirty_ = false;
+  }
+  return *this;
+}
+
+void BasicPageGuard::Drop() {
+  if (page_ != nullptr && bpm_ != nullptr) {
+    bpm_->UnpinPage(page_->GetPageId(), is_dirty_);
+  }
+  bpm_ = nullptr;
+  page_ = nullptr;
+  is_dirty_ = false;
+}
+
+ReadPageGuard BasicPageGuard::UpgradeRead() {
+  ReadPageGuard guard(bpm_, page_);
+  guard.guard_.is_dirty_ = is_dirty_;
+  bpm_ = nullptr;
+  page_ = nullptr;
+  is_dirty_ = false;
+  return guard;
+}
+
+WritePageGuard BasicPageGuard::UpgradeWrite() {
+  WritePageGuard guard(bpm_, page_);
+  guard.guard_.is_dirty_ = is_dirty_;
+  bpm_ = nullptr;
+  page_ = nullptr;
+  is_dirty_ = false;
+  return guard;
+}
+
+ReadPageGuard::ReadPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {
+  // 没有竞争时直接拿到，只有要等待时才计时
+  if (page != nullptr && !page->TryRLatch()) {
+    auto wait_start = std::chrono::steady_clock::now();
+    page->RLatch();
+    if (bpm != nullptr) {
+      bpm->RecordLatchWait(wait_start);
+    }
+  }
+}
+
+ReadPageGuard &ReadPageGuard::operator=(ReadPageGuard &&that) noexcept {
+  if (this != &that) {
+    Drop();
+    guard_ = std::move(that.guard_);
+  }
+  return *this;
+}
+
+void ReadPageGuard::Drop() {
+  if (guard_.page_ != nullptr) {
+    guard_.page_->RUnlatch();
+  }
+  guard_.Drop();
+}
+
+WritePageGuard::WritePageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {
+  if (page != nullptr && !page->TryWLatch()) {
+    auto wait_start = std::chrono::steady_clock::now();
+    page->WLatch();
+    if (bpm != nullptr) {
+      bpm->RecordLatchWait(wait_start);
+    }
+  }
+}
+
+WritePageGuard &WritePageGuard::operator=(WritePageGuard &&that) noexcept {
+  if (this != &that) {
+    Drop();
+    guard_ = std::move(that.guard_);
+  }
+  return *this;
+}
+
+void WritePageGuard::Drop() {
+  if (guard_.page_ != nullptr) {
+    guard_.page_->WUnlatch();
+  }
+  guard_.Drop();
+}
@@ -1,5 +1,7 @@
 #include "catalog/catalog.h"
 
+#include <algorithm>
+
 void CatalogMeta::SerializeTo(char *buf) const {
   ASSERT(GetSerializedSize() <= PAGE_SIZE, "Failed to serialize catalog metadata to disk.");
   MACH_WRITE_UINT32(buf, CATALOG_METADATA_MAGIC_NUM);
@@ -175,7 +177,8 @@ dberr_t CatalogManager::GetTables(vector<TableInfo *> &tables) const {
  */
 dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string &index_name,
                                     const std::vector<std::string> &index_keys, Txn *txn, IndexInfo *&index_info,
-                                    const string &index_type) {
+                                    const string &index_type, bool unique, const std::vector<std::string> &include_keys,
+                                    const IndexBuildOptions &options) {
   TableInfo *table_info;
   if (GetTable(table_name, table_info) != DB_SUCCESS) {
     return DB_TABLE_NOT_EXIST;
@@ -185,6 +188,21 @@ dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string
     return DB_INDEX_ALREADY_EXIST;
   }
 
+  if (!IndexMetadata::IsSupportedType(index_type)) {
+    LOG(ERROR) << "Unsupported index type '" << index_type << "'.";
+    return DB_FAILED;
+  }
+  // B-link 树只支持唯一键
+  if (!unique && index_type == "blink") {
+    LOG(ERROR) << "blink indexes require UNIQUE, use CREATE UNIQUE INDEX ... USING blink.";
+    return DB_FAILED;
+  }
+  // 只有 B+ 树的叶子能存 INCLUDE 列，而且一个键只存一份，必须是唯一索引
+  if (!include_keys.empty() && (index_type != "bptree" || !unique)) {
+    LOG(ERROR) << "INCLUDE columns require a UNIQUE bptree index.";
+    return DB_FAILED;
+  }
+
   auto schema = table_info->GetSchema();
   std::vector<uint32_t> key_map;
 
@@ -195,6 +213,18 @@ dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string
     }
     key_map.push_back(column_index);
   }
+  std::vector<uint32_t> include_map;
+  for (const auto &key : include_keys) {
+    uint32_t column_index;
+    if (schema->GetColumnIndex(key, column_index) != DB_SUCCESS) {
+      return DB_COLUMN_NAME_NOT_EXIST;
+    }
+    // 已经在键中的列不用再存一次
+    if (std::find(key_map.begin(), key_map.end(), column_index) == key_map.end() &&
+        std::find(include_map.begin(), include_map.end(), column_index) == include_map.end()) {
+      include_map.push_back(column_index);
+    }
+  }
 
   page_id_t meta_page_id;
   Page *meta_page = buffer_pool_manager_->NewPage(meta_page_id);
@@ -204,7 +234,8 @@ dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string
 
   index_id_t index_id = next_index_id_++;
 
-  IndexMetadata *index_meta = IndexMetadata::Create(index_id, index_name, table_info->GetTableId(), key_map);
+  IndexMetadata *index_meta = IndexMetadata::Create(index_id, index_name, table_info->GetTableId(), key_map, index_type,
+                                                     unique, include_map);
 
   index_meta->SerializeTo(meta_page->GetData());
   buffer_pool_manager_->UnpinPage(meta_page_id, true);
@@ -220,15 +251,17 @@ dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string
   index_names_[table_name][index_name] = index_id;
   indexes_[index_id] = index_info;
 
-  // TableIterator iter = table_info->GetTableHeap()->Begin(txn);
-  // while (iter != table_info->GetTableHeap()->End()) {
-  //   const Row &row = *iter;
-  //   index_info->GetIndex()->InsertEntry(row, row.GetRowId(), txn);
-  //   ++iter;
-  // }
-
   FlushCatalogMetaPage();
 
+  // 用表中已有的行建立索引，失败时（如有重复的键）删除建了一半的索引
+  if (index_info->GetIndex() == nullptr ||
+      index_info->GetIndex()->Build(table_info->GetTableHeap(), index_info->GetEntryMapping(), options, txn) !=
+          DB_SUCCESS) {
+    DropIndex(table_name, index_name);
+    index_info = nullptr;
+    return DB_FAILED;
+  }
+
   return DB_SUCCESS;
 }
 
@@ -315,7 +348,7 @@ dberr_t CatalogManager::DropIndex(const string &table_name, const string &index_
   index_id_t index_id = index_names_.at(table_name).at(index_name);
   IndexInfo *index_info = indexes_.at(index_id);
 
-  if (index_info->GetIndex()->Destroy() != DB_SUCCESS) {
+  if (index_info->GetIndex() != nullptr && index_info->GetIndex()->Destroy() != DB_SUCCESS) {
     return DB_FAILED;
   }
 
@@ -405,6 +438,10 @@ dberr_t CatalogManager::LoadIndex(const index_id_t index_id, const page_id_t pag
 
   IndexInfo *index_info = IndexInfo::Create();
   index_info->Init(index_meta, table_info, buffer_pool_manager_);
+  // bloom 索引只存在内存中，打开数据库时按表中的行重建
+  if (index_meta->GetIndexType() == "bloom") {
+    static_cast<BloomFilterIndex *>(index_info->GetIndex())->Rebuild();
+  }
 
   std::string table_name = "";
   for (auto &entry : table_names_) {
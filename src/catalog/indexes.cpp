@@ -1,12 +1,20 @@
 #include "catalog/indexes.h"
 
 IndexMetadata::IndexMetadata(const index_id_t index_id, const std::string &index_name, const table_id_t table_id,
-                             const std::vector<uint32_t> &key_map)
-    : index_id_(index_id), index_name_(index_name), table_id_(table_id), key_map_(key_map) {}
+                             const std::vector<uint32_t> &key_map, const std::string &index_type, bool unique,
+                             const std::vector<uint32_t> &include_map)
+    : index_id_(index_id),
+      index_name_(index_name),
+      table_id_(table_id),
+      key_map_(key_map),
+      index_type_(index_type),
+      unique_(unique),
+      include_map_(include_map) {}
 
 IndexMetadata *IndexMetadata::Create(const index_id_t index_id, const string &index_name, const table_id_t table_id,
-                                     const vector<uint32_t> &key_map) {
-  return new IndexMetadata(index_id, index_name, table_id, key_map);
+                                     const vector<uint32_t> &key_map, const std::string &index_type, bool unique,
+                                     const vector<uint32_t> &include_map) {
+  return new IndexMetadata(index_id, index_name, table_id, key_map, index_type, unique, include_map);
 }
 
 uint32_t IndexMetadata::SerializeTo(char *buf) const {
@@ -14,7 +22,7 @@ uint32_t IndexMetadata::SerializeTo(char *buf) const {
   uint32_t ofs = GetSerializedSize();
   ASSERT(ofs <= PAGE_SIZE, "Failed to serialize index info.");
   // magic num
-  MACH_WRITE_UINT32(buf, INDEX_METADATA_MAGIC_NUM);
+  MACH_WRITE_UINT32(buf, INDEX_METADATA_INCLUDE_MAGIC_NUM);
   buf += 4;
   // index id
   MACH_WRITE_TO(index_id_t, buf, index_id_);
@@ -35,6 +43,21 @@ uint32_t IndexMetadata::SerializeTo(char *buf) const {
     MACH_WRITE_UINT32(buf, col_index);
     buf += 4;
   }
+  // index type
+  MACH_WRITE_UINT32(buf, index_type_.length());
+  buf += 4;
+  MACH_WRITE_STRING(buf, index_type_);
+  buf += index_type_.length();
+  // unique
+  MACH_WRITE_UINT32(buf, unique_ ? 1 : 0);
+  buf += 4;
+  // included columns
+  MACH_WRITE_UINT32(buf, include_map_.size());
+  buf += 4;
+  for (auto &col_index : include_map_) {
+    MACH_WRITE_UINT32(buf, col_index);
+    buf += 4;
+  }
   ASSERT(buf - p == ofs, "Unexpected serialize size.");
   return ofs;
 }
@@ -43,7 +66,8 @@ uint32_t IndexMetadata::SerializeTo(char *buf) const {
  * TODO: Student Implement
  */
 uint32_t IndexMetadata::GetSerializedSize() const {
-  return 4 + 4 + MACH_STR_SERIALIZED_SIZE(index_name_) + 4 + 4 + key_map_.size() * 4;
+  return 4 + 4 + MACH_STR_SERIALIZED_SIZE(index_name_) + 4 + 4 + key_map_.size() * 4 +
+         MACH_STR_SERIALIZED_SIZE(index_type_) + 4 + 4 + include_map_.size() * 4;
 }
 
 uint32_t IndexMetadata::DeserializeFrom(char *buf, IndexMetadata *&index_meta) {
@@ -54,7 +78,9 @@ uint32_t IndexMetadata::DeserializeFrom(char *buf, IndexMetadata *&index_meta) {
   // magic num
   uint32_t magic_num = MACH_READ_UINT32(buf);
   buf += 4;
-  ASSERT(magic_num == INDEX_METADATA_MAGIC_NUM, "Failed to deserialize index info.");
+  ASSERT(magic_num == INDEX_METADATA_MAGIC_NUM || magic_num == INDEX_METADATA_TYPED_MAGIC_NUM ||
+             magic_num == INDEX_METADATA_UNIQUE_MAGIC_NUM || magic_num == INDEX_METADATA_INCLUDE_MAGIC_NUM,
+         "Failed to deserialize index info.");
   // index id
   index_id_t index_id = MACH_READ_FROM(index_id_t, buf);
   buf += 4;
@@ -76,25 +102,43 @@ uint32_t IndexMetadata::DeserializeFrom(char *buf, IndexMetadata *&index_meta) {
     buf += 4;
     key_map.push_back(key_index);
   }
+  // index type
+  std::string index_type = "bptree";
+  if (magic_num != INDEX_METADATA_MAGIC_NUM) {
+    uint32_t type_len = MACH_READ_UINT32(buf);
+    buf += 4;
+    index_type = std::string(buf, type_len);
+    buf += type_len;
+  }
+  // unique
+  bool unique = true;
+  if (magic_num == INDEX_METADATA_UNIQUE_MAGIC_NUM || magic_num == INDEX_METADATA_INCLUDE_MAGIC_NUM) {
+    unique = MACH_READ_UINT32(buf) != 0;
+    buf += 4;
+  }
+  // included columns
+  std::vector<uint32_t> include_map;
+  if (magic_num == INDEX_METADATA_INCLUDE_MAGIC_NUM) {
+    uint32_t include_count = MACH_READ_UINT32(buf);
+    buf += 4;
+    for (uint32_t i = 0; i < include_count; i++) {
+      include_map.push_back(MACH_READ_UINT32(buf));
+      buf += 4;
+    }
+  }
   // allocate space for index meta data
-  index_meta = new IndexMetadata(index_id, index_name, table_id, key_map);
+  index_meta = new IndexMetadata(index_id, index_name, table_id, key_map, index_type, unique, include_map);
   return buf - p;
 }
 
-Index *IndexInfo::CreateIndex(BufferPoolManager *buffer_pool_manager, const string &index_type) {
-  size_t max_size = 0;
-  uint32_t column_cnt = key_schema_->GetColumns().size();
-  size_t size_bitmap = (column_cnt % 8) ? column_cnt / 8 + 1 : column_cnt / 8;
-  // column_cnt + bitmap
-  max_size += 4 + sizeof(unsigned char) * size_bitmap;
-  for (auto col : key_schema_->GetColumns()) {
-    // length of char column
-    if(col->GetType() == TypeId::kTypeChar)
-      max_size += 4;
-    max_size += col->GetLength();
+Index *IndexInfo::CreateIndex(BufferPoolManager *buffer_pool_manager, const string &index_type, TableInfo *table_info) {
+  if (index_type == "bloom") {
+    return new BloomFilterIndex(meta_data_->index_id_, key_schema_, table_info->GetSchema(), table_info->GetTableHeap());
   }
+  // 叶子中的键要放得下 INCLUDE 列
+  size_t max_size = KeyManager::GetNormalizedKeySize(entry_schema_);
 
-  if (index_type == "bptree") {
+  if (index_type == "bptree" || index_type == "blink") {
     if (max_size <= 8)
       max_size = 16;
     else if (max_size <= 24)
@@ -105,6 +149,9 @@ Index *IndexInfo::CreateIndex(BufferPoolManager *buffer_pool_manager, const stri
       max_size = 128;
     else if (max_size <= 248)
       max_size = 256;
+    // B+ 树的页面只存键实际用到的字节，更长的键也放得下；B-link 树的页面按完整的键长存放
+    else if (max_size <= 504 && index_type == "bptree")
+      max_size = 512;
     else {
       LOG(ERROR) << "GenericKey size is too large";
       return nullptr;
@@ -112,5 +159,9 @@ Index *IndexInfo::CreateIndex(BufferPoolManager *buffer_pool_manager, const stri
   } else {
     return nullptr;
   }
-  return new BPlusTreeIndex(meta_data_->index_id_, key_schema_, max_size, buffer_pool_manager);
+  if (index_type == "blink") {
+    return new BLinkTreeIndex(meta_data_->index_id_, key_schema_, max_size, buffer_pool_manager);
+  }
+  return new BPlusTreeIndex(meta_data_->index_id_, key_schema_, max_size, buffer_pool_manager, meta_data_->unique_,
+                            entry_schema_);
 }
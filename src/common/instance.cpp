@@ -3,7 +3,9 @@
 //
 #include "common/instance.h"
 
-DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size)
+#include <algorithm>
+
+DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size, uint32_t page_size)
     : db_file_name_(std::move(db_name)), init_(init) {
   // Init database file if needed
   db_file_name_ = "./databases/" + db_file_name_;
@@ -11,8 +13,9 @@ DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer
     remove(db_file_name_.c_str());
   }
   // Initialize components
-  disk_mgr_ = new DiskManager(db_file_name_);
-  bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_);
+  disk_mgr_ = new DiskManager(db_file_name_, page_size);
+  size_t frames = std::max<size_t>(1, static_cast<size_t>(buffer_pool_size) * PAGE_SIZE / disk_mgr_->GetPageSize());
+  bpm_ = new BufferPoolManager(frames, disk_mgr_);
 
   // Allocate static page for db storage engine
   if (init) {
@@ -16,13 +16,16 @@ void DeleteExecutor::Init() {
 }
 
 bool DeleteExecutor::Next([[maybe_unused]] Row *row, RowId *rid) {
-  if (child_executor_->Next(row, rid)) {
+  // 删除的行不会留到查询结束，处理完就把它在 arena 中的内存还回去
+  MemoryArena::Scope scope(exec_ctx_->GetArena());
+  Row src_row;
+  if (child_executor_->Next(&src_row, rid)) {
     if (!table_info_->GetTableHeap()->MarkDelete(*rid, txn_)) {
       return false;
     }
     Row key_row;
     for (auto info : index_info_) {  // 更新索引
-      row->GetKeyFromRow(table_info_->GetSchema(), info->GetIndexKeySchema(), key_row);
+      src_row.GetKeyFromRow(table_info_->GetSchema(), info->GetIndexEntrySchema(), key_row);
       info->GetIndex()->RemoveEntry(key_row, *rid, txn_);
     }
     return true;
@@ -4,7 +4,11 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
+#include <iomanip>
+#include <sstream>
 
 #include "common/result_writer.h"
 #include "executor/executors/delete_executor.h"
@@ -93,7 +97,7 @@ dberr_t ExecuteEngine::ExecutePlan(const AbstractPlanNodeRef &plan, std::vector<
     Row row{};
     while (executor->Next(&row, &rid)) {
       if (result_set != nullptr) {
-        result_set->push_back(row);
+        result_set->push_back(std::move(row));
       }
     }
   } catch (const exception &ex) {
@@ -112,7 +116,10 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast) {
   }
   auto start_time = std::chrono::system_clock::now();
   unique_ptr<ExecuteContext> context(nullptr);
-  if (!current_db_.empty()) context = dbs_[current_db_]->MakeExecuteContext(nullptr);
+  if (!current_db_.empty()) {
+    context = dbs_[current_db_]->MakeExecuteContext(nullptr);
+    context->SetSettings(settings_);
+  }
   switch (ast->type_) {
     case kNodeCreateDB:
       return ExecuteCreateDatabase(ast, context.get());
@@ -140,6 +147,10 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast) {
       return ExecuteTrxCommit(ast, context.get());
     case kNodeTrxRollback:
       return ExecuteTrxRollback(ast, context.get());
+    case kNodeShowBufferStatus:
+      return ExecuteShowBufferStatus(ast, context.get());
+    case kNodeSetVariable:
+      return ExecuteSetVariable(ast, context.get());
     case kNodeExecFile:
       return ExecuteExecfile(ast, context.get());
     case kNodeQuit:
@@ -254,7 +265,18 @@ dberr_t ExecuteEngine::ExecuteCreateDatabase(pSyntaxNode ast, ExecuteContext *co
   if (dbs_.find(db_name) != dbs_.end()) {
     return DB_ALREADY_EXIST;
   }
-  dbs_.insert(make_pair(db_name, new DBStorageEngine(db_name, true)));
+  // create database <name> page_size <n>，页大小写入数据库文件，之后打开时不需要再指定
+  uint32_t page_size = PAGE_SIZE;
+  if (ast->child_->next_ != nullptr) {
+    char *end = nullptr;
+    unsigned long value = strtoul(ast->child_->next_->val_, &end, 10);
+    if (*end != '\0' || value > MAX_PAGE_SIZE || !IsValidPageSize(value)) {
+      cout << "Page size must be a power of two between " << PAGE_SIZE << " and " << MAX_PAGE_SIZE << "." << endl;
+      return DB_FAILED;
+    }
+    page_size = static_cast<uint32_t>(value);
+  }
+  dbs_.insert(make_pair(db_name, new DBStorageEngine(db_name, true, DEFAULT_BUFFER_POOL_SIZE, page_size)));
   return DB_SUCCESS;
 }
 
@@ -426,11 +448,13 @@ dberr_t ExecuteEngine::ExecuteCreateTable(pSyntaxNode ast, ExecuteContext *conte
         unique_keys.push_back(column_name);
       }
 
+      // 主键列隐含 NOT NULL，全部列非空的表可以用更快的行编码
+      bool nullable = find(primary_keys.begin(), primary_keys.end(), column_name) == primary_keys.end();
       Column *column;
       if (type_id == TypeId::kTypeChar) {
-        column = new Column(column_name, type_id, length, column_index, true, unique);
+        column = new Column(column_name, type_id, length, column_index, nullable, unique);
       } else {
-        column = new Column(column_name, type_id, column_index, true, unique);
+        column = new Column(column_name, type_id, column_index, nullable, unique);
       }
       columns.push_back(column);
       column_index++;
@@ -549,6 +573,15 @@ dberr_t ExecuteEngine::ExecuteShowIndexes(pSyntaxNode ast, ExecuteContext *conte
         uint32_t table_col_idx = index_key_schema->GetColumn(i)->GetTableInd();
         column_names += table_schema->GetColumn(table_col_idx)->GetName();
       }
+      // 例如 "id include (name, age)"
+      auto index_entry_schema = index->GetIndexEntrySchema();
+      for (uint32_t i = index_key_schema->GetColumnCount(); i < index_entry_schema->GetColumnCount(); i++) {
+        column_names += i == index_key_schema->GetColumnCount() ? " include (" : ", ";
+        column_names += table_schema->GetColumn(index_entry_schema->GetColumn(i)->GetTableInd())->GetName();
+        if (i + 1 == index_entry_schema->GetColumnCount()) {
+          column_names += ")";
+        }
+      }
 
       if (column_names.length() > column_width) {
         column_width = column_names.length();
@@ -622,9 +655,17 @@ dberr_t ExecuteEngine::ExecuteCreateIndex(pSyntaxNode ast, ExecuteContext *conte
   }
 
   string index_type = "bptree";
-  pSyntaxNode type_node = ast->child_->next_->next_->next_;
-  if (type_node != nullptr && type_node->type_ == kNodeIndexType) {
-    index_type = type_node->val_;
+  vector<string> include_keys;
+  for (pSyntaxNode option = ast->child_->next_->next_->next_; option != nullptr; option = option->next_) {
+    if (option->type_ == kNodeIndexType && option->child_ != nullptr) {
+      // "using xxx" 的类型名挂在 kNodeIndexType 的孩子上
+      index_type = option->child_->val_;
+    } else if (option->type_ == kNodeColumnList) {
+      // "include (a, b)"
+      for (pSyntaxNode column = option->child_; column != nullptr; column = column->next_) {
+        include_keys.push_back(column->val_);
+      }
+    }
   }
 
   vector<string> index_keys;
@@ -641,11 +682,39 @@ dberr_t ExecuteEngine::ExecuteCreateIndex(pSyntaxNode ast, ExecuteContext *conte
       return DB_COLUMN_NAME_NOT_EXIST;
     }
   }
+  for (const auto &key : include_keys) {
+    uint32_t column_index;
+    if (schema->GetColumnIndex(key, column_index) != DB_SUCCESS) {
+      return DB_COLUMN_NAME_NOT_EXIST;
+    }
+  }
+
+  // CREATE UNIQUE INDEX 不允许重复的键；没有 UNIQUE 的 B-link 树由 CreateIndex 拒绝
+  bool unique = ast->val_ != nullptr && string(ast->val_) == "unique";
 
+  IndexBuildOptions options;
+  options.fill_factor_ = context->GetSettings().index_fill_factor_;
+  options.threads_ = context->GetSettings().index_build_threads_;
+  IndexBuildStats stats;
+  options.stats_ = &stats;
   IndexInfo *index_info = nullptr;
-  dberr_t result = dbs_[current_db_]->catalog_mgr_->CreateIndex(table_name, index_name, index_keys, nullptr, index_info, index_type);
+  dberr_t result = dbs_[current_db_]->catalog_mgr_->CreateIndex(table_name, index_name, index_keys, nullptr, index_info,
+                                                                index_type, unique, include_keys, options);
   if (result == DB_SUCCESS) {
     cout << "Index '" << index_name << "' created on table '" << table_name << "'." << endl;
+    if (!stats.phases_.empty()) {
+      // 各阶段耗时，例如 "1000 entries, 2 threads: scan 0.90 ms, sort 0.30 ms, merge 0.10 ms, load 0.25 ms"
+      std::stringstream ss;
+      ss << stats.entries_ << " entries, " << stats.threads_ << (stats.threads_ == 1 ? " thread" : " threads");
+      if (stats.spilled_runs_ > 0) {
+        ss << ", " << stats.spilled_runs_ << " runs spilled";
+      }
+      ss << std::fixed << std::setprecision(2);
+      for (size_t i = 0; i < stats.phases_.size(); i++) {
+        ss << (i == 0 ? ": " : ", ") << stats.phases_[i].first << " " << stats.phases_[i].second << " ms";
+      }
+      cout << ss.str() << endl;
+    }
   } else if (result == DB_INDEX_ALREADY_EXIST) {
     return DB_INDEX_ALREADY_EXIST;
   } else {
@@ -715,6 +784,99 @@ dberr_t ExecuteEngine::ExecuteTrxRollback(pSyntaxNode ast, ExecuteContext *conte
   return DB_FAILED;
 }
 
+dberr_t ExecuteEngine::ExecuteShowBufferStatus([[maybe_unused]] pSyntaxNode ast,
+                                               [[maybe_unused]] ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteShowBufferStatus" << std::endl;
+#endif
+  if (current_db_.empty()) {
+    cout << "No database selected" << endl;
+    return DB_FAILED;
+  }
+  BufferPoolStats stats = dbs_[current_db_]->bpm_->GetStats();
+  std::stringstream ratio;
+  ratio << fixed << setprecision(4) << stats.HitRatio();
+  // 计时统计以纳秒累计，这里换算成毫秒输出
+  auto ns_to_ms = [](uint64_t ns) {
+    std::stringstream ss;
+    ss << fixed << setprecision(3) << static_cast<double>(ns) / 1e6 << " ms";
+    return ss.str();
+  };
+  vector<std::pair<string, string>> rows = {
+      {"pool_size", std::to_string(stats.pool_size_)},
+      {"page_size", std::to_string(stats.page_size_)},
+      {"pages_cached", std::to_string(stats.pages_cached_)},
+      {"fetch_hits", std::to_string(stats.fetch_hits_)},
+      {"fetch_misses", std::to_string(stats.fetch_misses_)},
+      {"hit_ratio", ratio.str()},
+      {"new_pages", std::to_string(stats.new_pages_)},
+      {"clean_evictions", std::to_string(stats.clean_evictions_)},
+      {"dirty_evictions", std::to_string(stats.dirty_evictions_)},
+      {"pages_read", std::to_string(stats.disk_.pages_read_)},
+      {"pages_written", std::to_string(stats.disk_.pages_written_)},
+      {"bytes_read", std::to_string(stats.disk_.bytes_read_)},
+      {"bytes_written", std::to_string(stats.disk_.bytes_written_)},
+      {"latch_wait", ns_to_ms(stats.latch_wait_ns_)},
+      {"io_wait", ns_to_ms(stats.disk_.io_wait_ns_)},
+  };
+  string metric_header = "Metric", value_header = "Value";
+  size_t metric_width = metric_header.length(), value_width = value_header.length();
+  for (const auto &row : rows) {
+    metric_width = std::max(metric_width, row.first.length());
+    value_width = std::max(value_width, row.second.length());
+  }
+  metric_width += 2;
+  value_width += 2;
+
+  cout << "+" << setfill('-') << setw(metric_width) << "" << "+" << setw(value_width) << "" << "+" << endl;
+  cout << "|" << setfill(' ') << setw(metric_width) << std::left << " " + metric_header << "|"
+       << setw(value_width) << std::left << " " + value_header << "|" << endl;
+  cout << "+" << setfill('-') << setw(metric_width) << "" << "+" << setw(value_width) << "" << "+" << endl;
+  for (const auto &row : rows) {
+    cout << "|" << setfill(' ') << setw(metric_width) << std::left << " " + row.first << "|"
+         << setw(value_width) << std::left << " " + row.second << "|" << endl;
+  }
+  cout << "+" << setfill('-') << setw(metric_width) << "" << "+" << setw(value_width) << "" << "+" << endl;
+  cout << rows.size() << " rows in set (0.00 sec)" << endl;
+  return DB_SUCCESS;
+}
+
+dberr_t ExecuteEngine::ExecuteSetVariable(pSyntaxNode ast, [[maybe_unused]] ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteSetVariable" << std::endl;
+#endif
+  // 整数设置及其取值范围
+  struct IntegerSetting {
+    uint32_t SessionSettings::*member_;
+    uint32_t min_;
+    uint32_t max_;
+  };
+  static const std::unordered_map<std::string, IntegerSetting> integer_settings = {
+      {"scan_threads", {&SessionSettings::scan_threads_, 1, SessionSettings::MAX_THREADS}},
+      {"index_fill_factor", {&SessionSettings::index_fill_factor_, 10, 100}},
+      {"index_build_threads", {&SessionSettings::index_build_threads_, 1, SessionSettings::MAX_THREADS}}};
+  string name = ast->child_->val_;
+  auto it = integer_settings.find(name);
+  if (it == integer_settings.end()) {
+    cout << "Unknown variable '" << name << "'." << endl;
+    return DB_FAILED;
+  }
+  const IntegerSetting &setting = it->second;
+  // 超出 long 范围的值 strtol 会置 errno，不能让它溢出后落进取值范围
+  char *end = nullptr;
+  errno = 0;
+  long value = strtol(ast->child_->next_->val_, &end, 10);
+  if (errno == ERANGE || *end != '\0' || value < static_cast<long>(setting.min_) ||
+      value > static_cast<long>(setting.max_)) {
+    cout << "Value of '" << name << "' must be an integer between " << setting.min_ << " and " << setting.max_ << "."
+         << endl;
+    return DB_FAILED;
+  }
+  settings_.*(setting.member_) = static_cast<uint32_t>(value);
+  cout << "Variable '" << name << "' set to " << settings_.*(setting.member_) << "." << endl;
+  return DB_SUCCESS;
+}
+
 /**
  * TODO: Student Implement
  */
@@ -1,19 +1,140 @@
 #include "executor/executors/index_scan_executor.h"
-#include <planner/expressions/logic_expression.h>
-
-class RowidCompare {
- public:
-  bool operator()(RowId rid1, RowId rid2) { return rid1.Get() < rid2.Get(); }
-};
 
 IndexScanExecutor::IndexScanExecutor(ExecuteContext *exec_ctx, const IndexScanPlanNode *plan)
     : AbstractExecutor(exec_ctx), plan_(plan) {}
 
 void IndexScanExecutor::Init() {
   exec_ctx_->GetCatalog()->GetTable(plan_->GetTableName(), table_info_);
-  auto first_row = table_info_->GetTableHeap()->Begin(nullptr);
-  result_ = IndexScan(plan_->GetPredicate());
   is_schema_same_ = SchemaEqual(table_info_->GetSchema(), plan_->OutputSchema());
+  streaming_ = false;
+  range_ = IndexRangeIterator();
+  result_.clear();
+  cursor_ = 0;
+  covering_index_ = nullptr;
+  entry_pos_.clear();
+  duplicate_entries_.clear();
+
+  vector<std::shared_ptr<ComparisonExpression>> comparisons;
+  CollectComparisons(plan_->GetPredicate(), comparisons);
+  // 覆盖索引：行直接从叶子中的键和 INCLUDE 列解码出来，不读表
+  if (plan_->covering_index_ != nullptr) {
+    covering_index_ = dynamic_cast<BPlusTreeIndex *>(plan_->covering_index_->GetIndex());
+  }
+  if (covering_index_ != nullptr) {
+    const auto &entry_map = plan_->covering_index_->GetEntryMapping();
+    entry_pos_.assign(table_info_->GetSchema()->GetColumnCount(), -1);
+    for (size_t i = 0; i < entry_map.size(); i++) {
+      if (entry_pos_[entry_map[i]] < 0) {
+        entry_pos_[entry_map[i]] = static_cast<int>(i);
+      } else {
+        duplicate_entries_.push_back(i);
+      }
+    }
+    ScanRange(covering_index_, plan_->covering_index_->GetIndexKeySchema()->GetColumn(0)->GetTableInd(), comparisons);
+    return;
+  }
+  // 选驱动扫描的索引：等值条件优先，其次是范围条件；条件相同时优先可以流式扫描的 B+ 树索引
+  IndexInfo *driver = nullptr;
+  std::shared_ptr<ComparisonExpression> driver_comparison;
+  int best_rank = -1;
+  for (auto index : plan_->indexes_) {
+    uint32_t col_idx = index->GetIndexKeySchema()->GetColumn(0)->GetTableInd();
+    int rank = 0;
+    std::shared_ptr<ComparisonExpression> best_comparison;
+    for (const auto &comparison : comparisons) {
+      if (dynamic_pointer_cast<ColumnValueExpression>(comparison->GetChildAt(0))->GetColIdx() != col_idx) {
+        continue;
+      }
+      string type = comparison->GetComparisonType();
+      int comparison_rank = type == "=" ? 3 : (type == "<" || type == "<=" || type == ">" || type == ">=" ? 2 : 1);
+      if (comparison_rank > rank) {
+        rank = comparison_rank;
+        best_comparison = comparison;
+      }
+    }
+    rank = rank * 2 + (dynamic_cast<BPlusTreeIndex *>(index->GetIndex()) != nullptr ? 1 : 0);
+    if (best_comparison != nullptr && rank > best_rank) {
+      best_rank = rank;
+      driver = index;
+      driver_comparison = best_comparison;
+    }
+  }
+  if (driver == nullptr) {
+    return;
+  }
+  auto *tree_index = dynamic_cast<BPlusTreeIndex *>(driver->GetIndex());
+  if (tree_index != nullptr) {
+    ScanRange(tree_index, driver->GetIndexKeySchema()->GetColumn(0)->GetTableInd(), comparisons);
+  } else {
+    std::vector<Field> fields{driver_comparison->GetChildAt(1)->Evaluate(nullptr)};
+    Row key(fields);
+    driver->GetIndex()->ScanKey(key, result_, nullptr, driver_comparison->GetComparisonType());
+  }
+}
+
+void IndexScanExecutor::CollectComparisons(const AbstractExpressionRef &predicate,
+                                           vector<std::shared_ptr<ComparisonExpression>> &comparisons) {
+  if (predicate == nullptr) {
+    return;
+  }
+  if (predicate->GetType() == ExpressionType::LogicExpression) {
+    // 有 OR 时不会选择索引扫描
+    CollectComparisons(predicate->GetChildAt(0), comparisons);
+    CollectComparisons(predicate->GetChildAt(1), comparisons);
+  } else if (predicate->GetType() == ExpressionType::ComparisonExpression &&
+             predicate->GetChildAt(0)->GetType() == ExpressionType::ColumnExpression &&
+             predicate->GetChildAt(1)->GetType() == ExpressionType::ConstantExpression) {
+    comparisons.push_back(dynamic_pointer_cast<ComparisonExpression>(predicate));
+  }
+}
+
+void IndexScanExecutor::ScanRange(BPlusTreeIndex *index, uint32_t col_idx,
+                                  const vector<std::shared_ptr<ComparisonExpression>> &comparisons) {
+  std::unique_ptr<Field> lower, upper;
+  bool lower_inclusive = true, upper_inclusive = true;
+  // 多个条件取最紧的界
+  auto tighten_lower = [&](const Field &value, bool inclusive) {
+    if (lower == nullptr || value.CompareGreaterThan(*lower) == CmpBool::kTrue ||
+        (value.CompareEquals(*lower) == CmpBool::kTrue && !inclusive)) {
+      lower = std::make_unique<Field>(value);
+      lower_inclusive = inclusive;
+    }
+  };
+  auto tighten_upper = [&](const Field &value, bool inclusive) {
+    if (upper == nullptr || value.CompareLessThan(*upper) == CmpBool::kTrue ||
+        (value.CompareEquals(*upper) == CmpBool::kTrue && !inclusive)) {
+      upper = std::make_unique<Field>(value);
+      upper_inclusive = inclusive;
+    }
+  };
+  for (const auto &comparison : comparisons) {
+    if (dynamic_pointer_cast<ColumnValueExpression>(comparison->GetChildAt(0))->GetColIdx() != col_idx) {
+      continue;
+    }
+    Field value = comparison->GetChildAt(1)->Evaluate(nullptr);
+    if (value.IsNull()) {
+      continue;
+    }
+    string type = comparison->GetComparisonType();
+    if (type == "=" || type == ">" || type == ">=") {
+      tighten_lower(value, type != ">");
+    }
+    if (type == "=" || type == "<" || type == "<=") {
+      tighten_upper(value, type != "<");
+    }
+  }
+  // "<>" 等其它条件不缩小范围，在取出记录后检查
+  std::unique_ptr<Row> lower_row, upper_row;
+  if (lower != nullptr) {
+    std::vector<Field> fields{std::move(*lower)};
+    lower_row = std::make_unique<Row>(fields);
+  }
+  if (upper != nullptr) {
+    std::vector<Field> fields{std::move(*upper)};
+    upper_row = std::make_unique<Row>(fields);
+  }
+  range_ = index->ScanRange(lower_row.get(), lower_inclusive, upper_row.get(), upper_inclusive);
+  streaming_ = true;
 }
 
 bool IndexScanExecutor::SchemaEqual(const Schema *table_schema, const Schema *output_schema) {
@@ -35,81 +156,61 @@ bool IndexScanExecutor::SchemaEqual(const Schema *table_schema, const Schema *ou
 
 void IndexScanExecutor::TupleTransfer(const Schema *table_schema, const Schema *output_schema, const Row *row,
                                       Row *output_row) {
-  const auto &output_columns = output_schema->GetColumns();
-  std::vector<Field> dest_row;
-  dest_row.reserve(output_columns.size());
-  for (const auto column : output_columns) {
-    auto idx = column->GetTableInd();
-    dest_row.emplace_back(*row->GetField(idx));
-  }
-  *output_row = Row(dest_row);
+  output_row->Reset(exec_ctx_->GetArena());
+  for (const auto column : output_schema->GetColumns()) {
+    output_row->AppendField(Field(*row->GetField(column->GetTableInd())));
+  }
 }
 
-vector<RowId> IndexScanExecutor::IndexScan(AbstractExpressionRef predicate) {
-  switch (predicate->GetType()) {
-    case ExpressionType::LogicExpression: {
-      vector<RowId> lhs = IndexScan(predicate->GetChildAt(0));
-      vector<RowId> rhs = IndexScan(predicate->GetChildAt(1));
-      // The function cannot differentiate between the case where the number of rows that
-      // meet the criteria in the indexed column is zero and the case where the column is
-      // not indexed. Writing it this way will ignore the filtering effect brought about
-      // by having zero rows that meet the criteria in the indexed column.
-      if (plan_->need_filter_) {
-        if (lhs.empty()) return rhs;
-        if (rhs.empty()) return lhs;
-      }
-      sort(lhs.begin(), lhs.end(), RowidCompare());
-      sort(rhs.begin(), rhs.end(), RowidCompare());
-      vector<RowId> result;
-      auto logic_type = dynamic_pointer_cast<LogicExpression>(predicate)->logic_type_;
-      if (logic_type == LogicType::And) {
-        set_intersection(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), back_inserter(result), RowidCompare());
-      } else if (logic_type == LogicType::Or) {
-        set_union(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), back_inserter(result), RowidCompare());
-      } 
-      //set_intersection(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), back_inserter(result), RowidCompare());
-      return result;
-    }
-    case ExpressionType::ComparisonExpression: {
-      std::vector<RowId> ret;
-      std::vector<Field> fields{predicate->GetChildAt(1)->Evaluate(nullptr)};
-      Row key(fields);
-      for (auto index : plan_->indexes_) {
-        uint32_t col_idx = dynamic_pointer_cast<ColumnValueExpression>(predicate->GetChildAt(0))->GetColIdx();
-        if (col_idx == index->GetIndexKeySchema()->GetColumn(0)->GetTableInd()) {
-          index->GetIndex()->ScanKey(key, ret, nullptr,
-                                     dynamic_pointer_cast<ComparisonExpression>(predicate)->GetComparisonType());
-          break;
-        }
-      }
-      return ret;
+void IndexScanExecutor::DecodeEntry(Row *row) {
+  covering_index_->DecodeEntry(range_.GetKey(), *row);
+  // 解出的字段直接按表的列序重排，索引中没有的列查询用不到，填 null 占位
+  std::vector<Field *> entry;
+  entry.swap(row->GetFields());
+  auto table_schema = table_info_->GetSchema();
+  for (uint32_t i = 0; i < table_schema->GetColumnCount(); i++) {
+    if (entry_pos_[i] >= 0) {
+      row->GetFields().push_back(entry[entry_pos_[i]]);
+    } else {
+      row->AppendField(Field(table_schema->GetColumn(i)->GetType()));
     }
-    default:
-      break;
+  }
+  // 键中重复出现的列只用第一份，其余的字段在 arena 中，只析构
+  for (auto i : duplicate_entries_) {
+    entry[i]->~Field();
   }
 }
 
 bool IndexScanExecutor::Next(Row *row, RowId *rid) {
   auto predicate = plan_->GetPredicate();
   auto table_schema = table_info_->GetSchema();
-  while (cursor_ < result_.size()) {
-    auto p_row = new Row(result_[cursor_]);
-    table_info_->GetTableHeap()->GetTuple(p_row, nullptr);
-    if (plan_->need_filter_) {
-      if (!predicate->Evaluate(p_row).CompareEquals(Field(kTypeInt, 1))) {
-        cursor_++;
-        delete p_row;
-        continue;
-      }
+  RowId next_rid;
+  // 每次只从索引取一个行号，调用者不再取时扫描就停下
+  while (streaming_ ? range_.Next(next_rid) : cursor_ < result_.size()) {
+    if (!streaming_) {
+      next_rid = result_[cursor_++];
+    }
+    // 不满足谓词的行不会交出去，它在 arena 中的内存马上还回去
+    auto position = exec_ctx_->GetArena()->Mark();
+    Row stored(next_rid);
+    stored.Reset(exec_ctx_->GetArena());
+    if (covering_index_ != nullptr) {
+      DecodeEntry(&stored);
+    } else {
+      table_info_->GetTableHeap()->GetTuple(&stored, nullptr);
+    }
+    // 驱动索引只保证它那一列的部分条件，整个谓词在这里检查
+    if (predicate->Evaluate(&stored).CompareEquals(Field(kTypeInt, 1)) != CmpBool::kTrue) {
+      stored.Reset(nullptr);
+      exec_ctx_->GetArena()->Rewind(position);
+      continue;
     }
-    *rid = result_[cursor_];
+    *rid = next_rid;
     if (!is_schema_same_) {
-      TupleTransfer(table_schema, plan_->OutputSchema(), p_row, row);
+      TupleTransfer(table_schema, plan_->OutputSchema(), &stored, row);
     } else {
-      *row = *p_row;
+      *row = std::move(stored);
     }
-    delete p_row;
-    cursor_++;
     return true;
   }
   return false;
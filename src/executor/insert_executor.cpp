@@ -20,6 +20,9 @@ bool InsertExecutor::Next([[maybe_unused]] Row *row, RowId *rid) {
     RowId insert_rid;
     if (child_executor_->Next(&insert_row, &insert_rid)) {
         for (auto info: index_info_) {
+            if (!info->IsUnique()) {  // 非唯一索引允许重复的键
+                continue;
+            }
             Row key_row;
             insert_row.GetKeyFromRow(table_info_->GetSchema(), info->GetIndexKeySchema(), key_row);
             std::vector<RowId> result;
@@ -32,7 +35,7 @@ bool InsertExecutor::Next([[maybe_unused]] Row *row, RowId *rid) {
         if (table_info_->GetTableHeap()->InsertTuple(insert_row, exec_ctx_->GetTransaction())) {
             Row key_row;
             for (auto info: index_info_) {  // 更新索引
-                insert_row.GetKeyFromRow(schema_, info->GetIndexKeySchema(), key_row);
+                insert_row.GetKeyFromRow(schema_, info->GetIndexEntrySchema(), key_row);
                 info->GetIndex()->InsertEntry(key_row, insert_row.GetRowId(), exec_ctx_->GetTransaction());
             }
             return true;
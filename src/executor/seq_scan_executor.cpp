@@ -3,12 +3,15 @@
 //
 #include "executor/executors/seq_scan_executor.h"
 
+#include <algorithm>
+
 SeqScanExecutor::SeqScanExecutor(ExecuteContext *exec_ctx, const SeqScanPlanNode *plan)
     : AbstractExecutor(exec_ctx),
       plan_(plan),
-      iterator_(nullptr, RowId(INVALID_PAGE_ID, 0), nullptr),
       is_schema_same_(false) {}
 
+SeqScanExecutor::~SeqScanExecutor() { StopWorkers(); }
+
 bool SeqScanExecutor::SchemaEqual(const Schema *table_schema, const Schema *output_schema) {
   auto table_columns = table_schema->GetColumns();
   auto output_columns = output_schema->GetColumns();
@@ -26,44 +29,282 @@ bool SeqScanExecutor::SchemaEqual(const Schema *table_schema, const Schema *outp
   return true;
 }
 
-void SeqScanExecutor::TupleTransfer(const Schema *table_schema, const Schema *output_schema, const Row *row,
-                                    Row *output_row) {
-  const auto &output_columns = output_schema->GetColumns();
-  std::vector<Field> dest_row;
-  dest_row.reserve(output_columns.size());
-  for (const auto column : output_columns) {
-    auto idx = column->GetTableInd();
-    dest_row.emplace_back(*row->GetField(idx));
-  }
-  *output_row = Row(dest_row);
+void SeqScanExecutor::CollectColumns(const AbstractExpressionRef &expr, std::vector<bool> &columns) {
+  if (expr == nullptr) {
+    return;
+  }
+  if (expr->GetType() == ExpressionType::ColumnExpression) {
+    columns[std::dynamic_pointer_cast<ColumnValueExpression>(expr)->GetColIdx()] = true;
+  }
+  for (const auto &child : expr->GetChildren()) {
+    CollectColumns(child, columns);
+  }
+}
+
+void SeqScanExecutor::CollectZoneMapTerms(const AbstractExpressionRef &expr, ZoneMapFilter *filter) {
+  if (expr == nullptr) {
+    return;
+  }
+  if (expr->GetType() == ExpressionType::LogicExpression) {
+    // OR 的两边都可能成立，只有 AND 的条件才能用来裁剪
+    if (std::dynamic_pointer_cast<LogicExpression>(expr)->logic_type_ == LogicType::And) {
+      CollectZoneMapTerms(expr->GetChildAt(0), filter);
+      CollectZoneMapTerms(expr->GetChildAt(1), filter);
+    }
+    return;
+  }
+  if (expr->GetType() != ExpressionType::ComparisonExpression ||
+      expr->GetChildAt(0)->GetType() != ExpressionType::ColumnExpression ||
+      expr->GetChildAt(1)->GetType() != ExpressionType::ConstantExpression) {
+    return;
+  }
+  auto column = std::dynamic_pointer_cast<ColumnValueExpression>(expr->GetChildAt(0));
+  const Field &constant = std::dynamic_pointer_cast<ConstantValueExpression>(expr->GetChildAt(1))->val_;
+  std::string comp_type = std::dynamic_pointer_cast<ComparisonExpression>(expr)->GetComparisonType();
+  if (comp_type == "is") {
+    filter->AddTerm(column->GetColIdx(), ZoneMapFilter::Op::kIsNull);
+    return;
+  }
+  double value;
+  if (column->GetReturnType() != constant.GetTypeId() || !ZoneMap::GetNumericValue(constant, &value)) {
+    return;
+  }
+  static const std::unordered_map<std::string, ZoneMapFilter::Op> ops = {
+      {"=", ZoneMapFilter::Op::kEqual},
+      {"<", ZoneMapFilter::Op::kLessThan},
+      {"<=", ZoneMapFilter::Op::kLessThanEquals},
+      {">", ZoneMapFilter::Op::kGreaterThan},
+      {">=", ZoneMapFilter::Op::kGreaterThanEquals}};
+  auto it = ops.find(comp_type);
+  if (it != ops.end()) {
+    filter->AddTerm(column->GetColIdx(), it->second, value);
+  }
+}
+
+void SeqScanExecutor::CollectEqualityTerms(const AbstractExpressionRef &expr,
+                                           std::unordered_map<uint32_t, const Field *> *constants) {
+  if (expr == nullptr) {
+    return;
+  }
+  if (expr->GetType() == ExpressionType::LogicExpression) {
+    if (std::dynamic_pointer_cast<LogicExpression>(expr)->logic_type_ == LogicType::And) {
+      CollectEqualityTerms(expr->GetChildAt(0), constants);
+      CollectEqualityTerms(expr->GetChildAt(1), constants);
+    }
+    return;
+  }
+  if (expr->GetType() != ExpressionType::ComparisonExpression ||
+      expr->GetChildAt(0)->GetType() != ExpressionType::ColumnExpression ||
+      expr->GetChildAt(1)->GetType() != ExpressionType::ConstantExpression ||
+      std::dynamic_pointer_cast<ComparisonExpression>(expr)->GetComparisonType() != "=") {
+    return;
+  }
+  auto column = std::dynamic_pointer_cast<ColumnValueExpression>(expr->GetChildAt(0));
+  const Field &constant = std::dynamic_pointer_cast<ConstantValueExpression>(expr->GetChildAt(1))->val_;
+  // 类型不同时比较会先做转换，哈希对不上
+  if (column->GetReturnType() == constant.GetTypeId() && !constant.IsNull()) {
+    (*constants)[column->GetColIdx()] = &constant;
+  }
 }
 
 void SeqScanExecutor::Init() {
+  StopWorkers();
   exec_ctx_->GetCatalog()->GetTable(plan_->GetTableName(), table_info_);
-  auto first_row = table_info_->GetTableHeap()->Begin(nullptr);
-  iterator_ = (table_info_->GetTableHeap()->Begin(exec_ctx_->GetTransaction()));
   schema_ = plan_->OutputSchema();
-  is_schema_same_ = SchemaEqual(table_info_->GetSchema(), schema_);
+  auto table_schema = table_info_->GetSchema();
+  is_schema_same_ = SchemaEqual(table_schema, schema_);
+  output_columns_.clear();
+  if (is_schema_same_) {
+    for (uint32_t i = 0; i < table_schema->GetColumnCount(); i++) {
+      output_columns_.push_back(i);
+    }
+  } else {
+    for (const auto column : schema_->GetColumns()) {
+      output_columns_.push_back(column->GetTableInd());
+    }
+  }
+  predicate_columns_.assign(table_schema->GetColumnCount(), false);
+  CollectColumns(plan_->GetPredicate(), predicate_columns_);
+  zone_map_filter_ = ZoneMapFilter();
+  CollectZoneMapTerms(plan_->GetPredicate(), &zone_map_filter_);
+  bloom_probes_.clear();
+  std::unordered_map<uint32_t, const Field *> constants;
+  CollectEqualityTerms(plan_->GetPredicate(), &constants);
+  std::vector<IndexInfo *> indexes;
+  if (!constants.empty()) {
+    exec_ctx_->GetCatalog()->GetTableIndexes(plan_->GetTableName(), indexes);
+  }
+  for (auto index : indexes) {
+    if (index->GetIndexType() != "bloom") {
+      continue;
+    }
+    // 索引的每一列都有等值条件时才能算出要找的键
+    std::vector<Field> key_fields;
+    for (auto column : index->GetIndexKeySchema()->GetColumns()) {
+      auto it = constants.find(column->GetTableInd());
+      if (it == constants.end()) {
+        break;
+      }
+      key_fields.emplace_back(*it->second);
+    }
+    uint64_t hash;
+    if (key_fields.size() != index->GetIndexKeySchema()->GetColumnCount() ||
+        !BloomFilterIndex::HashKey(Row(key_fields), &hash)) {
+      continue;
+    }
+    bloom_probes_.emplace_back(static_cast<BloomFilterIndex *>(index->GetIndex()), hash);
+  }
+  page_filter_ = nullptr;
+  if (!bloom_probes_.empty()) {
+    page_filter_ = [this](page_id_t page_id) {
+      for (const auto &probe : bloom_probes_) {
+        if (!probe.first->MayContain(page_id, probe.second)) {
+          return false;
+        }
+      }
+      return true;
+    };
+  }
+  auto table_heap = table_info_->GetTableHeap();
+  uint32_t threads = exec_ctx_->GetSettings().scan_threads_;
+  page_count_ = table_heap->GetPageCount();
+  // 表不到两个 morsel 时不值得启动工作线程
+  parallel_ = threads > 1 && page_count_ > MORSEL_PAGES;
+  if (!parallel_) {
+    iterator_ = table_heap->ViewBegin(exec_ctx_->GetTransaction(), &zone_map_filter_, page_filter_);
+    return;
+  }
+  iterator_ = TableViewIterator();
+  next_page_ = 0;
+  stop_ = false;
+  skipped_pages_ = 0;
+  batches_.clear();
+  batch_.clear();
+  batch_pos_ = 0;
+  worker_error_ = nullptr;
+  uint32_t worker_count = std::min<size_t>(threads, (page_count_ + MORSEL_PAGES - 1) / MORSEL_PAGES);
+  running_workers_ = worker_count;
+  max_batches_ = 2 * worker_count;
+  for (uint32_t i = 0; i < worker_count; i++) {
+    workers_.emplace_back(&SeqScanExecutor::ScanMorsels, this);
+  }
 }
 
-bool SeqScanExecutor::Next(Row *row, RowId *rid) {
-  auto predicate = plan_->GetPredicate();
-  auto table_schema = table_info_->GetSchema();
-  while (iterator_ != table_info_->GetTableHeap()->End()) {
-    auto p_row = &(*iterator_);
-    if (predicate != nullptr) {
-      if (!predicate->Evaluate(p_row).CompareEquals(Field(kTypeInt, 1))) {
-        iterator_++;
-        continue;
+void SeqScanExecutor::ScanMorsels() {
+  auto table_heap = table_info_->GetTableHeap();
+  try {
+    while (!stop_) {
+      size_t begin = next_page_.fetch_add(MORSEL_PAGES);
+      if (begin >= page_count_) {
+        break;
       }
+      std::vector<Row> batch;
+      auto it = table_heap->ViewRange(exec_ctx_->GetTransaction(), begin, begin + MORSEL_PAGES, &zone_map_filter_,
+                                      page_filter_);
+      for (; !it.IsEnd(); ++it) {
+        if (!Matches(*it)) {
+          continue;
+        }
+        batch.emplace_back();
+        it->Materialize(&batch.back(), output_columns_);
+      }
+      skipped_pages_ += it.GetSkippedPageCount();
+      it.Release();
+      for (auto &row : batch) {
+        table_heap->LoadOverflowValues(&row, {});
+      }
+      if (!batch.empty()) {
+        // 队列满了就等上层取走一批，扫描不会比消费快出太多
+        std::unique_lock<std::mutex> lock(queue_latch_);
+        space_cv_.wait(lock, [this] { return batches_.size() < max_batches_ || stop_; });
+        if (stop_) {
+          break;
+        }
+        batches_.push_back(std::move(batch));
+        queue_cv_.notify_one();
+      }
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(queue_latch_);
+    if (worker_error_ == nullptr) {
+      worker_error_ = std::current_exception();
     }
-    *rid = iterator_->GetRowId();
-    if (!is_schema_same_) {
-      TupleTransfer(table_schema, schema_, p_row, row);
-    } else {
-      *row = *p_row;
+  }
+  std::lock_guard<std::mutex> lock(queue_latch_);
+  running_workers_--;
+  queue_cv_.notify_all();
+}
+
+bool SeqScanExecutor::NextQueued(Row *row, RowId *rid) {
+  while (batch_pos_ == batch_.size()) {
+    std::unique_lock<std::mutex> lock(queue_latch_);
+    queue_cv_.wait(lock, [this] { return !batches_.empty() || running_workers_ == 0; });
+    if (worker_error_ != nullptr) {
+      std::rethrow_exception(worker_error_);
+    }
+    if (batches_.empty()) {
+      return false;
+    }
+    batch_ = std::move(batches_.front());
+    batches_.pop_front();
+    batch_pos_ = 0;
+    space_cv_.notify_one();
+  }
+  *row = std::move(batch_[batch_pos_++]);
+  *rid = row->GetRowId();
+  return true;
+}
+
+void SeqScanExecutor::StopWorkers() {
+  {
+    // 持有队列锁再唤醒，等队列空位的工作线程不会错过 stop_
+    std::lock_guard<std::mutex> lock(queue_latch_);
+    stop_ = true;
+    space_cv_.notify_all();
+  }
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+}
+
+bool SeqScanExecutor::Matches(const RowView &view) {
+  auto predicate = plan_->GetPredicate();
+  if (predicate == nullptr) {
+    return true;
+  }
+  for (uint32_t i = 0; i < predicate_columns_.size(); i++) {
+    if (predicate_columns_[i] && view.IsExternal(i)) {
+      // 谓词用到了存放在溢出页中的长值，只能先把整行物化出来
+      Row row;
+      view.Materialize(&row);
+      table_info_->GetTableHeap()->LoadOverflowValues(&row, predicate_columns_);
+      return predicate->Evaluate(&row).CompareEquals(Field(kTypeInt, 1)) == CmpBool::kTrue;
+    }
+  }
+  return predicate->EvaluateView(view).CompareEquals(Field(kTypeInt, 1)) == CmpBool::kTrue;
+}
+
+bool SeqScanExecutor::Next(Row *row, RowId *rid) {
+  if (parallel_) {
+    return NextQueued(row, rid);
+  }
+  // 上一次返回时已经放开了页面，从返回的那一行之后继续
+  if (iterator_.IsReleased()) {
+    ++iterator_;
+  }
+  for (; !iterator_.IsEnd(); ++iterator_) {
+    const RowView &view = *iterator_;
+    if (!Matches(view)) {
+      continue;
     }
-    iterator_++;
+    // 只有离开算子的行才会被物化
+    *rid = view.GetRowId();
+    row->Reset(exec_ctx_->GetArena());
+    view.Materialize(row, output_columns_);
+    // 上层算子可能会修改表（update/delete），不能在持有页面读锁时返回
+    iterator_.Release();
+    table_info_->GetTableHeap()->LoadOverflowValues(row, {});
     return true;
   }
   return false;
@@ -16,6 +16,8 @@ void UpdateExecutor::Init() {
 }
 
 bool UpdateExecutor::Next([[maybe_unused]] Row *row, RowId *rid) {
+  // 被更新的行不会留到查询结束，处理完就把它在 arena 中的内存还回去
+  MemoryArena::Scope scope(exec_ctx_->GetArena());
   Row src_row;
   RowId src_rid;
   if (child_executor_->Next(&src_row, &src_rid)) {
@@ -26,8 +28,12 @@ bool UpdateExecutor::Next([[maybe_unused]] Row *row, RowId *rid) {
     Row src_key_row;
     Row dest_key_row;
     for (auto info : index_info_) {  // 更新索引
-      src_row.GetKeyFromRow(table_info_->GetSchema(), info->GetIndexKeySchema(), src_key_row);
-      dest_row.GetKeyFromRow(table_info_->GetSchema(), info->GetIndexKeySchema(), dest_key_row);
+      src_row.GetKeyFromRow(table_info_->GetSchema(), info->GetIndexEntrySchema(), src_key_row);
+      dest_row.GetKeyFromRow(table_info_->GetSchema(), info->GetIndexEntrySchema(), dest_key_row);
+      // 记录即使被搬到别的页面 rid 也不变，键和 INCLUDE 列都没变的索引无需维护
+      if (KeyEquals(src_key_row, dest_key_row)) {
+        continue;
+      }
       info->GetIndex()->RemoveEntry(src_key_row, src_rid, txn_);
       info->GetIndex()->InsertEntry(dest_key_row, src_rid, txn_);
     }
@@ -36,6 +42,18 @@ bool UpdateExecutor::Next([[maybe_unused]] Row *row, RowId *rid) {
   return false;
 }
 
+bool UpdateExecutor::KeyEquals(const Row &lhs, const Row &rhs) {
+  if (lhs.GetFieldCount() != rhs.GetFieldCount()) {
+    return false;
+  }
+  for (uint32_t i = 0; i < lhs.GetFieldCount(); i++) {
+    if (lhs.GetField(i)->CompareEquals(*rhs.GetField(i)) != CmpBool::kTrue) {
+      return false;
+    }
+  }
+  return true;
+}
+
 Row UpdateExecutor::GenerateUpdatedTuple(const Row &src_row) {
   const auto update_attrs = plan_->GetUpdateAttr();
   Schema *schema = table_info_->GetSchema();
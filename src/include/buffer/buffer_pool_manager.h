@@ -1,18 +1,47 @@
 #ifndef MINISQL_BUFFER_POOL_MANAGER_H
 #define MINISQL_BUFFER_POOL_MANAGER_H
 
+#include <atomic>
+#include <chrono>
 #include <list>
 #include <mutex>
 #include <unordered_map>
 
 #include "buffer/lru_replacer.h"
+#include "buffer/page_guard.h"
 #include "page/disk_file_meta_page.h"
 #include "page/page.h"
 #include "storage/disk_manager.h"
 
 using namespace std;
 
+/**
+ * Point-in-time copy of the buffer pool counters, returned by BufferPoolManager::GetStats().
+ */
+struct BufferPoolStats {
+  size_t pool_size_{0};
+  uint32_t page_size_{0};
+  size_t pages_cached_{0};       // frames currently mapped to a page
+  uint64_t fetch_hits_{0};       // FetchPage served from the pool
+  uint64_t fetch_misses_{0};     // FetchPage that had to read from disk
+  uint64_t new_pages_{0};        // successful NewPage calls
+  uint64_t clean_evictions_{0};  // victims dropped without a write back
+  uint64_t dirty_evictions_{0};  // victims written back before reuse
+  uint64_t latch_wait_ns_{0};    // time spent acquiring the pool latch and page latches
+  DiskIOStats disk_;
+
+  /** @return fetch_hits_ / (fetch_hits_ + fetch_misses_), or 0 when nothing has been fetched */
+  double HitRatio() const {
+    uint64_t total = fetch_hits_ + fetch_misses_;
+    return total == 0 ? 0.0 : static_cast<double>(fetch_hits_) / total;
+  }
+};
+
 class BufferPoolManager {
+  // guards report the time they spend waiting for page latches
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
  public:
   explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager);
 
@@ -28,10 +57,34 @@ class BufferPoolManager {
 
   bool DeletePage(page_id_t page_id);
 
+  /**
+   * Guarded variants of FetchPage/NewPage. The returned guard owns the pin (and the latch for the read/write
+   * variants) and gives both back when it is destroyed, so callers never pair Fetch and Unpin by hand.
+   * If the page cannot be brought into the pool the guard is empty, check IsValid() before use.
+   */
+  BasicPageGuard FetchPageBasic(page_id_t page_id);
+
+  ReadPageGuard FetchPageRead(page_id_t page_id);
+
+  WritePageGuard FetchPageWrite(page_id_t page_id);
+
+  BasicPageGuard NewPageGuarded(page_id_t &page_id);
+
   bool IsPageFree(page_id_t page_id);
 
   bool CheckAllUnpinned();
 
+  /** @return the size of every frame, equal to the page size of the underlying database file */
+  inline uint32_t GetPageSize() const { return disk_manager_->GetPageSize(); }
+
+  /**
+   * Snapshot of the buffer pool and disk I/O counters. Counters are relaxed atomics, so the values of
+   * different fields are not guaranteed to be taken at the same instant.
+   */
+  BufferPoolStats GetStats();
+
+  void ResetStats();
+
  private:
   /**
    * Allocate new page (operations like create index/table) For now just keep an increasing counter
@@ -45,6 +98,25 @@ class BufferPoolManager {
 
   frame_id_t TryToFindFreePage();
 
+  /** Write back a victim frame if needed and account the eviction. */
+  void EvictFrame(frame_id_t frame_id);
+
+  /** Lock the pool latch, adding the time spent waiting for it to the latch wait counter. */
+  inline std::unique_lock<recursive_mutex> LockPool() {
+    std::unique_lock<recursive_mutex> lock(latch_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+      auto wait_start = std::chrono::steady_clock::now();
+      lock.lock();
+      RecordLatchWait(wait_start);
+    }
+    return lock;
+  }
+
+  inline void RecordLatchWait(std::chrono::steady_clock::time_point start) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    latch_wait_ns_.fetch_add(elapsed.count(), std::memory_order_relaxed);
+  }
+
  private:
   size_t pool_size_;                                 // number of pages in buffer pool
   Page *pages_;                                      // array of pages
@@ -53,6 +125,13 @@ class BufferPoolManager {
   Replacer *replacer_;                               // to find an unpinned page for replacement
   list<frame_id_t> free_list_;                       // to find a free page for replacement
   recursive_mutex latch_;                            // to protect shared data structure
+  // counters, see BufferPoolStats
+  atomic<uint64_t> fetch_hits_{0};
+  atomic<uint64_t> fetch_misses_{0};
+  atomic<uint64_t> new_pages_{0};
+  atomic<uint64_t> clean_evictions_{0};
+  atomic<uint64_t> dirty_evictions_{0};
+  atomic<uint64_t> latch_wait_ns_{0};
 };
 
 #endif  // MINISQL_BUFFER_POOL_MANAGER_H
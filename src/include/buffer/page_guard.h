@@ -0,0 +1,170 @@
+#ifndef MINISQL_PAGE_GUARD_H
+#define MINISQL_PAGE_GUARD_H
+
+#include <type_traits>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "page/page.h"
+
+class BufferPoolManager;
+class ReadPageGuard;
+class WritePageGuard;
+
+/**
+ * BasicPageGuard owns exactly one pin on a buffer pool page and releases it when it goes out of scope.
+ *
+ * Guards are move-only: moving transfers the pin, copying is not allowed. Accessing the page through
+ * GetDataMut()/AsMut() marks the guard dirty so that the page is unpinned with is_dirty = true.
+ */
+class BasicPageGuard {
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
+ public:
+  BasicPageGuard() = default;
+
+  BasicPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  DISALLOW_COPY(BasicPageGuard)
+
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+  BasicPageGuard &operator=(BasicPageGuard &&that) noexcept;
+
+  ~BasicPageGuard() { Drop(); }
+
+  /** Unpin the page now. The guard becomes empty and can be reused as a move target. */
+  void Drop();
+
+  /** Take the read latch and hand the pin over to a ReadPageGuard, leaving this guard empty. */
+  ReadPageGuard UpgradeRead();
+
+  /** Take the write latch and hand the pin over to a WritePageGuard, leaving this guard empty. */
+  WritePageGuard UpgradeWrite();
+
+  /** @return true if the guard holds a page, false if the fetch failed or the guard was moved from */
+  inline bool IsValid() const { return page_ != nullptr; }
+
+  inline page_id_t PageId() const { return page_->GetPageId(); }
+
+  inline Page *GetPage() const { return page_; }
+
+  inline const char *GetData() const { return page_->GetData(); }
+
+  inline char *GetDataMut() {
+    is_dirty_ = true;
+    return page_->GetData();
+  }
+
+  /**
+   * View the page as T. Types deriving from Page (e.g. TablePage) wrap the frame itself, all other page layouts
+   * (e.g. B+ tree pages) are overlaid on the page data.
+   */
+  template <class T>
+  inline T *As() const {
+    if constexpr (std::is_base_of_v<Page, T>) {
+      return static_cast<T *>(page_);
+    } else {
+      return reinterpret_cast<T *>(page_->GetData());
+    }
+  }
+
+  template <class T>
+  inline T *AsMut() {
+    is_dirty_ = true;
+    return As<T>();
+  }
+
+  /** Mark the page dirty without going through AsMut(), e.g. when a pointer obtained earlier was modified. */
+  inline void SetDirty() { is_dirty_ = true; }
+
+ private:
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+/**
+ * ReadPageGuard owns one pin and the read latch of a page. Both are released on destruction.
+ */
+class ReadPageGuard {
+  friend class BasicPageGuard;
+
+ public:
+  ReadPageGuard() = default;
+
+  ReadPageGuard(BufferPoolManager *bpm, Page *page);
+
+  DISALLOW_COPY(ReadPageGuard)
+
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+  ReadPageGuard &operator=(ReadPageGuard &&that) noexcept;
+
+  ~ReadPageGuard() { Drop(); }
+
+  void Drop();
+
+  inline bool IsValid() const { return guard_.IsValid(); }
+
+  inline page_id_t PageId() const { return guard_.PageId(); }
+
+  inline const char *GetData() const { return guard_.GetData(); }
+
+  /** Pages are read-only through this guard; non-const page methods may still be used for reading. */
+  template <class T>
+  inline T *As() const {
+    return guard_.As<T>();
+  }
+
+ private:
+  BasicPageGuard guard_;
+};
+
+/**
+ * WritePageGuard owns one pin and the write latch of a page. Both are released on destruction.
+ */
+class WritePageGuard {
+  friend class BasicPageGuard;
+
+ public:
+  WritePageGuard() = default;
+
+  WritePageGuard(BufferPoolManager *bpm, Page *page);
+
+  DISALLOW_COPY(WritePageGuard)
+
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+  WritePageGuard &operator=(WritePageGuard &&that) noexcept;
+
+  ~WritePageGuard() { Drop(); }
+
+  void Drop();
+
+  inline bool IsValid() const { return guard_.IsValid(); }
+
+  inline page_id_t PageId() const { return guard_.PageId(); }
+
+  inline const char *GetData() const { return guard_.GetData(); }
+
+  inline char *GetDataMut() { return guard_.GetDataMut(); }
+
+  template <class T>
+  inline T *As() const {
+    return guard_.As<T>();
+  }
+
+  template <class T>
+  inline T *AsMut() {
+    return guard_.AsMut<T>();
+  }
+
+  inline void SetDirty() { guard_.SetDirty(); }
+
+ private:
+  BasicPageGuard guard_;
+};
+
+#endif  // MINISQL_PAGE_GUARD_H
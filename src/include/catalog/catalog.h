@@ -82,9 +82,16 @@ class CatalogManager {
 
   dberr_t GetTables(std::vector<TableInfo *> &tables) const;
 
+  /**
+   * Create an index and build it from the rows already in the table.
+   * @param include_keys  columns stored in the leaves after the key (B+ tree only), for index-only scans
+   * @return DB_FAILED if the index cannot be built (e.g. duplicate keys), nothing of it is kept then
+   */
   dberr_t CreateIndex(const std::string &table_name, const std::string &index_name,
                       const std::vector<std::string> &index_keys, Txn *txn, IndexInfo *&index_info,
-                      const string &index_type);
+                      const string &index_type, bool unique = true,
+                      const std::vector<std::string> &include_keys = {},
+                      const IndexBuildOptions &options = IndexBuildOptions());
 
   dberr_t GetIndex(const std::string &table_name, const std::string &index_name, IndexInfo *&index_info) const;
 
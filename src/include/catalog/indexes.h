@@ -6,7 +6,9 @@
 #include "catalog/table.h"
 #include "common/macros.h"
 #include "common/rowid.h"
+#include "index/b_link_tree_index.h"
 #include "index/b_plus_tree_index.h"
+#include "index/bloom_filter_index.h"
 #include "index/generic_key.h"
 #include "record/schema.h"
 
@@ -15,7 +17,13 @@ class IndexMetadata {
 
  public:
   static IndexMetadata *Create(const index_id_t index_id, const std::string &index_name, const table_id_t table_id,
-                               const std::vector<uint32_t> &key_map);
+                               const std::vector<uint32_t> &key_map, const std::string &index_type = "bptree",
+                               bool unique = true, const std::vector<uint32_t> &include_map = {});
+
+  /** @return true if an index of this type can be created */
+  static bool IsSupportedType(const std::string &index_type) {
+    return index_type == "bptree" || index_type == "bloom" || index_type == "blink";
+  }
 
   uint32_t SerializeTo(char *buf) const;
 
@@ -31,20 +39,38 @@ class IndexMetadata {
 
   inline const std::vector<uint32_t> &GetKeyMapping() const { return key_map_; }
 
+  /** @return the table columns stored in the leaves after the key (INCLUDE), not part of the key order */
+  inline const std::vector<uint32_t> &GetIncludeMapping() const { return include_map_; }
+
   inline index_id_t GetIndexId() const { return index_id_; }
 
+  inline const std::string &GetIndexType() const { return index_type_; }
+
+  /** @return false if several rows may share a key */
+  inline bool IsUnique() const { return unique_; }
+
  private:
   IndexMetadata() = delete;
 
   explicit IndexMetadata(const index_id_t index_id, const std::string &index_name, const table_id_t table_id,
-                         const std::vector<uint32_t> &key_map);
+                         const std::vector<uint32_t> &key_map, const std::string &index_type, bool unique,
+                         const std::vector<uint32_t> &include_map);
 
  private:
   static constexpr uint32_t INDEX_METADATA_MAGIC_NUM = 344528;
+  // 带索引类型的元数据，旧的元数据没有类型，都是 B+ 树
+  static constexpr uint32_t INDEX_METADATA_TYPED_MAGIC_NUM = 344529;
+  // 带唯一性标记的元数据，旧的元数据都是唯一索引
+  static constexpr uint32_t INDEX_METADATA_UNIQUE_MAGIC_NUM = 344530;
+  // 带 INCLUDE 列的元数据
+  static constexpr uint32_t INDEX_METADATA_INCLUDE_MAGIC_NUM = 344531;
   index_id_t index_id_;
   std::string index_name_;
   table_id_t table_id_;
   std::vector<uint32_t> key_map_; /** The mapping of index key to tuple key */
+  std::string index_type_;
+  bool unique_;
+  std::vector<uint32_t> include_map_; /** The mapping of included columns to tuple columns */
 };
 
 /**
@@ -57,6 +83,9 @@ class IndexInfo {
   ~IndexInfo() {
     delete meta_data_;
     delete index_;
+    if (entry_schema_ != key_schema_) {
+      delete entry_schema_;
+    }
     delete key_schema_;
   }
 
@@ -70,9 +99,14 @@ class IndexInfo {
 
     // Step2: mapping index key to key schema
     key_schema_ = Schema::ShallowCopySchema(schema, meta_data_->GetKeyMapping());
+    // 叶子中存的条目：键之后跟着 INCLUDE 列
+    entry_schema_ = key_schema_;
+    if (!meta_data_->GetIncludeMapping().empty()) {
+      entry_schema_ = Schema::ShallowCopySchema(schema, GetEntryMapping());
+    }
 
     // Step3: call CreateIndex to create the index
-    index_ = CreateIndex(buffer_pool_manager, "bptree");
+    index_ = CreateIndex(buffer_pool_manager, meta_data_->GetIndexType(), table_info);
   }
 
   inline Index *GetIndex() { return index_; }
@@ -81,15 +115,30 @@ class IndexInfo {
 
   IndexSchema *GetIndexKeySchema() { return key_schema_; }
 
+  /** @return the columns of an index entry, the key followed by the INCLUDE columns; what InsertEntry takes */
+  IndexSchema *GetIndexEntrySchema() { return entry_schema_; }
+
+  /** @return the table columns an entry holds, in entry order */
+  std::vector<uint32_t> GetEntryMapping() const {
+    std::vector<uint32_t> entry_map(meta_data_->GetKeyMapping());
+    entry_map.insert(entry_map.end(), meta_data_->GetIncludeMapping().begin(), meta_data_->GetIncludeMapping().end());
+    return entry_map;
+  }
+
+  const std::string &GetIndexType() const { return meta_data_->GetIndexType(); }
+
+  bool IsUnique() const { return meta_data_->IsUnique(); }
+
  private:
-  explicit IndexInfo() : meta_data_{nullptr}, index_{nullptr}, key_schema_{nullptr} {}
+  explicit IndexInfo() : meta_data_{nullptr}, index_{nullptr}, key_schema_{nullptr}, entry_schema_{nullptr} {}
 
-  Index *CreateIndex(BufferPoolManager *buffer_pool_manager, const string &index_type);
+  Index *CreateIndex(BufferPoolManager *buffer_pool_manager, const string &index_type, TableInfo *table_info);
 
  private:
   IndexMetadata *meta_data_;
   Index *index_;
   IndexSchema *key_schema_;
+  IndexSchema *entry_schema_;
 };
 
 #endif  // MINISQL_INDEXES_H
@@ -13,11 +13,17 @@ static constexpr int META_PAGE_ID = 0;          // physical page id of the disk
 static constexpr int CATALOG_META_PAGE_ID = 0;  // logical page id of the catalog meta data
 static constexpr int INDEX_ROOTS_PAGE_ID = 1;   // logical page id of the index roots
 
-static constexpr int PAGE_SIZE = 4096;                  // size of a data page in byte
-static constexpr int DEFAULT_BUFFER_POOL_SIZE = 20480;  // default size of buffer pool
+static constexpr int PAGE_SIZE = 4096;                  // default (and smallest) size of a data page in byte
+static constexpr int MAX_PAGE_SIZE = 32768;             // largest page size a database file can be created with
+static constexpr int DEFAULT_BUFFER_POOL_SIZE = 20480;  // default size of buffer pool, counted in PAGE_SIZE frames
 
 static constexpr uint32_t FIELD_NULL_LEN = UINT32_MAX;
-static constexpr uint32_t VARCHAR_MAX_LEN = PAGE_SIZE / 2;  // max length of varchar
+static constexpr uint32_t VARCHAR_MAX_LEN = 1 << 20;  // max length of varchar, long values live in overflow pages
+
+/** Supported page sizes are the powers of two between PAGE_SIZE and MAX_PAGE_SIZE. */
+static constexpr bool IsValidPageSize(uint32_t page_size) {
+  return page_size >= PAGE_SIZE && page_size <= MAX_PAGE_SIZE && (page_size & (page_size - 1)) == 0;
+}
 
 // static std::string DB_META_FILE = "minisql.meta.db";
 
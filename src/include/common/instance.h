@@ -14,7 +14,12 @@
 
 class DBStorageEngine {
  public:
-  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE);
+  /**
+   * @param buffer_pool_size number of PAGE_SIZE frames, scaled down for larger pages so the pool keeps its memory budget
+   * @param page_size page size of a newly created database file, an existing file keeps its own page size
+   */
+  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE,
+                           uint32_t page_size = PAGE_SIZE);
 
   ~DBStorageEngine();
 
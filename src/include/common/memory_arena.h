@@ -0,0 +1,115 @@
+#ifndef MINISQL_MEMORY_ARENA_H
+#define MINISQL_MEMORY_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+
+/**
+ * Bump allocator for objects living as long as one query, e.g. the rows and char values produced by the executors.
+ *
+ * Memory is carved out of blocks of BLOCK_SIZE bytes (larger requests get a block of their own) and is only given
+ * back when the arena is destroyed or rewound to a Mark(), objects built in it are destructed by their owner but never
+ * freed one by one. Not thread safe.
+ */
+class MemoryArena {
+ public:
+  static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+  /** A point in the allocations of an arena, see Mark(). */
+  struct Position {
+    size_t blocks_;
+    char *current_;
+    size_t block_size_;
+    size_t used_;
+    size_t allocated_bytes_;
+  };
+
+  /**
+   * Rewinds the arena, when it goes out of scope, to where it was when the scope was created. Objects built since
+   * must be destructed before, e.g. by declaring them after the scope.
+   */
+  class Scope {
+   public:
+    explicit Scope(MemoryArena *arena) : arena_(arena), position_(arena->Mark()) {}
+
+    ~Scope() { arena_->Rewind(position_); }
+
+    DISALLOW_COPY_AND_MOVE(Scope);
+
+   private:
+    MemoryArena *arena_;
+    Position position_;
+  };
+
+  MemoryArena() = default;
+
+  ~MemoryArena() = default;
+
+  DISALLOW_COPY_AND_MOVE(MemoryArena);
+
+  void *Allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+    size_t offset = (used_ + align - 1) & ~(align - 1);
+    if (current_ == nullptr || offset + size > block_size_) {
+      // 大对象单独占一个块，当前块剩余的空间留给之后的小对象
+      if (size > BLOCK_SIZE / 4) {
+        allocated_bytes_ += size;
+        return NewBlock(size, false);
+      }
+      NewBlock(BLOCK_SIZE, true);
+      offset = 0;
+    }
+    used_ = offset + size;
+    allocated_bytes_ += size;
+    return current_ + offset;
+  }
+
+  /** Construct a T in the arena, its destructor must be called by the owner. */
+  template <typename T, typename... Args>
+  T *New(Args &&... args) {
+    return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+  }
+
+  /** @return the current position, Rewind() to it gives back everything allocated after */
+  Position Mark() const { return {blocks_.size(), current_, block_size_, used_, allocated_bytes_}; }
+
+  /** Give back everything allocated since position, the objects built there must already be destructed. */
+  void Rewind(const Position &position) {
+    ASSERT(position.blocks_ <= blocks_.size(), "Rewinding past the current position.");
+    blocks_.resize(position.blocks_);
+    current_ = position.current_;
+    block_size_ = position.block_size_;
+    used_ = position.used_;
+    allocated_bytes_ = position.allocated_bytes_;
+  }
+
+  /** @return bytes handed out so far */
+  inline size_t GetAllocatedBytes() const { return allocated_bytes_; }
+
+  /** @return blocks taken from the heap so far */
+  inline size_t GetBlockCount() const { return blocks_.size(); }
+
+ private:
+  char *NewBlock(size_t size, bool current) {
+    blocks_.emplace_back(new char[size]);
+    char *block = blocks_.back().get();
+    if (current) {
+      current_ = block;
+      block_size_ = size;
+      used_ = 0;
+    }
+    return block;
+  }
+
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  char *current_{nullptr};
+  size_t block_size_{0};
+  size_t used_{0};
+  size_t allocated_bytes_{0};
+};
+
+#endif  // MINISQL_MEMORY_ARENA_H
@@ -36,6 +36,19 @@ class ReaderWriterLatch {
     }
   }
 
+  /**
+   * Acquire a write latch if no one holds the latch.
+   * @return false, without waiting, if a reader or a writer holds it
+   */
+  bool TryWLock() {
+    std::lock_guard<mutex_t> guard(mutex_);
+    if (writer_entered_ || reader_count_ > 0) {
+      return false;
+    }
+    writer_entered_ = true;
+    return true;
+  }
+
   /**
    * Release a write latch.
    */
@@ -56,6 +69,19 @@ class ReaderWriterLatch {
     reader_count_++;
   }
 
+  /**
+   * Acquire a read latch if no writer holds or waits for the latch.
+   * @return false, without waiting, if the latch cannot be shared now
+   */
+  bool TryRLock() {
+    std::lock_guard<mutex_t> guard(mutex_);
+    if (writer_entered_ || reader_count_ == MAX_READERS) {
+      return false;
+    }
+    reader_count_++;
+    return true;
+  }
+
   /**
    * Release a read latch.
    */
@@ -8,8 +8,23 @@
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/catalog.h"
 #include "common/macros.h"
+#include "common/memory_arena.h"
 #include "concurrency/txn.h"
 
+/**
+ * Settings of a client session, changed with `set <name> = <value>;` and seen by every query the session runs.
+ */
+struct SessionSettings {
+  static constexpr uint32_t MAX_THREADS = 64;
+
+  /** Number of workers a sequential scan runs on, 1 scans on the calling thread. */
+  uint32_t scan_threads_{1};
+  /** Percentage of each leaf CREATE INDEX fills, see IndexBuildOptions. */
+  uint32_t index_fill_factor_{90};
+  /** Number of workers CREATE INDEX scans and sorts the table on. */
+  uint32_t index_build_threads_{1};
+};
+
 class ExecuteContext {
  public:
   /**
@@ -34,6 +49,14 @@ class ExecuteContext {
   /** @return the buffer pool manager */
   BufferPoolManager *GetBufferPoolManager() { return bpm_; }
 
+  /** @return the arena the rows produced by the executors are allocated from, freed with the context */
+  MemoryArena *GetArena() { return &arena_; }
+
+  /** @return the settings of the session running the query */
+  const SessionSettings &GetSettings() const { return settings_; }
+
+  void SetSettings(const SessionSettings &settings) { settings_ = settings; }
+
  private:
   /** The recovery context associated with this executor context */
   Txn *transaction_;
@@ -41,6 +64,10 @@ class ExecuteContext {
   CatalogManager *catalog_;
   /** The buffer pool manager associated with this executor context */
   BufferPoolManager *bpm_;
+  /** Memory of the rows of the query, must outlive every row allocated from it */
+  MemoryArena arena_;
+  /** The settings of the session */
+  SessionSettings settings_;
 };
 
 #endif  // MINISQL_EXECUTE_CONTEXT_H
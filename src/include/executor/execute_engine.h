@@ -69,6 +69,10 @@ class ExecuteEngine {
 
   dberr_t ExecuteTrxRollback(pSyntaxNode ast, ExecuteContext *context);
 
+  dberr_t ExecuteShowBufferStatus(pSyntaxNode ast, ExecuteContext *context);
+
+  dberr_t ExecuteSetVariable(pSyntaxNode ast, ExecuteContext *context);
+
   dberr_t ExecuteExecfile(pSyntaxNode ast, ExecuteContext *context);
 
   dberr_t ExecuteQuit(pSyntaxNode ast, ExecuteContext *context);
@@ -76,6 +80,7 @@ class ExecuteEngine {
  private:
   std::unordered_map<std::string, DBStorageEngine *> dbs_; /** all opened databases */
   std::string current_db_;                                 /** current database */
+  SessionSettings settings_;                               /** settings of this session */
 };
 
 #endif  // MINISQL_EXECUTE_ENGINE_H
@@ -1,15 +1,20 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "executor/execute_context.h"
 #include "executor/executors/abstract_executor.h"
 #include "executor/plans/index_scan_plan.h"
+#include "index/index_range_iterator.h"
 #include "planner/expressions/column_value_expression.h"
 #include "planner/expressions/comparison_expression.h"
 
 /**
  * The IndexScanExecutor executor can over a table.
+ * One index drives the scan: the comparisons on its column become a key range, which a B+ tree index streams row id
+ * by row id, and the whole predicate is checked on every row fetched. When the plan has a covering index, rows are
+ * decoded from the leaf entries of that index and the table is not read at all.
  */
 class IndexScanExecutor : public AbstractExecutor {
  public:
@@ -39,12 +44,29 @@ class IndexScanExecutor : public AbstractExecutor {
   void TupleTransfer(const Schema *table_schema, const Schema *output_schema, const Row *row, Row *output_row);
 
  private:
-  vector<RowId> IndexScan(AbstractExpressionRef predicate);
+  // 收集 AND 连接的 "列 比较 常量" 条件
+  void CollectComparisons(const AbstractExpressionRef &predicate,
+                          vector<std::shared_ptr<ComparisonExpression>> &comparisons);
+
+  // 把 comparisons 中与 col_idx 列比较的条件合成键范围，交给 B+ 树索引扫描
+  void ScanRange(BPlusTreeIndex *index, uint32_t col_idx,
+                 const vector<std::shared_ptr<ComparisonExpression>> &comparisons);
+
+  // 把 range_ 当前的叶子项直接解码进 arena 中的 row，按表的列序排列，索引中没有的列为 null
+  void DecodeEntry(Row *row);
 
   /** The sequential scan plan node to be executed */
   const IndexScanPlanNode *plan_;
   TableInfo *table_info_{};
+  // B+ 树索引流式扫描，其它索引（B-link 树）由 ScanKey 一次取出所有行号
+  bool streaming_{false};
+  IndexRangeIterator range_;
   vector<RowId> result_;
   size_t cursor_ = 0;
+  // 覆盖索引和表的每一列在叶子项中的位置（-1 表示不在索引中）
+  BPlusTreeIndex *covering_index_{nullptr};
+  vector<int> entry_pos_;
+  // 叶子项中与前面重复的列，解码后丢弃
+  vector<size_t> duplicate_entries_;
   bool is_schema_same_;
 };
\ No newline at end of file
@@ -5,17 +5,38 @@
 #ifndef MINISQL_SEQ_SCAN_EXECUTOR_H
 #define MINISQL_SEQ_SCAN_EXECUTOR_H
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "executor/execute_context.h"
 #include "executor/executors/abstract_executor.h"
 #include "executor/plans/seq_scan_plan.h"
+#include "index/bloom_filter_index.h"
+#include "planner/expressions/column_value_expression.h"
+#include "planner/expressions/comparison_expression.h"
+#include "planner/expressions/constant_value_expression.h"
+#include "planner/expressions/logic_expression.h"
+#include "storage/zone_map.h"
 
 /**
  * The SeqScanExecutor executor executes a sequential table scan.
+ *
+ * With the scan_threads setting of the session above 1, the scan runs on a pool of workers: each one claims morsels
+ * of MORSEL_PAGES consecutive pages from the page directory of the table, checks the predicate and builds the output
+ * rows itself, and queues them in one batch per morsel. Next() hands out the queued rows, in no particular order.
+ * At most two batches per worker are queued, a worker waits for Next() to take one before it queues more.
  */
 class SeqScanExecutor : public AbstractExecutor {
  public:
+  static constexpr size_t MORSEL_PAGES = 8;
+
   /**
    * Construct a new SeqScanExecutor instance.
    * @param exec_ctx The executor context
@@ -23,6 +44,8 @@ class SeqScanExecutor : public AbstractExecutor {
    */
   SeqScanExecutor(ExecuteContext *exec_ctx, const SeqScanPlanNode *plan);
 
+  ~SeqScanExecutor() override;
+
   /** Initialize the sequential scan */
   void Init() override;
 
@@ -39,15 +62,74 @@ class SeqScanExecutor : public AbstractExecutor {
 
   bool SchemaEqual(const Schema *table_schema, const Schema *output_schema);
 
-  void TupleTransfer(const Schema *table_schema, const Schema *output_schema, const Row *row, Row *output_row);
+  /** Mark the table columns read by expr (and its children) in columns. */
+  static void CollectColumns(const AbstractExpressionRef &expr, std::vector<bool> &columns);
+
+  /**
+   * Add to filter the `column op constant` and `column is null` conditions on int/float columns that every row
+   * satisfying expr must satisfy, i.e. the ones not under an OR.
+   */
+  static void CollectZoneMapTerms(const AbstractExpressionRef &expr, ZoneMapFilter *filter);
+
+  /**
+   * Add to constants the `column = constant` conditions (constant not null) every row satisfying expr must satisfy,
+   * constants[i] points into expr.
+   */
+  static void CollectEqualityTerms(const AbstractExpressionRef &expr,
+                                   std::unordered_map<uint32_t, const Field *> *constants);
+
+  /** @return how many pages the scan skipped thanks to the zone maps and the bloom filters */
+  uint32_t GetSkippedPageCount() const { return parallel_ ? skipped_pages_.load() : iterator_.GetSkippedPageCount(); }
+
+  /** @return the number of workers the scan runs on, 0 if it runs on the calling thread */
+  uint32_t GetWorkerCount() const { return workers_.size(); }
 
  private:
+  /** @return true if the row satisfies the predicate of the plan, evaluated in place where possible */
+  bool Matches(const RowView &view);
+
+  /** Body of a worker: claim morsels until none is left, queue the output rows of each one. */
+  void ScanMorsels();
+
+  /** Hand out the next queued row, waiting for the workers if needed. */
+  bool NextQueued(Row *row, RowId *rid);
+
+  /** Make the workers stop after their current morsel and wait for them. */
+  void StopWorkers();
+
   /** The sequential scan plan node to be executed */
   const SeqScanPlanNode *plan_;
   TableInfo *table_info_{};
-  TableIterator iterator_;
+  TableViewIterator iterator_;
   const Schema *schema_{};
+  // the table columns making up an output row, in output order
+  std::vector<uint32_t> output_columns_;
+  // the table columns read by the predicate
+  std::vector<bool> predicate_columns_;
+  // the part of the predicate checked against the zone maps of the pages, iterator_ points to it
+  ZoneMapFilter zone_map_filter_;
+  // 每个可用的 bloom 索引和谓词中等值条件对应的键哈希，页面要通过所有的 bloom 索引才会被扫描
+  std::vector<std::pair<BloomFilterIndex *, uint64_t>> bloom_probes_;
+  TableViewIterator::PageFilter page_filter_;
   bool is_schema_same_;
+  // 并行扫描：工作线程从 next_page_ 起领取页面，结果按批放进队列
+  bool parallel_{false};
+  std::vector<std::thread> workers_;
+  size_t page_count_{0};
+  std::atomic<size_t> next_page_{0};
+  std::atomic<bool> stop_{false};
+  std::atomic<uint32_t> skipped_pages_{0};
+  std::mutex queue_latch_;
+  std::condition_variable queue_cv_;
+  // 队列满时工作线程在这里等上层取走一批
+  std::condition_variable space_cv_;
+  std::deque<std::vector<Row>> batches_;
+  size_t max_batches_{0};
+  uint32_t running_workers_{0};
+  std::exception_ptr worker_error_;
+  // 正在交给上层的一批
+  std::vector<Row> batch_;
+  size_t batch_pos_{0};
 };
 
 #endif  // MINISQL_SEQ_SCAN_EXECUTOR_H
@@ -51,6 +51,9 @@ class UpdateExecutor : public AbstractExecutor {
    */
   Row GenerateUpdatedTuple(const Row &src_row);
 
+  /** @return true if both index keys hold equal values, NULLs never compare equal */
+  static bool KeyEquals(const Row &lhs, const Row &rhs);
+
   /** The update plan node to be executed */
   const UpdatePlanNode *plan_;
   /** Metadata identifying the table that should be updated */
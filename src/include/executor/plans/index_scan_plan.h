@@ -16,14 +16,16 @@ class IndexScanPlanNode : public AbstractPlanNode {
    * Creates a new index scan plan node.
    * @param output the output format of this scan plan node
    * @param table_name The identifier of table to be scanned
+   * @param covering_index one of indexes whose leaves hold every column the query reads, nullptr if none
    */
   IndexScanPlanNode(const Schema *output, std::string table_name, std::vector<IndexInfo *> indexes, bool need_filter,
-                    AbstractExpressionRef filter_predicate = nullptr)
+                    AbstractExpressionRef filter_predicate = nullptr, IndexInfo *covering_index = nullptr)
       : AbstractPlanNode(output, {}),
         table_name_(std::move(table_name)),
         indexes_(std::move(indexes)),
         need_filter_(need_filter),
-        filter_predicate_(std::move(filter_predicate)) {}
+        filter_predicate_(std::move(filter_predicate)),
+        covering_index_(covering_index) {}
 
   /** @return The type of the plan node */
   PlanType GetType() const override { return PlanType::IndexScan; }
@@ -44,4 +46,7 @@ class IndexScanPlanNode : public AbstractPlanNode {
 
   /** The predicate to filter in IndexScan.*/
   AbstractExpressionRef filter_predicate_;
+
+  /** The index that answers the query from its leaves alone, without reading the table. */
+  IndexInfo *covering_index_{nullptr};
 };
\ No newline at end of file
@@ -0,0 +1,105 @@
+#ifndef MINISQL_B_LINK_TREE_H
+#define MINISQL_B_LINK_TREE_H
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "concurrency/txn.h"
+#include "page/b_link_tree_page.h"
+
+/**
+ * B-link tree (Lehman and Yao) with optimistic lock coupling, for indexes declared with `CREATE INDEX ... USING
+ * blink`. It uses the same KeyManager as the B+ tree, but pages of its own with keys in fixed slots (see
+ * BLinkLeafPage), which latch-free readers can rely on.
+ *
+ * Every page has a high key, the upper bound of its key range, and a right link to the next page on its level. Leaves
+ * use their next page id as right link, inner pages the pair slot after max size, and both keep the high key in the
+ * key of that slot (one pair slot of each page is reserved for it). A split links the new page to the right of the old
+ * one before adding it to the parent, so a thread that reaches the old page in between follows the right link when
+ * its key is not below the high key.
+ *
+ * Readers take no latch: they pin a page, read it and check that its version (Page::GetVersion()) did not change,
+ * reading the page again otherwise. Writers latch one page at a time (two while moving right), bottom up and left to
+ * right. Pages are never merged, a leaf emptied by removes stays in the chain until the tree is destroyed.
+ */
+class BLinkTree {
+  using InternalPage = BLinkInternalPage;
+  using LeafPage = BLinkLeafPage;
+
+ public:
+  explicit BLinkTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager, const KeyManager &KM,
+                     int leaf_max_size = UNDEFINED_SIZE, int internal_max_size = UNDEFINED_SIZE);
+
+  bool IsEmpty() const { return root_page_id_ == INVALID_PAGE_ID; }
+
+  // Insert a key-value pair, false if the key is already in the tree.
+  bool Insert(GenericKey *key, const RowId &value, Txn *transaction = nullptr);
+
+  // Remove a key, false if it is not in the tree.
+  bool Remove(const GenericKey *key, Txn *transaction = nullptr);
+
+  // return the value associated with a given key
+  bool GetValue(const GenericKey *key, std::vector<RowId> &result, Txn *transaction = nullptr);
+
+  /**
+   * Visit the entries in key order, starting from the first key >= low (from the smallest key if low is nullptr),
+   * until visit returns false. Leaves are read latched one at a time.
+   */
+  void Scan(const GenericKey *low, const std::function<bool(GenericKey *, const RowId &)> &visit);
+
+  // used to check whether all pages are unpinned
+  bool Check();
+
+  // destroy the tree and its record in the index roots page
+  void Destroy();
+
+ private:
+  /**
+   * Walk down to the leaf level for key (along the left most pages if key is nullptr) without latching.
+   * @param path  if not null, the inner page left on every level, from the root down
+   * @return the leaf reached, INVALID_PAGE_ID if the tree is empty
+   */
+  page_id_t FindLeaf(const GenericKey *key, std::vector<page_id_t> *path);
+
+  // Read a pinned page with read() until no writer changed it meanwhile, return what read() returned.
+  template <typename F>
+  auto ReadOptimistic(BasicPageGuard &guard, F &&read);
+
+  // Write latch page_id, then move right until the latched page covers key.
+  WritePageGuard LockCovering(page_id_t page_id, const GenericKey *key);
+
+  // Add (key, right_id) to the parent of left_id, which is on the given level (leaves are level 0).
+  void InsertIntoParent(int level, page_id_t left_id, GenericKey *key, page_id_t right_id,
+                        std::vector<page_id_t> &path);
+
+  void StartNewTree(GenericKey *key, const RowId &value);
+
+  // 叶子页面和内部页面的右链接与 high key
+  static page_id_t RightLink(BPlusTreePage *node);
+
+  static void SetRightLink(BPlusTreePage *node, page_id_t page_id);
+
+  static GenericKey *HighKey(BPlusTreePage *node);
+
+  static void SetHighKey(BPlusTreePage *node, GenericKey *key);
+
+  // whether key is beyond the range of node, i.e. it must be looked for right of it
+  bool MoveRight(BPlusTreePage *node, const GenericKey *key) const;
+
+  void UpdateRootPageId(bool insert_record);
+
+  void Destroy(page_id_t page_id);
+
+  index_id_t index_id_;
+  std::atomic<page_id_t> root_page_id_{INVALID_PAGE_ID};
+  // 只在根节点改变时使用，读者和普通的写者都不需要
+  std::mutex root_latch_;
+  BufferPoolManager *buffer_pool_manager_;
+  KeyManager processor_;
+  int leaf_max_size_;
+  int internal_max_size_;
+};
+
+#endif  // MINISQL_B_LINK_TREE_H
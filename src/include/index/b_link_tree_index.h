@@ -0,0 +1,31 @@
+#ifndef MINISQL_B_LINK_TREE_INDEX_H
+#define MINISQL_B_LINK_TREE_INDEX_H
+
+#include "index/b_link_tree.h"
+#include "index/generic_key.h"
+#include "index/index.h"
+
+/**
+ * Index on a BLinkTree, declared with `CREATE INDEX ... USING blink`. Point lookups take no latch, which suits
+ * read-heavy tables; keys are unique as in BPlusTreeIndex.
+ */
+class BLinkTreeIndex : public Index {
+ public:
+  BLinkTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size, BufferPoolManager *buffer_pool_manager);
+
+  dberr_t InsertEntry(const Row &key, RowId row_id, Txn *txn) override;
+
+  dberr_t RemoveEntry(const Row &key, RowId row_id, Txn *txn) override;
+
+  dberr_t ScanKey(const Row &key, std::vector<RowId> &result, Txn *txn, string compare_operator = "=") override;
+
+  dberr_t Destroy() override;
+
+ protected:
+  // comparator for key
+  KeyManager processor_;
+  // container
+  BLinkTree container_;
+};
+
+#endif  // MINISQL_B_LINK_TREE_INDEX_H
@@ -1,7 +1,12 @@
 #ifndef MINISQL_B_PLUS_TREE_H
 #define MINISQL_B_PLUS_TREE_H
 
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
 #include <queue>
+#include <shared_mutex>
 #include <string>
 #include <vector>
 
@@ -16,10 +21,18 @@
  *
  * Implementation of simple b+ tree data structure where internal pages direct
  * the search and leaf pages contain actual data.
- * (1) We only support unique key
+ * (1) Keys are unique, or (unique = false) several rows share a key through a PostingList
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ * (5) Pages split and merge by bytes, not entry counts: leaves prefix compress their keys and inner pages hold
+ *     separators truncated to the bytes that tell two children apart, so the fan out follows the keys
+ *
+ * Concurrency: latch crabbing. Readers hand read latches down from the root to the leaf. Writers first try an
+ * optimistic pass that read-latches the inner pages and write-latches only the leaf; when the leaf might split or
+ * merge they start over and write-latch the path from the root, releasing the ancestors as soon as a page is safe,
+ * i.e. cannot split (insert) or underflow (remove). root_latch_ guards root_page_id_ the same way a page latch guards
+ * a page. Leaves are latched left to right, the order an iterator walks them in.
  */
 class BPlusTree {
   using InternalPage = BPlusTreeInternalPage;
@@ -27,18 +40,32 @@ class BPlusTree {
 
  public:
   explicit BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager, const KeyManager &comparator,
-                     int leaf_max_size = UNDEFINED_SIZE, int internal_max_size = UNDEFINED_SIZE);
+                     int leaf_max_size = UNDEFINED_SIZE, int internal_max_size = UNDEFINED_SIZE, bool unique = true);
+
+  bool IsUnique() const { return unique_; }
 
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
 
-  // Insert a key-value pair into this B+ tree.
+  // Insert a key-value pair into this B+ tree, false if the key (the pair if not unique) is already in it.
   bool Insert(GenericKey *key, const RowId &value, Txn *transaction = nullptr);
 
-  // Remove a key and its value from this B+ tree.
+  /**
+   * Build the empty tree bottom up from entries in increasing key order: leaves are packed left to right up to
+   * fill_factor percent of their capacity, then every level of inner pages is built over the one below it.
+   * @param next  gets the next entry, false at the end; the key only has to stay valid until the next call
+   * The entries of a key shared by several rows (not unique) must come in row id order.
+   * @return false if a key is smaller than the one before it or (unique) equal, the tree is then left empty
+   */
+  bool BulkLoad(const std::function<bool(GenericKey *&, RowId &)> &next, uint32_t fill_factor);
+
+  // Remove a key and its value (every value if not unique) from this B+ tree.
   void Remove(const GenericKey *key, Txn *transaction = nullptr);
 
-  // return the value associated with a given key
+  // Remove one value of a key, the key goes with its last value.
+  void Remove(const GenericKey *key, const RowId &value, Txn *transaction = nullptr);
+
+  // return the values associated with a given key
   bool GetValue(const GenericKey *key, std::vector<RowId> &result, Txn *transaction = nullptr);
 
   IndexIterator Begin();
@@ -47,8 +74,8 @@ class BPlusTree {
 
   IndexIterator End();
 
-  // expose for test purpose
-  Page *FindLeafPage(const GenericKey *key, page_id_t page_id = INVALID_PAGE_ID, bool leftMost = false);
+  // expose for test purpose, the leaf page stays pinned (not latched) while the returned guard is alive
+  BasicPageGuard FindLeafPage(const GenericKey *key, page_id_t page_id = INVALID_PAGE_ID, bool leftMost = false);
 
   // used to check whether all pages are unpinned
   bool Check();
@@ -68,18 +95,61 @@ class BPlusTree {
   }
 
  private:
+  /**
+   * The latches one pessimistic writer holds: the root latch while the root page may change, and the write latched
+   * path from the topmost page that may still be modified down to the current page. Pages emptied by a merge are
+   * deleted once everything is released.
+   */
+  struct Context {
+    std::unique_lock<std::shared_mutex> root_lock_;
+    std::deque<WritePageGuard> write_set_;
+    std::vector<page_id_t> deleted_pages_;
+
+    // the current page is safe, nothing above it will be modified
+    void ReleaseAncestors() {
+      if (root_lock_.owns_lock()) {
+        root_lock_.unlock();
+      }
+      while (write_set_.size() > 1) {
+        write_set_.pop_front();
+      }
+    }
+  };
+
+  // whether inserting key (or removing one key) can change node without touching its parent
+  bool IsSafe(const BPlusTreePage *node, const GenericKey *key, bool insert) const;
+
+  // read latch crabbing down to the leaf holding key (or the left most leaf)
+  ReadPageGuard FindLeafRead(const GenericKey *key, bool leftMost = false);
+
+  // optimistic pass: read latches on inner pages, a write latch only on the leaf
+  WritePageGuard FindLeafOptimistic(const GenericKey *key);
+
+  // pessimistic pass: write latches from the root, released above each safe page
+  void FindLeafPessimistic(const GenericKey *key, bool insert, Context &ctx);
+
   void StartNewTree(GenericKey *key, const RowId &value);
 
-  bool InsertIntoLeaf(GenericKey *key, const RowId &value, Txn *transaction = nullptr);
+  bool InsertIntoLeaf(GenericKey *key, const RowId &value, Context &ctx, Txn *transaction = nullptr);
+
+  // 非唯一索引：把 value 加入叶子中第 index 个键的行号，已有时返回 false
+  bool AddPosting(LeafPage *leaf, int index, const RowId &value);
+
+  // 非唯一索引：从叶子中第 index 个键的行号中删除 value，返回是否要删除整个键（value 是它唯一的行号）
+  bool RemovePosting(LeafPage *leaf, int index, const RowId &value);
+
+  // value 为空时删除整个键
+  void RemoveImpl(const GenericKey *key, const RowId *value, Txn *transaction);
 
   void InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node, Txn *transaction = nullptr);
 
-  LeafPage *Split(LeafPage *node, Txn *transaction);
+  // 分裂叶子，同时把放不下的 (key, value) 放进两页之一
+  BasicPageGuard Split(LeafPage *node, GenericKey *key, const RowId &value, Txn *transaction);
 
-  InternalPage *Split(InternalPage *node, Txn *transaction);
+  BasicPageGuard Split(InternalPage *node, Txn *transaction);
 
   template <typename N>
-  bool CoalesceOrRedistribute(N *&node, Txn *transaction = nullptr);
+  bool CoalesceOrRedistribute(N *&node, Context &ctx, Txn *transaction = nullptr);
 
   bool Coalesce(InternalPage *&neighbor_node, InternalPage *&node, InternalPage *&parent, int index,
                 Txn *transaction = nullptr);
@@ -87,9 +157,13 @@ class BPlusTree {
   bool Coalesce(LeafPage *&neighbor_node, LeafPage *&node, InternalPage *&parent, int index,
                 Txn *transaction = nullptr);
 
-  void Redistribute(LeafPage *neighbor_node, LeafPage *node, int index);
+  bool Redistribute(LeafPage *neighbor_node, LeafPage *node, int index);
+
+  bool Redistribute(InternalPage *neighbor_node, InternalPage *node, int index);
 
-  void Redistribute(InternalPage *neighbor_node, InternalPage *node, int index);
+  // 叶子 left 的第 left_index 个键和 right 的第 right_index 个键之间最短的分隔键
+  void SeparatorAt(const LeafPage *left, int left_index, const LeafPage *right, int right_index,
+                   GenericKey *separator) const;
 
   bool AdjustRoot(BPlusTreePage *node);
 
@@ -102,11 +176,13 @@ class BPlusTree {
 
   // member variable
   index_id_t index_id_;
-  page_id_t root_page_id_{INVALID_PAGE_ID};
+  std::atomic<page_id_t> root_page_id_{INVALID_PAGE_ID};
+  std::shared_mutex root_latch_;
   BufferPoolManager *buffer_pool_manager_;
   KeyManager processor_;
   int leaf_max_size_;
   int internal_max_size_;
+  bool unique_;
 };
 
 #endif  // MINISQL_B_PLUS_TREE_H
@@ -1,13 +1,28 @@
 #ifndef MINISQL_B_PLUS_TREE_INDEX_H
 #define MINISQL_B_PLUS_TREE_INDEX_H
 
+#include <atomic>
+
 #include "index/b_plus_tree.h"
 #include "index/generic_key.h"
 #include "index/index.h"
+#include "index/index_range_iterator.h"
+
+class KeySorter;
 
 class BPlusTreeIndex : public Index {
  public:
-  BPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size, BufferPoolManager *buffer_pool_manager);
+  /** Pages of the table a build worker claims at a time. */
+  static constexpr size_t MORSEL_PAGES = 8;
+
+  /**
+   * With unique = false several rows may share a key, each key then keeps the posting list of its rows.
+   * entry_schema is the key schema followed by the columns stored with the key in the leaves (INCLUDE), which are
+   * not part of the key order; key_size must fit all of them. InsertEntry and RemoveEntry take rows of entry_schema,
+   * searches take rows of key_schema.
+   */
+  BPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size, BufferPoolManager *buffer_pool_manager,
+                 bool unique = true, IndexSchema *entry_schema = nullptr);
 
   dberr_t InsertEntry(const Row &key, RowId row_id, Txn *txn) override;
 
@@ -17,6 +32,26 @@ class BPlusTreeIndex : public Index {
 
   dberr_t Destroy() override;
 
+  /**
+   * Stream the row ids whose keys lie between lower and upper; a null bound leaves that side of the range open.
+   * Nothing is read ahead, so a caller that stops early does not walk the rest of the range.
+   */
+  IndexRangeIterator ScanRange(const Row *lower, bool lower_inclusive, const Row *upper, bool upper_inclusive);
+
+  IndexSchema *GetEntrySchema() const { return entry_schema_; }
+
+  /** Decode an entry key, e.g. IndexRangeIterator::GetKey(), into a row of the entry schema. */
+  void DecodeEntry(const GenericKey *key, Row &entry) const { processor_.DeserializeToKey(key, entry, entry_schema_); }
+
+  /**
+   * Sort the keys of the table (spilling to temporary pages past options.sort_memory_) and bulk load the tree. With
+   * options.threads_ above 1, workers claim morsels of MORSEL_PAGES pages and sort the keys of each into sorters of
+   * their own, sharing the memory budget; the runs of all of them are then merged into the bulk load. The stats
+   * time the scan, sort, merge and load phases apart, the sort time of workers averaged over them.
+   */
+  dberr_t Build(TableHeap *table_heap, const std::vector<uint32_t> &key_map, const IndexBuildOptions &options,
+                Txn *txn) override;
+
   IndexIterator GetBeginIterator();
 
   IndexIterator GetBeginIterator(GenericKey *key);
@@ -24,10 +59,17 @@ class BPlusTreeIndex : public Index {
   IndexIterator GetEndIterator();
 
  protected:
-  // comparator for key
+  // 扫描页面 [begin, end) 中的行，键加入 sorter；有不能放进索引的键时将 serialized 置为 false
+  void SortKeys(TableHeap *table_heap, const std::vector<uint32_t> &key_map, Txn *txn, KeySorter &sorter,
+                size_t begin, size_t end, std::atomic<bool> &serialized);
+
+  // key columns followed by the included columns
+  IndexSchema *entry_schema_;
+  // comparator for key, only the key columns take part in the comparison
   KeyManager processor_;
   // container
   BPlusTree container_;
+  BufferPoolManager *buffer_pool_manager_;
 };
 
 #endif  // MINISQL_B_PLUS_TREE_INDEX_H
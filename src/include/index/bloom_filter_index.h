@@ -0,0 +1,58 @@
+#ifndef MINISQL_BLOOM_FILTER_INDEX_H
+#define MINISQL_BLOOM_FILTER_INDEX_H
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "storage/table_heap.h"
+#include "index/index.h"
+
+/**
+ * Bloom filters over the key of a table, one per range of PAGES_PER_RANGE page ids, declared with
+ * `CREATE INDEX ... USING bloom`. It cannot find rows, it only tells that a range of pages holds no row with a given
+ * key, which lets a sequential scan on `key = constant` skip those pages.
+ *
+ * Entries are added on insert and never removed: deleted and overwritten keys stay in the filters (more false
+ * positives, never a false negative) until Rebuild() starts over from the rows of the table. The filters are kept in
+ * memory: Build() fills them when the index is created, and the catalog calls Rebuild() when it loads the index.
+ */
+class BloomFilterIndex : public Index {
+ public:
+  static constexpr uint32_t PAGES_PER_RANGE = 4;
+  static constexpr uint32_t BITS_PER_RANGE = 8 * 1024;
+  static constexpr uint32_t HASH_COUNT = 4;
+
+  /** The filters start empty, see Build() and Rebuild(). */
+  BloomFilterIndex(index_id_t index_id, IndexSchema *key_schema, Schema *table_schema, TableHeap *table_heap);
+
+  dberr_t InsertEntry(const Row &key, RowId row_id, Txn *txn) override;
+
+  /** Keys cannot be removed from a bloom filter, the entry stays until the next Rebuild(). */
+  dberr_t RemoveEntry(const Row &key, RowId row_id, Txn *txn) override;
+
+  /** Not supported, always DB_KEY_NOT_FOUND: a bloom filter cannot locate rows. */
+  dberr_t ScanKey(const Row &key, std::vector<RowId> &result, Txn *txn, string compare_operator = "=") override;
+
+  dberr_t Destroy() override;
+
+  /** Drop every filter and add the keys of the rows currently in the table. */
+  void Rebuild();
+
+  /** @return the hash of key, false if a field is null (no row can be equal to it) */
+  static bool HashKey(const Row &key, uint64_t *hash);
+
+  /** @return false if no row of the page range holding page_id has a key with this hash */
+  bool MayContain(page_id_t page_id, uint64_t hash);
+
+ private:
+  void Add(page_id_t page_id, uint64_t hash);
+
+  Schema *table_schema_;
+  TableHeap *table_heap_;
+  // 每段页面一个位图，段号为 page_id / PAGES_PER_RANGE
+  std::unordered_map<page_id_t, std::vector<uint64_t>> filters_;
+  std::mutex latch_;
+};
+
+#endif  // MINISQL_BLOOM_FILTER_INDEX_H
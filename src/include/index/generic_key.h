@@ -11,64 +11,74 @@ class GenericKey {
   char data[0];
 };
 
+/**
+ * Keys are stored in a normalized, order-preserving binary form, so that comparing two keys is one memcmp, without
+ * decoding them or allocating anything. Each column is encoded as:
+ *
+ *   | null byte (0 null, 1 not null) | value |
+ *
+ * - int: 4 bytes big-endian, sign bit flipped
+ * - float: 4 bytes big-endian, sign bit flipped for positives, every bit flipped for negatives
+ * - char(n): the bytes of the value padded with zeros to n, then as 4 bytes big-endian how many bytes of the value
+ *   follow its last nonzero byte, i.e. its trailing '\0's. Values that only differ in those sort by their length, and
+ *   an ordinary string ends in zeros whatever its length, which pages do not store (see BPlusTreeLeafPage). A value
+ *   longer than n keeps its first n bytes and counts all the bytes after them, it still compares correctly against
+ *   the stored keys but is not exact, e.g. a search key that cannot match any of them.
+ *
+ * A null value is all zeros, so nulls sort before any other value. The bytes after the encoded columns are zero.
+ */
 class KeyManager {
  public: /**/
   [[nodiscard]] inline GenericKey *InitKey() const {
     return (GenericKey *)malloc(key_size_);  // remember delete
   }
 
-  inline void SerializeFromKey(GenericKey *key_buf, const Row &key, Schema *schema) const {
-    // initialize to 0
-    [[maybe_unused]] uint32_t size = key.GetSerializedSize(schema);
-    ASSERT(key.GetFieldCount() == schema->GetColumnCount(), "field nums not match.");
-    ASSERT(size <= (uint32_t)key_size_, "Index key size exceed max key size.");
-    memset(key_buf->data, 0, key_size_);
-    key.SerializeTo(key_buf->data, schema);
-  }
+  /** @return false if a char value is longer than its column, the key is then not exact and must not be stored */
+  bool SerializeFromKey(GenericKey *key_buf, const Row &key, Schema *schema) const;
 
-  inline void DeserializeToKey(const GenericKey *key_buf, Row &key, Schema *schema) const {
-    [[maybe_unused]] uint32_t ofs = key.DeserializeFrom(const_cast<char *>(key_buf->data), schema);
-    ASSERT(ofs <= (uint32_t)key_size_, "Index key size exceed max key size.");
-  }
+  void DeserializeToKey(const GenericKey *key_buf, Row &key, Schema *schema) const;
 
   // compare
   [[nodiscard]] inline int CompareKeys(const GenericKey *lhs, const GenericKey *rhs) const {
-    //    ASSERT(malloc_usable_size((void *)&lhs) == malloc_usable_size((void *)&rhs), "key size not match.");
-    uint32_t column_count = key_schema_->GetColumnCount();
-    Row lhs_key(INVALID_ROWID);
-    Row rhs_key(INVALID_ROWID);
-    DeserializeToKey(lhs, lhs_key, key_schema_);
-    DeserializeToKey(rhs, rhs_key, key_schema_);
-
-    for (uint32_t i = 0; i < column_count; i++) {
-      Field *lhs_value = lhs_key.GetField(i);
-      Field *rhs_value = rhs_key.GetField(i);
+    return memcmp(lhs->data, rhs->data, normalized_size_);
+  }
 
-      if (lhs_value->CompareLessThan(*rhs_value) == CmpBool::kTrue) {
-        return -1;
-      }
+  /**
+   * Compare a key kept as its bytes [offset, offset + lhs_size), the bytes after them being zero, with the same bytes
+   * of rhs. Pages store keys this way, without their common prefix and their trailing zeros.
+   */
+  int CompareKeys(const char *lhs, int lhs_size, const GenericKey *rhs, int offset = 0) const;
 
-      if (lhs_value->CompareGreaterThan(*rhs_value) == CmpBool::kTrue) {
-        return 1;
-      }
-    }
-    // equals
-    return 0;
-  }
+  /**
+   * Write into separator the shortest prefix of right, zero padded, that is greater than left: every key k with
+   * left < k <= right falls on the same side of it as right. left must be smaller than right.
+   */
+  void MakeSeparator(const GenericKey *left, const GenericKey *right, GenericKey *separator) const;
 
   inline int GetKeySize() const { return key_size_; }
 
+  /** @return the number of bytes the normalized form of a key of schema takes */
+  static uint32_t GetNormalizedKeySize(const Schema *schema);
+
   KeyManager(const KeyManager &other) {
-    this->key_schema_ = other.key_schema_;
     this->key_size_ = other.key_size_;
+    this->key_schema_ = other.key_schema_;
+    this->normalized_size_ = other.normalized_size_;
   }
 
   // constructor
-  KeyManager(Schema *key_schema, size_t key_size) : key_size_(key_size), key_schema_(key_schema) {}
+  KeyManager(Schema *key_schema, size_t key_size)
+      : key_size_(key_size),
+        key_schema_(key_schema),
+        normalized_size_(key_schema == nullptr ? key_size : GetNormalizedKeySize(key_schema)) {
+    ASSERT(static_cast<int>(normalized_size_) <= key_size_, "Index key size exceed max key size.");
+  }
 
  private:
   int key_size_;
   Schema *key_schema_;
+  // 规范化编码实际占用的字节数，之后的字节都是 0，比较时不用看
+  uint32_t normalized_size_;
 };
 
 #endif  // MINISQL_GENERIC_KEY_H
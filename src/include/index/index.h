@@ -1,12 +1,42 @@
 #ifndef MINISQL_INDEX_H
 #define MINISQL_INDEX_H
 
+#include <functional>
+#include <limits>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "common/dberr.h"
 #include "concurrency/txn.h"
 #include "record/row.h"
 
+class TableHeap;
+
+/** What an index build did, filled by Index::Build() when IndexBuildOptions::stats_ is set. */
+struct IndexBuildStats {
+  size_t entries_{0};
+  uint32_t threads_{1};
+  /** Runs of sorted entries written to temporary pages */
+  size_t spilled_runs_{0};
+  /** Name and duration in milliseconds of every phase, in order */
+  std::vector<std::pair<std::string, double>> phases_;
+};
+
+/** How an index is built from the rows already in its table, see Index::Build(). */
+struct IndexBuildOptions {
+  static constexpr size_t DEFAULT_SORT_MEMORY = 16 << 20;
+
+  /** Percentage of each leaf filled by a bulk load, the rest is left for later inserts. */
+  uint32_t fill_factor_{90};
+  /** Bytes of entries sorted in memory before they are spilled to temporary pages. */
+  size_t sort_memory_{DEFAULT_SORT_MEMORY};
+  /** Number of workers that scan the table and sort the keys, if the index supports building in parallel. */
+  uint32_t threads_{1};
+  IndexBuildStats *stats_{nullptr};
+};
+
 class Index {
  public:
   explicit Index(index_id_t index_id, IndexSchema *key_schema) : index_id_(index_id), key_schema_(key_schema) {}
@@ -21,7 +51,25 @@ class Index {
 
   virtual dberr_t Destroy() = 0;
 
+  /**
+   * Add an entry for every row of table_heap to the index, which must be empty. Called once when the index is
+   * created on a table that may already hold rows. The default inserts the rows one by one.
+   * @param key_map  the columns of the table that make up the key
+   * @return DB_FAILED if a key cannot be stored (e.g. a duplicate key)
+   */
+  virtual dberr_t Build(TableHeap *table_heap, const std::vector<uint32_t> &key_map, const IndexBuildOptions &options,
+                        Txn *txn);
+
  protected:
+  /**
+   * Visit the key (columns key_map) and row id of every row of table_heap until visit returns false.
+   * @param begin, end  only scan the pages at positions [begin, end) of the page chain
+   */
+  static void ScanKeys(TableHeap *table_heap, const std::vector<uint32_t> &key_map, Txn *txn,
+                       const std::function<bool(const Row &, RowId)> &visit, size_t begin = 0,
+                       size_t end = std::numeric_limits<size_t>::max());
+
+
   index_id_t index_id_;
   IndexSchema *key_schema_;
 };
@@ -1,6 +1,9 @@
 #ifndef MINISQL_INDEX_ITERATOR_H
 #define MINISQL_INDEX_ITERATOR_H
 
+#include <vector>
+
+#include "buffer/page_guard.h"
 #include "page/b_plus_tree_leaf_page.h"
 
 class IndexIterator {
@@ -12,9 +15,19 @@ class IndexIterator {
 
   explicit IndexIterator(page_id_t page_id, BufferPoolManager *bpm, int index = 0);
 
+  // take over an already fetched leaf page, no second fetch needed
+  explicit IndexIterator(ReadPageGuard &&leaf_guard, BufferPoolManager *bpm, int index = 0);
+
+  IndexIterator(IndexIterator &&that) noexcept = default;
+
+  IndexIterator &operator=(IndexIterator &&that) noexcept = default;
+
   ~IndexIterator();
 
-  /** Return the key/value pair this iterator is currently pointing at. */
+  /**
+   * Return the key/value pair this iterator is currently pointing at. Leaves store their keys compressed, the key is
+   * copied out and stays valid until the next call.
+   */
   std::pair<GenericKey *, RowId> operator*();
 
   /** Move to the next key/value pair.*/
@@ -32,6 +45,8 @@ class IndexIterator {
   int item_index{0};
   BufferPoolManager *buffer_pool_manager{nullptr};
   // add your own private member variables here
+  ReadPageGuard page_guard;  // holds the pin and read latch of the current leaf
+  std::vector<char> key_;     // the current key at full key size
 };
 
 #endif  // MINISQL_INDEX_ITERATOR_H
@@ -0,0 +1,59 @@
+#ifndef MINISQL_INDEX_RANGE_ITERATOR_H
+#define MINISQL_INDEX_RANGE_ITERATOR_H
+
+#include <vector>
+
+#include "buffer/page_guard.h"
+#include "index/generic_key.h"
+#include "index/index_iterator.h"
+
+/**
+ * Streaming scan of the row ids of a BPlusTree whose keys lie between a lower and an upper bound, each inclusive or
+ * exclusive or open. Row ids come in key order, and in row id order within a key.
+ *
+ * Like IndexIterator it holds the read latch of one leaf at a time, and it reads posting lists page by page, so the
+ * memory it needs does not grow with the range; a caller that stops pulling stops the leaf traversal.
+ */
+class IndexRangeIterator {
+ public:
+  /** An empty range. */
+  IndexRangeIterator() = default;
+
+  /**
+   * @param begin   iterator at the first key not below the lower bound (the end iterator if there is none)
+   * @param lower   lower bound, skipped when exclusive; nullptr if open
+   * @param upper   upper bound, nullptr if open
+   */
+  IndexRangeIterator(IndexIterator &&begin, const KeyManager &processor, BufferPoolManager *buffer_pool_manager,
+                     const GenericKey *lower, bool lower_inclusive, const GenericKey *upper, bool upper_inclusive);
+
+  IndexRangeIterator(IndexRangeIterator &&that) noexcept = default;
+
+  IndexRangeIterator &operator=(IndexRangeIterator &&that) noexcept = default;
+
+  /** @return false once the range is exhausted, the leaf latch is then released */
+  bool Next(RowId &rid);
+
+  /** @return the key of the row id last returned by Next(), with the columns stored after it in the leaf */
+  const GenericKey *GetKey() const { return reinterpret_cast<const GenericKey *>(key_.data()); }
+
+ private:
+  bool InRange(const GenericKey *key) const;
+
+  // 范围结束时释放叶子的读锁
+  void Finish();
+
+  IndexIterator iter_;
+  const KeyManager *processor_{nullptr};
+  BufferPoolManager *buffer_pool_manager_{nullptr};
+  std::vector<char> upper_;  // 为空时没有上界
+  bool upper_inclusive_{true};
+  // 最近返回的行号的键，叶子可能已经换掉了，所以复制出来
+  std::vector<char> key_;
+  // 正在读的 posting list 页面，受叶子的读锁保护
+  BasicPageGuard posting_guard_;
+  uint32_t posting_pos_{0};
+  bool done_{true};
+};
+
+#endif  // MINISQL_INDEX_RANGE_ITERATOR_H
@@ -0,0 +1,110 @@
+#ifndef MINISQL_KEY_SORTER_H
+#define MINISQL_KEY_SORTER_H
+
+#include <chrono>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "index/generic_key.h"
+
+/**
+ * External sort of (key, RowId) entries, the input of a bottom up index build.
+ *
+ * Entries are collected in memory until they take more than the memory budget, then sorted and written out as a run
+ * of temporary pages. Finish() merges the runs (several passes if there are more than MAX_MERGE_WIDTH of them, so
+ * that only a bounded number of pages is pinned at once) and Next() returns the entries in key order, ties broken by
+ * row id. Temporary pages go through the buffer pool, which writes them to disk only when it runs short of frames,
+ * and are deleted as soon as they are read.
+ *
+ * For a parallel build every worker fills a sorter of its own and Seal()s it, then one sorter Absorb()s the runs of
+ * all of them and merges them together.
+ */
+class KeySorter {
+ public:
+  static constexpr size_t MAX_MERGE_WIDTH = 16;
+
+  KeySorter(BufferPoolManager *buffer_pool_manager, const KeyManager &KM, size_t memory_limit);
+
+  ~KeySorter();
+
+  DISALLOW_COPY(KeySorter)
+
+  void Add(const GenericKey *key, const RowId &rid);
+
+  /** Sort the entries still in memory into a run of their own, which stays in memory. */
+  void Seal();
+
+  /** Take over the runs of other, which must be sealed and is left empty. */
+  void Absorb(KeySorter &other);
+
+  /** Sort what was added, no more entries can be added afterwards. */
+  void Finish();
+
+  /**
+   * Get the next entry in order, key points into the sorter and is valid until the next call.
+   * @return false when every entry has been returned
+   */
+  bool Next(GenericKey *&key, RowId &rid);
+
+  inline size_t GetEntryCount() const { return entry_count_; }
+
+  /** @return the number of runs spilled to temporary pages, 0 if everything was sorted in memory */
+  inline size_t GetSpilledRunCount() const { return spilled_runs_; }
+
+  /** @return milliseconds spent sorting entries into runs, summed over the absorbed sorters */
+  inline double GetSortTime() const { return sort_ms_; }
+
+  /** @return milliseconds spent merging the runs, in Finish() and Next() */
+  inline double GetMergeTime() const { return merge_ms_; }
+
+ private:
+  /** A sorted run, on temporary pages or (pages_ empty) in data_. */
+  struct Run {
+    std::vector<page_id_t> pages_;
+    std::vector<char> data_;
+    size_t size_{0};
+    size_t pos_{0};
+    BasicPageGuard guard_;
+  };
+
+  // 比较两个条目：先比较键，键相同时比较 RowId
+  int Compare(const char *lhs, const char *rhs) const;
+
+  // 内存中的条目排好序后写成一个溢出段
+  void Spill();
+
+  // 返回内存中条目排序后的下标
+  std::vector<uint32_t> SortBuffer() const;
+
+  // 将 runs_ 中 [begin, end) 的段归并成一个新的溢出段
+  Run Merge(size_t begin, size_t end);
+
+  // 在溢出段末尾追加一个条目，guard 持有段的最后一页
+  void Append(Run &run, BasicPageGuard &guard, const char *entry);
+
+  const char *Current(Run &run);
+
+  // 从 start 到现在的毫秒数
+  static double ElapsedMs(std::chrono::steady_clock::time_point start);
+
+  void Advance(Run &run);
+
+  BufferPoolManager *buffer_pool_manager_;
+  KeyManager processor_;
+  size_t memory_limit_;
+  size_t entry_size_;
+  size_t entries_per_page_;
+  // 内存中尚未排序的条目
+  std::vector<char> buffer_;
+  std::vector<Run> runs_;
+  // 最后一轮归并：按各段当前条目排序的小顶堆
+  std::vector<size_t> heap_;
+  std::vector<char> current_;
+  size_t entry_count_{0};
+  size_t spilled_runs_{0};
+  double sort_ms_{0};
+  double merge_ms_{0};
+  bool finished_{false};
+};
+
+#endif  // MINISQL_KEY_SORTER_H
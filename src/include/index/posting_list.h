@@ -0,0 +1,45 @@
+#ifndef MINISQL_POSTING_LIST_H
+#define MINISQL_POSTING_LIST_H
+
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/rowid.h"
+
+/**
+ * Posting lists of a non-unique B+ tree index. The value of a leaf entry is the row id itself while only one row has
+ * the key; from the second row on, the row ids move to a chain of PostingPages and the value becomes a reference to
+ * its first page: RowId(first page id, LIST_SLOT). The first page stays the same for the whole life of the list, and
+ * when removes leave a single row id, it goes back into the leaf.
+ *
+ * The pages of a list are only pinned, never latched: they are reached through their leaf entry, and the latch of the
+ * leaf (read to read the list, write to change it) covers them.
+ */
+class PostingList {
+ public:
+  /** Slot number marking a reference to a posting list, no table page has that many slots. */
+  static constexpr uint32_t LIST_SLOT = UINT32_MAX;
+
+  static bool IsList(const RowId &value) { return value.GetSlotNum() == LIST_SLOT; }
+
+  /** Write a list holding rids, which must be sorted and at least two, and return the reference to it. */
+  static RowId Create(BufferPoolManager *buffer_pool_manager, const std::vector<RowId> &rids);
+
+  /** @return false if rid is already in the list */
+  static bool Insert(BufferPoolManager *buffer_pool_manager, const RowId &list, const RowId &rid);
+
+  /**
+   * Remove rid from the list.
+   * @param only  set to the row id left when there is only one, the list is then freed; INVALID_ROWID otherwise
+   * @return false if rid is not in the list
+   */
+  static bool Remove(BufferPoolManager *buffer_pool_manager, const RowId &list, const RowId &rid, RowId *only);
+
+  /** Append the row ids of the list to result, in order. */
+  static void Collect(BufferPoolManager *buffer_pool_manager, const RowId &list, std::vector<RowId> &result);
+
+  /** Free the pages of the list. */
+  static void Destroy(BufferPoolManager *buffer_pool_manager, const RowId &list);
+};
+
+#endif  // MINISQL_POSTING_LIST_H
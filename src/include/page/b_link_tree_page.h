@@ -0,0 +1,90 @@
+#ifndef MINISQL_B_LINK_TREE_PAGE_H
+#define MINISQL_B_LINK_TREE_PAGE_H
+
+#include "index/generic_key.h"
+#include "page/b_plus_tree_page.h"
+
+#define B_LINK_LEAF_PAGE_HEADER_SIZE 32
+#define B_LINK_INTERNAL_PAGE_HEADER_SIZE 28
+
+/**
+ * Pages of the B-link tree. Unlike the B+ tree pages they keep every key at full key size in fixed slots: readers of
+ * a B-link tree take no latch and may read a page while it is being written, so a key must always be found at the
+ * same place, whatever the writer is doing, for the version check to catch the change afterwards.
+ *
+ * Leaf page format:
+ *  -------------------------------------------------------------------------
+ * | HEADER (28) | NextPageId (4) | KEY(1) + RID(1) | ... | KEY(n) + RID(n) |
+ *  -------------------------------------------------------------------------
+ *
+ * Internal page format, the first key is invalid as in the B+ tree:
+ *  -----------------------------------------------------------------
+ * | HEADER (28) | KEY(0) + PAGE_ID(0) | ... | KEY(n) + PAGE_ID(n) |
+ *  -----------------------------------------------------------------
+ */
+class BLinkLeafPage : public BPlusTreePage {
+ public:
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int key_size = UNDEFINED_SIZE,
+            int max_size = UNDEFINED_SIZE);
+
+  page_id_t GetNextPageId() const { return next_page_id_; }
+
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  GenericKey *KeyAt(int index);
+
+  void SetKeyAt(int index, const GenericKey *key);
+
+  RowId ValueAt(int index) const;
+
+  void SetValueAt(int index, RowId value);
+
+  // the first index whose key is not below key
+  int KeyIndex(const GenericKey *key, const KeyManager &KM);
+
+  // @return page size after insertion, unchanged if key is already there
+  int Insert(const GenericKey *key, const RowId &value, const KeyManager &KM);
+
+  bool Lookup(const GenericKey *key, RowId &value, const KeyManager &KM);
+
+  // @return page size after deletion
+  int RemoveAndDeleteRecord(const GenericKey *key, const KeyManager &KM);
+
+  void MoveHalfTo(BLinkLeafPage *recipient);
+
+ private:
+  char *PairPtrAt(int index) { return data_ + index * (GetKeySize() + sizeof(RowId)); }
+
+  page_id_t next_page_id_{INVALID_PAGE_ID};
+  char data_[0];
+};
+
+class BLinkInternalPage : public BPlusTreePage {
+ public:
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int key_size = UNDEFINED_SIZE,
+            int max_size = UNDEFINED_SIZE);
+
+  GenericKey *KeyAt(int index);
+
+  void SetKeyAt(int index, const GenericKey *key);
+
+  page_id_t ValueAt(int index) const;
+
+  void SetValueAt(int index, page_id_t value);
+
+  page_id_t Lookup(const GenericKey *key, const KeyManager &KM);
+
+  void PopulateNewRoot(const page_id_t &old_value, const GenericKey *new_key, const page_id_t &new_value);
+
+  // insert (new_key, new_value) right after the entry of old_value, @return new size
+  int InsertNodeAfter(const page_id_t &old_value, const GenericKey *new_key, const page_id_t &new_value);
+
+  void MoveHalfTo(BLinkInternalPage *recipient);
+
+ private:
+  char *PairPtrAt(int index) { return data_ + index * (GetKeySize() + sizeof(page_id_t)); }
+
+  char data_[0];
+};
+
+#endif  // MINISQL_B_LINK_TREE_PAGE_H
@@ -8,7 +8,7 @@
 #include "index/generic_key.h"
 #include "page/b_plus_tree_page.h"
 
-#define INTERNAL_PAGE_HEADER_SIZE 28
+#define INTERNAL_PAGE_HEADER_SIZE 40
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
  * Pointer PAGE_ID(i) points to a subtree in which all keys K satisfy:
@@ -17,20 +17,32 @@
  * the first key always remains invalid. That is to say, any search/lookup
  * should ignore the first key.
  *
- * Internal page format (keys are stored in increasing order):
- *  --------------------------------------------------------------------------
- * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
- *  --------------------------------------------------------------------------
+ * Keys are stored without their trailing zeros. The tree only pushes up separators truncated to the bytes that tell
+ * the two children apart (see KeyManager::MakeSeparator), so most keys take a few bytes and the fan out depends on
+ * the keys, not on the key size: the page is full when a key of full key size might not fit any more (or when it
+ * holds max size entries, if a max size was given). Slots grow from the front of the page and key bytes from its end.
+ *
+ * Internal page format (slots are stored in increasing key order):
+ *  -------------------------------------------------------------------------------
+ * | HEADER | SLOT(0) | SLOT(1) | ... | SLOT(n) | free space | KEY BYTES (any order) |
+ *  -------------------------------------------------------------------------------
+ *  SLOT: | KeyOffset (2) | KeySize (2) | PAGE_ID (4) |
+ *
+ *  Header: | BPlusTreePage header (28) | DataSize (4) | KeyBegin (4) | KeyBytes (4) |
  */
 class BPlusTreeInternalPage : public BPlusTreePage {
  public:
+  static constexpr int SLOT_SIZE = 2 * sizeof(uint16_t) + sizeof(page_id_t);
+
   // must call initialize method after "create" a new node
   void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int key_size = UNDEFINED_SIZE,
-            int max_size = UNDEFINED_SIZE);
+            int max_size = UNDEFINED_SIZE, int page_size = PAGE_SIZE);
 
-  GenericKey *KeyAt(int index);
+  // copy the key at index, at full key size, into key
+  void KeyAt(int index, GenericKey *key) const;
 
-  void SetKeyAt(int index, GenericKey *key);
+  // the page must have room for key (CanSetKeyAt); nullptr stores an empty key, for the invalid first key
+  void SetKeyAt(int index, const GenericKey *key);
 
   int ValueIndex(const page_id_t &value) const;
 
@@ -38,39 +50,82 @@ class BPlusTreeInternalPage : public BPlusTreePage {
 
   void SetValueAt(int index, page_id_t value);
 
-  void *PairPtrAt(int index);
+  page_id_t Lookup(const GenericKey *key, const KeyManager &KP) const;
+
+  // bytes after the header, and how many of them the slots and the keys use
+  int GetDataSize() const { return data_size_; }
+
+  int GetUsedSize() const { return GetSize() * SLOT_SIZE + key_bytes_; }
+
+  // the page must split: one more entry might not fit
+  bool IsFull() const;
+
+  // whether the page takes one more entry with key without becoming full, nullptr standing for any key
+  bool CanInsert(const GenericKey *key) const;
+
+  bool CanSetKeyAt(int index, const GenericKey *key) const;
 
-  void PairCopy(void *dest, void *src, int pair_num = 1);
+  // fewer than min size entries and less than half of the bytes used
+  bool IsUnderflow() const;
 
-  page_id_t Lookup(const GenericKey *key, const KeyManager &KP);
+  // whether removing any one entry leaves the page out of underflow
+  bool CanRemove() const;
 
-  void PopulateNewRoot(const page_id_t &old_value, GenericKey *new_key, const page_id_t &new_value);
+  // whether the entry at index can go to a sibling without leaving the page in underflow
+  bool CanLend(int index) const;
 
-  int InsertNodeAfter(const page_id_t &old_value, GenericKey *new_key, const page_id_t &new_value);
+  void PopulateNewRoot(const page_id_t &old_value, const GenericKey *new_key, const page_id_t &new_value);
+
+  // the page must not be full
+  int InsertNodeAfter(const page_id_t &old_value, const GenericKey *new_key, const page_id_t &new_value);
 
   void Remove(int index);
 
   page_id_t RemoveAndReturnOnlyChild();
 
   // Split and Merge utility methods
-  void MoveAllTo(BPlusTreeInternalPage *recipient, GenericKey *middle_key, BufferPoolManager *buffer_pool_manager);
+  // @return false, with nothing moved, if the entries of both pages and middle_key do not fit in recipient
+  bool MoveAllTo(BPlusTreeInternalPage *recipient, const GenericKey *middle_key,
+                 BufferPoolManager *buffer_pool_manager);
 
+  // move the entries after the split point, which evens out the bytes of the two pages, to the empty recipient
   void MoveHalfTo(BPlusTreeInternalPage *recipient, BufferPoolManager *buffer_pool_manager);
 
-  void MoveFirstToEndOf(BPlusTreeInternalPage *recipient, GenericKey *middle_key,
+  // recipient must have room for middle_key (CanInsert)
+  void MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const GenericKey *middle_key,
                         BufferPoolManager *buffer_pool_manager);
 
-  void MoveLastToFrontOf(BPlusTreeInternalPage *recipient, GenericKey *middle_key,
+  void MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const GenericKey *middle_key,
                          BufferPoolManager *buffer_pool_manager);
   page_id_t LeftMostKeyFromCurr(BufferPoolManager *buffer_pool_manager);
+
+  // append size pairs of a full key and a page id, and make this page the parent of their children, used by bulk
+  // loading
+  void CopyNFrom(const void *src, int size, BufferPoolManager *buffer_pool_manager);
+
  private:
-  void CopyNFrom(void *src, int size, BufferPoolManager *buffer_pool_manager);
+  char *SlotAt(int index) { return data_ + index * SLOT_SIZE; }
+
+  const char *SlotAt(int index) const { return data_ + index * SLOT_SIZE; }
+
+  int KeyOffsetAt(int index) const;
+
+  int KeySizeAt(int index) const;
+
+  void SetSlotAt(int index, int key_offset, int key_size);
+
+  // 插入 key_size 字节的键，空间不连续时先整理键区
+  void InsertAt(int index, const char *key, int key_size, page_id_t value);
 
-  void CopyLastFrom(GenericKey *key, page_id_t value, BufferPoolManager *buffer_pool_manager);
+  // 把键区挪到页面末尾，去掉删除留下的空洞
+  void Compact();
 
-  void CopyFirstFrom(page_id_t value, BufferPoolManager *buffer_pool_manager);
+  void Adopt(page_id_t child_page_id, BufferPoolManager *buffer_pool_manager);
 
-  char data_[PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE];
+  int data_size_;
+  int key_begin_;
+  int key_bytes_;
+  char data_[0];  // slots and keys, up to the end of the page whatever its size
 };
 
 using InternalPage = BPlusTreeInternalPage;
@@ -6,83 +6,136 @@
  *
  * Store indexed key and record id(record id = page id combined with slot id,
  * see include/common/rid.h for detailed implementation) together within leaf
- * page. Only support unique key.
-
- * Leaf page format (keys are stored in order):
- *  ----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
- *  ----------------------------------------------------------------------
+ * page. Each key appears once: in a non-unique tree the record id of a key
+ * shared by several rows points to their PostingList instead.
+ *
+ * Keys are prefix compressed: the bytes that all keys of the page share are stored once, and each key keeps only the
+ * bytes after them, without its trailing zeros. Slots grow from the front of the page and the key bytes from its end,
+ * so every entry takes as many bytes as its key needs and the page splits when its bytes run out (or when it holds
+ * max size entries, if a max size was given).
+ *
+ * Leaf page format (slots are stored in key order):
+ *  ------------------------------------------------------------------------------------------
+ * | HEADER | PREFIX | SLOT(1) | SLOT(2) | ... | SLOT(n) | free space | KEY BYTES (any order) |
+ *  ------------------------------------------------------------------------------------------
+ *  SLOT: | KeyOffset (2) | KeySize (2) | RID (8) |
  *
- *  Header format (size in byte, 24 bytes in total):
- *  ---------------------------------------------------------------------
- * | PageType (4) | CurrentSize (4) | MaxSize (4) | ParentPageId (4) |
- *  ---------------------------------------------------------------------
- *  ------------------------------
- * | PageId (4) | NextPageId (4)
- *  ------------------------------
+ *  Header format (size in byte, 48 bytes in total):
+ *  ------------------------------------------------------------------------------------
+ * | BPlusTreePage header (28) | NextPageId (4) | DataSize (4) | PrefixSize (4) |
+ *  ------------------------------------------------------------------------------------
+ * | KeyBegin (4) | KeyBytes (4) |
+ *  ------------------------------------------------------------------------------------
  */
-#include <utility>
 #include <vector>
 
 #include "index/generic_key.h"
 #include "page/b_plus_tree_page.h"
 
-#define LEAF_PAGE_HEADER_SIZE 32
+#define LEAF_PAGE_HEADER_SIZE 48
 
 class BPlusTreeLeafPage : public BPlusTreePage {
  public:
+  static constexpr int SLOT_SIZE = 2 * sizeof(uint16_t) + sizeof(RowId);
+
   // After creating a new leaf page from buffer pool, must call initialize
   // method to set default values
   void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int key_size = UNDEFINED_SIZE,
-            int max_size = UNDEFINED_SIZE);
+            int max_size = UNDEFINED_SIZE, int page_size = PAGE_SIZE);
 
   // helper methods
   page_id_t GetNextPageId() const;
 
   void SetNextPageId(page_id_t next_page_id);
 
-  GenericKey *KeyAt(int index);
-
-  void SetKeyAt(int index, GenericKey *key);
+  // copy the key at index, at full key size, into key
+  void KeyAt(int index, GenericKey *key) const;
 
   RowId ValueAt(int index) const;
 
   void SetValueAt(int index, RowId value);
 
-  int KeyIndex(const GenericKey *key, const KeyManager &comparator);
+  int KeyIndex(const GenericKey *key, const KeyManager &comparator) const;
+
+  // compare the key at index with key, without copying it
+  int CompareAt(int index, const GenericKey *key, const KeyManager &comparator) const;
+
+  // bytes after the header, and how many of them the prefix, the slots and the keys use
+  int GetDataSize() const { return data_size_; }
+
+  int GetUsedSize() const { return prefix_size_ + GetSize() * SLOT_SIZE + key_bytes_; }
+
+  int GetPrefixSize() const { return prefix_size_; }
+
+  // whether key fits in the page, the prefix shrinking if key does not share it
+  bool CanInsert(const GenericKey *key) const;
 
-  void *PairPtrAt(int index);
+  // fewer than min size entries and less than half of the bytes used
+  bool IsUnderflow() const;
 
-  void PairCopy(void *dest, void *src, int pair_num = 1);
+  // whether removing any one entry leaves the page out of underflow
+  bool CanRemove() const;
 
-  std::pair<GenericKey *, RowId> GetItem(int index);
+  // whether the entry at index can go to a sibling without leaving the page in underflow
+  bool CanLend(int index) const;
 
   // insert and delete methods
-  int Insert(GenericKey *key, const RowId &value, const KeyManager &comparator);
+  int Insert(const GenericKey *key, const RowId &value, const KeyManager &comparator);
 
-  bool Lookup(const GenericKey *key, RowId &value, const KeyManager &comparator);
+  bool Lookup(const GenericKey *key, RowId &value, const KeyManager &comparator) const;
 
   int RemoveAndDeleteRecord(const GenericKey *key, const KeyManager &comparator);
 
   // Split and Merge utility methods
-  void MoveHalfTo(BPlusTreeLeafPage *recipient);
+  /**
+   * Split the entries of this full page plus (key, value) with recipient, an empty page on its right. The split point
+   * evens out the bytes of the two pages, each with its own prefix.
+   */
+  void MoveHalfTo(BPlusTreeLeafPage *recipient, const GenericKey *key, const RowId &value,
+                  const KeyManager &comparator);
 
-  void MoveAllTo(BPlusTreeLeafPage *recipient);
+  // @return false, with nothing moved, if the entries of both pages do not fit in recipient
+  bool MoveAllTo(BPlusTreeLeafPage *recipient);
 
-  void MoveFirstToEndOf(BPlusTreeLeafPage *recipient);
+  // @return false, with nothing moved, if the entry does not fit in recipient
+  bool MoveFirstToEndOf(BPlusTreeLeafPage *recipient, const KeyManager &comparator);
 
-  void MoveLastToFrontOf(BPlusTreeLeafPage *recipient);
+  bool MoveLastToFrontOf(BPlusTreeLeafPage *recipient, const KeyManager &comparator);
 
  private:
-  void CopyNFrom(void *src, int size);
+  char *SlotAt(int index) { return data_ + prefix_size_ + index * SLOT_SIZE; }
 
-  void CopyLastFrom(GenericKey *key, const RowId value);
+  const char *SlotAt(int index) const { return data_ + prefix_size_ + index * SLOT_SIZE; }
 
-  void CopyFirstFrom(GenericKey *key, const RowId value);
+  int KeyOffsetAt(int index) const;
 
-  page_id_t next_page_id_{INVALID_PAGE_ID};
+  int KeySizeAt(int index) const;
+
+  void SetSlotAt(int index, int key_offset, int key_size, const RowId &value);
+
+  // 新键加入后整页共用的前缀长度
+  int PrefixWith(const GenericKey *key) const;
+
+  void RemoveAt(int index);
+
+  // 把所有条目展开成 (完整的键, 行号) 追加到 pairs，或者用这样的条目重写整个页面
+  void Unpack(std::vector<char> &pairs) const;
 
-  char data_[PAGE_SIZE - LEAF_PAGE_HEADER_SIZE];
+  void Pack(const char *pairs, int count);
+
+  // 这些条目共用的前缀：首尾两个键的公共前缀，且不超过任何一个键去掉末尾 0 之后的长度
+  int PrefixOf(const char *pairs, int count) const;
+
+  // Pack 这些条目要用的字节数
+  int PackedSize(const char *pairs, int count) const;
+
+  page_id_t next_page_id_{INVALID_PAGE_ID};
+  int data_size_;
+  int prefix_size_;
+  // 键区从 key_begin_ 到页面末尾，删除留下的空洞在放不下新键时才整理
+  int key_begin_;
+  int key_bytes_;
+  char data_[0];  // prefix, slots and keys, up to the end of the page whatever its size
 };
 
 using LeafPage = BPlusTreeLeafPage;
@@ -59,6 +59,12 @@ class BPlusTreePage {
 
   void SetLSN(lsn_t lsn = INVALID_LSN);
 
+  // the size of key without its trailing zeros, the bytes a page stores of it
+  static int SignificantSize(const char *key, int key_size);
+
+ protected:
+  static int CommonPrefix(const char *lhs, const char *rhs, int size);
+
  private:
   // member variable, attributes that both internal and leaf page share
   [[maybe_unused]] IndexPageType page_type_;
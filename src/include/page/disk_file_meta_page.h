@@ -5,10 +5,30 @@
 
 #include "page/bitmap_page.h"
 
-static constexpr page_id_t MAX_VALID_PAGE_ID = (PAGE_SIZE - 8) / 4 * BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
-
+/**
+ * The first physical page of a database file. It is as large as the other pages of the file, the page size itself
+ * is recorded in the header so that the file can be reopened without knowing it in advance.
+ *
+ * Format (size in bytes):
+ *  -----------------------------------------------------------------------------------------
+ *  | Magic (4) | PageSize (4) | AllocatedPages (4) | Extents (4) | ExtentUsedPage (4) | ... |
+ *  -----------------------------------------------------------------------------------------
+ */
 class DiskFileMetaPage {
  public:
+  static constexpr uint32_t MAGIC = 0x4C51534D;  // "MSQL"
+  static constexpr uint32_t SIZE_HEADER = 16;
+  // files written before the page size was recorded: | AllocatedPages (4) | Extents (4) | ExtentUsedPage (4) | ... |
+  static constexpr uint32_t SIZE_LEGACY_HEADER = 8;
+
+  /** @return how many extents a meta page of page_size bytes can keep track of */
+  static constexpr uint32_t GetMaxExtentNums(uint32_t page_size) { return (page_size - SIZE_HEADER) / 4; }
+
+  /** @return true if the page carries the header above, false if it is a legacy or an empty meta page */
+  bool IsTagged() const { return magic_ == MAGIC; }
+
+  uint32_t GetPageSize() { return page_size_; }
+
   uint32_t GetExtentNums() { return num_extents_; }
 
   uint32_t GetAllocatedPages() { return num_allocated_pages_; }
@@ -21,6 +41,8 @@ class DiskFileMetaPage {
   }
 
  public:
+  uint32_t magic_{0};
+  uint32_t page_size_{0};
   uint32_t num_allocated_pages_{0};
   uint32_t num_extents_{0};  // each extent consists with a bit map and BIT_MAP_SIZE pages
   uint32_t extent_used_page_[0];
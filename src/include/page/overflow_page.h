@@ -0,0 +1,45 @@
+#ifndef MINISQL_OVERFLOW_PAGE_H
+#define MINISQL_OVERFLOW_PAGE_H
+
+#include <cstring>
+
+#include "common/macros.h"
+#include "page/page.h"
+
+/**
+ * A page of the chain holding a char value too long to be kept inside its row. The row only keeps the length of
+ * the value and the id of the first page of the chain.
+ *
+ * Format (size in bytes):
+ *  ----------------------------------------------
+ *  | NextPageId (4) | DataSize (4) | Data ... |
+ *  ----------------------------------------------
+ */
+class OverflowPage : public Page {
+ public:
+  void Init(page_id_t next_page_id, const char *data, uint32_t size) {
+    ASSERT(size <= GetCapacity(GetPageSize()), "Overflow page data exceeds page size.");
+    memcpy(GetData() + OFFSET_NEXT_PAGE_ID, &next_page_id, sizeof(page_id_t));
+    memcpy(GetData() + OFFSET_DATA_SIZE, &size, sizeof(uint32_t));
+    memcpy(GetData() + SIZE_HEADER, data, size);
+  }
+
+  page_id_t GetNextPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
+
+  uint32_t GetDataSize() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_DATA_SIZE); }
+
+  const char *GetValueData() { return GetData() + SIZE_HEADER; }
+
+  /** @return how many bytes of a value one overflow page of page_size bytes holds */
+  static constexpr uint32_t GetCapacity(uint32_t page_size) { return page_size - SIZE_HEADER; }
+
+  /** @return the length above which a char value is moved out of its row, a quarter of the page */
+  static constexpr uint32_t GetInlineLimit(uint32_t page_size) { return page_size / 4; }
+
+ private:
+  static constexpr uint32_t OFFSET_NEXT_PAGE_ID = 0;
+  static constexpr uint32_t OFFSET_DATA_SIZE = 4;
+  static constexpr uint32_t SIZE_HEADER = 8;
+};
+
+#endif  // MINISQL_OVERFLOW_PAGE_H
@@ -1,8 +1,10 @@
 #ifndef MINISQL_PAGE_H
 #define MINISQL_PAGE_H
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <shared_mutex>
 
 #include "common/config.h"
@@ -20,14 +22,20 @@ class Page {
  public:
   DISALLOW_COPY(Page)
 
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor. Allocates a page of the default size and zeros out the page data. */
+  Page() : Page(PAGE_SIZE) {}
+
+  /** Constructor. Allocates a page of page_size bytes and zeros out the page data. */
+  explicit Page(uint32_t page_size) : data_(new char[page_size]), page_size_(page_size) { ResetMemory(); }
 
   /** Default destructor. */
   ~Page() = default;
 
   /** @return the actual data contained within this page */
-  inline char *GetData() { return data_; }
+  inline char *GetData() { return data_.get(); }
+
+  /** @return the size of the page data in bytes, it is the page size of the database file the page belongs to */
+  inline uint32_t GetPageSize() const { return page_size_; }
 
   /** @return the page id of this page */
   inline page_id_t GetPageId() { return page_id_; }
@@ -39,14 +47,39 @@ class Page {
   inline bool IsDirty() { return is_dirty_; }
 
   /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  inline void WLatch() {
+    rwlatch_.WLock();
+    version_.fetch_add(1, std::memory_order_acq_rel);
+  }
+
+  /** @return true if the page write latch was free and is now held, false without waiting otherwise */
+  inline bool TryWLatch() {
+    if (!rwlatch_.TryWLock()) {
+      return false;
+    }
+    version_.fetch_add(1, std::memory_order_acq_rel);
+    return true;
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  inline void WUnlatch() {
+    version_.fetch_add(1, std::memory_order_release);
+    rwlatch_.WUnlock();
+  }
+
+  /**
+   * Version for readers that only pin the page instead of latching it: odd while the write latch is held, bumped
+   * when it is taken and when it is released. A reader that sees the same even version before and after reading the
+   * page has read a consistent state.
+   */
+  inline uint64_t GetVersion() const { return version_.load(std::memory_order_acquire); }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
 
+  /** @return true if the page read latch is now held, false without waiting if it cannot be shared now */
+  inline bool TryRLatch() { return rwlatch_.TryRLock(); }
+
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
@@ -66,10 +99,19 @@ class Page {
 
  private:
   /** Zeroes out the data that is held within the page. */
-  inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
+  inline void ResetMemory() { memset(data_.get(), OFFSET_PAGE_START, page_size_); }
+
+  /** Re-allocate the page data for another page size, used by the buffer pool before any page is cached. */
+  inline void Resize(uint32_t page_size) {
+    data_.reset(new char[page_size]);
+    page_size_ = page_size;
+    ResetMemory();
+  }
 
   /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  std::unique_ptr<char[]> data_;
+  /** The size of data_ in bytes. */
+  uint32_t page_size_;
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
   /** The pin count of this page. */
@@ -78,6 +120,8 @@ class Page {
   bool is_dirty_ = false;
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
+  /** See GetVersion(). */
+  std::atomic<uint64_t> version_{0};
 };
 
 #endif  // MINISQL_PAGE_H
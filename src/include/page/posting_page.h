@@ -0,0 +1,84 @@
+#ifndef MINISQL_POSTING_PAGE_H
+#define MINISQL_POSTING_PAGE_H
+
+#include <cstring>
+
+#include "common/config.h"
+#include "common/rowid.h"
+
+/**
+ * A page of the posting list of a key of a non-unique B+ tree index: the row ids with that key, sorted, continued on
+ * the next page of the chain. Every row id of a page is smaller than those of the pages after it.
+ *
+ * Format (size in bytes):
+ *  ------------------------------------------------------------
+ *  | NextPageId (4) | Size (4) | RowId(1) (8) | RowId(2) | ... |
+ *  ------------------------------------------------------------
+ */
+class PostingPage {
+ public:
+  void Init(page_id_t next_page_id) {
+    next_page_id_ = next_page_id;
+    size_ = 0;
+  }
+
+  page_id_t GetNextPageId() const { return next_page_id_; }
+
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  uint32_t GetSize() const { return size_; }
+
+  void SetSize(uint32_t size) { size_ = size; }
+
+  RowId RowIdAt(uint32_t index) const {
+    RowId rid;
+    memcpy(&rid, data_ + index * sizeof(RowId), sizeof(RowId));
+    return rid;
+  }
+
+  void SetRowIdAt(uint32_t index, const RowId &rid) { memcpy(data_ + index * sizeof(RowId), &rid, sizeof(RowId)); }
+
+  /** @return the position of the first row id not below rid */
+  uint32_t LowerBound(const RowId &rid) const {
+    uint32_t low = 0, high = size_;
+    while (low < high) {
+      uint32_t mid = (low + high) / 2;
+      if (RowIdAt(mid).Get() < rid.Get()) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    return low;
+  }
+
+  /** Insert rid at index, the page must not be full. */
+  void InsertAt(uint32_t index, const RowId &rid) {
+    memmove(data_ + (index + 1) * sizeof(RowId), data_ + index * sizeof(RowId), (size_ - index) * sizeof(RowId));
+    SetRowIdAt(index, rid);
+    size_++;
+  }
+
+  void RemoveAt(uint32_t index) {
+    memmove(data_ + index * sizeof(RowId), data_ + (index + 1) * sizeof(RowId), (size_ - index - 1) * sizeof(RowId));
+    size_--;
+  }
+
+  /** Append the row ids [begin, end) of src. */
+  void CopyFrom(const PostingPage *src, uint32_t begin, uint32_t end) {
+    memcpy(data_ + size_ * sizeof(RowId), src->data_ + begin * sizeof(RowId), (end - begin) * sizeof(RowId));
+    size_ += end - begin;
+  }
+
+  /** @return how many row ids a posting page of page_size bytes holds */
+  static constexpr uint32_t GetCapacity(uint32_t page_size) {
+    return (page_size - sizeof(page_id_t) - sizeof(uint32_t)) / sizeof(RowId);
+  }
+
+ private:
+  page_id_t next_page_id_;
+  uint32_t size_;
+  char data_[0];
+};
+
+#endif  // MINISQL_POSTING_PAGE_H
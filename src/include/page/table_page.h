@@ -12,9 +12,27 @@
  *  ----------------------------------------------------------------------------
  *  | PageId (4)| LSN (4)| PrevPageId (4)| NextPageId (4)| FreeSpacePointer(4) |
  *  ----------------------------------------------------------------------------
- *  ----------------------------------------------------------------
- *  | TupleCount (4) | Tuple_1 offset (4) | Tuple_1 size (4) | ... |
- *  ----------------------------------------------------------------
+ *  -----------------------------------------------------------------------
+ *  | TupleCount (2)| Version (2)| FreeSlotHead (4)| FragmentedBytes (4) |
+ *  -----------------------------------------------------------------------
+ *  -------------------------------------------------
+ *  | Tuple_1 offset (4) | Tuple_1 size (4) | ... |
+ *  -------------------------------------------------
+ *
+ *  Empty slots (size 0) are chained through their offset field, starting at FreeSlotHead, so an insert can reuse a
+ *  slot without scanning the slot directory. Version 0 pages were written before the chain existed: TupleCount took
+ *  4 bytes and was directly followed by the slots. They are still read as they are, and upgraded to the current
+ *  version by the first insert that finds 8 free bytes for the longer header.
+ *
+ *  Deletes and shrinking updates leave holes between the tuples instead of moving the tuples below them, the holes
+ *  are counted in FragmentedBytes. The page is compacted in one pass when an insert or a growing update needs more
+ *  contiguous space than there is between the slot directory and the free space pointer. Version 0 pages have no
+ *  room for the counter and are kept compact after every delete, as they always were.
+ *
+ *  A row that grows past what its page can hold is moved to another page by the table heap. Its slot keeps a
+ *  forwarding stub (the 8-byte RowId of the new location, FORWARD flag in the size field) so that the RowId seen by
+ *  indexes stays valid; the relocated tuple carries the MOVED_IN flag and is skipped by scans, which reach it through
+ *  the stub instead.
  **/
 
 #include <cstring>
@@ -25,6 +43,7 @@
 #include "concurrency/txn.h"
 #include "page/page.h"
 #include "record/row.h"
+#include "record/row_view.h"
 #include "recovery/log_manager.h"
 
 class TablePage : public Page {
@@ -56,12 +75,36 @@ class TablePage : public Page {
 
   void RollbackDelete(const RowId &rid, Txn *txn, LogManager *log_manager);
 
-  bool GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_manager);
+  /** @param include_deleted also read a tuple marked deleted but not yet removed by ApplyDelete */
+  bool GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_manager, bool include_deleted = false);
+
+  /** Point view at the tuple at rid without copying it, the view is valid as long as the page stays pinned. */
+  bool GetTupleView(const RowId &rid, Schema *schema, RowView *view);
 
   bool GetFirstTupleRid(RowId *first_rid);
 
   bool GetNextTupleRid(const RowId &cur_rid, RowId *next_rid);
 
+  /** @return true if the slot holds a forwarding stub, target is then set to where the row lives now */
+  bool GetForwardRowId(const RowId &rid, RowId *target);
+
+  /**
+   * Replace the live tuple (or stub) at rid by a forwarding stub pointing to target.
+   * @return false if rid holds no live tuple or there is no room left even for the stub
+   */
+  bool SetForwardRowId(const RowId &rid, const RowId &target);
+
+  /** Flag the live tuple at rid as the relocated copy of a row reached through a forwarding stub. */
+  void MarkMovedIn(const RowId &rid);
+
+  /** @return true if rid holds a live tuple or stub, i.e. an UpdateTuple failure there means the row did not fit */
+  bool HasTuple(const RowId &rid) {
+    return rid.GetSlotNum() < GetTupleCount() && !IsDeleted(GetTupleSize(rid.GetSlotNum()));
+  }
+
+  /** @return bytes an insert or a growing update can use, counting the holes a compaction would merge */
+  uint32_t GetAvailableSpace() { return GetFreeSpaceRemaining() + GetFragmentedBytes(); }
+
  private:
   uint32_t GetFreeSpacePointer() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
 
@@ -69,50 +112,108 @@ class TablePage : public Page {
     memcpy(GetData() + OFFSET_FREE_SPACE, &free_space_pointer, sizeof(uint32_t));
   }
 
-  uint32_t GetTupleCount() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_COUNT); }
+  // TupleCount never exceeds 16 bits, so reading the low half is also correct for version 0 pages
+  uint32_t GetTupleCount() { return *reinterpret_cast<uint16_t *>(GetData() + OFFSET_TUPLE_COUNT); }
+
+  void SetTupleCount(uint32_t tuple_count) {
+    auto count = static_cast<uint16_t>(tuple_count);
+    memcpy(GetData() + OFFSET_TUPLE_COUNT, &count, sizeof(uint16_t));
+  }
+
+  uint16_t GetVersion() { return *reinterpret_cast<uint16_t *>(GetData() + OFFSET_VERSION); }
+
+  void SetVersion(uint16_t version) { memcpy(GetData() + OFFSET_VERSION, &version, sizeof(uint16_t)); }
 
-  void SetTupleCount(uint32_t tuple_count) { memcpy(GetData() + OFFSET_TUPLE_COUNT, &tuple_count, sizeof(uint32_t)); }
+  uint32_t GetHeaderSize() { return GetVersion() == 0 ? SIZE_TABLE_PAGE_HEADER_V0 : SIZE_TABLE_PAGE_HEADER; }
 
-  uint32_t GetFreeSpaceRemaining() {
-    return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
+  uint32_t GetFreeSlotHead() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SLOT_HEAD); }
+
+  void SetFreeSlotHead(uint32_t slot_num) { memcpy(GetData() + OFFSET_FREE_SLOT_HEAD, &slot_num, sizeof(uint32_t)); }
+
+  /** @return contiguous free bytes between the slot directory and the free space pointer */
+  uint32_t GetFreeSpaceRemaining() { return GetFreeSpacePointer() - GetHeaderSize() - SIZE_TUPLE * GetTupleCount(); }
+
+  /** @return bytes in holes between tuples, they become contiguous free space after Compact() */
+  uint32_t GetFragmentedBytes() {
+    return GetVersion() == 0 ? 0 : *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FRAGMENTED_BYTES);
   }
 
+  void SetFragmentedBytes(uint32_t bytes) { memcpy(GetData() + OFFSET_FRAGMENTED_BYTES, &bytes, sizeof(uint32_t)); }
+
+  /** Record a hole of the given size, version 0 pages are compacted right away instead. */
+  void AddFragmentedBytes(uint32_t bytes);
+
+  /** Slide all tuples (including those marked deleted) to the end of the page in one pass, closing every hole. */
+  void Compact();
+
   uint32_t GetTupleOffsetAtSlot(uint32_t slot_num) {
-    return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num);
+    return *reinterpret_cast<uint32_t *>(GetData() + GetHeaderSize() + SIZE_TUPLE * slot_num);
   }
 
   void SetTupleOffsetAtSlot(uint32_t slot_num, uint32_t offset) {
-    memcpy(GetData() + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num, &offset, sizeof(uint32_t));
+    memcpy(GetData() + GetHeaderSize() + SIZE_TUPLE * slot_num, &offset, sizeof(uint32_t));
   }
 
   uint32_t GetTupleSize(uint32_t slot_num) {
-    return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_SIZE + SIZE_TUPLE * slot_num);
+    return *reinterpret_cast<uint32_t *>(GetData() + GetHeaderSize() + SIZE_TUPLE * slot_num + sizeof(uint32_t));
   }
 
   void SetTupleSize(uint32_t slot_num, uint32_t size) {
-    memcpy(GetData() + OFFSET_TUPLE_SIZE + SIZE_TUPLE * slot_num, &size, sizeof(uint32_t));
+    memcpy(GetData() + GetHeaderSize() + SIZE_TUPLE * slot_num + sizeof(uint32_t), &size, sizeof(uint32_t));
   }
 
+  /**
+   * Make room for new_size bytes of the live tuple at slot_num, whose current bytes may be overwritten, and set its
+   * size to new_size | flags. The caller checked that the page has the room and writes the value at the slot offset.
+   */
+  void ReserveTupleSpace(uint32_t slot_num, uint32_t new_size, uint32_t flags);
+
+  /** Put an empty slot at the head of the free slot chain, its offset field links to the previous head. */
+  void PushFreeSlot(uint32_t slot_num);
+
+  /** Move a version 0 page to the current layout. @return false if there is no room for the longer header. */
+  bool UpgradeVersion();
+
   static bool IsDeleted(uint32_t tuple_size) { return static_cast<bool>(tuple_size & DELETE_MASK) || tuple_size == 0; }
 
   static uint32_t SetDeletedFlag(uint32_t tuple_size) { return static_cast<uint32_t>(tuple_size | DELETE_MASK); }
 
   static uint32_t UnsetDeletedFlag(uint32_t tuple_size) { return static_cast<uint32_t>(tuple_size & (~DELETE_MASK)); }
 
+  static bool IsForward(uint32_t tuple_size) { return static_cast<bool>(tuple_size & FORWARD_MASK); }
+
+  static bool IsMovedIn(uint32_t tuple_size) { return static_cast<bool>(tuple_size & MOVED_IN_MASK); }
+
+  /** @return the number of tuple bytes, with every flag stripped */
+  static uint32_t GetTupleLength(uint32_t tuple_size) {
+    return static_cast<uint32_t>(tuple_size & ~(DELETE_MASK | FORWARD_MASK | MOVED_IN_MASK));
+  }
+
  private:
   static_assert(sizeof(page_id_t) == 4);
   static constexpr uint64_t DELETE_MASK = (1U << (8 * sizeof(uint32_t) - 1));
-  static constexpr size_t SIZE_TABLE_PAGE_HEADER = 24;
+  static constexpr uint64_t FORWARD_MASK = (1U << (8 * sizeof(uint32_t) - 2));
+  static constexpr uint64_t MOVED_IN_MASK = (1U << (8 * sizeof(uint32_t) - 3));
+  static constexpr uint32_t SIZE_FORWARD_STUB = sizeof(int64_t);
+  static constexpr uint16_t CURRENT_VERSION = 1;
+  static constexpr uint32_t NO_FREE_SLOT = UINT32_MAX;
+  static constexpr size_t SIZE_TABLE_PAGE_HEADER = 32;
+  static constexpr size_t SIZE_TABLE_PAGE_HEADER_V0 = 24;
   static constexpr size_t SIZE_TUPLE = 8;
   static constexpr size_t OFFSET_PREV_PAGE_ID = 8;
   static constexpr size_t OFFSET_NEXT_PAGE_ID = 12;
   static constexpr size_t OFFSET_FREE_SPACE = 16;
   static constexpr size_t OFFSET_TUPLE_COUNT = 20;
-  static constexpr size_t OFFSET_TUPLE_OFFSET = 24;
-  static constexpr size_t OFFSET_TUPLE_SIZE = 28;
+  static constexpr size_t OFFSET_VERSION = 22;
+  static constexpr size_t OFFSET_FREE_SLOT_HEAD = 24;
+  static constexpr size_t OFFSET_FRAGMENTED_BYTES = 28;
 
  public:
-  static constexpr size_t SIZE_MAX_ROW = PAGE_SIZE - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE;
+  /** @return the largest serialized row that fits into an empty table page of page_size bytes */
+  static constexpr size_t MaxRowSize(uint32_t page_size) { return page_size - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE; }
+
+  /** @return the space an insert of serialized_size bytes needs in the worst case, i.e. with a new slot */
+  static constexpr uint32_t InsertSpace(uint32_t serialized_size) { return serialized_size + SIZE_TUPLE; }
 };
 
 #endif
\ No newline at end of file
@@ -1,5 +1,6 @@
 %{
   #include <stdio.h>
+  #include <string.h>
   #include "parser/parser.h"
 
   extern char *yytext;
@@ -7,6 +8,8 @@
   int yyerror(char* error);
 %}
 
+%define api.header.include {"parser/minisql_yacc.h"}
+
 %union {
 	pSyntaxNode syntax_node;
 }
@@ -22,12 +25,13 @@
 %type <syntax_node> sql_create_database sql_drop_database sql_show_databases sql_use_database
 %type <syntax_node> sql_show_tables sql_create_table sql_drop_table
 %type <syntax_node> column_definition_list column_definition column_type column_list
-%type <syntax_node> sql_create_index sql_drop_index sql_show_indexes
+%type <syntax_node> sql_create_index index_options sql_drop_index sql_show_indexes
 %type <syntax_node> sql_trx_begin sql_trx_commit sql_trx_rollback
 %type <syntax_node> sql_select select_columns column_values column_value operator
 %type <syntax_node> connector where_conditions where_condition
 %type <syntax_node> sql_insert sql_delete sql_update update_values update_value
 %type <syntax_node> sql_quit sql_exec_file
+%type <syntax_node> sql_show_buffer_status sql_set_variable
 
 %%
 
@@ -58,6 +62,8 @@ sql:
   | sql_trx_rollback { $$ = $1; }
   | sql_quit { $$ = $1; }
   | sql_exec_file { $$ = $1; }
+  | sql_show_buffer_status { $$ = $1; }
+  | sql_set_variable { $$ = $1; }
   ;
 
 sql_create_database:
@@ -65,6 +71,16 @@ sql_create_database:
     $$ = CreateSyntaxNode(kNodeCreateDB, NULL);
     SyntaxNodeAddChildren($$, $3);
   }
+  /* "page_size" is not a reserved word, it is matched as an identifier here. */
+  | CREATE DATABASE IDENTIFIER IDENTIFIER NUMBER {
+    if (strcmp($4->val_, "page_size") != 0) {
+      yyerror("syntax error");
+      YYERROR;
+    }
+    $$ = CreateSyntaxNode(kNodeCreateDB, NULL);
+    SyntaxNodeAddChildren($$, $3);
+    SyntaxNodeAddSibling($3, $5);
+  }
   ;
 
 sql_drop_database:
@@ -161,24 +177,53 @@ sql_drop_table:
   ;
 
 sql_create_index:
-  CREATE INDEX IDENTIFIER ON IDENTIFIER '(' column_list ')' {
+  CREATE INDEX IDENTIFIER ON IDENTIFIER '(' column_list ')' index_options {
     $$ = CreateSyntaxNode(kNodeCreateIndex, NULL);
     SyntaxNodeAddChildren($$, $3);
     SyntaxNodeAddChildren($$, $5);
     pSyntaxNode index_keys_node = CreateSyntaxNode(kNodeColumnList, "index keys");
     SyntaxNodeAddChildren(index_keys_node, $7);
     SyntaxNodeAddChildren($$, index_keys_node);
+    SyntaxNodeAddChildren($$, $9);
+  }
+  | CREATE UNIQUE INDEX IDENTIFIER ON IDENTIFIER '(' column_list ')' index_options {
+    $$ = CreateSyntaxNode(kNodeCreateIndex, "unique");
+    SyntaxNodeAddChildren($$, $4);
+    SyntaxNodeAddChildren($$, $6);
+    pSyntaxNode index_keys_node = CreateSyntaxNode(kNodeColumnList, "index keys");
+    SyntaxNodeAddChildren(index_keys_node, $8);
+    SyntaxNodeAddChildren($$, index_keys_node);
+    SyntaxNodeAddChildren($$, $10);
+  }
+  ;
+
+/* "include" is not a reserved word, it is matched as an identifier here. */
+index_options:
+  /* empty */ {
+    $$ = NULL;
+  }
+  | USING IDENTIFIER {
+    $$ = CreateSyntaxNode(kNodeIndexType, "index type");
+    SyntaxNodeAddChildren($$, $2);
+  }
+  | IDENTIFIER '(' column_list ')' {
+    if (strcmp($1->val_, "include") != 0) {
+      yyerror("syntax error");
+      YYERROR;
+    }
+    $$ = CreateSyntaxNode(kNodeColumnList, "include columns");
+    SyntaxNodeAddChildren($$, $3);
   }
-  | CREATE INDEX IDENTIFIER ON IDENTIFIER '(' column_list ')' USING IDENTIFIER {
-      $$ = CreateSyntaxNode(kNodeCreateIndex, NULL);
-      SyntaxNodeAddChildren($$, $3);
-      SyntaxNodeAddChildren($$, $5);
-      pSyntaxNode index_keys_node = CreateSyntaxNode(kNodeColumnList, "index keys");
-      SyntaxNodeAddChildren(index_keys_node, $7);
-      SyntaxNodeAddChildren($$, index_keys_node);
-      pSyntaxNode index_type_node = CreateSyntaxNode(kNodeIndexType, "index type");
-      SyntaxNodeAddChildren(index_type_node, $10);
-      SyntaxNodeAddChildren($$, index_type_node);
+  | IDENTIFIER '(' column_list ')' USING IDENTIFIER {
+    if (strcmp($1->val_, "include") != 0) {
+      yyerror("syntax error");
+      YYERROR;
+    }
+    $$ = CreateSyntaxNode(kNodeColumnList, "include columns");
+    SyntaxNodeAddChildren($$, $3);
+    pSyntaxNode index_type_node = CreateSyntaxNode(kNodeIndexType, "index type");
+    SyntaxNodeAddChildren(index_type_node, $6);
+    SyntaxNodeAddSibling($$, index_type_node);
   }
   ;
 
@@ -195,6 +240,26 @@ sql_show_indexes:
   }
   ;
 
+/* "buffer" and "status" are not reserved words, they are matched as identifiers here. */
+sql_show_buffer_status:
+  SHOW IDENTIFIER IDENTIFIER {
+    if (strcmp($2->val_, "buffer") != 0 || strcmp($3->val_, "status") != 0) {
+      yyerror("syntax error");
+      YYERROR;
+    }
+    $$ = CreateSyntaxNode(kNodeShowBufferStatus, NULL);
+  }
+  ;
+
+/* session setting, e.g. "set scan_threads = 8" */
+sql_set_variable:
+  SET IDENTIFIER EQ NUMBER {
+    $$ = CreateSyntaxNode(kNodeSetVariable, NULL);
+    SyntaxNodeAddChildren($$, $2);
+    SyntaxNodeAddChildren($$, $4);
+  }
+  ;
+
 sql_select:
   SELECT select_columns FROM IDENTIFIER {
     $$ = CreateSyntaxNode(kNodeSelect, NULL);
@@ -16,9 +16,13 @@ class ConstantValueExpression : public AbstractExpression {
   explicit ConstantValueExpression(const Field &val)
       : AbstractExpression({}, val.GetTypeId(), ExpressionType::ConstantExpression), val_(val) {}
 
-  Field Evaluate(const Row *row) const override { return Field(val_); }
+  Field Evaluate([[maybe_unused]] const Row *row) const override { return Field(val_); }
 
-  Field EvaluateJoin(const Row *left_row, const Row *right_row) const override { return Field(val_); }
+  Field EvaluateView([[maybe_unused]] const RowView &view) const override { return Field(val_); }
+
+  Field EvaluateJoin([[maybe_unused]] const Row *left_row, [[maybe_unused]] const Row *right_row) const override {
+    return Field(val_);
+  }
 
   const Field val_;
 };
@@ -18,6 +18,12 @@ class Field {
 
   friend class TypeFloat;
 
+  friend struct RowCodec;
+
+  friend class ZoneMap;
+
+  friend class KeyManager;
+
  public:
   explicit Field(const TypeId type) : type_id_(type), len_(FIELD_NULL_LEN), is_null_(true) {}
 
@@ -61,12 +67,23 @@ class Field {
     }
   }
 
+  /**
+   * char stored out of line: a reference to the chain of overflow pages holding the len bytes of the value. The
+   * value itself is only available once the table heap has loaded it.
+   */
+  explicit Field(TypeId type, uint32_t len, page_id_t overflow_page_id)
+      : type_id_(type), len_(len), overflow_page_id_(overflow_page_id) {
+    ASSERT(type == TypeId::kTypeChar, "Invalid type.");
+    value_.chars_ = nullptr;
+  }
+
   // copy constructor
   explicit Field(const Field &other) {
     type_id_ = other.type_id_;
     len_ = other.len_;
     is_null_ = other.is_null_;
     manage_data_ = other.manage_data_;
+    overflow_page_id_ = other.overflow_page_id_;
     if (type_id_ == TypeId::kTypeChar && !is_null_ && manage_data_) {
       value_.chars_ = new char[len_];
       memcpy(value_.chars_, other.value_.chars_, len_);
@@ -75,6 +92,22 @@ class Field {
     }
   }
 
+  // move, the char value changes hands without being copied
+  Field(Field &&other) noexcept
+      : value_(other.value_),
+        type_id_(other.type_id_),
+        len_(other.len_),
+        is_null_(other.is_null_),
+        manage_data_(other.manage_data_),
+        overflow_page_id_(other.overflow_page_id_) {
+    other.manage_data_ = false;
+  }
+
+  Field &operator=(Field &&other) noexcept {
+    Swap(*this, other);
+    return *this;
+  }
+
   // copy
   Field &operator=(Field &other) {
     Swap(*this, other);
@@ -83,6 +116,12 @@ class Field {
 
   inline bool IsNull() const { return is_null_; }
 
+  /** @return true if the value is kept in overflow pages and has not been loaded */
+  inline bool IsExternal() const { return overflow_page_id_ != INVALID_PAGE_ID; }
+
+  /** @return the first overflow page of an external value */
+  inline page_id_t GetOverflowPageId() const { return overflow_page_id_; }
+
   inline uint32_t GetLength() const { return Type::GetInstance(type_id_)->GetLength(*this); }
 
   inline TypeId GetTypeId() const { return type_id_; }
@@ -127,6 +166,7 @@ class Field {
     std::swap(first.len_, second.len_);
     std::swap(first.is_null_, second.is_null_);
     std::swap(first.manage_data_, second.manage_data_);
+    std::swap(first.overflow_page_id_, second.overflow_page_id_);
   }
 
   std::string toString() {
@@ -154,6 +194,7 @@ class Field {
   uint32_t len_;
   bool is_null_{false};
   bool manage_data_{false};
+  page_id_t overflow_page_id_{INVALID_PAGE_ID};
 };
 
 #endif  // MINISQL_FIELD_H
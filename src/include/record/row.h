@@ -5,12 +5,19 @@
 #include <vector>
 
 #include "common/macros.h"
+#include "common/memory_arena.h"
 #include "common/rowid.h"
 #include "record/field.h"
 #include "record/schema.h"
 
 /**
- *  Row format:
+ * On-disk row formats. Both start with the same header, DeserializeFrom tells them apart by FORMAT_V2_MASK in the
+ * field count.
+ */
+enum class RowFormat { kV1, kV2 };
+
+/**
+ *  Row format (v1), null fields take no space:
  * -------------------------------------------
  * | Header | Field-1 | ... | Field-N |
  * -------------------------------------------
@@ -19,10 +26,22 @@
  * | Field Nums | Null bitmap |
  * -------------------------------------------
  *
+ *  Row format (v2), any field is found without decoding the others:
+ * ---------------------------------------------------------------------------------
+ * | Field Nums | V2 | Null bitmap | Fixed area | Var offsets | Var-1 | ... | Var-M |
+ * ---------------------------------------------------------------------------------
+ *  Fixed area: int and float fields in schema order, at Schema::GetLayoutSlot(), zeroed when null.
+ *  Var offsets: one uint32 per char field, the offset of its value from the start of the row.
+ *  Var-i: char values encoded as in v1, absent when null.
+ *  v2 rows are encoded by the RowCodec of the schema.
  *
+ *  Table pages store v2 rows and keep reading v1 rows written before, which are converted when they are rewritten.
+ *  Index keys stay in v1, the smaller one.
  */
 class Row {
  public:
+  static constexpr uint32_t FORMAT_V2_MASK = 1U << 31;
+
   /**
    * Row used for insert
    * Field integrity should check by upper level
@@ -37,12 +56,33 @@ class Row {
   void destroy() {
     if (!fields_.empty()) {
       for (auto field : fields_) {
-        delete field;
+        if (arena_ != nullptr) {
+          // 字段的内存属于 arena，只析构不释放
+          field->~Field();
+        } else {
+          delete field;
+        }
       }
       fields_.clear();
     }
   }
 
+  /**
+   * Drop the fields, the next ones are allocated from arena, or from the heap if it is nullptr.
+   * An arena must outlive the rows allocated from it.
+   */
+  void Reset(MemoryArena *arena) {
+    destroy();
+    arena_ = arena;
+  }
+
+  inline MemoryArena *GetArena() const { return arena_; }
+
+  /** Append a field allocated from the arena of the row, taking the value of field. */
+  void AppendField(Field &&field) {
+    fields_.push_back(arena_ != nullptr ? arena_->New<Field>(std::move(field)) : new Field(std::move(field)));
+  }
+
   ~Row() { destroy(); };
 
   /**
@@ -56,13 +96,13 @@ class Row {
   Row(RowId rid) : rid_(rid) {}
 
   /**
-   * Row copy function, deep copy
+   * Row copy function, deep copy. The copy lives on the heap, char values of an arena row are copied out of the arena.
    */
   Row(const Row &other) {
     destroy();
     rid_ = other.rid_;
     for (auto &field : other.fields_) {
-      fields_.push_back(new Field(*field));
+      fields_.push_back(CopyField(*field, other.arena_ != nullptr));
     }
   }
 
@@ -70,19 +110,42 @@ class Row {
    * Assign operator, deep copy
    */
   Row &operator=(const Row &other) {
+    if (this == &other) {
+      return *this;
+    }
     destroy();
+    arena_ = nullptr;
     rid_ = other.rid_;
     for (auto &field : other.fields_) {
-      fields_.push_back(new Field(*field));
+      fields_.push_back(CopyField(*field, other.arena_ != nullptr));
+    }
+    return *this;
+  }
+
+  /**
+   * Move, the fields change hands with their arena
+   */
+  Row(Row &&other) noexcept : rid_(other.rid_), fields_(std::move(other.fields_)), arena_(other.arena_) {
+    other.fields_.clear();
+  }
+
+  Row &operator=(Row &&other) noexcept {
+    if (this == &other) {
+      return *this;
     }
+    destroy();
+    rid_ = other.rid_;
+    fields_.swap(other.fields_);
+    arena_ = other.arena_;
     return *this;
   }
 
   /**
    * Note: Make sure that bytes write to buf is equal to GetSerializedSize()
    */
-  uint32_t SerializeTo(char *buf, Schema *schema) const;
+  uint32_t SerializeTo(char *buf, Schema *schema, RowFormat format = RowFormat::kV1) const;
 
+  /** Reads rows of either format. */
   uint32_t DeserializeFrom(char *buf, Schema *schema);
 
   /**
@@ -90,7 +153,7 @@ class Row {
    * For non-empty row with null fields, eg: |null|null|null|, return header size only
    * @return
    */
-  uint32_t GetSerializedSize(Schema *schema) const;
+  uint32_t GetSerializedSize(Schema *schema, RowFormat format = RowFormat::kV1) const;
 
   void GetKeyFromRow(const Schema *schema, const Schema *key_schema, Row &key_row);
 
@@ -108,8 +171,20 @@ class Row {
   inline size_t GetFieldCount() const { return fields_.size(); }
 
  private:
+  /**
+   * @return a heap copy of field, with a char value of its own if copy_borrowed is set: a field of an arena row only
+   * points to its value, which goes away with the arena
+   */
+  static Field *CopyField(const Field &field, bool copy_borrowed) {
+    if (copy_borrowed && field.GetTypeId() == TypeId::kTypeChar && !field.IsNull() && !field.IsExternal()) {
+      return new Field(TypeId::kTypeChar, const_cast<char *>(field.GetData()), field.GetLength(), true);
+    }
+    return new Field(field);
+  }
+
   RowId rid_{};
   std::vector<Field *> fields_; /** Make sure that all field ptr are destructed*/
+  MemoryArena *arena_{nullptr}; /** where fields_ live, nullptr for the heap */
 };
 
 #endif  // MINISQL_ROW_H
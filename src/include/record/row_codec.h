@@ -0,0 +1,40 @@
+#ifndef MINISQL_ROW_CODEC_H
+#define MINISQL_ROW_CODEC_H
+
+#include "record/field.h"
+#include "record/row.h"
+#include "record/schema.h"
+
+/**
+ * Encoder and decoder of v2 rows (see Row) specialized for one RowLayoutKind. Schema picks its codec once when it is
+ * created, the rows of a table are then encoded and decoded with typed reads and writes instead of a virtual Type call
+ * per field, and without per field null checks for schemas without nullable columns.
+ *
+ * Nullability is not enforced above the storage: a row holding a null in a NOT NULL column falls back to the
+ * kNullable codec, the bytes written are the same.
+ */
+struct RowCodec {
+  RowLayoutKind kind_;
+  uint32_t (*get_serialized_size_)(const Row &row, const Schema &schema);
+  uint32_t (*serialize_to_)(const Row &row, const Schema &schema, char *buf);
+  uint32_t (*deserialize_from_)(Row *row, const Schema &schema, const char *buf);
+
+  static const RowCodec *Get(RowLayoutKind kind);
+
+  /** Write a fixed size field, zeroes for null. */
+  static void SerializeFixed(const Field &field, char *buf);
+
+  /** @return bytes written for a non null char field, same encoding as TypeChar */
+  static uint32_t SerializeVarLength(const Field &field, char *buf);
+
+  static uint32_t GetVarLengthSize(const Field &field);
+
+  /**
+   * Decode one field at buf, the field and its value are copied into arena, or onto the heap if it is nullptr.
+   * @return bytes read
+   */
+  static uint32_t DeserializeField(const char *buf, TypeId type, Field **field, bool is_null,
+                                   MemoryArena *arena = nullptr);
+};
+
+#endif  // MINISQL_ROW_CODEC_H
@@ -0,0 +1,66 @@
+#ifndef MINISQL_ROW_VIEW_H
+#define MINISQL_ROW_VIEW_H
+
+#include <vector>
+
+#include "common/rowid.h"
+#include "record/field.h"
+#include "record/row.h"
+#include "record/schema.h"
+
+/**
+ * Read-only view of a row in its serialized form (see Row), usually pointing into a pinned table page.
+ *
+ * Nothing is decoded or copied up front: a field of a v2 row is located directly through the layout of the schema,
+ * for v1 rows the offsets of the fields are computed on the first field access. GetField() returns fields borrowing
+ * the bytes of the view. The view, and every field taken from it, is only valid
+ * while the underlying bytes are, i.e. as long as the page stays pinned. Rows that outlive it are built with
+ * Materialize().
+ */
+class RowView {
+ public:
+  RowView() = default;
+
+  /** Point the view at another serialized row, the storage of the cached offsets is reused. */
+  void Reset(const char *data, Schema *schema, RowId rid);
+
+  inline RowId GetRowId() const { return rid_; }
+
+  inline void SetRowId(RowId rid) { rid_ = rid; }
+
+  inline uint32_t GetFieldCount() const { return field_count_; }
+
+  inline RowFormat GetFormat() const { return format_; }
+
+  bool IsNull(uint32_t idx) const;
+
+  /** @return true if the value of a char column is kept in overflow pages */
+  bool IsExternal(uint32_t idx) const;
+
+  /** @return the field at idx, char values borrow the bytes of the view */
+  Field GetField(uint32_t idx) const;
+
+  /** Copy every field into row, which gets the row id of the view. Fields are allocated from the arena of row. */
+  void Materialize(Row *row) const;
+
+  /** Copy the listed fields, in that order, into row, which gets the row id of the view. */
+  void Materialize(Row *row, const std::vector<uint32_t> &columns) const;
+
+ private:
+  /** @return the offset of field idx from data_ */
+  uint32_t GetFieldOffset(uint32_t idx) const;
+
+  /** Walk a v1 row once to find the offset of every field. */
+  void ComputeOffsets() const;
+
+  const char *data_{nullptr};
+  Schema *schema_{nullptr};
+  RowId rid_{};
+  uint32_t field_count_{0};
+  RowFormat format_{RowFormat::kV1};
+  // offset of each field of a v1 row from data_, computed on the first field access
+  mutable std::vector<uint32_t> offsets_;
+  mutable bool offsets_valid_{false};
+};
+
+#endif  // MINISQL_ROW_VIEW_H
@@ -6,14 +6,27 @@
 #include "common/macros.h"
 #include "glog/logging.h"
 #include "record/column.h"
+#include "record/types.h"
 
 #ifndef MINISQL_SCHEMA_H
 #define MINISQL_SCHEMA_H
 
+struct RowCodec;
+
+/**
+ * Shape of the rows of a schema, decides which RowCodec encodes them:
+ *  - kAllFixed: int/float columns only, none nullable, every row has the same size.
+ *  - kFixedVarchar: char columns too, none nullable.
+ *  - kNullable: at least one nullable column.
+ */
+enum class RowLayoutKind { kAllFixed, kFixedVarchar, kNullable };
+
 class Schema {
  public:
   explicit Schema(const std::vector<Column *> columns, bool is_manage_ = true)
-      : columns_(std::move(columns)), is_manage_(is_manage_) {}
+      : columns_(std::move(columns)), is_manage_(is_manage_) {
+    ComputeLayout();
+  }
 
   ~Schema() {
     if (is_manage_) {
@@ -39,6 +52,27 @@ class Schema {
 
   inline uint32_t GetColumnCount() const { return static_cast<uint32_t>(columns_.size()); }
 
+  /**
+   * Layout of the columns in a v2 row (see Row), computed when the schema is created.
+   * @return true if column_index is stored in the fixed size area, false if it is reached through the offset array
+   */
+  inline bool IsFixedLength(const uint32_t column_index) const { return layout_slots_[column_index].fixed_; }
+
+  /** @return the offset of a fixed size column in the fixed size area, or the offset array slot of the others */
+  inline uint32_t GetLayoutSlot(const uint32_t column_index) const { return layout_slots_[column_index].slot_; }
+
+  inline uint32_t GetFixedAreaSize() const { return fixed_area_size_; }
+
+  inline uint32_t GetVarLengthCount() const { return var_length_count_; }
+
+  /** @return the size of a v2 row without its char values: header, null bitmap, fixed area and offset array */
+  inline uint32_t GetFixedRowSize() const { return fixed_row_size_; }
+
+  inline RowLayoutKind GetLayoutKind() const { return layout_kind_; }
+
+  /** @return the codec picked for the layout of this schema */
+  inline const RowCodec *GetCodec() const { return codec_; }
+
   /**
    * Shallow copy schema, only used in index
    *
@@ -81,9 +115,23 @@ class Schema {
   static uint32_t DeserializeFrom(char *buf, Schema *&schema);
 
  private:
+  /** Build the layout plan of the columns and pick the row codec, once when the schema is created. */
+  void ComputeLayout();
+
+  struct LayoutSlot {
+    bool fixed_;
+    uint32_t slot_;
+  };
+
   static constexpr uint32_t SCHEMA_MAGIC_NUM = 200715;
   std::vector<Column *> columns_;
   bool is_manage_ = false; /** if false, don't need to delete pointer to column */
+  std::vector<LayoutSlot> layout_slots_;
+  uint32_t fixed_area_size_{0};
+  uint32_t var_length_count_{0};
+  uint32_t fixed_row_size_{0};
+  RowLayoutKind layout_kind_{RowLayoutKind::kNullable};
+  const RowCodec *codec_{nullptr};
 };
 
 using IndexSchema = Schema;
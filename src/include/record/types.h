@@ -120,6 +120,9 @@ class TypeChar : public Type {
   virtual CmpBool CompareGreaterThan(const Field &left, const Field &right) const override;
 
   virtual CmpBool CompareGreaterThanEquals(const Field &left, const Field &right) const override;
+
+  // set in the serialized length of a value kept in overflow pages, the first overflow page id follows the length
+  static constexpr uint32_t EXTERNAL_MASK = 1U << 31;
 };
 
 class TypeFloat : public Type {
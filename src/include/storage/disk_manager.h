@@ -4,6 +4,7 @@
 #include <atomic>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <string>
 
@@ -12,17 +13,35 @@
 #include "page/bitmap_page.h"
 #include "page/disk_file_meta_page.h"
 
+/**
+ * Point-in-time copy of the I/O counters kept by DiskManager.
+ * Every page write is flushed before returning, so pages_written_ also counts synchronous writes.
+ */
+struct DiskIOStats {
+  uint64_t pages_read_{0};
+  uint64_t pages_written_{0};
+  uint64_t bytes_read_{0};
+  uint64_t bytes_written_{0};
+  uint64_t io_wait_ns_{0};  // time spent inside read/write/flush calls
+};
+
 /**
  * DiskManager takes care of the allocation and de allocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
  *
- * Disk page storage format: (Free Page BitMap Size = PAGE_SIZE * 8, we note it as N)
+ * Disk page storage format: (Free Page BitMap Size = page size * 8, we note it as N)
  * | Meta Page | Free Page BitMap 1 | Page 1 | Page 2 | ....
  *      | Page N | Free Page BitMap 2 | Page N+1 | ... | Page 2N | ... |
+ *
+ * All pages of a file have the same size, which is chosen when the file is created and recorded in the meta page.
  */
 class DiskManager {
  public:
-  explicit DiskManager(const std::string &db_file);
+  /**
+   * @param page_size page size used if db_file is created by this call, an existing file keeps the page size it was
+   *                  created with. Must satisfy IsValidPageSize().
+   */
+  explicit DiskManager(const std::string &db_file, uint32_t page_size = PAGE_SIZE);
 
   ~DiskManager() {
     if (!closed) {
@@ -67,15 +86,32 @@ class DiskManager {
    * Get Meta Page
    * Note: Used only for debug
    */
-  char *GetMetaData() { return meta_data_; }
+  char *GetMetaData() { return meta_data_.get(); }
+
+  /** @return the size in bytes of every page in this file */
+  inline uint32_t GetPageSize() const { return page_size_; }
+
+  /** @return the number of data pages in one extent, i.e. what a single bitmap page can record */
+  inline size_t GetBitmapSize() const { return bitmap_size_; }
 
+  /** @return the largest logical page id this file can address */
+  inline page_id_t GetMaxValidPageId() const { return max_valid_page_id_; }
+
+  /**
+   * @return a snapshot of the I/O counters, counters are updated with relaxed atomics
+   */
+  DiskIOStats GetIOStats() const;
+
+  void ResetIOStats();
+
+  /** Extent capacity of a file that uses the default PAGE_SIZE, see GetBitmapSize() for the general case. */
   static constexpr size_t BITMAP_SIZE = BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
 
  private:
   /**
    * Helper function to get disk file size
    */
-  int GetFileSize(const std::string &file_name);
+  int64_t GetFileSize(const std::string &file_name);
 
   /**
    * Read physical page from disk
@@ -92,6 +128,12 @@ class DiskManager {
    */
   page_id_t MapPageId(page_id_t logical_page_id);
 
+  /**
+   * Load the meta page, or set up an empty one for a new file. Files written before the page size was recorded are
+   * converted to the tagged layout in memory and written back on Close().
+   */
+  void LoadMetaPage(uint32_t page_size);
+
  private:
   // stream to write db file
   std::fstream db_io_;
@@ -99,7 +141,16 @@ class DiskManager {
   // with multiple buffer pool instances, need to protect file access
   std::recursive_mutex db_io_latch_;
   bool closed{false};
-  char meta_data_[PAGE_SIZE];
+  uint32_t page_size_{PAGE_SIZE};
+  size_t bitmap_size_{BITMAP_SIZE};
+  page_id_t max_valid_page_id_{0};
+  std::unique_ptr<char[]> meta_data_;
+  // I/O counters, see DiskIOStats
+  std::atomic<uint64_t> pages_read_{0};
+  std::atomic<uint64_t> pages_written_{0};
+  std::atomic<uint64_t> bytes_read_{0};
+  std::atomic<uint64_t> bytes_written_{0};
+  std::atomic<uint64_t> io_wait_ns_{0};
 };
 
 #endif
\ No newline at end of file
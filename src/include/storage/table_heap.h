@@ -1,15 +1,25 @@
 #ifndef MINISQL_TABLE_HEAP_H
 #define MINISQL_TABLE_HEAP_H
 
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
 #include "page/header_page.h"
+#include "page/overflow_page.h"
 #include "page/table_page.h"
 #include "recovery/log_manager.h"
 #include "storage/table_iterator.h"
+#include "storage/table_page_directory.h"
+#include "storage/table_view_iterator.h"
+#include "storage/zone_map.h"
 
 class TableHeap {
   friend class TableIterator;
+  friend class TableViewIterator;
 
  public:
   static TableHeap *Create(BufferPoolManager *buffer_pool_manager, Schema *schema, Txn *txn, LogManager *log_manager,
@@ -25,7 +35,8 @@ class TableHeap {
   ~TableHeap() {}
 
   /**
-   * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
+   * Insert a tuple into the table. Char values longer than OverflowPage::GetInlineLimit() are written to overflow
+   * pages and only referenced from the row. If the tuple is still too large (>= page_size), return false.
    * @param[in/out] row Tuple Row to insert, the rid of the inserted tuple is wrapped in object row
    * @param[in] txn The recovery performing the insert
    * @return true iff the insert is successful
@@ -41,11 +52,12 @@ class TableHeap {
   bool MarkDelete(const RowId &rid, Txn *txn);
 
   /**
-   * if the new tuple is too large to fit in the old page, return false (will delete and insert)
+   * Update a tuple in place. If the new tuple no longer fits into its page, it is moved to another page and a
+   * forwarding stub is left at rid, so rid (and every index entry pointing to it) stays valid.
    * @param[in] row Tuple of new row
    * @param[in] rid Rid of the old tuple
    * @param[in] txn Txn performing the update
-   * @return true is update is successful.
+   * @return true is update is successful, false if the tuple does not exist or is larger than a page.
    */
   bool UpdateTuple(Row &row, const RowId &rid, Txn *txn);
 
@@ -64,21 +76,28 @@ class TableHeap {
   void RollbackDelete(const RowId &rid, Txn *txn);
 
   /**
-   * Read a tuple from the table.
+   * Read a tuple from the table, including the values kept in overflow pages.
    * @param[in/out] row Output variable for the tuple, row id of the tuple is wrapped in row
    * @param[in] txn recovery performing the read
    * @return true if the read was successful (i.e. the tuple exists)
    */
   bool GetTuple(Row *row, Txn *txn);
 
+  /**
+   * Load the values of the listed columns that are kept in overflow pages.
+   * @param columns columns[i] tells whether column i is needed, an empty vector means every column
+   */
+  void LoadOverflowValues(Row *row, const std::vector<bool> &columns);
+
   void FreeTableHeap() {
     auto next_page_id = first_page_id_;
     while (next_page_id != INVALID_PAGE_ID) {
       auto old_page_id = next_page_id;
-      auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(old_page_id));
-      assert(page != nullptr);
-      next_page_id = page->GetNextPageId();
-      buffer_pool_manager_->UnpinPage(old_page_id, false);
+      {
+        ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(old_page_id);
+        assert(guard.IsValid());
+        next_page_id = guard.As<TablePage>()->GetNextPageId();
+      }
       buffer_pool_manager_->DeletePage(old_page_id);
     }
   }
@@ -89,9 +108,31 @@ class TableHeap {
   void DeleteTable(page_id_t page_id = INVALID_PAGE_ID);
 
   /**
+   * @param columns columns[i] tells whether the caller reads column i, an empty vector means every column. Values of
+   * the other columns kept in overflow pages are not loaded and stay external references (Field::IsExternal()).
    * @return the begin iterator of this table
    */
-  TableIterator Begin(Txn *txn);
+  TableIterator Begin(Txn *txn, const std::vector<bool> &columns = {});
+
+  /**
+   * @param filter if not nullptr, pages whose zone map shows no row can satisfy it are skipped, the caller still
+   * has to check the rows handed out
+   * @param page_filter if not empty, pages it returns false for are skipped as well
+   * @return an iterator handing out views of the rows in place, see TableViewIterator
+   */
+  TableViewIterator ViewBegin(Txn *txn, const ZoneMapFilter *filter = nullptr,
+                              TableViewIterator::PageFilter page_filter = nullptr) {
+    return TableViewIterator(this, txn, filter, std::move(page_filter));
+  }
+
+  /**
+   * Like ViewBegin(), but only over the pages at positions [begin, end) of the page chain (see GetPageCount()).
+   * Scans over disjoint ranges hand out disjoint rows.
+   */
+  TableViewIterator ViewRange(Txn *txn, size_t begin, size_t end, const ZoneMapFilter *filter = nullptr,
+                              TableViewIterator::PageFilter page_filter = nullptr) {
+    return TableViewIterator(this, txn, page_directory_.GetPageIds(begin, end), filter, std::move(page_filter));
+  }
 
   /**
    * @return the end iterator of this table
@@ -103,42 +144,115 @@ class TableHeap {
    */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /** @return the number of pages in the page chain of this table */
+  size_t GetPageCount() { return page_directory_.GetPageCount(); }
+
+  /** @return the page at position index of the page chain, INVALID_PAGE_ID if past the end */
+  page_id_t GetPageId(size_t index) { return page_directory_.GetPageId(index); }
+
  private:
+  /**
+   * Insert the tuple into the first page with enough room, skipping skip_page_id, and append a new page if none has.
+   * @param moved_in the tuple is the relocated copy of a row reached through a forwarding stub
+   */
+  bool InsertTupleImpl(Row &row, Txn *txn, page_id_t skip_page_id, bool moved_in);
+
+  /** Read the relocated copy of a row stored at target, row keeps its own row id. */
+  bool GetForwardedTuple(Row *row, const RowId &target, Txn *txn);
+
+  /** Read a tuple as it is stored, values kept in overflow pages stay external references. */
+  bool GetStoredTuple(Row *row, Txn *txn, bool include_deleted = false);
+
+  /** The body of UpdateTuple, on a row already prepared for storage. */
+  bool UpdateStoredTuple(Row &row, const RowId &rid, Txn *txn);
+
+  /** Remove a single slot, without following forwarding stubs or freeing overflow pages. */
+  void ApplyDeleteSlot(const RowId &rid, Txn *txn);
+
+  /**
+   * Build the stored form of row: long char values are written to overflow pages, unless old_row (the stored form
+   * of the row being updated) already references an equal value, which is then shared.
+   * @return false if the overflow pages could not be allocated
+   */
+  bool PrepareStoredRow(const Row &row, const Row *old_row, Row *stored);
+
+  /** Free the overflow pages referenced by stored and not by keep (which may be nullptr). */
+  void FreeOverflowValues(const Row &stored, const Row *keep);
+
+  /** @return the first page of a new chain of overflow pages holding data, INVALID_PAGE_ID if out of pages */
+  page_id_t WriteOverflow(const char *data, uint32_t len);
+
+  /** Read the len bytes of the chain starting at page_id into buf. */
+  void ReadOverflow(page_id_t page_id, uint32_t len, char *buf);
+
+  void FreeOverflow(page_id_t page_id);
+
+  /** Remember how much room a page has left after it was modified. */
+  void UpdateFreeSpaceHint(page_id_t page_id, TablePage *page);
+
+  /**
+   * @return a page other than skip_page_id that had room for required_space bytes when last seen, the one with the
+   * least room among them, found in O(log n) through pages_by_space_
+   */
+  page_id_t FindPageWithSpace(uint32_t required_space, page_id_t skip_page_id);
+
+  /** Widen the zone map of page_id, if it has one, with the values of a row whose home is that page. */
+  void WidenZoneMap(page_id_t page_id, const Row &row);
+
+  /**
+   * Check filter against the zone map of a page the caller holds latched, the zone map is built on first use.
+   * @return false if no row of the page can satisfy filter
+   */
+  bool PageMayMatch(page_id_t page_id, TablePage *page, const ZoneMapFilter &filter);
+
   /**
    * create table heap and initialize first page
    */
   explicit TableHeap(BufferPoolManager *buffer_pool_manager, Schema *schema, Txn *txn, LogManager *log_manager,
                      LockManager *lock_manager)
       : buffer_pool_manager_(buffer_pool_manager),
+        page_directory_(buffer_pool_manager),
         schema_(schema),
         log_manager_(log_manager),
         lock_manager_(lock_manager) {
     page_id_t new_page_id;
-    buffer_pool_manager_->NewPage(new_page_id);
+    WritePageGuard guard = buffer_pool_manager_->NewPageGuarded(new_page_id).UpgradeWrite();
+    ASSERT(guard.IsValid(), "Failed to allocate the first page of table heap.");
     first_page_id_ = new_page_id;
-    auto new_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(new_page_id));
-    new_page->WLatch();
-    new_page->Init(new_page_id,INVALID_PAGE_ID,log_manager,txn);
+    auto new_page = guard.AsMut<TablePage>();
+    new_page->Init(new_page_id, INVALID_PAGE_ID, log_manager, txn);
     new_page->SetNextPageId(INVALID_PAGE_ID);
-    new_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(new_page->GetPageId(), true);
-    //ASSERT(false, "Not implemented yet.");
+    page_directory_.Init(new_page_id);
+    zone_maps_.emplace(new_page_id, ZoneMap(schema_, true));
   };
 
   explicit TableHeap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
                      LogManager *log_manager, LockManager *lock_manager)
       : buffer_pool_manager_(buffer_pool_manager),
+        page_directory_(buffer_pool_manager),
         first_page_id_(first_page_id),
         schema_(schema),
         log_manager_(log_manager),
-        lock_manager_(lock_manager) {}
+        lock_manager_(lock_manager) {
+    page_directory_.Load(first_page_id_);
+  }
 
  private:
   BufferPoolManager *buffer_pool_manager_;
+  // 页链中的页面按顺序排成的目录：找尾页、按位置取页面都不用沿页链走
+  TablePageDirectory page_directory_;
   page_id_t first_page_id_;
   Schema *schema_;
   [[maybe_unused]] LogManager *log_manager_;
   [[maybe_unused]] LockManager *lock_manager_;
+  // 各页面最近一次修改后剩余的空间，只是提示：用于给搬迁的记录挑选页面，不准时回退到遍历页链
+  std::unordered_map<page_id_t, uint32_t> free_space_hint_;
+  // 同样的提示按（剩余空间，页号）排序，找有足够空间的页面只要一次 lower_bound
+  std::set<std::pair<uint32_t, page_id_t>> pages_by_space_;
+  std::mutex hint_latch_;
+  // 各页面的 zone map：新建的页面从空的完整汇总开始，已有的页面在第一次扫描时补建
+  std::unordered_map<page_id_t, ZoneMap> zone_maps_;
+  std::mutex zone_map_latch_;
 };
 
 #endif  // MINISQL_TABLE_HEAP_H
@@ -1,6 +1,8 @@
 #ifndef MINISQL_TABLE_ITERATOR_H
 #define MINISQL_TABLE_ITERATOR_H
 
+#include <vector>
+
 #include "common/rowid.h"
 #include "concurrency/txn.h"
 #include "record/row.h"
@@ -12,7 +14,8 @@ public:
  // you may define your own constructor based on your member variables
  explicit TableIterator(){}
 
- explicit TableIterator(TableHeap *table_heap, RowId rid, Txn *txn);
+ /** @param columns columns whose overflow values are loaded, empty for every column, see TableHeap::Begin */
+ explicit TableIterator(TableHeap *table_heap, RowId rid, Txn *txn, std::vector<bool> columns = {});
 
  TableIterator(const TableIterator &other);
 
@@ -38,6 +41,7 @@ private:
   RowId current_row_id_;// the current row id
   Txn* txn_;// the transaction
   Row current_row_;// the current row
+  std::vector<bool> columns_;// the columns whose overflow values are loaded
 };
 
 #endif  // MINISQL_TABLE_ITERATOR_H
@@ -0,0 +1,61 @@
+#ifndef MINISQL_TABLE_PAGE_DIRECTORY_H
+#define MINISQL_TABLE_PAGE_DIRECTORY_H
+
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+
+/**
+ * The pages of a table heap in chain order, so that the last page, the n-th page or a range of pages can be found
+ * without walking the chain: inserts go to the tail directly, scans can be split into disjoint page ranges and
+ * statistics can sample random pages.
+ *
+ * Pages are only ever appended to a table heap, the directory follows the chain by Append(). It is kept in memory:
+ * the directory of a new heap starts with its first page, the one of an existing heap is built by walking the chain
+ * once, on first use.
+ */
+class TablePageDirectory {
+ public:
+  explicit TablePageDirectory(BufferPoolManager *buffer_pool_manager) : buffer_pool_manager_(buffer_pool_manager) {}
+
+  /** The directory of a new heap, holding only its first page. */
+  void Init(page_id_t first_page_id);
+
+  /** The directory of an existing heap starting at first_page_id, built on first use. */
+  void Load(page_id_t first_page_id);
+
+  /**
+   * Record that page_id was linked after prev_page_id, the last page of the heap. Called while the last page is
+   * still write latched, so appends arrive in chain order.
+   */
+  void Append(page_id_t prev_page_id, page_id_t page_id);
+
+  page_id_t GetLastPageId();
+
+  size_t GetPageCount();
+
+  /** @return the page at position index of the chain, INVALID_PAGE_ID if past the end */
+  page_id_t GetPageId(size_t index);
+
+  /** @return the pages at positions [begin, end) of the chain, end is clamped to the page count */
+  std::vector<page_id_t> GetPageIds(size_t begin, size_t end);
+
+ private:
+  /**
+   * Walk the page chain if the directory was not built yet. Pages are latched without holding latch_ (an inserter
+   * holds the last page while appending), the lock is released during the walk.
+   */
+  void EnsureBuilt(std::unique_lock<std::mutex> &lock);
+
+  BufferPoolManager *buffer_pool_manager_;
+  page_id_t first_page_id_{INVALID_PAGE_ID};
+  std::vector<page_id_t> page_ids_;
+  // 目录建立期间追加的页面 (prev, page)，建好后补上遍历没有看到的
+  std::vector<std::pair<page_id_t, page_id_t>> pending_appends_;
+  bool built_{false};
+  std::mutex latch_;
+};
+
+#endif  // MINISQL_TABLE_PAGE_DIRECTORY_H
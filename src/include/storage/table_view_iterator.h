@@ -0,0 +1,96 @@
+#ifndef MINISQL_TABLE_VIEW_ITERATOR_H
+#define MINISQL_TABLE_VIEW_ITERATOR_H
+
+#include <functional>
+#include <vector>
+
+#include "buffer/page_guard.h"
+#include "common/rowid.h"
+#include "concurrency/txn.h"
+#include "record/row_view.h"
+
+class TableHeap;
+class TablePage;
+class ZoneMapFilter;
+
+/**
+ * Scan of a table heap handing out RowViews instead of Rows: the page under the current row stays pinned and
+ * read latched, rows are neither decoded nor copied until the caller asks for it.
+ *
+ * The view is only valid until the iterator moves or Release() is called. A caller that modifies the table between
+ * two rows (e.g. an executor under an update) must Release() first, the next ++ fetches the page again and resumes
+ * after the released row.
+ *
+ * With a ZoneMapFilter, pages whose zone map rules the filter out are stepped over without looking at their rows.
+ * A PageFilter does the same for the pages it returns false for, e.g. the ones a bloom filter index rules out.
+ */
+class TableViewIterator {
+ public:
+  /** @return false if no row the caller looks for can be on the page */
+  using PageFilter = std::function<bool(page_id_t)>;
+
+  TableViewIterator() = default;
+
+  /**
+   * Positioned at the first row of the table, filter may be nullptr and must outlive the iterator, page_filter may
+   * be empty.
+   */
+  explicit TableViewIterator(TableHeap *table_heap, Txn *txn, const ZoneMapFilter *filter = nullptr,
+                             PageFilter page_filter = nullptr);
+
+  /** Positioned at the first row of the listed pages, which are visited in that order instead of the page chain. */
+  TableViewIterator(TableHeap *table_heap, Txn *txn, std::vector<page_id_t> pages, const ZoneMapFilter *filter,
+                    PageFilter page_filter);
+
+  TableViewIterator(TableViewIterator &&that) noexcept = default;
+
+  TableViewIterator &operator=(TableViewIterator &&that) noexcept = default;
+
+  TableViewIterator(const TableViewIterator &) = delete;
+
+  TableViewIterator &operator=(const TableViewIterator &) = delete;
+
+  inline bool IsEnd() const { return rid_ == INVALID_ROWID; }
+
+  inline bool IsReleased() const { return released_; }
+
+  const RowView &operator*() const { return view_; }
+
+  const RowView *operator->() const { return &view_; }
+
+  TableViewIterator &operator++();
+
+  /** Unpin the pages under the current row, the view becomes invalid. */
+  void Release();
+
+  /** @return how many pages the zone maps and the page filter let the scan skip so far */
+  inline uint32_t GetSkippedPageCount() const { return skipped_pages_; }
+
+ private:
+  /** Find the first row at or after next_rid, walking to the following pages if needed, and point the view at it. */
+  void Seek(bool found, RowId next_rid);
+
+  /** @return the first row of the page under page_guard_, false if it has none or the filter rules the page out */
+  bool SeekPage(RowId *first_rid);
+
+  /** @return the page to visit after page, INVALID_PAGE_ID at the end of the scan */
+  page_id_t NextPageId(TablePage *page);
+
+  TableHeap *table_heap_{nullptr};
+  Txn *txn_{nullptr};
+  const ZoneMapFilter *filter_{nullptr};
+  PageFilter page_filter_;
+  // 只扫描这些页面时非空，next_page_index_ 是下一个要去的位置
+  std::vector<page_id_t> pages_;
+  bool use_pages_{false};
+  size_t next_page_index_{0};
+  uint32_t skipped_pages_{0};
+  RowId rid_{INVALID_ROWID};
+  ReadPageGuard page_guard_;
+  // 记录被搬到其他页面时，该页面也要保持 pin 住
+  ReadPageGuard forward_guard_;
+  RowView view_;
+  bool released_{false};
+};
+
+#endif  // MINISQL_TABLE_VIEW_ITERATOR_H
@@ -0,0 +1,83 @@
+#ifndef MINISQL_ZONE_MAP_H
+#define MINISQL_ZONE_MAP_H
+
+#include <vector>
+
+#include "record/row.h"
+#include "record/row_view.h"
+#include "record/schema.h"
+
+/**
+ * A conjunction of simple conditions on the columns of a table, `column op constant` or `column is null`, that a
+ * ZoneMap can check against the summary of a page.
+ */
+class ZoneMapFilter {
+ public:
+  enum class Op { kEqual, kLessThan, kLessThanEquals, kGreaterThan, kGreaterThanEquals, kIsNull };
+
+  struct Term {
+    uint32_t column_;
+    Op op_;
+    double value_;
+  };
+
+  void AddTerm(uint32_t column, Op op, double value = 0) { terms_.push_back({column, op, value}); }
+
+  inline bool IsEmpty() const { return terms_.empty(); }
+
+  inline const std::vector<Term> &GetTerms() const { return terms_; }
+
+ private:
+  std::vector<Term> terms_;
+};
+
+/**
+ * Summary of the rows whose home is one table page: per column the number of nulls and, for int and float columns,
+ * the min and max of the other values. Char columns only get their null count.
+ *
+ * Summaries are only widened, never shrunk: deleting a row or overwriting a value leaves them as they were, so they
+ * may be wider than the rows on the page but never narrower. A summary is complete once it covers every row of the
+ * page, only complete summaries are used to skip pages.
+ */
+class ZoneMap {
+ public:
+  explicit ZoneMap(const Schema *schema, bool complete) : columns_(schema->GetColumnCount()), complete_(complete) {}
+
+  /** Widen the summary with the values of row. */
+  void Add(const Row &row);
+
+  void Add(const RowView &view);
+
+  /** Widen the summary with another summary of the same page. */
+  void Merge(const ZoneMap &other);
+
+  inline bool IsComplete() const { return complete_; }
+
+  inline void SetComplete() { complete_ = true; }
+
+  inline uint32_t GetNullCount(uint32_t column) const { return columns_[column].null_count_; }
+
+  /** @return false if field is null or not an int or float, otherwise its value in value */
+  static bool GetNumericValue(const Field &field, double *value);
+
+  /**
+   * @return false if no row summarized can satisfy every term of filter, true if some row may
+   */
+  bool MayMatch(const ZoneMapFilter &filter) const;
+
+ private:
+  void AddField(uint32_t column, const Field &field);
+
+  struct ColumnSummary {
+    uint32_t null_count_{0};
+    bool has_value_{false};
+    // int32 和 float 都能用 double 精确表示
+    double min_{0};
+    double max_{0};
+  };
+
+  std::vector<ColumnSummary> columns_;
+  bool complete_;
+};
+
+#endif  // MINISQL_ZONE_MAP_H
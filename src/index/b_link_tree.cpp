@@ -0,0 +1,386 @@
+#include "index/b_link_tree.h"
+
+#include <thread>
+
+#include "glog/logging.h"
+#include "index/generic_key.h"
+#include "page/index_roots_page.h"
+
+BLinkTree::BLinkTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager, const KeyManager &KM,
+                     int leaf_max_size, int internal_max_size)
+    : index_id_(index_id),
+      buffer_pool_manager_(buffer_pool_manager),
+      processor_(KM),
+      leaf_max_size_(leaf_max_size),
+      internal_max_size_(internal_max_size) {
+  ReadPageGuard header_guard = buffer_pool_manager_->FetchPageRead(INDEX_ROOTS_PAGE_ID);
+  if (header_guard.IsValid()) {
+    page_id_t root_page_id;
+    if (header_guard.As<IndexRootsPage>()->GetRootId(index_id_, &root_page_id)) {
+      root_page_id_ = root_page_id;
+    }
+  }
+  // 每个页面留出一个 pair 的位置存放 high key 和右链接
+  if (leaf_max_size == UNDEFINED_SIZE) {
+    leaf_max_size_ = (buffer_pool_manager_->GetPageSize() - B_LINK_LEAF_PAGE_HEADER_SIZE) /
+                         (processor_.GetKeySize() + sizeof(RowId)) - 1;
+  }
+  if (internal_max_size == UNDEFINED_SIZE) {
+    internal_max_size_ = (buffer_pool_manager_->GetPageSize() - B_LINK_INTERNAL_PAGE_HEADER_SIZE) /
+                             (processor_.GetKeySize() + sizeof(page_id_t)) - 1;
+  }
+}
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+template <typename F>
+auto BLinkTree::ReadOptimistic(BasicPageGuard &guard, F &&read) {
+  Page *page = guard.GetPage();
+  while (true) {
+    uint64_t version = page->GetVersion();
+    // 版本为奇数时有写者持有页面
+    if ((version & 1) == 0) {
+      auto result = read(guard.As<BPlusTreePage>());
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (page->GetVersion() == version) {
+        return result;
+      }
+    }
+    std::this_thread::yield();
+  }
+}
+
+page_id_t BLinkTree::FindLeaf(const GenericKey *key, std::vector<page_id_t> *path) {
+  page_id_t page_id = root_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    BasicPageGuard guard = buffer_pool_manager_->FetchPageBasic(page_id);
+    if (!guard.IsValid()) {
+      throw std::runtime_error("Failed to fetch page during B-link tree traversal.");
+    }
+    // <下一个页面, 是否向右移动>，叶子返回 INVALID_PAGE_ID
+    auto [next_page_id, right] = ReadOptimistic(guard, [&](BPlusTreePage *node) {
+      if (node->IsLeafPage()) {
+        return std::make_pair(INVALID_PAGE_ID, false);
+      }
+      if (key != nullptr && MoveRight(node, key)) {
+        return std::make_pair(RightLink(node), true);
+      }
+      auto *internal = reinterpret_cast<InternalPage *>(node);
+      return std::make_pair(key == nullptr ? internal->ValueAt(0) : internal->Lookup(key, processor_), false);
+    });
+    if (next_page_id == INVALID_PAGE_ID) {
+      return page_id;
+    }
+    if (!right && path != nullptr) {
+      path->push_back(page_id);
+    }
+    page_id = next_page_id;
+  }
+  return INVALID_PAGE_ID;
+}
+
+bool BLinkTree::GetValue(const GenericKey *key, std::vector<RowId> &result, [[maybe_unused]] Txn *transaction) {
+  page_id_t page_id = FindLeaf(key, nullptr);
+  while (page_id != INVALID_PAGE_ID) {
+    BasicPageGuard guard = buffer_pool_manager_->FetchPageBasic(page_id);
+    if (!guard.IsValid()) {
+      return false;
+    }
+    struct LeafRead {
+      page_id_t right_;
+      bool found_;
+      RowId value_;
+    };
+    LeafRead read = ReadOptimistic(guard, [&](BPlusTreePage *node) {
+      LeafRead leaf_read{INVALID_PAGE_ID, false, RowId()};
+      if (MoveRight(node, key)) {
+        leaf_read.right_ = RightLink(node);
+      } else {
+        leaf_read.found_ = reinterpret_cast<LeafPage *>(node)->Lookup(key, leaf_read.value_, processor_);
+      }
+      return leaf_read;
+    });
+    if (read.right_ == INVALID_PAGE_ID) {
+      if (read.found_) {
+        result.push_back(read.value_);
+      }
+      return read.found_;
+    }
+    page_id = read.right_;
+  }
+  return false;
+}
+
+void BLinkTree::Scan(const GenericKey *low, const std::function<bool(GenericKey *, const RowId &)> &visit) {
+  page_id_t page_id = FindLeaf(low, nullptr);
+  if (page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(page_id);
+  while (low != nullptr && MoveRight(guard.As<BPlusTreePage>(), low)) {
+    guard = buffer_pool_manager_->FetchPageRead(RightLink(guard.As<BPlusTreePage>()));
+  }
+  int index = low == nullptr ? 0 : guard.As<LeafPage>()->KeyIndex(low, processor_);
+  while (true) {
+    auto *leaf = guard.As<LeafPage>();
+    for (; index < leaf->GetSize(); index++) {
+      if (!visit(leaf->KeyAt(index), leaf->ValueAt(index))) {
+        return;
+      }
+    }
+    if (leaf->GetNextPageId() == INVALID_PAGE_ID) {
+      return;
+    }
+    // 先锁住右边的叶子再释放当前叶子
+    guard = buffer_pool_manager_->FetchPageRead(leaf->GetNextPageId());
+    index = 0;
+  }
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+bool BLinkTree::Insert(GenericKey *key, const RowId &value, [[maybe_unused]] Txn *transaction) {
+  std::vector<page_id_t> path;
+  page_id_t leaf_id = FindLeaf(key, &path);
+  if (leaf_id == INVALID_PAGE_ID) {
+    std::unique_lock<std::mutex> lock(root_latch_);
+    if (IsEmpty()) {
+      StartNewTree(key, value);
+      return true;
+    }
+    lock.unlock();
+    leaf_id = FindLeaf(key, &path);
+  }
+  WritePageGuard guard = LockCovering(leaf_id, key);
+  auto *leaf = guard.As<LeafPage>();
+  RowId temp_val;
+  if (leaf->Lookup(key, temp_val, processor_)) {
+    return false;
+  }
+  if (leaf->GetSize() < leaf->GetMaxSize()) {
+    guard.AsMut<LeafPage>()->Insert(key, value, processor_);
+    return true;
+  }
+
+  // 叶子已满，分裂出右边的新叶子
+  page_id_t new_page_id;
+  BasicPageGuard new_guard = buffer_pool_manager_->NewPageGuarded(new_page_id);
+  if (!new_guard.IsValid()) {
+    throw std::runtime_error("out of memory");
+  }
+  leaf = guard.AsMut<LeafPage>();
+  auto *new_leaf = new_guard.AsMut<LeafPage>();
+  new_leaf->Init(new_page_id, INVALID_PAGE_ID, leaf->GetKeySize(), leaf_max_size_);
+  leaf->MoveHalfTo(new_leaf);
+  GenericKey *separator = processor_.InitKey();
+  memcpy(separator, new_leaf->KeyAt(0), processor_.GetKeySize());
+  if (processor_.CompareKeys(key, separator) < 0) {
+    leaf->Insert(key, value, processor_);
+  } else {
+    new_leaf->Insert(key, value, processor_);
+  }
+  // 新叶子继承原来的右链接和 high key，原叶子的范围到分隔键为止
+  SetRightLink(new_leaf, RightLink(leaf));
+  SetHighKey(new_leaf, HighKey(leaf));
+  SetRightLink(leaf, new_page_id);
+  SetHighKey(leaf, separator);
+  leaf_id = guard.PageId();
+  new_guard.Drop();
+  guard.Drop();
+
+  InsertIntoParent(0, leaf_id, separator, new_page_id, path);
+  free(separator);
+  return true;
+}
+
+void BLinkTree::InsertIntoParent(int level, page_id_t left_id, GenericKey *key, page_id_t right_id,
+                                 std::vector<page_id_t> &path) {
+  GenericKey *separator = processor_.InitKey();
+  memcpy(separator, key, processor_.GetKeySize());
+  while (true) {
+    if (path.empty()) {
+      std::unique_lock<std::mutex> lock(root_latch_);
+      if (root_page_id_ == left_id) {
+        // 分裂的是根节点，长出新的根
+        page_id_t root_page_id;
+        BasicPageGuard root_guard = buffer_pool_manager_->NewPageGuarded(root_page_id);
+        if (!root_guard.IsValid()) {
+          throw std::runtime_error("out of memory");
+        }
+        auto *root = root_guard.AsMut<InternalPage>();
+        root->Init(root_page_id, INVALID_PAGE_ID, processor_.GetKeySize(), internal_max_size_);
+        root->PopulateNewRoot(left_id, separator, right_id);
+        SetRightLink(root, INVALID_PAGE_ID);
+        root_guard.Drop();
+        root_page_id_ = root_page_id;
+        UpdateRootPageId(false);
+        break;
+      }
+      lock.unlock();
+      // 下降时 left_id 还是根，之后根已经分裂过：重新下降，取出上一层的页面和它的祖先
+      std::vector<page_id_t> new_path;
+      FindLeaf(separator, &new_path);
+      ASSERT(new_path.size() > static_cast<size_t>(level), "The tree must have grown above the old root.");
+      new_path.resize(new_path.size() - level);
+      path = std::move(new_path);
+    }
+    page_id_t parent_id = path.back();
+    path.pop_back();
+
+    WritePageGuard guard = LockCovering(parent_id, separator);
+    auto *parent = guard.AsMut<InternalPage>();
+    // 按分隔键找位置：left_id 可能还没有加进父节点（它自己也是分裂出来的）
+    parent->InsertNodeAfter(parent->Lookup(separator, processor_), separator, right_id);
+    if (parent->GetSize() < parent->GetMaxSize()) {
+      break;
+    }
+
+    // 父节点满了，继续分裂
+    page_id_t new_page_id;
+    BasicPageGuard new_guard = buffer_pool_manager_->NewPageGuarded(new_page_id);
+    if (!new_guard.IsValid()) {
+      throw std::runtime_error("out of memory");
+    }
+    auto *new_internal = new_guard.AsMut<InternalPage>();
+    new_internal->Init(new_page_id, INVALID_PAGE_ID, processor_.GetKeySize(), internal_max_size_);
+    parent->MoveHalfTo(new_internal);
+    SetRightLink(new_internal, RightLink(parent));
+    SetHighKey(new_internal, HighKey(parent));
+    SetRightLink(parent, new_page_id);
+    // 新页面的第一个键就是分隔键
+    SetHighKey(parent, new_internal->KeyAt(0));
+    memcpy(separator, new_internal->KeyAt(0), processor_.GetKeySize());
+    left_id = guard.PageId();
+    right_id = new_page_id;
+    level++;
+  }
+  free(separator);
+}
+
+void BLinkTree::StartNewTree(GenericKey *key, const RowId &value) {
+  page_id_t root_page_id;
+  BasicPageGuard guard = buffer_pool_manager_->NewPageGuarded(root_page_id);
+  if (!guard.IsValid()) {
+    throw std::runtime_error("out of memory");
+  }
+  auto *root = guard.AsMut<LeafPage>();
+  root->Init(root_page_id, INVALID_PAGE_ID, processor_.GetKeySize(), leaf_max_size_);
+  root->Insert(key, value, processor_);
+  guard.Drop();
+  root_page_id_ = root_page_id;
+  UpdateRootPageId(true);
+}
+
+WritePageGuard BLinkTree::LockCovering(page_id_t page_id, const GenericKey *key) {
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(page_id);
+  if (!guard.IsValid()) {
+    throw std::runtime_error("Failed to fetch page during B-link tree traversal.");
+  }
+  while (key != nullptr && MoveRight(guard.As<BPlusTreePage>(), key)) {
+    // 先锁住右边再释放左边
+    guard = buffer_pool_manager_->FetchPageWrite(RightLink(guard.As<BPlusTreePage>()));
+  }
+  return guard;
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+bool BLinkTree::Remove(const GenericKey *key, [[maybe_unused]] Txn *transaction) {
+  page_id_t leaf_id = FindLeaf(key, nullptr);
+  if (leaf_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  WritePageGuard guard = LockCovering(leaf_id, key);
+  auto *leaf = guard.As<LeafPage>();
+  int size = leaf->GetSize();
+  // 不合并页面，叶子删空之后仍留在链表中
+  return guard.AsMut<LeafPage>()->RemoveAndDeleteRecord(key, processor_) < size;
+}
+
+/*****************************************************************************
+ * UTILITIES
+ *****************************************************************************/
+page_id_t BLinkTree::RightLink(BPlusTreePage *node) {
+  if (node->IsLeafPage()) {
+    return reinterpret_cast<LeafPage *>(node)->GetNextPageId();
+  }
+  return reinterpret_cast<InternalPage *>(node)->ValueAt(node->GetMaxSize());
+}
+
+void BLinkTree::SetRightLink(BPlusTreePage *node, page_id_t page_id) {
+  if (node->IsLeafPage()) {
+    reinterpret_cast<LeafPage *>(node)->SetNextPageId(page_id);
+  } else {
+    reinterpret_cast<InternalPage *>(node)->SetValueAt(node->GetMaxSize(), page_id);
+  }
+}
+
+GenericKey *BLinkTree::HighKey(BPlusTreePage *node) {
+  if (node->IsLeafPage()) {
+    return reinterpret_cast<LeafPage *>(node)->KeyAt(node->GetMaxSize());
+  }
+  return reinterpret_cast<InternalPage *>(node)->KeyAt(node->GetMaxSize());
+}
+
+void BLinkTree::SetHighKey(BPlusTreePage *node, GenericKey *key) {
+  if (node->IsLeafPage()) {
+    reinterpret_cast<LeafPage *>(node)->SetKeyAt(node->GetMaxSize(), key);
+  } else {
+    reinterpret_cast<InternalPage *>(node)->SetKeyAt(node->GetMaxSize(), key);
+  }
+}
+
+bool BLinkTree::MoveRight(BPlusTreePage *node, const GenericKey *key) const {
+  // 最右边的页面没有 high key
+  return RightLink(node) != INVALID_PAGE_ID && processor_.CompareKeys(key, HighKey(node)) >= 0;
+}
+
+void BLinkTree::UpdateRootPageId(bool insert_record) {
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(INDEX_ROOTS_PAGE_ID);
+  auto *index_roots_page = guard.AsMut<IndexRootsPage>();
+  if (insert_record) {
+    index_roots_page->Insert(index_id_, root_page_id_);
+  } else {
+    index_roots_page->Update(index_id_, root_page_id_);
+  }
+}
+
+bool BLinkTree::Check() {
+  bool all_unpinned = buffer_pool_manager_->CheckAllUnpinned();
+  if (!all_unpinned) {
+    LOG(ERROR) << "problem in page unpin" << std::endl;
+  }
+  return all_unpinned;
+}
+
+void BLinkTree::Destroy() {
+  if (IsEmpty()) {
+    return;
+  }
+  Destroy(root_page_id_);
+  root_page_id_ = INVALID_PAGE_ID;
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(INDEX_ROOTS_PAGE_ID);
+  if (guard.IsValid() && guard.As<IndexRootsPage>()->Delete(index_id_)) {
+    guard.SetDirty();
+  }
+}
+
+void BLinkTree::Destroy(page_id_t page_id) {
+  {
+    ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(page_id);
+    if (!guard.IsValid()) {
+      return;
+    }
+    // 每个页面都只被父节点指向一次，右链接不用跟随
+    if (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+      auto *internal = guard.As<InternalPage>();
+      for (int i = 0; i < internal->GetSize(); i++) {
+        Destroy(internal->ValueAt(i));
+      }
+    }
+  }
+  buffer_pool_manager_->DeletePage(page_id);
+}
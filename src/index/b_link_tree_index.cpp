@@ -0,0 +1,66 @@
+#include "index/b_link_tree_index.h"
+
+BLinkTreeIndex::BLinkTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size,
+                               BufferPoolManager *buffer_pool_manager)
+    : Index(index_id, key_schema),
+      processor_(key_schema_, key_size),
+      container_(index_id, buffer_pool_manager, processor_) {}
+
+dberr_t BLinkTreeIndex::InsertEntry(const Row &key, RowId row_id, Txn *txn) {
+  GenericKey *index_key = processor_.InitKey();
+  // 超出列长度的值编码不唯一，不能放进索引
+  if (!processor_.SerializeFromKey(index_key, key, key_schema_)) {
+    free(index_key);
+    return DB_FAILED;
+  }
+  bool status = container_.Insert(index_key, row_id, txn);
+  free(index_key);
+  return status ? DB_SUCCESS : DB_FAILED;
+}
+
+dberr_t BLinkTreeIndex::RemoveEntry(const Row &key, [[maybe_unused]] RowId row_id, Txn *txn) {
+  GenericKey *index_key = processor_.InitKey();
+  processor_.SerializeFromKey(index_key, key, key_schema_);
+  container_.Remove(index_key, txn);
+  free(index_key);
+  return DB_SUCCESS;
+}
+
+dberr_t BLinkTreeIndex::ScanKey(const Row &key, vector<RowId> &result, Txn *txn, string compare_operator) {
+  GenericKey *index_key = processor_.InitKey();
+  processor_.SerializeFromKey(index_key, key, key_schema_);
+  if (compare_operator == "=") {
+    container_.GetValue(index_key, result, txn);
+  } else if (compare_operator == ">" || compare_operator == ">=") {
+    bool inclusive = compare_operator == ">=";
+    container_.Scan(index_key, [&](GenericKey *entry_key, const RowId &rid) {
+      if (inclusive || processor_.CompareKeys(entry_key, index_key) != 0) {
+        result.push_back(rid);
+      }
+      return true;
+    });
+  } else if (compare_operator == "<" || compare_operator == "<=") {
+    int stop = compare_operator == "<" ? 0 : 1;
+    container_.Scan(nullptr, [&](GenericKey *entry_key, const RowId &rid) {
+      if (processor_.CompareKeys(entry_key, index_key) >= stop) {
+        return false;
+      }
+      result.push_back(rid);
+      return true;
+    });
+  } else if (compare_operator == "<>") {
+    container_.Scan(nullptr, [&](GenericKey *entry_key, const RowId &rid) {
+      if (processor_.CompareKeys(entry_key, index_key) != 0) {
+        result.push_back(rid);
+      }
+      return true;
+    });
+  }
+  free(index_key);
+  return result.empty() ? DB_KEY_NOT_FOUND : DB_SUCCESS;
+}
+
+dberr_t BLinkTreeIndex::Destroy() {
+  container_.Destroy();
+  return DB_SUCCESS;
+}
@@ -1,38 +1,41 @@
 #include "index/b_plus_tree.h"
 
+#include <algorithm>
 #include <string>
 
 #include "glog/logging.h"
 #include "index/basic_comparator.h"
 #include "index/generic_key.h"
+#include "index/posting_list.h"
 #include "page/index_roots_page.h"
 
 /**
  * TODO: Student Implement
  */
 BPlusTree::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager, const KeyManager &KM,
-                     int leaf_max_size, int internal_max_size)
+                     int leaf_max_size, int internal_max_size, bool unique)
     : index_id_(index_id),
       buffer_pool_manager_(buffer_pool_manager),
       processor_(KM),
       leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {
-        Page *header_page_obj = buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID);
-        if (header_page_obj == nullptr) {
+      internal_max_size_(internal_max_size),
+      unique_(unique) {
+        ReadPageGuard header_guard = buffer_pool_manager_->FetchPageRead(INDEX_ROOTS_PAGE_ID);
+        if (!header_guard.IsValid()) {
             return;
         }
-        IndexRootsPage *header_page = reinterpret_cast<IndexRootsPage *>(header_page_obj->GetData());
+        IndexRootsPage *header_page = header_guard.As<IndexRootsPage>();
         root_page_id_ = INVALID_PAGE_ID;
         page_id_t temp_root_page_id;
         if (header_page->GetRootId(index_id_, &temp_root_page_id)) {
           root_page_id_ = temp_root_page_id;
         }
-        buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID,false);
+        header_guard.Drop();
+        // 默认不限条目数，页面的字节决定何时分裂和合并
         if(leaf_max_size == UNDEFINED_SIZE)
-          leaf_max_size_ = (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / (processor_.GetKeySize() + sizeof(RowId));
+          leaf_max_size_ = (buffer_pool_manager_->GetPageSize() - LEAF_PAGE_HEADER_SIZE) / LeafPage::SLOT_SIZE;
         if(internal_max_size == UNDEFINED_SIZE)
-          internal_max_size_ = (PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (processor_.GetKeySize() + sizeof(page_id_t));
-        
+          internal_max_size_ = (buffer_pool_manager_->GetPageSize() - INTERNAL_PAGE_HEADER_SIZE) / InternalPage::SLOT_SIZE;
 }
 
 void BPlusTree::Destroy(page_id_t current_page_id) {
@@ -40,80 +43,61 @@ void BPlusTree::Destroy(page_id_t current_page_id) {
   if (current_page_id == INVALID_PAGE_ID) {
     // 这是销毁整个树的入口。
     // 我们需要从一个特殊的地方（IndexRootsPage）获取这棵B+树真正的根页面ID。
-    Page *header_page_obj = buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID);
-    if (header_page_obj == nullptr) {
-      // 如果无法获取存储根页面ID的"头部页面"，说明可能存在更深层的问题，
-      // 或者树的相关信息已丢失，此时无法继续，直接返回。
-      return;
-    }
-    // 将头部页面的原始数据转换为 IndexRootsPage 类型，方便我们调用其方法。
-    IndexRootsPage *header_page = reinterpret_cast<IndexRootsPage *>(header_page_obj->GetData());
-    
     page_id_t actual_root_page_id;
-    // 尝试从头部页面中根据当前树的 index_id_ 获取其根页面ID。
-    if (header_page->GetRootId(index_id_, &actual_root_page_id)) {
-      // 成功获取到根页面ID后，我们不再需要头部页面了，所以要 Unpin它。
-      buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, false); 
-      if (actual_root_page_id != INVALID_PAGE_ID) {
-        // 如果获取到的根页面ID是有效的，就以这个ID为起点，开始递归销毁过程。
-        Destroy(actual_root_page_id); 
-        Page *roots_page_obj = buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID);
-        if (roots_page_obj != nullptr) {
-          IndexRootsPage *roots_page = reinterpret_cast<IndexRootsPage *>(roots_page_obj->GetData());
-          // 删除当前索引ID对应的记录
-          if (roots_page->Delete(index_id_)) {
-            // 成功删除，标记页面为脏
-            buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, true);
-          } else {
-            buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, false);
-          }
-        }
-        // 根据具体需求，这里可能需要重新获取 header_page 并调用 header_page->Delete(index_id_)
-        // 或者将其 root_id 更新为 INVALID_PAGE_ID。
+    {
+      ReadPageGuard header_guard = buffer_pool_manager_->FetchPageRead(INDEX_ROOTS_PAGE_ID);
+      if (!header_guard.IsValid()) {
+        // 如果无法获取存储根页面ID的"头部页面"，说明可能存在更深层的问题，
+        // 或者树的相关信息已丢失，此时无法继续，直接返回。
+        return;
+      }
+      // 尝试从头部页面中根据当前树的 index_id_ 获取其根页面ID。
+      // 如果找不到，可能意味着树已经被销毁或者为空。
+      if (!header_guard.As<IndexRootsPage>()->GetRootId(index_id_, &actual_root_page_id)) {
+        return;
+      }
+    }
+    if (actual_root_page_id != INVALID_PAGE_ID) {
+      // 如果获取到的根页面ID是有效的，就以这个ID为起点，开始递归销毁过程。
+      Destroy(actual_root_page_id);
+      WritePageGuard roots_guard = buffer_pool_manager_->FetchPageWrite(INDEX_ROOTS_PAGE_ID);
+      // 删除当前索引ID对应的记录，成功删除则标记页面为脏
+      if (roots_guard.IsValid() && roots_guard.As<IndexRootsPage>()->Delete(index_id_)) {
+        roots_guard.SetDirty();
       }
-    } else {
-      // 如果在头部页面中找不到这个 index_id_ 对应的根页面ID，
-      // 可能意味着树已经被销毁或者为空。同样 Unpin 头部页面。
-      buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, false);
     }
     // 处理完初始 INVALID_PAGE_ID 的情况后，函数返回。
-    return; 
-  }
-
-  // 情况2：递归调用，current_page_id 是一个有效的页面ID
-  // 获取当前要处理的页面。
-  Page *page_obj = buffer_pool_manager_->FetchPage(current_page_id);
-  if (page_obj == nullptr) {
-    // 如果页面无法获取（例如，它可能已经被其他操作删除了，或者缓冲池管理器出错），
-    // 我们无法处理它，直接返回。
     return;
   }
 
-  // 将获取到的页面的原始数据转换为 BPlusTreePage 类型。
-  // BPlusTreePage 是叶子页面和内部页面的基类，它有一个 IsLeafPage() 方法。
-  BPlusTreePage *node = reinterpret_cast<BPlusTreePage *>(page_obj->GetData());
-
-  if (node->IsLeafPage()) {
-    // 如果当前节点是叶子页面：
-    // 叶子页面没有子节点需要进一步递归销毁。
-    // 我们只需要 Unpin（解除锁定）然后从缓冲池管理器中删除这个页面。
-    buffer_pool_manager_->UnpinPage(current_page_id, false);
-    buffer_pool_manager_->DeletePage(current_page_id);
-  } else {
-    // 如果当前节点是内部页面：
-    // 首先，将节点转换为更具体的 InternalPage 类型，以便访问其子节点。
-    InternalPage *internal_node = reinterpret_cast<InternalPage *>(node);
-    // 遍历这个内部节点中存储的所有子页面的ID。
-    for (int i = 0; i < internal_node->GetSize(); ++i) {
-      // 对于每一个子页面的ID (internal_node->ValueAt(i))，递归调用 Destroy 函数。
-      // 这会确保在删除父节点之前，其所有子节点都已经被处理和删除了。
-      Destroy(internal_node->ValueAt(i));
+  // 情况2：递归调用，current_page_id 是一个有效的页面ID
+  {
+    ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(current_page_id);
+    if (!guard.IsValid()) {
+      // 如果页面无法获取（例如，它可能已经被其他操作删除了，或者缓冲池管理器出错），
+      // 我们无法处理它，直接返回。
+      return;
+    }
+    // 叶子页面没有子节点需要进一步递归销毁；
+    // 内部页面则需要在删除自己之前，先把所有子页面递归删除。
+    BPlusTreePage *node = guard.As<BPlusTreePage>();
+    if (!node->IsLeafPage()) {
+      InternalPage *internal_node = reinterpret_cast<InternalPage *>(node);
+      for (int i = 0; i < internal_node->GetSize(); ++i) {
+        Destroy(internal_node->ValueAt(i));
+      }
+    } else if (!unique_) {
+      // 非唯一索引的叶子还要释放其中的 posting list
+      LeafPage *leaf_node = reinterpret_cast<LeafPage *>(node);
+      for (int i = 0; i < leaf_node->GetSize(); ++i) {
+        if (PostingList::IsList(leaf_node->ValueAt(i))) {
+          PostingList::Destroy(buffer_pool_manager_, leaf_node->ValueAt(i));
+        }
+      }
     }
-    // 当这个内部节点的所有子节点都被销毁后，
-    // 我们 Unpin 并删除当前这个内部页面。
-    buffer_pool_manager_->UnpinPage(current_page_id, false);
-    buffer_pool_manager_->DeletePage(current_page_id);
   }
+  // guard 离开作用域后页面已经 unpin，可以安全删除。
+  buffer_pool_manager_->DeletePage(current_page_id);
 }
 
 /*
@@ -127,68 +111,29 @@ bool BPlusTree::IsEmpty() const {
  * SEARCH
  *****************************************************************************/
 /*
- * Return the only value that associated with input key
+ * Return the values associated with input key, in row id order when there are several
  * This method is used for point query
  * @return : true means key exists
  */
 bool BPlusTree::GetValue(const GenericKey *key, std::vector<RowId> &result, Txn *transaction) {
-  // Step 2 & 3: 如果树为空，返回 false
-  if (IsEmpty()) {
+  // 从根页面开始向下查找，子页面加读锁之后才释放父页面
+  ReadPageGuard guard = FindLeafRead(key);
+  if (!guard.IsValid()) {
+    // 树为空或无法获取页面
     return false;
   }
 
-  // Step 4: 获取 root_page_id_ 对应的页面
-  page_id_t current_page_id = root_page_id_;
-  Page *current_page_obj = buffer_pool_manager_->FetchPage(current_page_id);
-  if (current_page_obj == nullptr) {
-    // 无法获取根页面
-    return false;
-  }
-
-  // Step 5: 将页面数据转换为 BPlusTreePage 类型
-  BPlusTreePage *current_node_ptr = reinterpret_cast<BPlusTreePage *>(current_page_obj->GetData());
-
-  // Step 6: 当 node 不是叶子页面时 (traverse to leaf)
-  while (!current_node_ptr->IsLeafPage()) {
-    // Step 7: 将 node 转换为 InternalPage 类型
-    InternalPage *internal_node = reinterpret_cast<InternalPage *>(current_node_ptr);
-    
-    // Step 8: 获取要查找的子页面 ID
-    // InternalPage::Lookup (或类似方法) 应使用 key 和 processor_ 来找到正确的子页面ID
-    page_id_t child_page_id = internal_node->Lookup(key, processor_);
-    
-    // Step 9: 释放当前 node 页面
-    buffer_pool_manager_->UnpinPage(current_page_id, false);
-    
-    // Step 10: 获取子页面
-    current_page_id = child_page_id;
-    current_page_obj = buffer_pool_manager_->FetchPage(current_page_id);
-    if (current_page_obj == nullptr) {
-      // 无法获取子页面
-      return false; 
-    }
-    
-    // Step 11: 将子页面数据转换为 BPlusTreePage 类型
-    current_node_ptr = reinterpret_cast<BPlusTreePage *>(current_page_obj->GetData());
-  }
-
-  // 此时, current_node_ptr 指向一个叶子页面 (current_page_obj 也指向它)
-  // Step 12: 将 node 转换为 LeafPage 类型
-  LeafPage *leaf_node = reinterpret_cast<LeafPage *>(current_node_ptr);
-
-  // Step 13 & 14 & 15: 查找 key 对应的值, 如果找到值，将值添加到 result 中
-  RowId temp_row_id; // Declare a temporary RowId to store the lookup result
-  bool found = leaf_node->Lookup(key, temp_row_id, processor_); // Pass temp_row_id
-
+  // 在叶子页面中查找 key 对应的值, 如果找到值，将值添加到 result 中
+  RowId temp_row_id;
+  bool found = guard.As<LeafPage>()->Lookup(key, temp_row_id, processor_);
   if (found) {
-    //result.clear(); // Ensure result vector is clean for the single value
-    result.push_back(temp_row_id); // Add the found RowId to the result vector
+    // posting list 的页面由叶子的读锁保护
+    if (PostingList::IsList(temp_row_id)) {
+      PostingList::Collect(buffer_pool_manager_, temp_row_id, result);
+    } else {
+      result.push_back(temp_row_id);
+    }
   }
-
-  // Step 16: 释放 node 页面 (叶子页面)
-  buffer_pool_manager_->UnpinPage(current_page_id, false);
-  
-  // Step 17: 返回是否找到值
   return found;
 }
 
@@ -199,16 +144,35 @@ bool BPlusTree::GetValue(const GenericKey *key, std::vector<RowId> &result, Txn
  * Insert constant key & value pair into b+ tree
  * if current tree is empty, start new tree, update root page id and insert
  * entry, otherwise insert into leaf page.
- * @return: since we only support unique key, if user try to insert duplicate
- * keys return false, otherwise return true.
+ * @return: false if the key exists in a unique tree, or the pair exists in a non-unique one, otherwise true.
+ * A non-unique tree adds value to the posting of an existing key, the leaf does not change size.
  */
-bool BPlusTree::Insert(GenericKey *key, const RowId &value, Txn *transaction) { 
-  if(IsEmpty()){
-    StartNewTree(key,value);
+bool BPlusTree::Insert(GenericKey *key, const RowId &value, Txn *transaction) {
+  // 乐观插入：只锁住叶子，叶子不会分裂时直接插入
+  WritePageGuard leaf_guard = FindLeafOptimistic(key);
+  if (leaf_guard.IsValid()) {
+    LeafPage *leaf_node = leaf_guard.As<LeafPage>();
+    int index = leaf_node->KeyIndex(key, processor_);
+    if (index < leaf_node->GetSize() && leaf_node->CompareAt(index, key, processor_) == 0) {
+      return !unique_ && AddPosting(leaf_guard.AsMut<LeafPage>(), index, value);
+    }
+    if (IsSafe(leaf_node, key, true)) {
+      leaf_guard.AsMut<LeafPage>()->Insert(key, value, processor_);
+      return true;
+    }
+    leaf_guard.Drop();
+  }
+  // 悲观插入：从根开始加写锁
+  Context ctx;
+  ctx.root_lock_ = std::unique_lock<std::shared_mutex>(root_latch_);
+  if (IsEmpty()) {
+    StartNewTree(key, value);
     return true;
   }
-  return InsertIntoLeaf(key,value,transaction);
- }
+  FindLeafPessimistic(key, true, ctx);
+  return InsertIntoLeaf(key, value, ctx, transaction);
+}
+
 /*
  * Insert constant key & value pair into an empty tree
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
@@ -216,14 +180,17 @@ bool BPlusTree::Insert(GenericKey *key, const RowId &value, Txn *transaction) {
  * tree's root page id and insert entry directly into leaf page.
  */
 void BPlusTree::StartNewTree(GenericKey *key, const RowId &value) {
-  Page *page_obj = buffer_pool_manager_->NewPage(root_page_id_);
-  if(page_obj == nullptr){
+  page_id_t root_page_id;
+  BasicPageGuard guard = buffer_pool_manager_->NewPageGuarded(root_page_id);
+  if (!guard.IsValid()) {
     throw std::exception();
   }
-  LeafPage *root_page = reinterpret_cast<LeafPage *>(page_obj->GetData());
-  root_page->Init(root_page_id_, INVALID_PAGE_ID, processor_.GetKeySize(), leaf_max_size_);
+  LeafPage *root_page = guard.AsMut<LeafPage>();
+  root_page->Init(root_page_id, INVALID_PAGE_ID, processor_.GetKeySize(), leaf_max_size_,
+                  buffer_pool_manager_->GetPageSize());
   root_page->Insert(key,value,processor_);
-  buffer_pool_manager_->UnpinPage(root_page_id_,true);
+  guard.Drop();
+  root_page_id_ = root_page_id;
   UpdateRootPageId(1);
 
 }
@@ -233,90 +200,61 @@ void BPlusTree::StartNewTree(GenericKey *key, const RowId &value) {
  * User needs to first find the right leaf page as insertion target, then look
  * through leaf page to see whether insert key exist or not. If exist, return
  * immediately, otherwise insert entry. Remember to deal with split if necessary.
- * @return: since we only support unique key, if user try to insert duplicate
- * keys return false, otherwise return true.
+ * @return: false if the key exists in a unique tree, or the pair exists in a non-unique one, otherwise true.
  */
-
-bool BPlusTree::InsertIntoLeaf(GenericKey *key, const RowId &value, Txn *transaction) { 
-  // 步骤 1 & 2: 找到正确的叶子页面并进行类型转换 
-  page_id_t current_page_id = root_page_id_;
-  Page *current_page_obj = buffer_pool_manager_->FetchPage(current_page_id);
-
-  if (current_page_obj == nullptr) {
-    // 如果树非空（IsEmpty()检查后调用此函数），则 root_page_id_ 应该是有效的。
-    // 此处获取根页面失败是很严重的错误。
-    // LOG(ERROR) << "InsertIntoLeaf: Failed to fetch root page " << root_page_id_;
-    throw std::runtime_error("InsertIntoLeaf: Failed to fetch root page.");
-  }
-
-  BPlusTreePage *current_bpt_page = reinterpret_cast<BPlusTreePage *>(current_page_obj->GetData());
-
-  // 遍历B+树找到目标叶子节点
-  while (!current_bpt_page->IsLeafPage()) {
-    InternalPage *internal_page = reinterpret_cast<InternalPage *>(current_bpt_page);
-    page_id_t child_page_id = internal_page->Lookup(key, processor_);
-    
-    buffer_pool_manager_->UnpinPage(current_page_id, false); // 解锁当前内部节点
-    
-    current_page_id = child_page_id;
-    current_page_obj = buffer_pool_manager_->FetchPage(current_page_id);
-    if (current_page_obj == nullptr) {
-      // LOG(ERROR) << "InsertIntoLeaf: Failed to fetch page " << current_page_id << " during traversal.";
-      throw std::runtime_error("InsertIntoLeaf: Failed to fetch page during B+ tree traversal.");
-    }
-    current_bpt_page = reinterpret_cast<BPlusTreePage *>(current_page_obj->GetData());
-  }
-
-  // 此刻, current_page_obj 指向目标叶子页面, 并且已被锁定 (pinned)
-  LeafPage *leaf_node = reinterpret_cast<LeafPage *>(current_bpt_page);
-  page_id_t leaf_page_id = current_page_id; // 保存页面ID用于后续解锁
+bool BPlusTree::InsertIntoLeaf(GenericKey *key, const RowId &value, Context &ctx, Txn *transaction) {
+  // 步骤 1 & 2: 叶子页面和所有可能被修改的祖先页面都已经加了写锁
+  WritePageGuard &leaf_guard = ctx.write_set_.back();
+  LeafPage *leaf_node = leaf_guard.As<LeafPage>();
 
   // 步骤 3: 检查键是否存在
-  RowId temp_val; // Lookup 需要一个 RowId 参数, 但此处我们不关心其值
-  if (leaf_node->Lookup(key, temp_val, processor_)) {
-    // 键已存在，不允许插入重复键
-    // std::cout << "Duplicate key" << std::endl; // 
-    buffer_pool_manager_->UnpinPage(leaf_page_id, false); // 释放 leaf_node 页面
-    return false; // 重复键返回 false
+  int index = leaf_node->KeyIndex(key, processor_);
+  if (index < leaf_node->GetSize() && leaf_node->CompareAt(index, key, processor_) == 0) {
+    // 键已存在：唯一索引不允许插入重复键，非唯一索引把行号加入这个键
+    return !unique_ && AddPosting(leaf_guard.AsMut<LeafPage>(), index, value);
   }
+  leaf_guard.SetDirty();
 
-  // 步骤 4: 如果叶子页面未满，则插入键和值
-  if (leaf_node->GetSize() < leaf_node->GetMaxSize()) { 
+  // 步骤 4: 如果叶子页面放得下，则插入键和值
+  if (leaf_node->CanInsert(key)) {
     leaf_node->Insert(key, value, processor_);
-    buffer_pool_manager_->UnpinPage(leaf_page_id, true); // 释放 leaf_node 页面 (标记为脏页)
     return true;
   }
 
-  // 步骤 5: 否则 (叶子页面已满)，分裂叶子页面 
-  LeafPage *new_leaf_node = Split(leaf_node, transaction); // Split() 返回新的 (右兄弟) 叶子页面。
-                                                          // Split 应该处理新页面的分配、锁定、数据迁移，并返回锁定的 new_leaf_node。
-                                                          // leaf_node (原始页面) 也被修改并保持锁定状态。
-  if (new_leaf_node == nullptr) {
-      buffer_pool_manager_->UnpinPage(leaf_page_id, true); // 解锁原始叶子页面
-      return false; // 或者抛出异常
-  }
+  // 步骤 5: 否则分裂叶子页面，要插入的键在分裂时一起放进左右两页之一。
+  // 新的 (右兄弟) 叶子页面由 new_leaf_guard 持有，直到插入父节点完成后才 unpin。
+  BasicPageGuard new_leaf_guard = Split(leaf_node, key, value, transaction);
+  LeafPage *new_leaf_node = new_leaf_guard.As<LeafPage>();
 
   leaf_node->SetNextPageId(new_leaf_node->GetPageId()); // 更新原始叶子页面的 next_page_id 指向新叶子页面。
-  
-  // 需要提升到父节点的键是新右兄弟节点的第一个键。
-  GenericKey *promoted_key = new_leaf_node->KeyAt(0);
 
+  // 提升到父节点的是能分开两页的最短的键，而不是新页面完整的第一个键
+  std::vector<char> separator(processor_.GetKeySize());
+  auto *promoted_key = reinterpret_cast<GenericKey *>(separator.data());
+  SeparatorAt(leaf_node, leaf_node->GetSize() - 1, new_leaf_node, 0, promoted_key);
 
-  // 分裂后，原始的 key/value 需要插入到旧的 leaf_node 或新的 new_leaf_node 中。
-  if (processor_.CompareKeys(key, promoted_key) < 0) {
-    // 要插入的键小于新页面的第一个键，因此它属于旧的 (左) 页面。
-    leaf_node->Insert(key, value, processor_);
-  } else {
-    // 要插入的键大于或等于新页面的第一个键，因此它属于新的 (右) 页面。
-    new_leaf_node->Insert(key, value, processor_);
-  }
-  
   InsertIntoParent(leaf_node, promoted_key, new_leaf_node, transaction);
-  
+  return true;
+}
 
-  buffer_pool_manager_->UnpinPage(leaf_page_id, false);             // 解锁原始叶子页面 (现在是左孩子)，标记为脏页。
-  //buffer_pool_manager_->UnpinPage(new_leaf_node->GetPageId(), false); // 解锁新叶子页面 (现在是右孩子)，标记为脏页。
-  
+/*
+ * Add value to the row ids of the index-th key of leaf, which must be write latched and dirtied by the caller.
+ * The first extra row id moves the key's row ids into a posting list.
+ * @return: false if value is already one of them
+ */
+bool BPlusTree::AddPosting(LeafPage *leaf, int index, const RowId &value) {
+  RowId current = leaf->ValueAt(index);
+  if (PostingList::IsList(current)) {
+    return PostingList::Insert(buffer_pool_manager_, current, value);
+  }
+  if (current == value) {
+    return false;
+  }
+  std::vector<RowId> rids{current, value};
+  if (value.Get() < current.Get()) {
+    std::swap(rids[0], rids[1]);
+  }
+  leaf->SetValueAt(index, PostingList::Create(buffer_pool_manager_, rids));
   return true;
 }
 
@@ -326,32 +264,46 @@ bool BPlusTree::InsertIntoLeaf(GenericKey *key, const RowId &value, Txn *transac
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
  * an "out of memory" exception if returned value is nullptr), then move half
  * of key & value pairs from input page to newly created page
+ * The new page stays pinned by the returned guard. It is not latched: no other thread can reach it before the
+ * write latched node (and parent) it is linked from are released.
  */
-BPlusTreeInternalPage *BPlusTree::Split(InternalPage *node, Txn *transaction) {
+BasicPageGuard BPlusTree::Split(InternalPage *node, Txn *transaction) {
   page_id_t new_page_id; 
-  Page *page_obj = buffer_pool_manager_->NewPage(new_page_id);
-  if(page_obj == nullptr){
+  BasicPageGuard guard = buffer_pool_manager_->NewPageGuarded(new_page_id);
+  if (!guard.IsValid()) {
     throw std::exception();
   }
-  InternalPage *new_internal_node = reinterpret_cast<InternalPage *>(page_obj->GetData());
-  new_internal_node->Init(new_page_id,node->GetParentPageId(),node->GetKeySize(),internal_max_size_);
+  InternalPage *new_internal_node = guard.AsMut<InternalPage>();
+  new_internal_node->Init(new_page_id, node->GetParentPageId(), node->GetKeySize(), internal_max_size_,
+                          buffer_pool_manager_->GetPageSize());
   node->MoveHalfTo(new_internal_node,buffer_pool_manager_);
-  buffer_pool_manager_->UnpinPage(new_page_id,true);
-  return new_internal_node;
+  return guard;
 }
 
-BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Txn *transaction) { 
+BasicPageGuard BPlusTree::Split(LeafPage *node, GenericKey *key, const RowId &value, Txn *transaction) {
   page_id_t new_page_id; 
-  Page *page_obj = buffer_pool_manager_->NewPage(new_page_id);
-  if(page_obj == nullptr){
+  BasicPageGuard guard = buffer_pool_manager_->NewPageGuarded(new_page_id);
+  if (!guard.IsValid()) {
     throw std::exception();
   }
-  LeafPage *new_leaf_node = reinterpret_cast<LeafPage *>(page_obj->GetData());
-  new_leaf_node->Init(new_page_id,node->GetParentPageId(),node->GetKeySize(),leaf_max_size_);
-  node->MoveHalfTo(new_leaf_node);
+  LeafPage *new_leaf_node = guard.AsMut<LeafPage>();
+  new_leaf_node->Init(new_page_id, node->GetParentPageId(), node->GetKeySize(), leaf_max_size_,
+                      buffer_pool_manager_->GetPageSize());
+  node->MoveHalfTo(new_leaf_node, key, value, processor_);
   new_leaf_node->SetNextPageId(node->GetNextPageId());
-  buffer_pool_manager_->UnpinPage(new_page_id,true);
-  return new_leaf_node;
+  return guard;
+}
+
+/*
+ * The shortest key that is greater than the left_index-th key of left and not greater than the right_index-th key of
+ * right, the separator pushed up between them
+ */
+void BPlusTree::SeparatorAt(const LeafPage *left, int left_index, const LeafPage *right, int right_index,
+                            GenericKey *separator) const {
+  std::vector<char> left_key(processor_.GetKeySize());
+  left->KeyAt(left_index, reinterpret_cast<GenericKey *>(left_key.data()));
+  right->KeyAt(right_index, separator);
+  processor_.MakeSeparator(reinterpret_cast<GenericKey *>(left_key.data()), separator, separator);
 }
 
 /*
@@ -366,33 +318,194 @@ BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Txn *transaction) {
 void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node, Txn *transaction) {
   if(old_node->IsRootPage()){
     page_id_t new_page_id;
-    Page *page_obj = buffer_pool_manager_->NewPage(new_page_id);
-    if(page_obj == nullptr){
+    BasicPageGuard root_guard = buffer_pool_manager_->NewPageGuarded(new_page_id);
+    if (!root_guard.IsValid()) {
       throw std::exception();
     }
-    InternalPage *new_root = reinterpret_cast<InternalPage *>(page_obj->GetData());
-    new_root->Init(new_page_id,INVALID_PAGE_ID,old_node->GetKeySize(),internal_max_size_);
+    InternalPage *new_root = root_guard.AsMut<InternalPage>();
+    new_root->Init(new_page_id, INVALID_PAGE_ID, old_node->GetKeySize(), internal_max_size_,
+                   buffer_pool_manager_->GetPageSize());
     new_root->PopulateNewRoot(old_node->GetPageId(),key,new_node->GetPageId());
     old_node->SetParentPageId(new_page_id);
     new_node->SetParentPageId(new_page_id);
+    // 根节点不安全时悲观路径一直持有 root_latch_
     root_page_id_ = new_page_id;
     UpdateRootPageId(0);
-    buffer_pool_manager_->UnpinPage(new_page_id,true);
     return;
   }
-  Page *page = buffer_pool_manager_->FetchPage(old_node->GetParentPageId());
-  if(page == nullptr){
+  // old_node 不安全，所以父页面仍在写锁路径中，这里只需要再 pin 一次
+  BasicPageGuard parent_guard = buffer_pool_manager_->FetchPageBasic(old_node->GetParentPageId());
+  if (!parent_guard.IsValid()) {
     throw std::exception();
   }
-  InternalPage *parent = reinterpret_cast<InternalPage *>(page->GetData());
-  int size = parent->InsertNodeAfter(old_node->GetPageId(),key,new_node->GetPageId());
-  if(size == internal_max_size_){
-    BPlusTreeInternalPage *new_parent = Split(parent,transaction);
-    GenericKey *promoted_key = new_parent->KeyAt(0);    // 使用新父节点的第一个键作为提升键
+  InternalPage *parent = parent_guard.AsMut<InternalPage>();
+  parent->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
+  if (parent->IsFull()) {
+    BasicPageGuard new_parent_guard = Split(parent, transaction);
+    InternalPage *new_parent = new_parent_guard.AsMut<InternalPage>();
+    // 新父节点的第一个键提升上去，它在新父节点中无效，不再占用空间
+    std::vector<char> promoted(processor_.GetKeySize());
+    auto *promoted_key = reinterpret_cast<GenericKey *>(promoted.data());
+    new_parent->KeyAt(0, promoted_key);
+    new_parent->SetKeyAt(0, nullptr);
     InsertIntoParent(parent, promoted_key, new_parent, transaction);
   }
-  buffer_pool_manager_->UnpinPage(page->GetPageId(),true);
-  return;
+}
+
+/*****************************************************************************
+ * BULK LOAD
+ *****************************************************************************/
+/*
+ * Build the tree bottom up from sorted entries. Nothing else can reach the tree until the root is published, the new
+ * pages are only pinned, not latched.
+ * The separators of a level are collected in the layout of inner page pairs, (separator of the page, page id), so
+ * that a slice of them can be copied into an inner page as is. Leaves and inner pages are filled by bytes, the fill
+ * factor being the share of a page the entries may take.
+ * In a non-unique tree the row ids of equal keys are gathered and written as one posting list per key.
+ */
+bool BPlusTree::BulkLoad(const std::function<bool(GenericKey *&, RowId &)> &next, uint32_t fill_factor) {
+  std::unique_lock<std::shared_mutex> root_lock(root_latch_);
+  ASSERT(IsEmpty(), "Only an empty tree can be bulk loaded.");
+  fill_factor = std::min(100u, std::max(1u, fill_factor));
+  int fill = static_cast<int>(fill_factor);
+  int page_size = buffer_pool_manager_->GetPageSize();
+  int key_size = processor_.GetKeySize();
+  int leaf_fill = std::max(1, leaf_max_size_ * fill / 100);
+  int leaf_bytes = (page_size - LEAF_PAGE_HEADER_SIZE) * fill / 100;
+  // 内部页面插入后满了就会分裂，还要留出一个最长的条目；至少放 3 个，最后两页重新分配后每页不少于 2 个
+  int internal_fill = std::max(3, (internal_max_size_ - 1) * fill / 100);
+  int internal_bytes = (page_size - INTERNAL_PAGE_HEADER_SIZE - InternalPage::SLOT_SIZE - key_size) * fill / 100;
+  size_t pair_size = key_size + sizeof(page_id_t);
+  std::vector<char> level;
+  auto add_separator = [&](std::vector<char> &to, const GenericKey *key, page_id_t page_id) {
+    size_t offset = to.size();
+    to.resize(offset + pair_size);
+    memcpy(to.data() + offset, key, key_size);
+    memcpy(to.data() + offset + key_size, &page_id, sizeof(page_id_t));
+  };
+
+  // 叶子层：从左到右依次写满，只保留最后两个叶子的 pin，用于最后一个叶子太空时重新平衡
+  BasicPageGuard prev_guard, leaf_guard;
+  LeafPage *leaf = nullptr;
+  GenericKey *key;
+  RowId value;
+  // 上一个写入的键，页面中的键是压缩过的，不能直接拿来比较
+  std::vector<char> last(key_size), separator(key_size);
+  auto *last_key = reinterpret_cast<GenericKey *>(last.data());
+  auto *separator_key = reinterpret_cast<GenericKey *>(separator.data());
+  // 叶子最后一个键的所有行号，多于一个时在换键时写成 posting list
+  std::vector<RowId> postings;
+  auto flush_postings = [&]() {
+    if (postings.size() > 1) {
+      leaf->SetValueAt(leaf->GetSize() - 1, PostingList::Create(buffer_pool_manager_, postings));
+    }
+    postings.clear();
+  };
+  while (next(key, value)) {
+    int cmp = leaf == nullptr ? 1 : processor_.CompareKeys(key, last_key);
+    if (cmp == 0 && !unique_) {
+      postings.push_back(value);
+      continue;
+    }
+    if (cmp <= 0) {
+      // 唯一索引中重复的键或者键的顺序不对：删除已经写好的叶子和其中的 posting list
+      prev_guard.Drop();
+      leaf_guard.Drop();
+      for (size_t offset = 0; offset < level.size(); offset += pair_size) {
+        Destroy(*reinterpret_cast<page_id_t *>(level.data() + offset + key_size));
+      }
+      return false;
+    }
+    if (leaf != nullptr) {
+      flush_postings();
+    }
+    postings.push_back(value);
+    if (leaf == nullptr || leaf->GetSize() >= leaf_fill || leaf->GetUsedSize() >= leaf_bytes ||
+        !leaf->CanInsert(key)) {
+      page_id_t page_id;
+      BasicPageGuard guard = buffer_pool_manager_->NewPageGuarded(page_id);
+      if (!guard.IsValid()) {
+        throw std::exception();
+      }
+      LeafPage *new_leaf = guard.AsMut<LeafPage>();
+      new_leaf->Init(page_id, INVALID_PAGE_ID, key_size, leaf_max_size_, page_size);
+      if (leaf != nullptr) {
+        leaf->SetNextPageId(page_id);
+        processor_.MakeSeparator(last_key, key, separator_key);
+        add_separator(level, separator_key, page_id);
+      } else {
+        add_separator(level, key, page_id);
+      }
+      prev_guard = std::move(leaf_guard);
+      leaf_guard = std::move(guard);
+      leaf = new_leaf;
+    }
+    // 键是递增的，总是追加在页面末尾
+    leaf->Insert(key, value, processor_);
+    memcpy(last_key, key, key_size);
+  }
+  if (leaf == nullptr) {
+    return true;
+  }
+  flush_postings();
+  if (prev_guard.IsValid() && leaf->IsUnderflow()) {
+    // 最后一个叶子不足半满，从前一个叶子移过来一些，直到不再不足半满或者两页差不多一样满
+    auto *prev = prev_guard.AsMut<LeafPage>();
+    while (leaf->IsUnderflow() && prev->GetSize() > 1 && leaf->GetUsedSize() < prev->GetUsedSize() &&
+           prev->MoveLastToFrontOf(leaf, processor_)) {
+    }
+    SeparatorAt(prev, prev->GetSize() - 1, leaf, 0, separator_key);
+    memcpy(level.data() + level.size() - pair_size, separator_key, key_size);
+  }
+  prev_guard.Drop();
+  leaf_guard.Drop();
+
+  // 内部页面层：按字节从左到右依次分组，每组放进一个页面，直到只剩一个页面作为根
+  while (level.size() > pair_size) {
+    size_t count = level.size() / pair_size;
+    std::vector<size_t> bounds{0};
+    int used = 0, entries = 0;
+    for (size_t i = 0; i < count; i++) {
+      int entry_size = InternalPage::SLOT_SIZE + BPlusTreePage::SignificantSize(level.data() + i * pair_size, key_size);
+      if (entries >= 2 && (entries >= internal_fill || used + entry_size > internal_bytes)) {
+        bounds.push_back(i);
+        used = 0;
+        entries = 0;
+      }
+      used += entry_size;
+      entries++;
+    }
+    // 最后一组只有一个子节点时，从前一组借一个，前一组只有两个时两组合并
+    if (entries == 1 && bounds.size() > 1) {
+      size_t prev_begin = bounds[bounds.size() - 2];
+      if (bounds.back() - prev_begin >= 3) {
+        bounds.back()--;
+      } else {
+        bounds.pop_back();
+      }
+    }
+    bounds.push_back(count);
+    std::vector<char> parent_level;
+    for (size_t i = 1; i < bounds.size(); i++) {
+      page_id_t page_id;
+      BasicPageGuard guard = buffer_pool_manager_->NewPageGuarded(page_id);
+      if (!guard.IsValid()) {
+        throw std::exception();
+      }
+      auto *node = guard.AsMut<InternalPage>();
+      node->Init(page_id, INVALID_PAGE_ID, key_size, internal_max_size_, page_size);
+      // CopyNFrom 同时把子页面的父页面设为 node
+      const char *first = level.data() + bounds[i - 1] * pair_size;
+      node->CopyNFrom(first, static_cast<int>(bounds[i] - bounds[i - 1]), buffer_pool_manager_);
+      // 第一个键提升到上一层，在 node 中无效
+      add_separator(parent_level, reinterpret_cast<const GenericKey *>(first), page_id);
+      node->SetKeyAt(0, nullptr);
+    }
+    level.swap(parent_level);
+  }
+  root_page_id_ = *reinterpret_cast<page_id_t *>(level.data() + key_size);
+  UpdateRootPageId(1);
+  return true;
 }
 
 /*****************************************************************************
@@ -404,265 +517,227 @@ void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlus
  * If not, User needs to first find the right leaf page as deletion target, then
  * delete entry from leaf page. Remember to deal with redistribute or merge if
  * necessary.
+ * In a non-unique tree this drops the key with all its row ids, Remove(key, value) drops a single row id.
  */
-void BPlusTree::Remove(const GenericKey *key, Txn *transaction) {
-  if (IsEmpty()) {
-    return;
+void BPlusTree::Remove(const GenericKey *key, Txn *transaction) { RemoveImpl(key, nullptr, transaction); }
+
+void BPlusTree::Remove(const GenericKey *key, const RowId &value, Txn *transaction) {
+  // 唯一索引中一个键只有一个行号，直接删除键
+  RemoveImpl(key, unique_ ? nullptr : &value, transaction);
+}
+
+/*
+ * Remove value from the row ids of the index-th key of leaf, which must be write latched and dirtied by the caller.
+ * The posting list is folded back into the leaf once a single row id is left.
+ * @return: true means value is the only row id of the key, so the key itself must be removed
+ */
+bool BPlusTree::RemovePosting(LeafPage *leaf, int index, const RowId &value) {
+  RowId current = leaf->ValueAt(index);
+  if (!PostingList::IsList(current)) {
+    return current == value;
   }
+  RowId only;
+  if (PostingList::Remove(buffer_pool_manager_, current, value, &only) && only.GetPageId() != INVALID_PAGE_ID) {
+    leaf->SetValueAt(index, only);
+  }
+  return false;
+}
 
-  Page *leaf_page_obj = FindLeafPage(key, INVALID_PAGE_ID, false);
-  if (leaf_page_obj == nullptr) {
+void BPlusTree::RemoveImpl(const GenericKey *key, const RowId *value, Txn *transaction) {
+  // 乐观删除：只锁住叶子，叶子不会下溢时直接删除
+  WritePageGuard leaf_guard = FindLeafOptimistic(key);
+  if (!leaf_guard.IsValid()) {
     return;
   }
-
-  LeafPage *leaf_page = reinterpret_cast<LeafPage *>(leaf_page_obj->GetData());
-  page_id_t current_leaf_page_id = leaf_page->GetPageId();
-
-
-
-  RowId temp_row_id;
-  if (!leaf_page->Lookup(key, temp_row_id, processor_)) {
-    buffer_pool_manager_->UnpinPage(current_leaf_page_id, false);
+  LeafPage *leaf_node = leaf_guard.As<LeafPage>();
+  int index = leaf_node->KeyIndex(key, processor_);
+  if (index == leaf_node->GetSize() || leaf_node->CompareAt(index, key, processor_) != 0) {
     return;
   }
-
-  // 判断是否是第一个键
-  bool is_first_key = leaf_page->KeyIndex(key, processor_) == 0;
-  
-  // 删除键值对
-  int size = leaf_page->RemoveAndDeleteRecord(key, processor_);
-  bool deleted = false;
-
-  if (size < leaf_page->GetMinSize()) {
-    deleted = CoalesceOrRedistribute(leaf_page, transaction);//check
-  } else if (is_first_key && !leaf_page->IsRootPage()) {
-    // 如果删除的是第一个键，需要向上更新父节点中的键
-    GenericKey *update_key = leaf_page->KeyAt(0);
-    page_id_t current_page_id = current_leaf_page_id;
-    Page *parent_page = buffer_pool_manager_->FetchPage(leaf_page->GetParentPageId());
-    
-    if (parent_page != nullptr) {
-      InternalPage *parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
-      
-      // 向上更新父节点中的键，直到根节点或找到不需要更新的节点
-      while (!parent->IsRootPage() && parent->ValueIndex(current_page_id) == 0) {
-        buffer_pool_manager_->UnpinPage(parent->GetPageId(), false);
-        current_page_id = parent->GetPageId();
-        parent_page = buffer_pool_manager_->FetchPage(parent->GetParentPageId());
-        if (parent_page == nullptr) {
-          break;
-        }
-        parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
-      }
-      
-      // 如果找到需要更新的节点，且键值不同，则更新
-      if (parent_page != nullptr && parent->ValueIndex(current_page_id) != 0) {
-        if (processor_.CompareKeys(update_key, parent->KeyAt(parent->ValueIndex(current_page_id))) != 0) {
-          parent->SetKeyAt(parent->ValueIndex(current_page_id), update_key);
-          buffer_pool_manager_->UnpinPage(parent->GetPageId(), true);
-        } else {
-          buffer_pool_manager_->UnpinPage(parent->GetPageId(), false);
-        }
-      }
-      else buffer_pool_manager_->UnpinPage(parent->GetPageId(), false); // debug：如果一路上去都是最左边节点则不需要更新但一定要UnpinPage！！
+  if (value != nullptr && !RemovePosting(leaf_guard.AsMut<LeafPage>(), index, *value)) {
+    // 键还有其他行号，叶子大小不变
+    return;
+  }
+  if (IsSafe(leaf_node, key, false)) {
+    // 删除叶子的第一个键时父节点中的分隔键仍然有效，不需要向上更新
+    if (PostingList::IsList(leaf_node->ValueAt(index))) {
+      PostingList::Destroy(buffer_pool_manager_, leaf_node->ValueAt(index));
     }
+    leaf_guard.AsMut<LeafPage>()->RemoveAndDeleteRecord(key, processor_);
+    return;
   }
+  leaf_guard.Drop();
 
-  // 处理叶子页面
-  if (!deleted) {
-    buffer_pool_manager_->UnpinPage(current_leaf_page_id, true);
-  } else {
-    // buffer_pool_manager_->UnpinPage(current_leaf_page_id, true); // debug
-    // buffer_pool_manager_->DeletePage(current_leaf_page_id);
+  // 悲观删除：从根开始加写锁
+  Context ctx;
+  ctx.root_lock_ = std::unique_lock<std::shared_mutex>(root_latch_);
+  if (IsEmpty()) {
+    return;
+  }
+  FindLeafPessimistic(key, false, ctx);
+  LeafPage *leaf_page = ctx.write_set_.back().AsMut<LeafPage>();
+  index = leaf_page->KeyIndex(key, processor_);
+  if (index == leaf_page->GetSize() || leaf_page->CompareAt(index, key, processor_) != 0) {
+    // 两次查找之间已经被其他线程删除
+    return;
+  }
+  // 两次查找之间其他线程可能插入了同一个键的行号，要重新检查
+  if (value != nullptr && !RemovePosting(leaf_page, index, *value)) {
+    return;
+  }
+  if (PostingList::IsList(leaf_page->ValueAt(index))) {
+    PostingList::Destroy(buffer_pool_manager_, leaf_page->ValueAt(index));
+  }
+  leaf_page->RemoveAndDeleteRecord(key, processor_);
+  if (leaf_page->IsUnderflow()) {
+    CoalesceOrRedistribute(leaf_page, ctx, transaction);
+  }
+
+  // 合并掉的页面在所有锁释放之后再删除
+  std::vector<page_id_t> deleted_pages = std::move(ctx.deleted_pages_);
+  ctx.write_set_.clear();
+  if (ctx.root_lock_.owns_lock()) {
+    ctx.root_lock_.unlock();
+  }
+  for (page_id_t page_id : deleted_pages) {
+    buffer_pool_manager_->DeletePage(page_id);
   }
-  // buffer_pool_manager_->UnpinPage(current_leaf_page_id, true);
-  // if(deleted) buffer_pool_manager_->DeletePage(current_leaf_page_id);
 }
 
-/* todo
- * User needs to first find the sibling of input page. If sibling's size + input
- * page's size > page's max size, then redistribute. Otherwise, merge.
+/*
+ * User needs to first find the sibling of input page. If the sibling can lend an entry, then redistribute.
+ * Otherwise, merge. When the entries of the two pages do not fit in one page either (long keys), the page is left
+ * in underflow.
  * Using template N to represent either internal page or leaf page.
+ * node and its parent are write latched in ctx, siblings are write latched here. Pages emptied by a merge are
+ * added to ctx.deleted_pages_ and deleted by Remove() once all latches are released.
  * @return: true means target leaf page should be deleted, false means no
  * deletion happens
  */
 template <typename N>
-bool BPlusTree::CoalesceOrRedistribute(N *&node, Txn *transaction) {//debug:理清楚Coalesce调用逻辑，返回true则调用者unpin，返回false则内部unpin+delete
+bool BPlusTree::CoalesceOrRedistribute(N *&node, Context &ctx, Txn *transaction) {
   // 如果 page 是根页面，直接调整根
   if (node->IsRootPage()) {
-    return AdjustRoot(node);
+    if (AdjustRoot(node)) {
+      ctx.deleted_pages_.push_back(node->GetPageId());
+      return true;
+    }
+    return false;
   }
 
-  // 如果 page 的条目数量大于等于最小填充，不需要调整
-  if (node->GetSize() >= node->GetMinSize()) {
+  // 如果 page 没有不足半满，不需要调整
+  if (!node->IsUnderflow()) {
     return false;
   }
 
-  // 获取父节点
-  Page *parent_page_obj = buffer_pool_manager_->FetchPage(node->GetParentPageId());
-  if (parent_page_obj == nullptr) {
+  // 获取父节点，父节点在写锁路径中
+  BasicPageGuard parent_guard = buffer_pool_manager_->FetchPageBasic(node->GetParentPageId());
+  if (!parent_guard.IsValid()) {
     throw std::runtime_error("Failed to fetch parent page.");
   }
-  InternalPage *parent = reinterpret_cast<InternalPage *>(parent_page_obj->GetData());
-  page_id_t parent_id = parent->GetPageId();
+  InternalPage *parent = parent_guard.AsMut<InternalPage>();
   page_id_t node_id = node->GetPageId();
 
   // 获取当前节点在父节点中的索引
   int node_index = parent->ValueIndex(node_id);
   if (node_index == -1) {
-    buffer_pool_manager_->UnpinPage(parent_id, false);
     throw std::runtime_error("Node not found in parent.");
   }
 
-  // 尝试从左兄弟节点重新分配
-  if (node_index > 0) {  // 不是第一个节点，可以尝试左兄弟
-    page_id_t left_sibling_id = parent->ValueAt(node_index - 1);
-    Page *left_sibling_page = buffer_pool_manager_->FetchPage(left_sibling_id);
-    if (left_sibling_page == nullptr) {
-      buffer_pool_manager_->UnpinPage(parent_id, false);
+  // 锁住左兄弟。迭代器持有左边的叶子去锁右边的叶子，所以叶子要先放开 node，按从左到右的顺序重新加锁；
+  // 父节点的写锁保证这期间没有其他写者能进入 node
+  WritePageGuard left_sibling_guard;
+  if (node_index > 0) {
+    if (node->IsLeafPage()) {
+      ASSERT(ctx.write_set_.back().PageId() == node_id, "The leaf must be the last latched page.");
+      BasicPageGuard pin = buffer_pool_manager_->FetchPageBasic(node_id);
+      ctx.write_set_.back().Drop();
+      left_sibling_guard = buffer_pool_manager_->FetchPageWrite(parent->ValueAt(node_index - 1));
+      ctx.write_set_.back() = buffer_pool_manager_->FetchPageWrite(node_id);
+      ctx.write_set_.back().SetDirty();
+    } else {
+      left_sibling_guard = buffer_pool_manager_->FetchPageWrite(parent->ValueAt(node_index - 1));
+    }
+    if (!left_sibling_guard.IsValid()) {
       throw std::runtime_error("Failed to fetch left sibling page.");
     }
-    N *left_sibling = reinterpret_cast<N *>(left_sibling_page->GetData());
-
-    if (left_sibling->GetSize() > left_sibling->GetMinSize()) {
-      // 从左兄弟重新分配
-      Redistribute(left_sibling, node, 0);
-      
-      // 如果是内部节点，需要更新父节点中的键
-      if (!node->IsLeafPage()) {
-        auto node_internal = reinterpret_cast<InternalPage *>(node);
-        page_id_t leftmost_leaf_id = node_internal->LeftMostKeyFromCurr(buffer_pool_manager_);
-        Page *leaf_page = buffer_pool_manager_->FetchPage(leftmost_leaf_id);
-        if (leaf_page != nullptr) {
-          LeafPage *leaf = reinterpret_cast<LeafPage *>(leaf_page->GetData());
-          parent->SetKeyAt(node_index, leaf->KeyAt(0));
-          buffer_pool_manager_->UnpinPage(leftmost_leaf_id, false);
-        }
-      }
+    N *left_sibling = left_sibling_guard.As<N>();
 
-      buffer_pool_manager_->UnpinPage(parent_id, true);
-      buffer_pool_manager_->UnpinPage(left_sibling_id, true);
+    // 尝试从左兄弟节点重新分配，Redistribute 同时更新父节点中的分隔键
+    if (left_sibling->CanLend(left_sibling->GetSize() - 1) && Redistribute(left_sibling_guard.AsMut<N>(), node, 0)) {
       return false;
     }
-    buffer_pool_manager_->UnpinPage(left_sibling_id, false);
   }
 
   // 尝试从右兄弟节点重新分配
+  WritePageGuard right_sibling_guard;
   if (node_index < parent->GetSize() - 1) {  // 不是最后一个节点，可以尝试右兄弟
-    page_id_t right_sibling_id = parent->ValueAt(node_index + 1);
-    Page *right_sibling_page = buffer_pool_manager_->FetchPage(right_sibling_id);
-    if (right_sibling_page == nullptr) {
-      buffer_pool_manager_->UnpinPage(parent_id, false);
+    right_sibling_guard = buffer_pool_manager_->FetchPageWrite(parent->ValueAt(node_index + 1));
+    if (!right_sibling_guard.IsValid()) {
       throw std::runtime_error("Failed to fetch right sibling page.");
     }
-    N *right_sibling = reinterpret_cast<N *>(right_sibling_page->GetData());
-
-    if (right_sibling->GetSize() > right_sibling->GetMinSize()) {
-      // 从右兄弟重新分配
-      Redistribute(right_sibling, node, 1);
-      
-      // 如果是内部节点，需要更新父节点中的键
-      if (!right_sibling->IsLeafPage()) {
-        auto right_sibling_internal = reinterpret_cast<InternalPage *>(right_sibling);
-        page_id_t leftmost_leaf_id = right_sibling_internal->LeftMostKeyFromCurr(buffer_pool_manager_);
-        Page *leaf_page = buffer_pool_manager_->FetchPage(leftmost_leaf_id);
-        if (leaf_page != nullptr) {
-          LeafPage *leaf = reinterpret_cast<LeafPage *>(leaf_page->GetData());
-          parent->SetKeyAt(node_index + 1, leaf->KeyAt(0));
-          buffer_pool_manager_->UnpinPage(leftmost_leaf_id, false);
-        }
-      }
+    N *right_sibling = right_sibling_guard.As<N>();
 
-      buffer_pool_manager_->UnpinPage(parent_id, true);
-      buffer_pool_manager_->UnpinPage(right_sibling_id, true);
+    if (right_sibling->CanLend(0) && Redistribute(right_sibling_guard.AsMut<N>(), node, 1)) {
       return false;
     }
-    buffer_pool_manager_->UnpinPage(right_sibling_id, false);
   }
 
-  // 如果无法重新分配，则进行合并
-  bool parent_may_need_adjustment = false;
-  if (node_index > 0) {  // 与左兄弟合并
-    page_id_t left_sibling_id = parent->ValueAt(node_index - 1);
-    Page *left_sibling_page = buffer_pool_manager_->FetchPage(left_sibling_id);
-    if (left_sibling_page == nullptr) {
-      buffer_pool_manager_->UnpinPage(parent_id, false);
-      throw std::runtime_error("Failed to fetch left sibling page for coalesce.");
-    }
-    N *left_sibling = reinterpret_cast<N *>(left_sibling_page->GetData());
-    parent_may_need_adjustment = Coalesce(left_sibling, node, parent, node_index, transaction);
-    buffer_pool_manager_->UnpinPage(left_sibling_id, true);
-  } else {  // 与右兄弟合并
-    page_id_t right_sibling_id = parent->ValueAt(node_index + 1);
-    Page *right_sibling_page = buffer_pool_manager_->FetchPage(right_sibling_id);
-    if (right_sibling_page == nullptr) {
-      buffer_pool_manager_->UnpinPage(parent_id, false);
-      throw std::runtime_error("Failed to fetch right sibling page for coalesce.");
-    }
-    N *right_sibling = reinterpret_cast<N *>(right_sibling_page->GetData());
-    parent_may_need_adjustment = Coalesce(node, right_sibling, parent, node_index + 1, transaction);//debug:node\right_sbling参数传反了
-    buffer_pool_manager_->UnpinPage(node->GetPageId(), true);
-  }
-
-  // 处理父节点
-  if (parent_may_need_adjustment || parent->GetSize() < parent->GetMinSize()) {
-    if (!CoalesceOrRedistribute(parent, transaction)) {
-      buffer_pool_manager_->UnpinPage(parent_id, true);
-    }
-    // else {
-    //   buffer_pool_manager_->UnpinPage(parent_id, true);
-    //   buffer_pool_manager_->DeletePage(parent_id);
-    // }
-    // bool deleted = CoalesceOrRedistribute(parent, transaction);
-    // buffer_pool_manager_->UnpinPage(parent_id, true);
-    // if(deleted) buffer_pool_manager_->DeletePage(parent_id); // debug
+  // 如果无法重新分配，则进行合并；两页的条目放不进一个页面时 node 保持不足半满
+  bool node_deleted = false;
+  N *left_sibling = node_index > 0 ? left_sibling_guard.AsMut<N>() : nullptr;
+  N *right_sibling = right_sibling_guard.IsValid() ? right_sibling_guard.AsMut<N>() : nullptr;
+  if (left_sibling != nullptr && Coalesce(left_sibling, node, parent, node_index, transaction)) {
+    // node 被并入左兄弟后删除
+    ctx.deleted_pages_.push_back(node_id);
+    node_deleted = true;
+  } else if (right_sibling != nullptr && Coalesce(node, right_sibling, parent, node_index + 1, transaction)) {
+    // 右兄弟被并入 node 后删除
+    ctx.deleted_pages_.push_back(right_sibling_guard.PageId());
   } else {
-    buffer_pool_manager_->UnpinPage(parent_id, true);
+    return false;
   }
 
-  return true;  // 节点已被删除
+  // 父节点少了一个条目，可能也要调整
+  CoalesceOrRedistribute(parent, ctx, transaction);
+
+  return node_deleted;
 }
 
 /*
- * Move all the key & value pairs from one page to its sibling page, and notify
- * buffer pool manager to delete this page. Parent page must be adjusted to
- * take info of deletion into account. Remember to deal with coalesce or
+ * Move all the key & value pairs from one page to its sibling page. The emptied
+ * page is deleted by the caller once its guard is released. Parent page must be
+ * adjusted to take info of deletion into account. Remember to deal with coalesce or
  * redistribute recursively if necessary.
  * Using template N to represent either internal page or leaf page.
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
  * @param   parent             parent page of input "node"
- * @return  true means parent node should be deleted, false means no deletion happened
+ * @return  true means node is merged into neighbor_node, false means the entries do not fit in one page and nothing
+ * moved
  */
 bool BPlusTree::Coalesce(LeafPage *&neighbor_node, LeafPage *&node, InternalPage *&parent, int index,
                          Txn *transaction) {
-                          // 将 node 的所有条目移动到 neighbor_node
-                          node->MoveAllTo(neighbor_node);
-                          // 更新 neighbor_node 的下一个页面 ID
-                          neighbor_node->SetNextPageId(node->GetNextPageId());
-
-                          buffer_pool_manager_->UnpinPage(node->GetPageId(),false);
-                          buffer_pool_manager_->DeletePage(node->GetPageId());
-                          // 从父节点中移除 node
-                          parent->Remove(index);
-                          // 如果父节点现在不足最小填充，或者父节点是根节点且只有一个子节点，则返回 true
-                          return(parent->GetSize() < parent->GetMinSize() || parent->IsRootPage() && parent->GetSize() < 2 && !parent->IsLeafPage());
-  
+  // 将 node 的所有条目移动到 neighbor_node，同时更新 neighbor_node 的下一个页面 ID
+  if (!node->MoveAllTo(neighbor_node)) {
+    return false;
+  }
+  // 从父节点中移除 node
+  parent->Remove(index);
+  return true;
 }
 
 bool BPlusTree::Coalesce(InternalPage *&neighbor_node, InternalPage *&node, InternalPage *&parent, int index,
                          Txn *transaction) {
-                          GenericKey *promoted_key = parent->KeyAt(index);
-                          // 将 node 的所有条目移动到 neighbor_node
-                          node->MoveAllTo(neighbor_node,promoted_key,buffer_pool_manager_);
-                          // 删除node 
-                          buffer_pool_manager_->UnpinPage(node->GetPageId(),false);
-                          buffer_pool_manager_->DeletePage(node->GetPageId());
-                          // 从父节点中移除 node
-                          parent->Remove(index);
-                          // 如果父节点现在不足最小填充，或者父节点是根节点且只有一个子节点，则返回 true
-                          return (parent->GetSize() < parent->GetMinSize() ||
-                                  (parent->IsRootPage() && parent->GetSize() < 2));
+  // 父节点中分隔两页的键下移到合并后的页面中
+  std::vector<char> middle(processor_.GetKeySize());
+  auto *middle_key = reinterpret_cast<GenericKey *>(middle.data());
+  parent->KeyAt(index, middle_key);
+  if (!node->MoveAllTo(neighbor_node, middle_key, buffer_pool_manager_)) {
+    return false;
+  }
+  parent->Remove(index);
+  return true;
 }
 
 /*
@@ -673,48 +748,60 @@ bool BPlusTree::Coalesce(InternalPage *&neighbor_node, InternalPage *&node, Inte
  * Using template N to represent either internal page or leaf page.
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
+ * @return  false, with nothing moved, if the entry or the new separator does not fit
  */
-void BPlusTree::Redistribute(LeafPage *neighbor_node, LeafPage *node, int index) {
+bool BPlusTree::Redistribute(LeafPage *neighbor_node, LeafPage *node, int index) {
   //获取父节点
-  Page *parent_page_obj = buffer_pool_manager_->FetchPage(node->GetParentPageId());
-  if (parent_page_obj == nullptr) {
+  BasicPageGuard parent_guard = buffer_pool_manager_->FetchPageBasic(node->GetParentPageId());
+  if (!parent_guard.IsValid()) {
     throw std::runtime_error("Redistribute (Leaf): Failed to fetch parent page.");
   }
-  InternalPage *parent_node = reinterpret_cast<InternalPage *>(parent_page_obj->GetData());
-  page_id_t parent_page_id = parent_node->GetPageId(); // For unpinning
+  InternalPage *parent_node = parent_guard.AsMut<InternalPage>();
+  std::vector<char> separator(processor_.GetKeySize());
+  auto *separator_key = reinterpret_cast<GenericKey *>(separator.data());
 
   if (index == 0) { // neighbor_node 是 node 的左兄弟
-    neighbor_node->MoveLastToFrontOf(node);
-    // 更新父节点中的分隔键。
-    // 该键位于指向 node 的指针的左侧，即 parent_node->KeyAt(parent_node->ValueIndex(node->GetPageId()))。
-    // 新的键应该是 node 的第一个键。
-    parent_node->SetKeyAt(parent_node->ValueIndex(node->GetPageId()), node->KeyAt(0));
+    // 父节点中指向 node 的指针左侧的分隔键，换成 neighbor_node 剩下的最后一个键和移走的键之间的分隔键
+    int key_index = parent_node->ValueIndex(node->GetPageId());
+    int last = neighbor_node->GetSize() - 1;
+    SeparatorAt(neighbor_node, last - 1, neighbor_node, last, separator_key);
+    if (!parent_node->CanSetKeyAt(key_index, separator_key) || !neighbor_node->MoveLastToFrontOf(node, processor_)) {
+      return false;
+    }
+    parent_node->SetKeyAt(key_index, separator_key);
   } else { // neighbor_node 是 node 的右兄弟 (index == 1)
-    neighbor_node->MoveFirstToEndOf(node);
-    // 更新父节点中的分隔键。
-    // 该键位于指向 neighbor_node 的指针的左侧，即 parent_node->KeyAt(parent_node->ValueIndex(neighbor_node->GetPageId()))。
-    // 新的键应该是 neighbor_node 的第一个键（在移动之后）。
-    parent_node->SetKeyAt(parent_node->ValueIndex(neighbor_node->GetPageId()), neighbor_node->KeyAt(0));
+    // 父节点中指向 neighbor_node 的指针左侧的分隔键，换成移走的键和 neighbor_node 剩下的第一个键之间的分隔键
+    int key_index = parent_node->ValueIndex(neighbor_node->GetPageId());
+    SeparatorAt(neighbor_node, 0, neighbor_node, 1, separator_key);
+    if (!parent_node->CanSetKeyAt(key_index, separator_key) || !neighbor_node->MoveFirstToEndOf(node, processor_)) {
+      return false;
+    }
+    parent_node->SetKeyAt(key_index, separator_key);
   }
-  buffer_pool_manager_->UnpinPage(parent_page_id, true); // 标记父页面为脏页并解锁
+  return true;
 }
 
-void BPlusTree::Redistribute(InternalPage *neighbor_node, InternalPage *node, int index) {
-  Page *parent_page_obj = buffer_pool_manager_->FetchPage(node->GetParentPageId());
-  if (parent_page_obj == nullptr) {
+bool BPlusTree::Redistribute(InternalPage *neighbor_node, InternalPage *node, int index) {
+  BasicPageGuard parent_guard = buffer_pool_manager_->FetchPageBasic(node->GetParentPageId());
+  if (!parent_guard.IsValid()) {
     throw std::runtime_error("Redistribute (Internal): Failed to fetch parent page.");
   }
-  InternalPage *parent_node = reinterpret_cast<InternalPage *>(parent_page_obj->GetData());
-  page_id_t parent_page_id = parent_node->GetPageId();
+  InternalPage *parent_node = parent_guard.AsMut<InternalPage>();
+  std::vector<char> middle(processor_.GetKeySize()), promoted(processor_.GetKeySize());
+  auto *key_from_parent = reinterpret_cast<GenericKey *>(middle.data());
+  auto *key_to_promote_up = reinterpret_cast<GenericKey *>(promoted.data());
 
   if (index == 0) { // neighbor_node 是 node 的左兄弟
     // 1. 获取父节点中分隔 neighbor_node 和 node 的键 (key_from_parent)
     //    这个键位于 parent_node 中指向 node 的指针的左边
     int node_ptr_idx_in_parent = parent_node->ValueIndex(node->GetPageId());
-    GenericKey *key_from_parent = parent_node->KeyAt(node_ptr_idx_in_parent);
+    parent_node->KeyAt(node_ptr_idx_in_parent, key_from_parent);
 
     // 2. 记录 neighbor_node 的最后一个键，它将提升到父节点
-    GenericKey *key_to_promote_up = neighbor_node->KeyAt(neighbor_node->GetSize() - 1);
+    neighbor_node->KeyAt(neighbor_node->GetSize() - 1, key_to_promote_up);
+    if (!node->CanInsert(key_from_parent) || !parent_node->CanSetKeyAt(node_ptr_idx_in_parent, key_to_promote_up)) {
+      return false;
+    }
 
     // 3. neighbor_node 将其最后一个条目移动到 node 的开头
     //    key_from_parent 会被插入到 node 中，作为新的 ValueAt(0) 和原始 ValueAt(0) 之间的分隔键
@@ -727,21 +814,24 @@ void BPlusTree::Redistribute(InternalPage *neighbor_node, InternalPage *node, in
     // 1. 获取父节点中分隔 node 和 neighbor_node 的键 (key_from_parent)
     //    这个键位于 parent_node 中指向 neighbor_node 的指针的左边
     int neighbor_ptr_idx_in_parent = parent_node->ValueIndex(neighbor_node->GetPageId());
-    GenericKey *key_from_parent = parent_node->KeyAt(neighbor_ptr_idx_in_parent);
+    parent_node->KeyAt(neighbor_ptr_idx_in_parent, key_from_parent);
+
+    // 2. neighbor_node 的第二个键将提升到父节点
+    neighbor_node->KeyAt(1, key_to_promote_up);
+    if (!node->CanInsert(key_from_parent) ||
+        !parent_node->CanSetKeyAt(neighbor_ptr_idx_in_parent, key_to_promote_up)) {
+      return false;
+    }
 
-    // 2. neighbor_node 将其第一个条目移动到 node 的末尾
+    // 3. neighbor_node 将其第一个条目移动到 node 的末尾
     //    key_from_parent 会被插入到 node 中，作为 node 原始最后一个值和新插入的值之间的分隔键
     neighbor_node->MoveFirstToEndOf(node, key_from_parent, buffer_pool_manager_);
 
-    // 3. neighbor_node 移动后的第一个键将提升到父节点
-    //    InternalPage::MoveFirstToEndOf 内部会将原来的 KeyAt(1) 移到 KeyAt(0)
-    GenericKey *key_to_promote_up = neighbor_node->KeyAt(0);
-    
-    // 4. 更新父节点的分隔键
+    // 4. 更新父节点的分隔键，neighbor_node 的第一个键不再有效，不占用空间
+    neighbor_node->SetKeyAt(0, nullptr);
     parent_node->SetKeyAt(neighbor_ptr_idx_in_parent, key_to_promote_up);
   }
-
-  buffer_pool_manager_->UnpinPage(parent_page_id, true); // 标记父页面为脏页并解锁
+  return true;
 }
 
 /*
@@ -766,36 +856,23 @@ bool BPlusTree::AdjustRoot(BPlusTreePage *old_root_node) {
     if (old_root_node->GetSize() == 1) {
       return false;
     }
-    // 叶子节点为空，删除整个树
-    buffer_pool_manager_->UnpinPage(old_root_node->GetPageId(), true);
-    buffer_pool_manager_->DeletePage(old_root_node->GetPageId());
+    // 叶子节点为空，整棵树被清空，旧根页面由调用者删除
     root_page_id_ = INVALID_PAGE_ID;
     UpdateRootPageId(0);
     return true;
   }
 
-  // 处理内部节点的情况
+  // 处理内部节点的情况：唯一的孩子成为新的根节点
   InternalPage *internal_root = reinterpret_cast<InternalPage *>(old_root_node);
   page_id_t child_page_id = internal_root->RemoveAndReturnOnlyChild();
   
-  // 获取新的根节点
-  Page *child_page_obj = buffer_pool_manager_->FetchPage(child_page_id);
-  if (child_page_obj == nullptr) {
+  BasicPageGuard child_guard = buffer_pool_manager_->FetchPageBasic(child_page_id);
+  if (!child_guard.IsValid()) {
     throw std::runtime_error("AdjustRoot: Failed to fetch the new root page.");
   }
-
-  buffer_pool_manager_->UnpinPage(old_root_node->GetPageId(), true);
-  buffer_pool_manager_->DeletePage(old_root_node->GetPageId());
-  
-  // 设置新的根节点
-  BPlusTreePage *new_root_node = reinterpret_cast<BPlusTreePage *>(child_page_obj->GetData());
-  new_root_node->SetParentPageId(INVALID_PAGE_ID);
+  child_guard.AsMut<BPlusTreePage>()->SetParentPageId(INVALID_PAGE_ID);
   root_page_id_ = child_page_id;
   UpdateRootPageId(0);
-  
-  // 释放页面
-  buffer_pool_manager_->UnpinPage(child_page_id, true);
-  
   return true;
 }
 
@@ -808,19 +885,13 @@ bool BPlusTree::AdjustRoot(BPlusTreePage *old_root_node) {
  * @return : index iterator
  */
 IndexIterator BPlusTree::Begin() {
-  if (IsEmpty()) {
-    return IndexIterator();
-  }
-  // 找到最左边的叶子页面
-  Page *leaf_page_obj = FindLeafPage(nullptr, root_page_id_, true);
-  if (leaf_page_obj == nullptr) {
-    return IndexIterator(); // 树可能在FindLeafPage过程中变空或发生错误
+  // 找到最左边的叶子页面，页面的读锁直接交给迭代器
+  ReadPageGuard leaf_guard = FindLeafRead(nullptr, true);
+  if (!leaf_guard.IsValid()) {
+    return IndexIterator(); // 树为空
   }
-  page_id_t leaf_page_id = leaf_page_obj->GetPageId();
-  // FindLeafPage 返回的页面是 pinned 的，迭代器会接管或复制所需信息，这里可以 unpin
-  buffer_pool_manager_->UnpinPage(leaf_page_id, false); 
   // 迭代器从该页面的第一个条目开始
-  return IndexIterator(leaf_page_id, buffer_pool_manager_, 0);
+  return IndexIterator(std::move(leaf_guard), buffer_pool_manager_, 0);
 }
 
 /*
@@ -829,26 +900,20 @@ IndexIterator BPlusTree::Begin() {
  * @return : index iterator
  */
 IndexIterator BPlusTree::Begin(const GenericKey *key) {
-  if (IsEmpty()) {
+  // 获取包含 key 的叶子页面
+  ReadPageGuard leaf_guard = FindLeafRead(key);
+  if (!leaf_guard.IsValid()) {
     return IndexIterator();
   }
-  // 调用 FindLeafPage(key, root_page_id_, false) 获取包含 key 的叶子页面
-  Page *leaf_page_obj = FindLeafPage(key, root_page_id_, false);
-  // 如果页面为空
-  if (leaf_page_obj == nullptr) {
-    return IndexIterator();
-  }
-  // 将页面数据转换为 LeafPage 类型
-  LeafPage *leaf_page = reinterpret_cast<LeafPage *>(leaf_page_obj->GetData());
-  page_id_t leaf_page_id = leaf_page->GetPageId();
   // 获取 key 在叶子页面中的索引
-  int index_in_page = leaf_page->KeyIndex(key, processor_);
-  // 释放叶子页面
-  // FindLeafPage 返回的页面是 pinned 的，迭代器会接管或复制所需信息，这里可以 unpin
-  buffer_pool_manager_->UnpinPage(leaf_page_id, false);
-
-  // 返回一个新的 IndexIterator 对象
-  return IndexIterator(leaf_page_id, buffer_pool_manager_, index_in_page);
+  int index_in_page = leaf_guard.As<LeafPage>()->KeyIndex(key, processor_);
+  bool past_end = index_in_page == leaf_guard.As<LeafPage>()->GetSize();
+  IndexIterator iter(std::move(leaf_guard), buffer_pool_manager_, index_in_page);
+  if (past_end) {
+    // key 比叶子中所有的键都大，从下一个叶子的第一个键开始
+    ++iter;
+  }
+  return iter;
 }
 
 /*
@@ -866,43 +931,95 @@ IndexIterator BPlusTree::End() {
 /*
  * Find leaf page containing particular key, if leftMost flag == true, find
  * the left most leaf page
- * Note: the leaf page is pinned, you need to unpin it after use.
+ * Note: the leaf page stays pinned by the returned guard.
  */
-Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool leftMost) {
+BasicPageGuard BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool leftMost) {
   if(IsEmpty()){
-    return nullptr;
+    return BasicPageGuard();
   }
 
-  page_id_t current_page_id = (page_id == INVALID_PAGE_ID) ? root_page_id_ : page_id;
-  Page *current_page_obj = buffer_pool_manager_->FetchPage(current_page_id);
-  if(current_page_obj == nullptr) {
-    return nullptr;
+  page_id_t current_page_id = (page_id == INVALID_PAGE_ID) ? root_page_id_.load() : page_id;
+  BasicPageGuard guard = buffer_pool_manager_->FetchPageBasic(current_page_id);
+  while (guard.IsValid() && !guard.As<BPlusTreePage>()->IsLeafPage()) {
+    InternalPage *internal_node = guard.As<InternalPage>();
+    page_id_t next_page_id = leftMost ? internal_node->ValueAt(0) : internal_node->Lookup(key, processor_);
+    guard = buffer_pool_manager_->FetchPageBasic(next_page_id);
   }
+  return guard;
+}
 
-  BPlusTreePage *current_node = reinterpret_cast<BPlusTreePage *>(current_page_obj->GetData());
-  
-  while (!current_node->IsLeafPage()) {
-    InternalPage *internal_node = reinterpret_cast<InternalPage *>(current_node);
-    page_id_t next_page_id;
-    
-    if (leftMost) {
-      next_page_id = internal_node->ValueAt(0);
-    } else {
-      next_page_id = internal_node->Lookup(key, processor_);
+bool BPlusTree::IsSafe(const BPlusTreePage *node, const GenericKey *key, bool insert) const {
+  if (insert) {
+    // 叶子放不下 key 时分裂；内部页面插入的是下一层提升上来的分隔键，长度未知，按最长的算
+    return node->IsLeafPage() ? reinterpret_cast<const LeafPage *>(node)->CanInsert(key)
+                              : reinterpret_cast<const InternalPage *>(node)->CanInsert(nullptr);
+  }
+  if (node->IsRootPage()) {
+    // 根叶子删空或者根内部页面只剩一个孩子时根节点改变
+    return node->IsLeafPage() ? node->GetSize() > 1 : node->GetSize() > 2;
+  }
+  return node->IsLeafPage() ? reinterpret_cast<const LeafPage *>(node)->CanRemove()
+                            : reinterpret_cast<const InternalPage *>(node)->CanRemove();
+}
+
+ReadPageGuard BPlusTree::FindLeafRead(const GenericKey *key, bool leftMost) {
+  std::shared_lock<std::shared_mutex> root_lock(root_latch_);
+  if (IsEmpty()) {
+    return ReadPageGuard();
+  }
+  ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(root_page_id_);
+  root_lock.unlock();
+  while (guard.IsValid() && !guard.As<BPlusTreePage>()->IsLeafPage()) {
+    InternalPage *internal_node = guard.As<InternalPage>();
+    page_id_t next_page_id = leftMost ? internal_node->ValueAt(0) : internal_node->Lookup(key, processor_);
+    // 先锁住子页面，赋值时才释放父页面
+    guard = buffer_pool_manager_->FetchPageRead(next_page_id);
+  }
+  return guard;
+}
+
+WritePageGuard BPlusTree::FindLeafOptimistic(const GenericKey *key) {
+  std::shared_lock<std::shared_mutex> root_lock(root_latch_);
+  if (IsEmpty()) {
+    return WritePageGuard();
+  }
+  page_id_t page_id = root_page_id_;
+  ReadPageGuard parent_guard;
+  while (true) {
+    ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(page_id);
+    if (!guard.IsValid()) {
+      return WritePageGuard();
     }
-    
-    buffer_pool_manager_->UnpinPage(current_page_id, false);
-    
-    current_page_id = next_page_id;
-    current_page_obj = buffer_pool_manager_->FetchPage(current_page_id);
-    if (current_page_obj == nullptr) {
-      return nullptr;
+    if (guard.As<BPlusTreePage>()->IsLeafPage()) {
+      // 读锁换成写锁。父页面的读锁（根叶子则是 root_latch_）还在，叶子在这期间不会被分裂或合并
+      guard.Drop();
+      return buffer_pool_manager_->FetchPageWrite(page_id);
+    }
+    page_id = guard.As<InternalPage>()->Lookup(key, processor_);
+    parent_guard = std::move(guard);
+    if (root_lock.owns_lock()) {
+      root_lock.unlock();
     }
-    
-    current_node = reinterpret_cast<BPlusTreePage *>(current_page_obj->GetData());
   }
-  
-  return current_page_obj;
+}
+
+void BPlusTree::FindLeafPessimistic(const GenericKey *key, bool insert, Context &ctx) {
+  page_id_t page_id = root_page_id_;
+  while (true) {
+    ctx.write_set_.push_back(buffer_pool_manager_->FetchPageWrite(page_id));
+    WritePageGuard &guard = ctx.write_set_.back();
+    if (!guard.IsValid()) {
+      throw std::runtime_error("Failed to fetch page during B+ tree traversal.");
+    }
+    auto *node = guard.As<BPlusTreePage>();
+    if (IsSafe(node, key, insert)) {
+      ctx.ReleaseAncestors();
+    }
+    if (node->IsLeafPage()) {
+      return;
+    }
+    page_id = guard.As<InternalPage>()->Lookup(key, processor_);
+  }
 }
 
 /*
@@ -914,14 +1031,13 @@ Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool lef
  * updating it.
  */
 void BPlusTree::UpdateRootPageId(int insert_record) {
-  Page *page_obj = buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID);
-  IndexRootsPage *index_roots_page = reinterpret_cast<IndexRootsPage *>(page_obj->GetData());
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(INDEX_ROOTS_PAGE_ID);
+  IndexRootsPage *index_roots_page = guard.AsMut<IndexRootsPage>();
   if(insert_record){
     index_roots_page->Insert(index_id_,root_page_id_);
   }else{
     index_roots_page->Update(index_id_,root_page_id_);
   }
-  buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID,true);
 }
 
 /**
@@ -945,9 +1061,11 @@ void BPlusTree::ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstre
         << "max_size=" << leaf->GetMaxSize() << ",min_size=" << leaf->GetMinSize() << ",size=" << leaf->GetSize()
         << "</TD></TR>\n";
     out << "<TR>";
+    std::vector<char> key(processor_.GetKeySize());
     for (int i = 0; i < leaf->GetSize(); i++) {
       Row ans;
-      processor_.DeserializeToKey(leaf->KeyAt(i), ans, schema);
+      leaf->KeyAt(i, reinterpret_cast<GenericKey *>(key.data()));
+      processor_.DeserializeToKey(reinterpret_cast<GenericKey *>(key.data()), ans, schema);
       out << "<TD>" << ans.GetField(0)->toString() << "</TD>\n";
     }
     out << "</TR>";
@@ -979,11 +1097,13 @@ void BPlusTree::ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstre
         << "max_size=" << inner->GetMaxSize() << ",min_size=" << inner->GetMinSize() << ",size=" << inner->GetSize()
         << "</TD></TR>\n";
     out << "<TR>";
+    std::vector<char> key(processor_.GetKeySize());
     for (int i = 0; i < inner->GetSize(); i++) {
       out << "<TD PORT=\"p" << inner->ValueAt(i) << "\">";
       if (i > 0) {
         Row ans;
-        processor_.DeserializeToKey(inner->KeyAt(i), ans, schema);
+        inner->KeyAt(i, reinterpret_cast<GenericKey *>(key.data()));
+        processor_.DeserializeToKey(reinterpret_cast<GenericKey *>(key.data()), ans, schema);
         out << ans.GetField(0)->toString();
       } else {
         out << " ";
@@ -1024,7 +1144,7 @@ void BPlusTree::ToString(BPlusTreePage *page, BufferPoolManager *bpm) const {
     std::cout << "Leaf Page: " << leaf->GetPageId() << " parent: " << leaf->GetParentPageId()
               << " next: " << leaf->GetNextPageId() << std::endl;
     for (int i = 0; i < leaf->GetSize(); i++) {
-      std::cout << leaf->KeyAt(i) << ",";
+      std::cout << leaf->ValueAt(i).Get() << ",";
     }
     std::cout << std::endl;
     std::cout << std::endl;
@@ -1032,7 +1152,7 @@ void BPlusTree::ToString(BPlusTreePage *page, BufferPoolManager *bpm) const {
     auto *internal = reinterpret_cast<InternalPage *>(page);
     std::cout << "Internal Page: " << internal->GetPageId() << " parent: " << internal->GetParentPageId() << std::endl;
     for (int i = 0; i < internal->GetSize(); i++) {
-      std::cout << internal->KeyAt(i) << ": " << internal->ValueAt(i) << ",";
+      std::cout << internal->ValueAt(i) << ",";
     }
     std::cout << std::endl;
     std::cout << std::endl;
@@ -1,17 +1,31 @@
 #include "index/b_plus_tree_index.h"
 
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 #include "index/generic_key.h"
+#include "index/key_sorter.h"
+#include "storage/table_heap.h"
 #include "utils/tree_file_mgr.h"
 BPlusTreeIndex::BPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size,
-                               BufferPoolManager *buffer_pool_manager)
+                               BufferPoolManager *buffer_pool_manager, bool unique, IndexSchema *entry_schema)
     : Index(index_id, key_schema),
+      entry_schema_(entry_schema == nullptr ? key_schema : entry_schema),
       processor_(key_schema_, key_size),
-      container_(index_id, buffer_pool_manager, processor_) {}
+      container_(index_id, buffer_pool_manager, processor_, UNDEFINED_SIZE, UNDEFINED_SIZE, unique),
+      buffer_pool_manager_(buffer_pool_manager) {}
 
 dberr_t BPlusTreeIndex::InsertEntry(const Row &key, RowId row_id, Txn *txn) {
   // ASSERT(row_id.Get() != INVALID_ROWID.Get(), "Invalid row id for index insert.");
   GenericKey *index_key = processor_.InitKey();
-  processor_.SerializeFromKey(index_key, key, key_schema_);
+  // 超出列长度的值编码不唯一，不能放进索引
+  if (!processor_.SerializeFromKey(index_key, key, entry_schema_)) {
+    free(index_key);
+    return DB_FAILED;
+  }
 
   bool status = container_.Insert(index_key, row_id, txn);
   free(index_key);
@@ -28,61 +42,169 @@ dberr_t BPlusTreeIndex::InsertEntry(const Row &key, RowId row_id, Txn *txn) {
 
 dberr_t BPlusTreeIndex::RemoveEntry(const Row &key, RowId row_id, Txn *txn) {
   GenericKey *index_key = processor_.InitKey();
-  processor_.SerializeFromKey(index_key, key, key_schema_);
+  processor_.SerializeFromKey(index_key, key, entry_schema_);
 
-  container_.Remove(index_key, txn);
+  container_.Remove(index_key, row_id, txn);
   free(index_key);
   return DB_SUCCESS;
 }
 
 dberr_t BPlusTreeIndex::ScanKey(const Row &key, vector<RowId> &result, Txn *txn, string compare_operator) {
-  GenericKey *index_key = processor_.InitKey();
-  processor_.SerializeFromKey(index_key, key, key_schema_);
-  auto end_iter = GetEndIterator();
+  auto scan = [&](const Row *lower, bool lower_inclusive, const Row *upper, bool upper_inclusive) {
+    IndexRangeIterator iter = ScanRange(lower, lower_inclusive, upper, upper_inclusive);
+    RowId rid;
+    while (iter.Next(rid)) {
+      result.emplace_back(rid);
+    }
+  };
   if (compare_operator == "=") {
+    GenericKey *index_key = processor_.InitKey();
+    processor_.SerializeFromKey(index_key, key, key_schema_);
     container_.GetValue(index_key, result, txn);
+    free(index_key);
   } else if (compare_operator == ">") {
-    auto iter = GetBeginIterator(index_key);
-    if (container_.GetValue(index_key, result, txn)) ++iter;
-    result.clear();
-    for (; iter != end_iter; ++iter) {
-      result.emplace_back((*iter).second);
-    }
+    scan(&key, false, nullptr, true);
   } else if (compare_operator == ">=") {
-    for (auto iter = GetBeginIterator(index_key); iter != end_iter; ++iter) {
-      result.emplace_back((*iter).second);
-    }
+    scan(&key, true, nullptr, true);
   } else if (compare_operator == "<") {
-    auto stop_iter = GetBeginIterator(index_key);
-    for (auto iter = GetBeginIterator(); iter != stop_iter; ++iter) {
-      result.emplace_back((*iter).second);
-    }
+    scan(nullptr, true, &key, false);
   } else if (compare_operator == "<=") {
-    auto stop_iter = GetBeginIterator(index_key);
-    for (auto iter = GetBeginIterator(); iter != stop_iter; ++iter) {
-      result.emplace_back((*iter).second);
-    }
-    container_.GetValue(index_key, result, txn);
+    scan(nullptr, true, &key, true);
   } else if (compare_operator == "<>") {
-    for (auto iter = GetBeginIterator(); iter != end_iter; ++iter) {
-      result.emplace_back((*iter).second);
-    }
-    vector<RowId> temp;
-    if (container_.GetValue(index_key, temp, txn))
-      result.erase(find(result.begin(), result.end(), temp[0]));
+    scan(nullptr, true, &key, false);
+    scan(&key, false, nullptr, true);
   }
-  free(index_key);
   if (!result.empty())
     return DB_SUCCESS;
   else
     return DB_KEY_NOT_FOUND;
 }
 
+IndexRangeIterator BPlusTreeIndex::ScanRange(const Row *lower, bool lower_inclusive, const Row *upper,
+                                             bool upper_inclusive) {
+  GenericKey *lower_key = nullptr, *upper_key = nullptr;
+  if (lower != nullptr) {
+    lower_key = processor_.InitKey();
+    processor_.SerializeFromKey(lower_key, *lower, key_schema_);
+  }
+  if (upper != nullptr) {
+    upper_key = processor_.InitKey();
+    processor_.SerializeFromKey(upper_key, *upper, key_schema_);
+  }
+  IndexIterator begin = lower_key == nullptr ? container_.Begin() : container_.Begin(lower_key);
+  IndexRangeIterator iter(std::move(begin), processor_, buffer_pool_manager_, lower_key, lower_inclusive, upper_key,
+                          upper_inclusive);
+  free(lower_key);
+  free(upper_key);
+  return iter;
+}
+
 dberr_t BPlusTreeIndex::Destroy() {
   container_.Destroy();
   return DB_SUCCESS;
 }
 
+dberr_t BPlusTreeIndex::Build(TableHeap *table_heap, const std::vector<uint32_t> &key_map,
+                              const IndexBuildOptions &options, Txn *txn) {
+  if (!container_.IsEmpty()) {
+    return DB_FAILED;
+  }
+  auto start_time = std::chrono::steady_clock::now();
+  size_t page_count = table_heap->GetPageCount();
+  // 每个工作线程至少分到一个 morsel，表不到两个 morsel 时不启动工作线程
+  uint32_t worker_count =
+      std::max<size_t>(1, std::min<size_t>(options.threads_, (page_count + MORSEL_PAGES - 1) / MORSEL_PAGES));
+  KeySorter sorter(buffer_pool_manager_, processor_, options.sort_memory_);
+  std::atomic<bool> serialized{true};
+  if (worker_count == 1) {
+    SortKeys(table_heap, key_map, txn, sorter, 0, page_count, serialized);
+  } else {
+    // 每个工作线程认领 morsel，排序到自己的 sorter 中，内存预算平分
+    std::vector<std::unique_ptr<KeySorter>> sorters;
+    for (uint32_t i = 0; i < worker_count; i++) {
+      sorters.emplace_back(new KeySorter(buffer_pool_manager_, processor_, options.sort_memory_ / worker_count));
+    }
+    std::atomic<size_t> next_page{0};
+    std::mutex error_latch;
+    std::exception_ptr worker_error = nullptr;
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < worker_count; i++) {
+      workers.emplace_back([&, i] {
+        try {
+          while (serialized) {
+            size_t begin = next_page.fetch_add(MORSEL_PAGES);
+            if (begin >= page_count) {
+              break;
+            }
+            SortKeys(table_heap, key_map, txn, *sorters[i], begin, begin + MORSEL_PAGES, serialized);
+          }
+          sorters[i]->Seal();
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(error_latch);
+          if (worker_error == nullptr) {
+            worker_error = std::current_exception();
+          }
+        }
+      });
+    }
+    for (auto &worker : workers) {
+      worker.join();
+    }
+    if (worker_error != nullptr) {
+      std::rethrow_exception(worker_error);
+    }
+    for (auto &worker_sorter : sorters) {
+      sorter.Absorb(*worker_sorter);
+    }
+  }
+  if (!serialized) {
+    return DB_FAILED;
+  }
+  auto scan_end_time = std::chrono::steady_clock::now();
+  double scan_sort_ms = sorter.GetSortTime();
+  sorter.Finish();
+  bool loaded = container_.BulkLoad([&](GenericKey *&key, RowId &rid) { return sorter.Next(key, rid); },
+                                    options.fill_factor_);
+  if (options.stats_ != nullptr) {
+    auto end_time = std::chrono::steady_clock::now();
+    double scan_ms = std::chrono::duration<double, std::milli>(scan_end_time - start_time).count();
+    double load_ms = std::chrono::duration<double, std::milli>(end_time - scan_end_time).count();
+    // 扫描时各工作线程的排序时间是累加的，取每个线程的平均值从扫描的墙钟时间中扣除
+    scan_sort_ms /= worker_count;
+    scan_ms -= scan_sort_ms;
+    // Finish() 先把最后一段排好序，归并穿插在装载中，都从装载时间里扣除
+    double finish_sort_ms = sorter.GetSortTime() - scan_sort_ms * worker_count;
+    load_ms -= finish_sort_ms + sorter.GetMergeTime();
+    options.stats_->entries_ = sorter.GetEntryCount();
+    options.stats_->threads_ = worker_count;
+    options.stats_->spilled_runs_ = sorter.GetSpilledRunCount();
+    options.stats_->phases_.emplace_back("scan", std::max(0.0, scan_ms));
+    options.stats_->phases_.emplace_back("sort", scan_sort_ms + finish_sort_ms);
+    options.stats_->phases_.emplace_back("merge", sorter.GetMergeTime());
+    options.stats_->phases_.emplace_back("load", std::max(0.0, load_ms));
+  }
+  return loaded ? DB_SUCCESS : DB_FAILED;
+}
+
+void BPlusTreeIndex::SortKeys(TableHeap *table_heap, const std::vector<uint32_t> &key_map, Txn *txn,
+                              KeySorter &sorter, size_t begin, size_t end, std::atomic<bool> &serialized) {
+  GenericKey *index_key = processor_.InitKey();
+  ScanKeys(
+      table_heap, key_map, txn,
+      [&](const Row &key, RowId rid) {
+        // 超出列长度的值不能放进索引，其它线程看到后也会停下
+        if (!processor_.SerializeFromKey(index_key, key, entry_schema_)) {
+          serialized = false;
+        }
+        if (serialized) {
+          sorter.Add(index_key, rid);
+        }
+        return serialized.load();
+      },
+      begin, end);
+  free(index_key);
+}
+
 IndexIterator BPlusTreeIndex::GetBeginIterator() {
   return container_.Begin();
 }
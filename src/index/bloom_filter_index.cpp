@@ -0,0 +1,102 @@
+#include "index/bloom_filter_index.h"
+
+#include "storage/zone_map.h"
+
+BloomFilterIndex::BloomFilterIndex(index_id_t index_id, IndexSchema *key_schema, Schema *table_schema,
+                                   TableHeap *table_heap)
+    : Index(index_id, key_schema), table_schema_(table_schema), table_heap_(table_heap) {}
+
+dberr_t BloomFilterIndex::InsertEntry(const Row &key, RowId row_id, [[maybe_unused]] Txn *txn) {
+  uint64_t hash;
+  if (HashKey(key, &hash)) {
+    Add(row_id.GetPageId(), hash);
+  }
+  return DB_SUCCESS;
+}
+
+dberr_t BloomFilterIndex::RemoveEntry([[maybe_unused]] const Row &key, [[maybe_unused]] RowId row_id,
+                                      [[maybe_unused]] Txn *txn) {
+  return DB_SUCCESS;
+}
+
+dberr_t BloomFilterIndex::ScanKey([[maybe_unused]] const Row &key, [[maybe_unused]] std::vector<RowId> &result,
+                                  [[maybe_unused]] Txn *txn, [[maybe_unused]] string compare_operator) {
+  return DB_KEY_NOT_FOUND;
+}
+
+dberr_t BloomFilterIndex::Destroy() {
+  std::lock_guard<std::mutex> lock(latch_);
+  filters_.clear();
+  return DB_SUCCESS;
+}
+
+void BloomFilterIndex::Rebuild() {
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    filters_.clear();
+  }
+  for (auto it = table_heap_->Begin(nullptr); it != table_heap_->End(); ++it) {
+    Row row(*it);
+    Row key;
+    row.GetKeyFromRow(table_schema_, key_schema_, key);
+    InsertEntry(key, it->GetRowId(), nullptr);
+  }
+}
+
+bool BloomFilterIndex::HashKey(const Row &key, uint64_t *hash) {
+  // FNV-1a
+  uint64_t h = 14695981039346656037ULL;
+  auto mix = [&h](const char *data, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+      h = (h ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+    }
+  };
+  for (uint32_t i = 0; i < key.GetFieldCount(); i++) {
+    const Field *field = key.GetField(i);
+    if (field->IsNull()) {
+      return false;
+    }
+    double value;
+    if (ZoneMap::GetNumericValue(*field, &value)) {
+      // 0.0 和 -0.0 相等，哈希也要相同
+      value = value == 0 ? 0 : value;
+      mix(reinterpret_cast<const char *>(&value), sizeof(value));
+    } else {
+      uint32_t len = field->GetLength();
+      mix(reinterpret_cast<const char *>(&len), sizeof(len));
+      mix(field->GetData(), len);
+    }
+  }
+  *hash = h;
+  return true;
+}
+
+bool BloomFilterIndex::MayContain(page_id_t page_id, uint64_t hash) {
+  std::lock_guard<std::mutex> lock(latch_);
+  auto it = filters_.find(page_id / PAGES_PER_RANGE);
+  if (it == filters_.end()) {
+    return false;
+  }
+  // 双重哈希：第 i 个位置为 h1 + i * h2
+  uint64_t h1 = hash, h2 = (hash >> 32) | 1;
+  for (uint32_t i = 0; i < HASH_COUNT; i++) {
+    uint64_t bit = (h1 + i * h2) % BITS_PER_RANGE;
+    if (!(it->second[bit / 64] & (1ULL << (bit % 64)))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void BloomFilterIndex::Add(page_id_t page_id, uint64_t hash) {
+  std::lock_guard<std::mutex> lock(latch_);
+  auto &bits = filters_[page_id / PAGES_PER_RANGE];
+  if (bits.empty()) {
+    bits.resize(BITS_PER_RANGE / 64);
+  }
+  uint64_t h1 = hash, h2 = (hash >> 32) | 1;
+  for (uint32_t i = 0; i < HASH_COUNT; i++) {
+    uint64_t bit = (h1 + i * h2) % BITS_PER_RANGE;
+    bits[bit / 64] |= 1ULL << (bit % 64);
+  }
+}
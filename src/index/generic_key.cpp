@@ -0,0 +1,155 @@
+#include "index/generic_key.h"
+
+#include <algorithm>
+
+namespace {
+void WriteBigEndian(char *buf, uint32_t value) {
+  for (int i = 3; i >= 0; i--) {
+    buf[i] = static_cast<char>(value & 0xff);
+    value >>= 8;
+  }
+}
+
+uint32_t ReadBigEndian(const char *buf) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++) {
+    value = (value << 8) | static_cast<unsigned char>(buf[i]);
+  }
+  return value;
+}
+
+// 按数值大小排序的 float 位模式
+uint32_t EncodeFloat(float value) {
+  // -0.0 和 0.0 相等，编码也要相同
+  if (value == 0) {
+    value = 0;
+  }
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+float DecodeFloat(uint32_t bits) {
+  bits = (bits & 0x80000000u) ? bits & ~0x80000000u : ~bits;
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+}  // namespace
+
+uint32_t KeyManager::GetNormalizedKeySize(const Schema *schema) {
+  uint32_t size = 0;
+  for (auto column : schema->GetColumns()) {
+    size += 1;
+    if (column->GetType() == TypeId::kTypeChar) {
+      size += column->GetLength() + sizeof(uint32_t);
+    } else {
+      size += Type::GetTypeSize(column->GetType());
+    }
+  }
+  return size;
+}
+
+bool KeyManager::SerializeFromKey(GenericKey *key_buf, const Row &key, Schema *schema) const {
+  ASSERT(key.GetFieldCount() == schema->GetColumnCount(), "field nums not match.");
+  ASSERT(GetNormalizedKeySize(schema) <= (uint32_t)key_size_, "Index key size exceed max key size.");
+  // initialize to 0, which is also the encoding of null values
+  memset(key_buf->data, 0, key_size_);
+  char *buf = key_buf->data;
+  bool exact = true;
+  for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+    const Column *column = schema->GetColumn(i);
+    const Field *field = key.GetField(i);
+    uint32_t value_size =
+        column->GetType() == TypeId::kTypeChar ? column->GetLength() + sizeof(uint32_t) : Type::GetTypeSize(column->GetType());
+    if (field->IsNull()) {
+      buf += 1 + value_size;
+      continue;
+    }
+    *buf++ = 1;
+    switch (column->GetType()) {
+      case TypeId::kTypeInt:
+        WriteBigEndian(buf, static_cast<uint32_t>(field->value_.integer_) ^ 0x80000000u);
+        break;
+      case TypeId::kTypeFloat:
+        WriteBigEndian(buf, EncodeFloat(field->value_.float_));
+        break;
+      case TypeId::kTypeChar: {
+        uint32_t len = field->GetLength();
+        if (len > column->GetLength()) {
+          exact = false;
+        }
+        uint32_t size = std::min(len, column->GetLength());
+        memcpy(buf, field->GetData(), size);
+        // 最后一个非 0 字节之后还有几个字节，普通的字符串是 0，和填充的 0 一起不占页面空间
+        while (size > 0 && buf[size - 1] == 0) {
+          size--;
+        }
+        WriteBigEndian(buf + column->GetLength(), len - size);
+        break;
+      }
+      default:
+        ASSERT(false, "Unsupported type.");
+    }
+    buf += value_size;
+  }
+  return exact;
+}
+
+void KeyManager::DeserializeToKey(const GenericKey *key_buf, Row &key, Schema *schema) const {
+  key.destroy();
+  const char *buf = key_buf->data;
+  for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+    const Column *column = schema->GetColumn(i);
+    TypeId type = column->GetType();
+    uint32_t value_size =
+        type == TypeId::kTypeChar ? column->GetLength() + sizeof(uint32_t) : Type::GetTypeSize(type);
+    bool is_null = *buf++ == 0;
+    if (is_null) {
+      key.AppendField(Field(type));
+    } else if (type == TypeId::kTypeInt) {
+      key.AppendField(Field(type, static_cast<int32_t>(ReadBigEndian(buf) ^ 0x80000000u)));
+    } else if (type == TypeId::kTypeFloat) {
+      key.AppendField(Field(type, DecodeFloat(ReadBigEndian(buf))));
+    } else {
+      uint32_t len = column->GetLength();
+      while (len > 0 && buf[len - 1] == 0) {
+        len--;
+      }
+      len += ReadBigEndian(buf + column->GetLength());
+      key.AppendField(Field(type, const_cast<char *>(buf), len, true));
+    }
+    buf += value_size;
+  }
+  ASSERT(static_cast<int>(buf - key_buf->data) <= key_size_, "Index key size exceed max key size.");
+}
+
+int KeyManager::CompareKeys(const char *lhs, int lhs_size, const GenericKey *rhs, int offset) const {
+  int end = static_cast<int>(normalized_size_);
+  if (offset >= end) {
+    return 0;
+  }
+  int size = std::min(lhs_size, end - offset);
+  int cmp = memcmp(lhs, rhs->data + offset, size);
+  if (cmp != 0) {
+    return cmp;
+  }
+  // lhs 之后的字节都是 0
+  for (int i = offset + size; i < end; i++) {
+    if (rhs->data[i] != 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+void KeyManager::MakeSeparator(const GenericKey *left, const GenericKey *right, GenericKey *separator) const {
+  // 保留 right 到第一个和 left 不同的字节为止
+  int size = 0;
+  while (size < static_cast<int>(normalized_size_) && left->data[size] == right->data[size]) {
+    size++;
+  }
+  ASSERT(size < static_cast<int>(normalized_size_), "Separator of equal keys.");
+  memmove(separator->data, right->data, size + 1);
+  memset(separator->data + size + 1, 0, key_size_ - size - 1);
+}
@@ -0,0 +1,43 @@
+#include "storage/table_heap.h"
+
+#include "index/index.h"
+
+#include <chrono>
+
+dberr_t Index::Build(TableHeap *table_heap, const std::vector<uint32_t> &key_map, const IndexBuildOptions &options,
+                     Txn *txn) {
+  auto start_time = std::chrono::steady_clock::now();
+  dberr_t result = DB_SUCCESS;
+  size_t entries = 0;
+  ScanKeys(table_heap, key_map, txn, [&](const Row &key, RowId rid) {
+    result = InsertEntry(key, rid, txn);
+    entries++;
+    return result == DB_SUCCESS;
+  });
+  if (options.stats_ != nullptr) {
+    options.stats_->entries_ = entries;
+    options.stats_->phases_.emplace_back(
+        "insert", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count());
+  }
+  return result;
+}
+
+void Index::ScanKeys(TableHeap *table_heap, const std::vector<uint32_t> &key_map, Txn *txn,
+                     const std::function<bool(const Row &, RowId)> &visit, size_t begin, size_t end) {
+  for (auto it = table_heap->ViewRange(txn, begin, end); !it.IsEnd(); ++it) {
+    Row key;
+    it->Materialize(&key, key_map);
+    bool external = false;
+    for (uint32_t i = 0; i < key.GetFieldCount(); i++) {
+      external = external || key.GetField(i)->IsExternal();
+    }
+    if (external) {
+      // 键中存放在溢出页里的长值要先读出来，读溢出页之前放开表页面
+      it.Release();
+      table_heap->LoadOverflowValues(&key, {});
+    }
+    if (!visit(key, key.GetRowId())) {
+      return;
+    }
+  }
+}
@@ -7,14 +7,18 @@ IndexIterator::IndexIterator() = default;
 
 IndexIterator::IndexIterator(page_id_t page_id, BufferPoolManager *bpm, int index)
     : current_page_id(page_id), item_index(index), buffer_pool_manager(bpm) {
-  page = reinterpret_cast<LeafPage *>(buffer_pool_manager->FetchPage(current_page_id)->GetData());
+  page_guard = buffer_pool_manager->FetchPageRead(current_page_id);
+  page = page_guard.As<LeafPage>();
 }
 
-IndexIterator::~IndexIterator() {
-  if (current_page_id != INVALID_PAGE_ID)
-    buffer_pool_manager->UnpinPage(current_page_id, false);
+IndexIterator::IndexIterator(ReadPageGuard &&leaf_guard, BufferPoolManager *bpm, int index)
+    : current_page_id(leaf_guard.PageId()), item_index(index), buffer_pool_manager(bpm),
+      page_guard(std::move(leaf_guard)) {
+  page = page_guard.As<LeafPage>();
 }
 
+IndexIterator::~IndexIterator() = default;
+
 /**
  * TODO: Student Implement
  */
@@ -22,7 +26,10 @@ std::pair<GenericKey *, RowId> IndexIterator::operator*() {
   if (current_page_id == INVALID_PAGE_ID || page == nullptr) {
     throw std::out_of_range("Cannot dereference an invalid or end iterator.");
   }
-  return page->GetItem(item_index);
+  key_.resize(page->GetKeySize());
+  auto *key = reinterpret_cast<GenericKey *>(key_.data());
+  page->KeyAt(item_index, key);
+  return {key, page->ValueAt(item_index)};
 }
 
 /**
@@ -43,26 +50,24 @@ IndexIterator &IndexIterator::operator++() {
   }
   // 如果超出了当前页面的范围，需要移动到下一个叶子页面
   page_id_t next_page_id = page->GetNextPageId();
-  // Unpin 当前页面，因为我们要离开它了
-  buffer_pool_manager->UnpinPage(current_page_id, false);
-
   // 更新到下一个页面的信息
   current_page_id = next_page_id;
   item_index = 0; // 到新页面后，从第一个条目开始
 
   if (current_page_id == INVALID_PAGE_ID) {
-    // 没有更多页面了，到达B+树的末尾
+    // 没有更多页面了，到达B+树的末尾，释放当前页面
+    page_guard.Drop();
     page = nullptr; // 将page指针置空
   } else {
-    // 尝试获取新的叶子页面
-    Page *raw_new_page = buffer_pool_manager->FetchPage(current_page_id);
-    if (raw_new_page == nullptr) {
+    // 先锁住下一个叶子页面再释放当前页面
+    page_guard = buffer_pool_manager->FetchPageRead(current_page_id);
+    if (!page_guard.IsValid()) {
       // 获取新页面失败，视为到达末尾
       page = nullptr;
       current_page_id = INVALID_PAGE_ID; // 确保状态一致性
     } else {
       // 成功获取新页面
-      page = reinterpret_cast<LeafPage *>(raw_new_page->GetData());
+      page = page_guard.As<LeafPage>();
     }
   }
   return *this;
@@ -0,0 +1,86 @@
+#include "index/index_range_iterator.h"
+
+#include "index/posting_list.h"
+#include "page/posting_page.h"
+
+IndexRangeIterator::IndexRangeIterator(IndexIterator &&begin, const KeyManager &processor,
+                                       BufferPoolManager *buffer_pool_manager, const GenericKey *lower,
+                                       bool lower_inclusive, const GenericKey *upper, bool upper_inclusive)
+    : iter_(std::move(begin)),
+      processor_(&processor),
+      buffer_pool_manager_(buffer_pool_manager),
+      upper_inclusive_(upper_inclusive),
+      key_(processor.GetKeySize()),
+      done_(false) {
+  if (upper != nullptr) {
+    upper_.resize(processor.GetKeySize());
+    memcpy(upper_.data(), upper, processor.GetKeySize());
+  }
+  // 不含下界时跳过与下界相等的键
+  if (lower != nullptr && !lower_inclusive) {
+    while (iter_ != IndexIterator() && processor.CompareKeys((*iter_).first, lower) == 0) {
+      ++iter_;
+    }
+  }
+}
+
+bool IndexRangeIterator::Next(RowId &rid) {
+  while (true) {
+    if (posting_guard_.IsValid()) {
+      auto *page = posting_guard_.As<PostingPage>();
+      if (posting_pos_ < page->GetSize()) {
+        rid = page->RowIdAt(posting_pos_++);
+        return true;
+      }
+      page_id_t next_page_id = page->GetNextPageId();
+      if (next_page_id != INVALID_PAGE_ID) {
+        posting_guard_ = buffer_pool_manager_->FetchPageBasic(next_page_id);
+        if (!posting_guard_.IsValid()) {
+          throw std::exception();
+        }
+        posting_pos_ = 0;
+        continue;
+      }
+      // 这个键的行号读完了，离开叶子之前先放开 posting list
+      posting_guard_.Drop();
+      ++iter_;
+    }
+    if (done_) {
+      return false;
+    }
+    if (iter_ == IndexIterator()) {
+      Finish();
+      return false;
+    }
+    auto item = *iter_;
+    if (!InRange(item.first)) {
+      Finish();
+      return false;
+    }
+    memcpy(key_.data(), item.first, key_.size());
+    if (PostingList::IsList(item.second)) {
+      posting_guard_ = buffer_pool_manager_->FetchPageBasic(item.second.GetPageId());
+      if (!posting_guard_.IsValid()) {
+        throw std::exception();
+      }
+      posting_pos_ = 0;
+      continue;
+    }
+    rid = item.second;
+    ++iter_;
+    return true;
+  }
+}
+
+bool IndexRangeIterator::InRange(const GenericKey *key) const {
+  if (upper_.empty()) {
+    return true;
+  }
+  int cmp = processor_->CompareKeys(key, reinterpret_cast<const GenericKey *>(upper_.data()));
+  return cmp < 0 || (cmp == 0 && upper_inclusive_);
+}
+
+void IndexRangeIterator::Finish() {
+  done_ = true;
+  iter_ = IndexIterator();
+}
@@ -0,0 +1,220 @@
+#include "index/key_sorter.h"
+
+#include <algorithm>
+#include <numeric>
+
+KeySorter::KeySorter(BufferPoolManager *buffer_pool_manager, const KeyManager &KM, size_t memory_limit)
+    : buffer_pool_manager_(buffer_pool_manager),
+      processor_(KM),
+      memory_limit_(memory_limit),
+      entry_size_(KM.GetKeySize() + sizeof(RowId)),
+      entries_per_page_(buffer_pool_manager->GetPageSize() / entry_size_),
+      current_(entry_size_) {}
+
+KeySorter::~KeySorter() {
+  for (auto &run : runs_) {
+    run.guard_.Drop();
+    for (auto page_id : run.pages_) {
+      if (page_id != INVALID_PAGE_ID) {
+        buffer_pool_manager_->DeletePage(page_id);
+      }
+    }
+  }
+}
+
+void KeySorter::Add(const GenericKey *key, const RowId &rid) {
+  ASSERT(!finished_, "Cannot add entries to a finished sorter.");
+  if (!buffer_.empty() && buffer_.size() + entry_size_ > memory_limit_) {
+    Spill();
+  }
+  size_t offset = buffer_.size();
+  buffer_.resize(offset + entry_size_);
+  memcpy(buffer_.data() + offset, key, processor_.GetKeySize());
+  memcpy(buffer_.data() + offset + processor_.GetKeySize(), &rid, sizeof(RowId));
+  entry_count_++;
+}
+
+void KeySorter::Seal() {
+  if (buffer_.empty()) {
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  std::vector<uint32_t> order = SortBuffer();
+  Run run;
+  run.size_ = order.size();
+  run.data_.resize(buffer_.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    memcpy(run.data_.data() + i * entry_size_, buffer_.data() + order[i] * entry_size_, entry_size_);
+  }
+  runs_.push_back(std::move(run));
+  buffer_.clear();
+  buffer_.shrink_to_fit();
+  sort_ms_ += ElapsedMs(start);
+}
+
+void KeySorter::Absorb(KeySorter &other) {
+  ASSERT(!finished_ && !other.finished_, "Cannot absorb into or from a finished sorter.");
+  ASSERT(other.buffer_.empty(), "The absorbed sorter must be sealed.");
+  ASSERT(entry_size_ == other.entry_size_, "Sorters of different key sizes.");
+  for (auto &run : other.runs_) {
+    runs_.push_back(std::move(run));
+  }
+  entry_count_ += other.entry_count_;
+  spilled_runs_ += other.spilled_runs_;
+  sort_ms_ += other.sort_ms_;
+  other.runs_.clear();
+  other.entry_count_ = 0;
+  other.spilled_runs_ = 0;
+  other.sort_ms_ = 0;
+}
+
+void KeySorter::Finish() {
+  ASSERT(!finished_, "Sorter is already finished.");
+  finished_ = true;
+  // 最后一段留在内存中参与归并
+  Seal();
+  auto start = std::chrono::steady_clock::now();
+  while (runs_.size() > MAX_MERGE_WIDTH) {
+    Run merged = Merge(0, MAX_MERGE_WIDTH);
+    runs_.erase(runs_.begin(), runs_.begin() + MAX_MERGE_WIDTH);
+    runs_.push_back(std::move(merged));
+  }
+  for (size_t i = 0; i < runs_.size(); i++) {
+    if (runs_[i].size_ > 0) {
+      heap_.push_back(i);
+    }
+  }
+  std::make_heap(heap_.begin(), heap_.end(),
+                 [this](size_t a, size_t b) { return Compare(Current(runs_[a]), Current(runs_[b])) > 0; });
+  merge_ms_ += ElapsedMs(start);
+}
+
+bool KeySorter::Next(GenericKey *&key, RowId &rid) {
+  ASSERT(finished_, "Sorter must be finished before reading.");
+  if (heap_.empty()) {
+    return false;
+  }
+  auto start = std::chrono::steady_clock::now();
+  auto greater = [this](size_t a, size_t b) { return Compare(Current(runs_[a]), Current(runs_[b])) > 0; };
+  std::pop_heap(heap_.begin(), heap_.end(), greater);
+  Run &run = runs_[heap_.back()];
+  // 前进之后当前页面可能已经被删除，先复制出来
+  memcpy(current_.data(), Current(run), entry_size_);
+  Advance(run);
+  if (run.pos_ < run.size_) {
+    std::push_heap(heap_.begin(), heap_.end(), greater);
+  } else {
+    heap_.pop_back();
+  }
+  key = reinterpret_cast<GenericKey *>(current_.data());
+  memcpy(&rid, current_.data() + processor_.GetKeySize(), sizeof(RowId));
+  merge_ms_ += ElapsedMs(start);
+  return true;
+}
+
+int KeySorter::Compare(const char *lhs, const char *rhs) const {
+  int result = processor_.CompareKeys(reinterpret_cast<const GenericKey *>(lhs), reinterpret_cast<const GenericKey *>(rhs));
+  if (result != 0) {
+    return result;
+  }
+  RowId lhs_rid, rhs_rid;
+  memcpy(&lhs_rid, lhs + processor_.GetKeySize(), sizeof(RowId));
+  memcpy(&rhs_rid, rhs + processor_.GetKeySize(), sizeof(RowId));
+  return lhs_rid.Get() < rhs_rid.Get() ? -1 : (lhs_rid.Get() > rhs_rid.Get() ? 1 : 0);
+}
+
+std::vector<uint32_t> KeySorter::SortBuffer() const {
+  std::vector<uint32_t> order(buffer_.size() / entry_size_);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+    return Compare(buffer_.data() + a * entry_size_, buffer_.data() + b * entry_size_) < 0;
+  });
+  return order;
+}
+
+void KeySorter::Spill() {
+  auto start = std::chrono::steady_clock::now();
+  Run run;
+  BasicPageGuard guard;
+  for (auto index : SortBuffer()) {
+    Append(run, guard, buffer_.data() + index * entry_size_);
+  }
+  runs_.push_back(std::move(run));
+  spilled_runs_++;
+  buffer_.clear();
+  sort_ms_ += ElapsedMs(start);
+}
+
+double KeySorter::ElapsedMs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+KeySorter::Run KeySorter::Merge(size_t begin, size_t end) {
+  auto greater = [this](size_t a, size_t b) { return Compare(Current(runs_[a]), Current(runs_[b])) > 0; };
+  std::vector<size_t> heap;
+  for (size_t i = begin; i < end; i++) {
+    if (runs_[i].size_ > 0) {
+      heap.push_back(i);
+    }
+  }
+  std::make_heap(heap.begin(), heap.end(), greater);
+  Run merged;
+  BasicPageGuard guard;
+  while (!heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end(), greater);
+    Run &run = runs_[heap.back()];
+    Append(merged, guard, Current(run));
+    Advance(run);
+    if (run.pos_ < run.size_) {
+      std::push_heap(heap.begin(), heap.end(), greater);
+    } else {
+      heap.pop_back();
+    }
+  }
+  return merged;
+}
+
+void KeySorter::Append(Run &run, BasicPageGuard &guard, const char *entry) {
+  size_t slot = run.size_ % entries_per_page_;
+  if (slot == 0) {
+    page_id_t page_id;
+    guard = buffer_pool_manager_->NewPageGuarded(page_id);
+    if (!guard.IsValid()) {
+      throw std::exception();
+    }
+    run.pages_.push_back(page_id);
+  }
+  memcpy(guard.GetDataMut() + slot * entry_size_, entry, entry_size_);
+  run.size_++;
+}
+
+const char *KeySorter::Current(Run &run) {
+  if (run.pages_.empty()) {
+    return run.data_.data() + run.pos_ * entry_size_;
+  }
+  if (!run.guard_.IsValid()) {
+    run.guard_ = buffer_pool_manager_->FetchPageBasic(run.pages_[run.pos_ / entries_per_page_]);
+    if (!run.guard_.IsValid()) {
+      throw std::exception();
+    }
+  }
+  return run.guard_.GetData() + (run.pos_ % entries_per_page_) * entry_size_;
+}
+
+void KeySorter::Advance(Run &run) {
+  run.pos_++;
+  if (run.pages_.empty()) {
+    if (run.pos_ == run.size_) {
+      std::vector<char>().swap(run.data_);
+    }
+    return;
+  }
+  if (run.pos_ % entries_per_page_ != 0 && run.pos_ < run.size_) {
+    return;
+  }
+  // 读完的页面不再需要，直接删除
+  size_t page_index = (run.pos_ - 1) / entries_per_page_;
+  run.guard_.Drop();
+  buffer_pool_manager_->DeletePage(run.pages_[page_index]);
+  run.pages_[page_index] = INVALID_PAGE_ID;
+}
@@ -0,0 +1,158 @@
+#include "index/posting_list.h"
+
+#include "page/posting_page.h"
+
+RowId PostingList::Create(BufferPoolManager *buffer_pool_manager, const std::vector<RowId> &rids) {
+  ASSERT(rids.size() >= 2, "A posting list holds at least two row ids.");
+  uint32_t capacity = PostingPage::GetCapacity(buffer_pool_manager->GetPageSize());
+  page_id_t first_page_id = INVALID_PAGE_ID;
+  BasicPageGuard prev_guard;
+  for (size_t begin = 0; begin < rids.size(); begin += capacity) {
+    page_id_t page_id;
+    BasicPageGuard guard = buffer_pool_manager->NewPageGuarded(page_id);
+    if (!guard.IsValid()) {
+      throw std::exception();
+    }
+    auto *page = guard.AsMut<PostingPage>();
+    page->Init(INVALID_PAGE_ID);
+    for (size_t i = begin; i < rids.size() && i < begin + capacity; i++) {
+      page->SetRowIdAt(i - begin, rids[i]);
+      page->SetSize(i - begin + 1);
+    }
+    if (prev_guard.IsValid()) {
+      prev_guard.AsMut<PostingPage>()->SetNextPageId(page_id);
+    } else {
+      first_page_id = page_id;
+    }
+    prev_guard = std::move(guard);
+  }
+  return RowId(first_page_id, LIST_SLOT);
+}
+
+bool PostingList::Insert(BufferPoolManager *buffer_pool_manager, const RowId &list, const RowId &rid) {
+  uint32_t capacity = PostingPage::GetCapacity(buffer_pool_manager->GetPageSize());
+  BasicPageGuard guard = buffer_pool_manager->FetchPageBasic(list.GetPageId());
+  // rid 放在第一个最后一个行号不小于它的页面，都比它小时放在最后一页
+  while (true) {
+    if (!guard.IsValid()) {
+      throw std::exception();
+    }
+    auto *page = guard.As<PostingPage>();
+    if (page->GetNextPageId() == INVALID_PAGE_ID || rid.Get() <= page->RowIdAt(page->GetSize() - 1).Get()) {
+      break;
+    }
+    guard = buffer_pool_manager->FetchPageBasic(page->GetNextPageId());
+  }
+  auto *page = guard.AsMut<PostingPage>();
+  uint32_t index = page->LowerBound(rid);
+  if (index < page->GetSize() && page->RowIdAt(index) == rid) {
+    return false;
+  }
+  if (page->GetSize() < capacity) {
+    page->InsertAt(index, rid);
+    return true;
+  }
+  // 页面已满：后一半移到新页面，新页面接在它后面
+  page_id_t new_page_id;
+  BasicPageGuard new_guard = buffer_pool_manager->NewPageGuarded(new_page_id);
+  if (!new_guard.IsValid()) {
+    throw std::exception();
+  }
+  auto *new_page = new_guard.AsMut<PostingPage>();
+  new_page->Init(page->GetNextPageId());
+  uint32_t half = page->GetSize() / 2;
+  new_page->CopyFrom(page, half, page->GetSize());
+  page->SetSize(half);
+  page->SetNextPageId(new_page_id);
+  if (index <= half) {
+    page->InsertAt(index, rid);
+  } else {
+    new_page->InsertAt(index - half, rid);
+  }
+  return true;
+}
+
+bool PostingList::Remove(BufferPoolManager *buffer_pool_manager, const RowId &list, const RowId &rid, RowId *only) {
+  *only = INVALID_ROWID;
+  page_id_t prev_page_id = INVALID_PAGE_ID;
+  page_id_t page_id = list.GetPageId();
+  BasicPageGuard guard = buffer_pool_manager->FetchPageBasic(page_id);
+  while (true) {
+    if (!guard.IsValid()) {
+      throw std::exception();
+    }
+    auto *page = guard.As<PostingPage>();
+    if (page->GetNextPageId() == INVALID_PAGE_ID || rid.Get() <= page->RowIdAt(page->GetSize() - 1).Get()) {
+      break;
+    }
+    prev_page_id = page_id;
+    page_id = page->GetNextPageId();
+    guard = buffer_pool_manager->FetchPageBasic(page_id);
+  }
+  auto *page = guard.As<PostingPage>();
+  uint32_t index = page->LowerBound(rid);
+  if (index == page->GetSize() || !(page->RowIdAt(index) == rid)) {
+    return false;
+  }
+  guard.AsMut<PostingPage>()->RemoveAt(index);
+  if (page->GetSize() == 0) {
+    page_id_t next_page_id = page->GetNextPageId();
+    if (prev_page_id != INVALID_PAGE_ID) {
+      // 删除空页面
+      guard.Drop();
+      BasicPageGuard prev_guard = buffer_pool_manager->FetchPageBasic(prev_page_id);
+      prev_guard.AsMut<PostingPage>()->SetNextPageId(next_page_id);
+      prev_guard.Drop();
+      buffer_pool_manager->DeletePage(page_id);
+    } else if (next_page_id != INVALID_PAGE_ID) {
+      // 第一页被叶子引用，不能删除，把下一页的内容搬过来
+      BasicPageGuard next_guard = buffer_pool_manager->FetchPageBasic(next_page_id);
+      auto *next_page = next_guard.As<PostingPage>();
+      page->CopyFrom(next_page, 0, next_page->GetSize());
+      page->SetNextPageId(next_page->GetNextPageId());
+      next_guard.Drop();
+      buffer_pool_manager->DeletePage(next_page_id);
+    }
+  }
+  guard.Drop();
+  // 只剩一个行号时放回叶子
+  guard = buffer_pool_manager->FetchPageBasic(list.GetPageId());
+  auto *first_page = guard.As<PostingPage>();
+  if (first_page->GetNextPageId() == INVALID_PAGE_ID && first_page->GetSize() == 1) {
+    *only = first_page->RowIdAt(0);
+    guard.Drop();
+    buffer_pool_manager->DeletePage(list.GetPageId());
+  }
+  return true;
+}
+
+void PostingList::Collect(BufferPoolManager *buffer_pool_manager, const RowId &list, std::vector<RowId> &result) {
+  page_id_t page_id = list.GetPageId();
+  while (page_id != INVALID_PAGE_ID) {
+    BasicPageGuard guard = buffer_pool_manager->FetchPageBasic(page_id);
+    if (!guard.IsValid()) {
+      throw std::exception();
+    }
+    auto *page = guard.As<PostingPage>();
+    for (uint32_t i = 0; i < page->GetSize(); i++) {
+      result.push_back(page->RowIdAt(i));
+    }
+    page_id = page->GetNextPageId();
+  }
+}
+
+void PostingList::Destroy(BufferPoolManager *buffer_pool_manager, const RowId &list) {
+  page_id_t page_id = list.GetPageId();
+  while (page_id != INVALID_PAGE_ID) {
+    page_id_t next_page_id;
+    {
+      BasicPageGuard guard = buffer_pool_manager->FetchPageBasic(page_id);
+      if (!guard.IsValid()) {
+        return;
+      }
+      next_page_id = guard.As<PostingPage>()->GetNextPageId();
+    }
+    buffer_pool_manager->DeletePage(page_id);
+    page_id = next_page_id;
+  }
+}
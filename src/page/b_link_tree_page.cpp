@@ -0,0 +1,149 @@
+#include "page/b_link_tree_page.h"
+
+/*****************************************************************************
+ * LEAF PAGE
+ *****************************************************************************/
+void BLinkLeafPage::Init(page_id_t page_id, page_id_t parent_id, int key_size, int max_size) {
+  SetPageId(page_id);
+  SetParentPageId(parent_id);
+  SetKeySize(key_size);
+  SetMaxSize(max_size);
+  SetPageType(IndexPageType::LEAF_PAGE);
+  SetSize(0);
+  SetNextPageId(INVALID_PAGE_ID);
+}
+
+GenericKey *BLinkLeafPage::KeyAt(int index) { return reinterpret_cast<GenericKey *>(PairPtrAt(index)); }
+
+void BLinkLeafPage::SetKeyAt(int index, const GenericKey *key) { memcpy(PairPtrAt(index), key, GetKeySize()); }
+
+RowId BLinkLeafPage::ValueAt(int index) const {
+  RowId value;
+  memcpy(&value, data_ + index * (GetKeySize() + sizeof(RowId)) + GetKeySize(), sizeof(RowId));
+  return value;
+}
+
+void BLinkLeafPage::SetValueAt(int index, RowId value) {
+  memcpy(PairPtrAt(index) + GetKeySize(), &value, sizeof(RowId));
+}
+
+int BLinkLeafPage::KeyIndex(const GenericKey *key, const KeyManager &KM) {
+  int low = 0, high = GetSize();
+  while (low < high) {
+    int mid = (low + high) / 2;
+    if (KM.CompareKeys(KeyAt(mid), key) < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+int BLinkLeafPage::Insert(const GenericKey *key, const RowId &value, const KeyManager &KM) {
+  int index = KeyIndex(key, KM);
+  if (index < GetSize() && KM.CompareKeys(KeyAt(index), key) == 0) {
+    return GetSize();
+  }
+  memmove(PairPtrAt(index + 1), PairPtrAt(index), (GetSize() - index) * (GetKeySize() + sizeof(RowId)));
+  SetKeyAt(index, key);
+  SetValueAt(index, value);
+  IncreaseSize(1);
+  return GetSize();
+}
+
+bool BLinkLeafPage::Lookup(const GenericKey *key, RowId &value, const KeyManager &KM) {
+  int index = KeyIndex(key, KM);
+  if (index < GetSize() && KM.CompareKeys(KeyAt(index), key) == 0) {
+    value = ValueAt(index);
+    return true;
+  }
+  return false;
+}
+
+int BLinkLeafPage::RemoveAndDeleteRecord(const GenericKey *key, const KeyManager &KM) {
+  int index = KeyIndex(key, KM);
+  if (index < GetSize() && KM.CompareKeys(KeyAt(index), key) == 0) {
+    memmove(PairPtrAt(index), PairPtrAt(index + 1), (GetSize() - index - 1) * (GetKeySize() + sizeof(RowId)));
+    IncreaseSize(-1);
+  }
+  return GetSize();
+}
+
+void BLinkLeafPage::MoveHalfTo(BLinkLeafPage *recipient) {
+  int half = GetSize() / 2;
+  memcpy(recipient->PairPtrAt(recipient->GetSize()), PairPtrAt(half),
+         (GetSize() - half) * (GetKeySize() + sizeof(RowId)));
+  recipient->IncreaseSize(GetSize() - half);
+  SetSize(half);
+}
+
+/*****************************************************************************
+ * INTERNAL PAGE
+ *****************************************************************************/
+void BLinkInternalPage::Init(page_id_t page_id, page_id_t parent_id, int key_size, int max_size) {
+  SetPageId(page_id);
+  SetParentPageId(parent_id);
+  SetKeySize(key_size);
+  SetMaxSize(max_size);
+  SetPageType(IndexPageType::INTERNAL_PAGE);
+  SetSize(0);
+}
+
+GenericKey *BLinkInternalPage::KeyAt(int index) { return reinterpret_cast<GenericKey *>(PairPtrAt(index)); }
+
+void BLinkInternalPage::SetKeyAt(int index, const GenericKey *key) { memcpy(PairPtrAt(index), key, GetKeySize()); }
+
+page_id_t BLinkInternalPage::ValueAt(int index) const {
+  page_id_t value;
+  memcpy(&value, data_ + index * (GetKeySize() + sizeof(page_id_t)) + GetKeySize(), sizeof(page_id_t));
+  return value;
+}
+
+void BLinkInternalPage::SetValueAt(int index, page_id_t value) {
+  memcpy(PairPtrAt(index) + GetKeySize(), &value, sizeof(page_id_t));
+}
+
+page_id_t BLinkInternalPage::Lookup(const GenericKey *key, const KeyManager &KM) {
+  // 找最后一个不大于 key 的键，第一个键无效
+  int low = 1, high = GetSize();
+  while (low < high) {
+    int mid = (low + high) / 2;
+    if (KM.CompareKeys(KeyAt(mid), key) <= 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return ValueAt(low - 1);
+}
+
+void BLinkInternalPage::PopulateNewRoot(const page_id_t &old_value, const GenericKey *new_key,
+                                        const page_id_t &new_value) {
+  SetValueAt(0, old_value);
+  SetKeyAt(1, new_key);
+  SetValueAt(1, new_value);
+  SetSize(2);
+}
+
+int BLinkInternalPage::InsertNodeAfter(const page_id_t &old_value, const GenericKey *new_key,
+                                       const page_id_t &new_value) {
+  int index = 0;
+  while (index < GetSize() && ValueAt(index) != old_value) {
+    index++;
+  }
+  index++;
+  memmove(PairPtrAt(index + 1), PairPtrAt(index), (GetSize() - index) * (GetKeySize() + sizeof(page_id_t)));
+  SetKeyAt(index, new_key);
+  SetValueAt(index, new_value);
+  IncreaseSize(1);
+  return GetSize();
+}
+
+void BLinkInternalPage::MoveHalfTo(BLinkInternalPage *recipient) {
+  int half = GetSize() / 2;
+  memcpy(recipient->PairPtrAt(recipient->GetSize()), PairPtrAt(half),
+         (GetSize() - half) * (GetKeySize() + sizeof(page_id_t)));
+  recipient->IncreaseSize(GetSize() - half);
+  SetSize(half);
+}
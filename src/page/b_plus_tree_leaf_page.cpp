@@ -4,24 +4,17 @@
 
 #include "index/generic_key.h"
 
-#define pairs_off (data_)
 #define pair_size (GetKeySize() + sizeof(RowId))
-#define key_off 0
-#define val_off GetKeySize()
 /*****************************************************************************
  * HELPER METHODS AND UTILITIES
  *****************************************************************************/
 
-/**
- * TODO: Student Implement
- */
 /**
  * Init method after creating a new leaf page
  * Including set page type, set current size to zero, set page id/parent id, set
  * next page id and set max size
- * 未初始化next_page_id
  */
-void LeafPage::Init(page_id_t page_id, page_id_t parent_id, int key_size, int max_size) {
+void LeafPage::Init(page_id_t page_id, page_id_t parent_id, int key_size, int max_size, int page_size) {
   SetPageId(page_id);
   SetParentPageId(parent_id);
   SetKeySize(key_size);
@@ -29,6 +22,10 @@ void LeafPage::Init(page_id_t page_id, page_id_t parent_id, int key_size, int ma
   SetPageType(IndexPageType::LEAF_PAGE);
   SetSize(0);
   SetNextPageId(INVALID_PAGE_ID);
+  data_size_ = page_size - LEAF_PAGE_HEADER_SIZE;
+  prefix_size_ = 0;
+  key_begin_ = data_size_;
+  key_bytes_ = 0;
 }
 
 /**
@@ -45,118 +42,250 @@ void LeafPage::SetNextPageId(page_id_t next_page_id) {
   }
 }
 
-/**
- * TODO: Student Implement
- */
-/**
+int LeafPage::KeyOffsetAt(int index) const {
+  uint16_t offset;
+  memcpy(&offset, SlotAt(index), sizeof(uint16_t));
+  return offset;
+}
+
+int LeafPage::KeySizeAt(int index) const {
+  uint16_t size;
+  memcpy(&size, SlotAt(index) + sizeof(uint16_t), sizeof(uint16_t));
+  return size;
+}
+
+void LeafPage::SetSlotAt(int index, int key_offset, int key_size, const RowId &value) {
+  char *slot = SlotAt(index);
+  auto offset = static_cast<uint16_t>(key_offset);
+  auto size = static_cast<uint16_t>(key_size);
+  memcpy(slot, &offset, sizeof(uint16_t));
+  memcpy(slot + sizeof(uint16_t), &size, sizeof(uint16_t));
+  memcpy(slot + 2 * sizeof(uint16_t), &value, sizeof(RowId));
+}
+
+/*
  * Helper method to find the first index i so that pairs_[i].first >= key
- * NOTE: This method is only used when generating index iterator
  * 二分查找
  */
-int LeafPage::KeyIndex(const GenericKey *key, const KeyManager &KM) {
-  int low = 0,high = GetSize() -1;
-  while(low<=high){
-    int mid = (low + high)/2;
-    if(KM.CompareKeys(KeyAt(mid),key)>=0){
+int LeafPage::KeyIndex(const GenericKey *key, const KeyManager &KM) const {
+  int low = 0, high = GetSize() - 1;
+  while (low <= high) {
+    int mid = (low + high) / 2;
+    if (CompareAt(mid, key, KM) >= 0) {
       high = mid - 1;
-    }else{
+    } else {
       low = mid + 1;
     }
   }
   return low;
 }
 
+int LeafPage::CompareAt(int index, const GenericKey *key, const KeyManager &KM) const {
+  // 前缀比完再比各自存下的字节
+  int cmp = memcmp(data_, key, prefix_size_);
+  if (cmp != 0) {
+    return cmp;
+  }
+  return KM.CompareKeys(data_ + KeyOffsetAt(index), KeySizeAt(index), key, prefix_size_);
+}
+
 /*
  * Helper method to find and return the key associated with input "index"(a.k.a
  * array offset)
  */
-GenericKey *LeafPage::KeyAt(int index) {
-  return reinterpret_cast<GenericKey *>(pairs_off + index * pair_size + key_off);
-}
-
-void LeafPage::SetKeyAt(int index, GenericKey *key) {
-  memcpy(pairs_off + index * pair_size + key_off, key, GetKeySize());
+void LeafPage::KeyAt(int index, GenericKey *key) const {
+  auto *buf = reinterpret_cast<char *>(key);
+  int size = KeySizeAt(index);
+  memcpy(buf, data_, prefix_size_);
+  memcpy(buf + prefix_size_, data_ + KeyOffsetAt(index), size);
+  memset(buf + prefix_size_ + size, 0, GetKeySize() - prefix_size_ - size);
 }
 
 RowId LeafPage::ValueAt(int index) const {
-  return *reinterpret_cast<const RowId *>(pairs_off + index * pair_size + val_off);
+  RowId value;
+  memcpy(&value, SlotAt(index) + 2 * sizeof(uint16_t), sizeof(RowId));
+  return value;
 }
 
 void LeafPage::SetValueAt(int index, RowId value) {
-  *reinterpret_cast<RowId *>(pairs_off + index * pair_size + val_off) = value;
+  memcpy(SlotAt(index) + 2 * sizeof(uint16_t), &value, sizeof(RowId));
 }
 
-void *LeafPage::PairPtrAt(int index) {
-  return KeyAt(index);
+/*****************************************************************************
+ * SPACE
+ *****************************************************************************/
+int LeafPage::PrefixWith(const GenericKey *key) const {
+  const auto *buf = reinterpret_cast<const char *>(key);
+  return std::min(CommonPrefix(data_, buf, prefix_size_), SignificantSize(buf, GetKeySize()));
 }
 
-void LeafPage::PairCopy(void *dest, void *src, int pair_num) {
-  memcpy(dest, src, pair_num * (GetKeySize() + sizeof(RowId)));
+bool LeafPage::CanInsert(const GenericKey *key) const {
+  if (GetSize() >= GetMaxSize()) {
+    return false;
+  }
+  // 前缀变短时每个键多存前缀少掉的那几个字节
+  int prefix = PrefixWith(key);
+  int key_size = SignificantSize(reinterpret_cast<const char *>(key), GetKeySize()) - prefix;
+  int used = prefix + (GetSize() + 1) * SLOT_SIZE + key_bytes_ + GetSize() * (prefix_size_ - prefix) + key_size;
+  return used <= data_size_;
+}
+
+bool LeafPage::IsUnderflow() const {
+  return GetSize() < GetMinSize() && GetUsedSize() * 2 < data_size_;
+}
+
+bool LeafPage::CanRemove() const {
+  return GetSize() - 1 >= GetMinSize() ||
+         (GetUsedSize() - SLOT_SIZE - (GetKeySize() - prefix_size_)) * 2 >= data_size_;
+}
+
+bool LeafPage::CanLend(int index) const {
+  return GetSize() > 1 &&
+         (GetSize() - 1 >= GetMinSize() || (GetUsedSize() - SLOT_SIZE - KeySizeAt(index)) * 2 >= data_size_);
+}
+
+int LeafPage::PrefixOf(const char *pairs, int count) const {
+  if (count < 2) {
+    return 0;
+  }
+  int prefix = CommonPrefix(pairs, pairs + (count - 1) * pair_size, GetKeySize());
+  for (int i = 0; i < count; i++) {
+    prefix = std::min(prefix, SignificantSize(pairs + i * pair_size, GetKeySize()));
+  }
+  return prefix;
+}
+
+int LeafPage::PackedSize(const char *pairs, int count) const {
+  int prefix = PrefixOf(pairs, count);
+  int size = prefix + count * SLOT_SIZE;
+  for (int i = 0; i < count; i++) {
+    size += SignificantSize(pairs + i * pair_size, GetKeySize()) - prefix;
+  }
+  return size;
+}
+
+void LeafPage::Unpack(std::vector<char> &pairs) const {
+  size_t begin = pairs.size();
+  pairs.resize(begin + GetSize() * pair_size);
+  for (int i = 0; i < GetSize(); i++) {
+    char *pair = pairs.data() + begin + i * pair_size;
+    KeyAt(i, reinterpret_cast<GenericKey *>(pair));
+    RowId value = ValueAt(i);
+    memcpy(pair + GetKeySize(), &value, sizeof(RowId));
+  }
+}
+
+void LeafPage::Pack(const char *pairs, int count) {
+  prefix_size_ = PrefixOf(pairs, count);
+  memcpy(data_, pairs, prefix_size_);
+  key_begin_ = data_size_;
+  key_bytes_ = 0;
+  for (int i = 0; i < count; i++) {
+    const char *pair = pairs + i * pair_size;
+    int size = SignificantSize(pair, GetKeySize()) - prefix_size_;
+    key_begin_ -= size;
+    memcpy(data_ + key_begin_, pair + prefix_size_, size);
+    key_bytes_ += size;
+    RowId value;
+    memcpy(&value, pair + GetKeySize(), sizeof(RowId));
+    SetSlotAt(i, key_begin_, size, value);
+  }
+  SetSize(count);
+  ASSERT(GetUsedSize() <= data_size_, "Leaf page overflow.");
 }
-/*
- * Helper method to find and return the key & value pair associated with input
- * "index"(a.k.a. array offset)
- */
-std::pair<GenericKey *, RowId> LeafPage::GetItem(int index) { return {KeyAt(index), ValueAt(index)}; }
 
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
 /*
- * Insert key & value pair into leaf page ordered by key
+ * Insert key & value pair into leaf page ordered by key, the caller makes sure it fits (CanInsert)
  * @return page size after insertion
  */
-int LeafPage::Insert(GenericKey *key, const RowId &value, const KeyManager &KM) {
+int LeafPage::Insert(const GenericKey *key, const RowId &value, const KeyManager &KM) {
   int size = GetSize();
-  // 空节点直接插入
-  if (size == 0) {
-    SetKeyAt(0, key);
-    SetValueAt(0, value);
-    SetSize(1);
-    return 1;
-  }
-
   int index = KeyIndex(key, KM);
   // 若值已经存在则直接返回当前大小
-  if (index < GetSize() && KM.CompareKeys(KeyAt(index), key) == 0) {
-    return GetSize();
+  if (index < size && CompareAt(index, key, KM) == 0) {
+    return size;
   }
-
-  // 将index及之后的元素后移
-  for (int i = size; i > index; i--) {
-    PairCopy(pairs_off + i * pair_size, pairs_off + (i - 1) * pair_size);
+  int key_size = SignificantSize(reinterpret_cast<const char *>(key), GetKeySize()) - prefix_size_;
+  if (PrefixWith(key) < prefix_size_ || key_begin_ - prefix_size_ - (size + 1) * SLOT_SIZE < key_size) {
+    // 前缀变短或者空闲空间不连续：展开后连同新键一起重写
+    std::vector<char> pairs;
+    Unpack(pairs);
+    pairs.insert(pairs.begin() + index * pair_size, pair_size, 0);
+    memcpy(pairs.data() + index * pair_size, key, GetKeySize());
+    memcpy(pairs.data() + index * pair_size + GetKeySize(), &value, sizeof(RowId));
+    Pack(pairs.data(), size + 1);
+    return GetSize();
   }
-  
-  // 插入新键值对
-  SetKeyAt(index, key);          // 设置新键
-  SetValueAt(index, value);      // 设置新值
-  IncreaseSize(1);               // 增加页面元素计数
-  
-  return GetSize();              // 返回插入后的新大小
+  // 将index及之后的槽位后移
+  memmove(SlotAt(index + 1), SlotAt(index), (size - index) * SLOT_SIZE);
+  key_begin_ -= key_size;
+  memcpy(data_ + key_begin_, reinterpret_cast<const char *>(key) + prefix_size_, key_size);
+  key_bytes_ += key_size;
+  SetSlotAt(index, key_begin_, key_size, value);
+  IncreaseSize(1);
+  return GetSize();
 }
 
 /*****************************************************************************
  * SPLIT
  *****************************************************************************/
-/*
- * Remove half of key & value pairs from this page to "recipient" page
- */
-void LeafPage::MoveHalfTo(LeafPage *recipient) {
-  int size = GetSize();
-  int half = size / 2;
-  recipient->CopyNFrom(pairs_off+half*pair_size,size-half);
-  SetSize(half);
-  //recipient->SetNextPageId(this->GetNextPageId());//TO CHECK:更新next_page_id/NextPageId
-  //this->SetNextPageId(recipient->GetPageId());
-}
+void LeafPage::MoveHalfTo(LeafPage *recipient, const GenericKey *key, const RowId &value, const KeyManager &KM) {
+  int index = KeyIndex(key, KM);
+  std::vector<char> pairs;
+  Unpack(pairs);
+  pairs.insert(pairs.begin() + index * pair_size, pair_size, 0);
+  memcpy(pairs.data() + index * pair_size, key, GetKeySize());
+  memcpy(pairs.data() + index * pair_size + GetKeySize(), &value, sizeof(RowId));
+  int count = GetSize() + 1;
 
-/*
- * Copy starting from items, and copy {size} number of elements into me.
- */
-void LeafPage::CopyNFrom(void *src, int size) {
-  int oldsize = GetSize();
-  memcpy(PairPtrAt(oldsize),src,static_cast<size_t>(size)*(GetKeySize() + sizeof(RowId)));
-  IncreaseSize(size);
+  // 两边各自的前缀：[0, i) 的记在 left_prefix[i]，[i, count) 的记在 right_prefix[i]
+  auto pair_at = [&](int i) { return pairs.data() + i * pair_size; };
+  std::vector<int> key_sum(count + 1, 0), left_prefix(count + 1, 0), right_prefix(count + 1, 0);
+  std::vector<int> significant(count);
+  for (int i = 0; i < count; i++) {
+    significant[i] = SignificantSize(pair_at(i), GetKeySize());
+    key_sum[i + 1] = key_sum[i] + significant[i];
+  }
+  int min_significant = GetKeySize();
+  for (int i = 1; i <= count; i++) {
+    min_significant = std::min(min_significant, significant[i - 1]);
+    if (i >= 2) {
+      left_prefix[i] = std::min(CommonPrefix(pair_at(0), pair_at(i - 1), GetKeySize()), min_significant);
+    }
+  }
+  min_significant = GetKeySize();
+  for (int i = count - 1; i >= 0; i--) {
+    min_significant = std::min(min_significant, significant[i]);
+    if (count - i >= 2) {
+      right_prefix[i] = std::min(CommonPrefix(pair_at(i), pair_at(count - 1), GetKeySize()), min_significant);
+    }
+  }
+  auto bytes = [&](int begin, int end, int prefix) {
+    return prefix + (end - begin) * (SLOT_SIZE - prefix) + key_sum[end] - key_sum[begin];
+  };
+  // 一边的满的程度按字节和条目数里更满的那个算，取两边中较满的一边最空的分裂点
+  auto fill = [&](int entries, int used) {
+    return std::max(static_cast<int64_t>(used) * GetMaxSize(), static_cast<int64_t>(entries) * data_size_);
+  };
+  int split = -1;
+  int64_t best = 0;
+  for (int i = 1; i < count; i++) {
+    int left = bytes(0, i, left_prefix[i]), right = bytes(i, count, right_prefix[i]);
+    if (left > data_size_ || right > data_size_ || i > GetMaxSize() || count - i > GetMaxSize()) {
+      continue;
+    }
+    int64_t worst = std::max(fill(i, left), fill(count - i, right));
+    if (split < 0 || worst < best) {
+      split = i;
+      best = worst;
+    }
+  }
+  ASSERT(split > 0, "No split point for the leaf page.");
+  Pack(pairs.data(), split);
+  recipient->Pack(pair_at(split), count - split);
 }
 
 /*****************************************************************************
@@ -167,9 +296,9 @@ void LeafPage::CopyNFrom(void *src, int size) {
  * does, then store its corresponding value in input "value" and return true.
  * If the key does not exist, then return false
  */
-bool LeafPage::Lookup(const GenericKey *key, RowId &value, const KeyManager &KM) {
-  int index = KeyIndex(key,KM);
-  if(index<GetSize() && KM.CompareKeys(KeyAt(index),key)==0){
+bool LeafPage::Lookup(const GenericKey *key, RowId &value, const KeyManager &KM) const {
+  int index = KeyIndex(key, KM);
+  if (index < GetSize() && CompareAt(index, key, KM) == 0) {
     value = ValueAt(index);
     return true;
   }
@@ -182,19 +311,24 @@ bool LeafPage::Lookup(const GenericKey *key, RowId &value, const KeyManager &KM)
 /*
  * First look through leaf page to see whether delete key exist or not. If
  * existed, perform deletion, otherwise return immediately.
- * NOTE: store key&value pair continuously after deletion
  * @return  page size after deletion
  */
 int LeafPage::RemoveAndDeleteRecord(const GenericKey *key, const KeyManager &KM) {
-  int index = KeyIndex(key,KM),size = GetSize();
-  if(index<size && KM.CompareKeys(KeyAt(index),key)==0){
-    for(int i=index;i< size-1; i++){
-      PairCopy(PairPtrAt(i),PairPtrAt(i+1),1);
-    }
-    IncreaseSize(-1);
-    size--;
+  int index = KeyIndex(key, KM);
+  if (index < GetSize() && CompareAt(index, key, KM) == 0) {
+    RemoveAt(index);
+  }
+  return GetSize();
+}
+
+void LeafPage::RemoveAt(int index) {
+  key_bytes_ -= KeySizeAt(index);
+  memmove(SlotAt(index), SlotAt(index + 1), (GetSize() - index - 1) * SLOT_SIZE);
+  IncreaseSize(-1);
+  if (GetSize() == 0) {
+    prefix_size_ = 0;
+    key_begin_ = data_size_;
   }
-  return(size);
 }
 
 /*****************************************************************************
@@ -204,11 +338,18 @@ int LeafPage::RemoveAndDeleteRecord(const GenericKey *key, const KeyManager &KM)
  * Remove all key & value pairs from this page to "recipient" page. Don't forget
  * to update the next_page id in the sibling page
  */
-void LeafPage::MoveAllTo(LeafPage *recipient) {
-  int size =GetSize();
-  recipient->CopyNFrom(PairPtrAt(0),size);
+bool LeafPage::MoveAllTo(LeafPage *recipient) {
+  std::vector<char> pairs;
+  recipient->Unpack(pairs);
+  Unpack(pairs);
+  int count = recipient->GetSize() + GetSize();
+  if (count > recipient->GetMaxSize() || PackedSize(pairs.data(), count) > recipient->data_size_) {
+    return false;
+  }
+  recipient->Pack(pairs.data(), count);
   recipient->SetNextPageId(next_page_id_);
   SetSize(0);
+  return true;
 }
 
 /*****************************************************************************
@@ -216,52 +357,28 @@ void LeafPage::MoveAllTo(LeafPage *recipient) {
  *****************************************************************************/
 /*
  * Remove the first key & value pair from this page to "recipient" page.
- *
  */
-void LeafPage::MoveFirstToEndOf(LeafPage *recipient) {
-  int size = GetSize();
-  if(size == 0) return ;
-  GenericKey* key_to_move = KeyAt(0);
-  RowId value_to_move = ValueAt(0);
-  recipient->CopyLastFrom(key_to_move,value_to_move);
-  for(int i = 0;i<size-1;i++){
-    PairCopy(PairPtrAt(i),PairPtrAt(i+1),1);
+bool LeafPage::MoveFirstToEndOf(LeafPage *recipient, const KeyManager &KM) {
+  std::vector<char> key(GetKeySize());
+  KeyAt(0, reinterpret_cast<GenericKey *>(key.data()));
+  if (!recipient->CanInsert(reinterpret_cast<GenericKey *>(key.data()))) {
+    return false;
   }
-  IncreaseSize(-1);
-}
-
-/*
- * Copy the item into the end of my item list. (Append item to my array)
- */
-void LeafPage::CopyLastFrom(GenericKey *key, const RowId value) {
-  int size = GetSize();
-  SetKeyAt(size,key);
-  SetValueAt(size,value);
-  IncreaseSize(1);
+  recipient->Insert(reinterpret_cast<GenericKey *>(key.data()), ValueAt(0), KM);
+  RemoveAt(0);
+  return true;
 }
 
 /*
  * Remove the last key & value pair from this page to "recipient" page.
  */
-void LeafPage::MoveLastToFrontOf(LeafPage *recipient) {
-  int size = GetSize();
-  if(size == 0) return;
-  GenericKey* ket_to_move = KeyAt(GetSize()-1);
-  RowId value_to_move = ValueAt(GetSize() - 1);
-  recipient->CopyFirstFrom(ket_to_move,value_to_move);
-  IncreaseSize(-1);
-}
-
-/*
- * Insert item at the front of my items. Move items accordingly.
- *
- */
-void LeafPage::CopyFirstFrom(GenericKey *key, const RowId value) {
-  int current_size = GetSize();
-  for (int i = current_size; i > 0; --i) {
-    PairCopy(PairPtrAt(i), PairPtrAt(i - 1), 1);
+bool LeafPage::MoveLastToFrontOf(LeafPage *recipient, const KeyManager &KM) {
+  std::vector<char> key(GetKeySize());
+  KeyAt(GetSize() - 1, reinterpret_cast<GenericKey *>(key.data()));
+  if (!recipient->CanInsert(reinterpret_cast<GenericKey *>(key.data()))) {
+    return false;
   }
-  SetKeyAt(0, key);
-  SetValueAt(0, value);
-  IncreaseSize(1);
-}
\ No newline at end of file
+  recipient->Insert(reinterpret_cast<GenericKey *>(key.data()), ValueAt(GetSize() - 1), KM);
+  RemoveAt(GetSize() - 1);
+  return true;
+}
@@ -107,4 +107,18 @@ void BPlusTreePage::SetPageId(page_id_t page_id) {
  */
 void BPlusTreePage::SetLSN(lsn_t lsn) {
   lsn_ = lsn;
-}
\ No newline at end of file
+}
+int BPlusTreePage::SignificantSize(const char *key, int key_size) {
+  while (key_size > 0 && key[key_size - 1] == 0) {
+    key_size--;
+  }
+  return key_size;
+}
+
+int BPlusTreePage::CommonPrefix(const char *lhs, const char *rhs, int size) {
+  int prefix = 0;
+  while (prefix < size && lhs[prefix] == rhs[prefix]) {
+    prefix++;
+  }
+  return prefix;
+}
@@ -1,36 +1,55 @@
 #include "page/table_page.h"
 
+#include <algorithm>
+#include <functional>
+#include <vector>
+
 // TODO: Update interface implementation if apply recovery
 
 void TablePage::Init(page_id_t page_id, page_id_t prev_id, LogManager *log_mgr, Txn *txn) {
   memcpy(GetData(), &page_id, sizeof(page_id));
   SetPrevPageId(prev_id);
   SetNextPageId(INVALID_PAGE_ID);
-  SetFreeSpacePointer(PAGE_SIZE);
+  SetFreeSpacePointer(GetPageSize());
   SetTupleCount(0);
+  SetVersion(CURRENT_VERSION);
+  SetFreeSlotHead(NO_FREE_SLOT);
+  SetFragmentedBytes(0);
 }
 
 bool TablePage::InsertTuple(Row &row, Schema *schema, Txn *txn, LockManager *lock_manager, LogManager *log_manager) {
-  uint32_t serialized_size = row.GetSerializedSize(schema);
+  uint32_t serialized_size = row.GetSerializedSize(schema, RowFormat::kV2);
   ASSERT(serialized_size > 0, "Can not have empty row.");
-  if (GetFreeSpaceRemaining() < serialized_size + SIZE_TUPLE) {
-    return false;
+  if (GetVersion() == 0) {
+    UpgradeVersion();
   }
   // Try to find a free slot to reuse.
   uint32_t i;
-  for (i = 0; i < GetTupleCount(); i++) {
-    // If the slot is empty, i.e. its tuple has size 0,
-    if (GetTupleSize(i) == 0) {
-      // Then we break out of the loop at index i.
-      break;
+  if (GetVersion() != 0) {
+    // Take the head of the free slot chain, or append a new slot if the chain is empty.
+    i = GetFreeSlotHead() == NO_FREE_SLOT ? GetTupleCount() : GetFreeSlotHead();
+  } else {
+    // A version 0 page too full to be upgraded, fall back to scanning the slot directory.
+    for (i = 0; i < GetTupleCount(); i++) {
+      if (GetTupleSize(i) == 0) {
+        break;
+      }
     }
   }
-  if (i == GetTupleCount() && GetFreeSpaceRemaining() < serialized_size + SIZE_TUPLE) {
-    return false;
+  // A reused slot needs room for the tuple only, a new slot also for its directory entry.
+  uint32_t required_space = serialized_size + (i == GetTupleCount() ? SIZE_TUPLE : 0);
+  if (GetFreeSpaceRemaining() < required_space) {
+    if (GetFreeSpaceRemaining() + GetFragmentedBytes() < required_space) {
+      return false;
+    }
+    Compact();
+  }
+  if (i != GetTupleCount() && GetVersion() != 0) {
+    SetFreeSlotHead(GetTupleOffsetAtSlot(i));
   }
   // Otherwise we claim available free space..
   SetFreeSpacePointer(GetFreeSpacePointer() - serialized_size);
-  uint32_t __attribute__((unused)) write_bytes = row.SerializeTo(reinterpret_cast<char*>(GetData() + GetFreeSpacePointer()), schema);
+  uint32_t __attribute__((unused)) write_bytes = row.SerializeTo(reinterpret_cast<char*>(GetData() + GetFreeSpacePointer()), schema, RowFormat::kV2);
   ASSERT(write_bytes == serialized_size, "Unexpected behavior in row serialize.");
 
   // Set the tuple.
@@ -65,7 +84,7 @@ bool TablePage::MarkDelete(const RowId &rid, Txn *txn, LockManager *lock_manager
 bool TablePage::UpdateTuple(Row &new_row, Row *old_row, Schema *schema, Txn *txn, LockManager *lock_manager,
                             LogManager *log_manager) {
   ASSERT(old_row != nullptr && old_row->GetRowId().Get() != INVALID_ROWID.Get(), "invalid old row.");
-  uint32_t serialized_size = new_row.GetSerializedSize(schema);
+  uint32_t serialized_size = new_row.GetSerializedSize(schema, RowFormat::kV2);
   ASSERT(serialized_size > 0, "Can not have empty row.");
   uint32_t slot_num = old_row->GetRowId().GetSlotNum();
   // If the slot number is invalid, abort.
@@ -73,63 +92,93 @@ bool TablePage::UpdateTuple(Row &new_row, Row *old_row, Schema *schema, Txn *txn
     return false;
   }
   uint32_t tuple_size = GetTupleSize(slot_num);
-  // If the tuple is deleted, abort.
-  if (IsDeleted(tuple_size)) {
+  // If the tuple is deleted or only a forwarding stub, abort.
+  if (IsDeleted(tuple_size) || IsForward(tuple_size)) {
     return false;
   }
+  uint32_t tuple_length = GetTupleLength(tuple_size);
   // If there is not enough space to update, we need to update via delete followed by an insert (not enough space).
-  if (GetFreeSpaceRemaining() + tuple_size < serialized_size) {
+  if (GetAvailableSpace() + tuple_length < serialized_size) {
     return false;
   }
   // Copy out the old value.
   uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
   uint32_t __attribute__((unused)) read_bytes = old_row->DeserializeFrom(GetData() + tuple_offset, schema);
-  ASSERT(tuple_size == read_bytes, "Unexpected behavior in tuple deserialize.");
-  uint32_t free_space_pointer = GetFreeSpacePointer();
-  ASSERT(tuple_offset >= free_space_pointer, "Offset should appear after current free space position.");
-  memmove(GetData() + free_space_pointer + tuple_size - serialized_size, GetData() + free_space_pointer,
-          tuple_offset - free_space_pointer);
-  SetFreeSpacePointer(free_space_pointer + tuple_size - serialized_size);
-  new_row.SerializeTo(GetData() + tuple_offset + tuple_size - serialized_size, schema);
-  SetTupleSize(slot_num, serialized_size);
-
-  // Update all tuple offsets.
-  for (uint32_t i = 0; i < GetTupleCount(); ++i) {
-    uint32_t tuple_offset_i = GetTupleOffsetAtSlot(i);
-    if (GetTupleSize(i) > 0 && tuple_offset_i < tuple_offset + tuple_size) {
-      SetTupleOffsetAtSlot(i, tuple_offset_i + tuple_size - new_row.GetSerializedSize(schema));
-    }
+  ASSERT(tuple_length == read_bytes, "Unexpected behavior in tuple deserialize.");
+  // 保留 MOVED_IN 标记，搬迁过来的元组原地更新后仍只能通过转发桩访问
+  ReserveTupleSpace(slot_num, serialized_size, tuple_size & MOVED_IN_MASK);
+  new_row.SerializeTo(GetData() + GetTupleOffsetAtSlot(slot_num), schema, RowFormat::kV2);
+  return true;
+}
+
+void TablePage::ReserveTupleSpace(uint32_t slot_num, uint32_t new_size, uint32_t flags) {
+  uint32_t old_size = GetTupleLength(GetTupleSize(slot_num));
+  if (new_size <= old_size) {
+    // The new value fits where the old one was, the tail of the old value becomes a hole.
+    SetTupleSize(slot_num, new_size | flags);
+    AddFragmentedBytes(old_size - new_size);
+    return;
+  }
+  bool old_value_is_hole = GetFreeSpaceRemaining() >= new_size;
+  if (!old_value_is_hole) {
+    // Only the holes together with the old value make enough room, drop the old value and compact.
+    SetTupleSize(slot_num, 0);
+    Compact();
+  }
+  // The new value goes to the free space pointer.
+  SetFreeSpacePointer(GetFreeSpacePointer() - new_size);
+  SetTupleOffsetAtSlot(slot_num, GetFreeSpacePointer());
+  SetTupleSize(slot_num, new_size | flags);
+  if (old_value_is_hole) {
+    AddFragmentedBytes(old_size);
+  }
+}
+
+bool TablePage::GetForwardRowId(const RowId &rid, RowId *target) {
+  uint32_t slot_num = rid.GetSlotNum();
+  if (slot_num >= GetTupleCount() || !IsForward(GetTupleSize(slot_num))) {
+    return false;
   }
+  int64_t target_rid;
+  memcpy(&target_rid, GetData() + GetTupleOffsetAtSlot(slot_num), sizeof(target_rid));
+  *target = RowId(target_rid);
   return true;
 }
 
+bool TablePage::SetForwardRowId(const RowId &rid, const RowId &target) {
+  uint32_t slot_num = rid.GetSlotNum();
+  if (!HasTuple(rid)) {
+    return false;
+  }
+  if (GetAvailableSpace() + GetTupleLength(GetTupleSize(slot_num)) < SIZE_FORWARD_STUB) {
+    return false;
+  }
+  ReserveTupleSpace(slot_num, SIZE_FORWARD_STUB, FORWARD_MASK);
+  int64_t target_rid = target.Get();
+  memcpy(GetData() + GetTupleOffsetAtSlot(slot_num), &target_rid, sizeof(target_rid));
+  return true;
+}
+
+void TablePage::MarkMovedIn(const RowId &rid) {
+  uint32_t slot_num = rid.GetSlotNum();
+  ASSERT(HasTuple(rid), "Only a live tuple can be marked as moved in.");
+  SetTupleSize(slot_num, GetTupleSize(slot_num) | MOVED_IN_MASK);
+}
+
 void TablePage::ApplyDelete(const RowId &rid, Txn *txn, LogManager *log_manager) {
   uint32_t slot_num = rid.GetSlotNum();
   ASSERT(slot_num < GetTupleCount(), "Cannot have more slots than tuples.");
 
-  uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
-  uint32_t tuple_size = GetTupleSize(slot_num);
   // Check if this is a delete operation, i.e. commit a delete.
-  if (IsDeleted(tuple_size)) {
-    tuple_size = UnsetDeletedFlag(tuple_size);
-  }
-
-  uint32_t free_space_pointer = GetFreeSpacePointer();
-  ASSERT(tuple_offset >= free_space_pointer, "Free space appears before tuples.");
-
-  memmove(GetData() + free_space_pointer + tuple_size, GetData() + free_space_pointer,
-          tuple_offset - free_space_pointer);
-  SetFreeSpacePointer(free_space_pointer + tuple_size);
+  uint32_t tuple_size = GetTupleLength(GetTupleSize(slot_num));
+  // Only free the slot here, the tuple bytes stay where they are until the page is compacted.
   SetTupleSize(slot_num, 0);
-  SetTupleOffsetAtSlot(slot_num, 0);
-
-  // Update all tuple offsets.
-  for (uint32_t i = 0; i < GetTupleCount(); ++i) {
-    uint32_t tuple_offset_i = GetTupleOffsetAtSlot(i);
-    if (GetTupleSize(i) != 0 && tuple_offset_i < tuple_offset) {
-      SetTupleOffsetAtSlot(i, tuple_offset_i + tuple_size);
-    }
+  if (GetVersion() != 0) {
+    PushFreeSlot(slot_num);
+  } else {
+    SetTupleOffsetAtSlot(slot_num, 0);
   }
+  AddFragmentedBytes(tuple_size);
 }
 
 void TablePage::RollbackDelete(const RowId &rid, Txn *txn, LogManager *log_manager) {
@@ -143,7 +192,69 @@ void TablePage::RollbackDelete(const RowId &rid, Txn *txn, LogManager *log_manag
   }
 }
 
-bool TablePage::GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_manager) {
+void TablePage::PushFreeSlot(uint32_t slot_num) {
+  SetTupleOffsetAtSlot(slot_num, GetFreeSlotHead());
+  SetFreeSlotHead(slot_num);
+}
+
+bool TablePage::UpgradeVersion() {
+  if (GetFreeSpaceRemaining() < SIZE_TABLE_PAGE_HEADER - SIZE_TABLE_PAGE_HEADER_V0) {
+    return false;
+  }
+  // 槽目录整体后移，给新增的头部字段腾出位置；旧版本 TupleCount 的高 16 位恰好是 0
+  uint32_t tuple_count = GetTupleCount();
+  memmove(GetData() + SIZE_TABLE_PAGE_HEADER, GetData() + SIZE_TABLE_PAGE_HEADER_V0, SIZE_TUPLE * tuple_count);
+  SetVersion(CURRENT_VERSION);
+  SetFreeSlotHead(NO_FREE_SLOT);
+  // 旧版本页面每次删除后都会立即整理，不存在碎片
+  SetFragmentedBytes(0);
+  // 把已有的空槽串成链表，倒序插入使链表按槽号递增
+  for (uint32_t i = tuple_count; i > 0; i--) {
+    if (GetTupleSize(i - 1) == 0) {
+      PushFreeSlot(i - 1);
+    }
+  }
+  return true;
+}
+
+void TablePage::AddFragmentedBytes(uint32_t bytes) {
+  if (bytes == 0) {
+    return;
+  }
+  if (GetVersion() == 0) {
+    Compact();
+    return;
+  }
+  SetFragmentedBytes(GetFragmentedBytes() + bytes);
+}
+
+void TablePage::Compact() {
+  // 按偏移从大到小依次把元组挪到页尾，每个元组只移动一次
+  std::vector<std::pair<uint32_t, uint32_t>> tuples;  // (offset, slot)
+  uint32_t tuple_count = GetTupleCount();
+  tuples.reserve(tuple_count);
+  for (uint32_t i = 0; i < tuple_count; i++) {
+    if (GetTupleSize(i) != 0) {
+      tuples.emplace_back(GetTupleOffsetAtSlot(i), i);
+    }
+  }
+  std::sort(tuples.begin(), tuples.end(), std::greater<>());
+  uint32_t free_space_pointer = GetPageSize();
+  for (auto &[offset, slot] : tuples) {
+    uint32_t size = GetTupleLength(GetTupleSize(slot));
+    free_space_pointer -= size;
+    if (free_space_pointer != offset) {
+      memmove(GetData() + free_space_pointer, GetData() + offset, size);
+      SetTupleOffsetAtSlot(slot, free_space_pointer);
+    }
+  }
+  SetFreeSpacePointer(free_space_pointer);
+  if (GetVersion() != 0) {
+    SetFragmentedBytes(0);
+  }
+}
+
+bool TablePage::GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_manager, bool include_deleted) {
   ASSERT(row != nullptr && row->GetRowId().Get() != INVALID_ROWID.Get(), "Invalid row.");
   // Get the current slot number.
   uint32_t slot_num = row->GetRowId().GetSlotNum();
@@ -153,21 +264,34 @@ bool TablePage::GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_m
   }
   // Otherwise get the current tuple size too.
   uint32_t tuple_size = GetTupleSize(slot_num);
-  // If the tuple is deleted, abort the recovery.
-  if (IsDeleted(tuple_size)) {
+  // If the tuple is deleted, or the slot only forwards to the row, abort the recovery.
+  if (tuple_size == 0 || (IsDeleted(tuple_size) && !include_deleted) || IsForward(tuple_size)) {
     return false;
   }
   // At this point, we have at least a shared lock on the RID. Copy the tuple data into our result.
   uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
   uint32_t __attribute__((unused)) read_bytes = row->DeserializeFrom(GetData() + tuple_offset, schema);
-  ASSERT(tuple_size == read_bytes, "Unexpected behavior in tuple deserialize.");
+  ASSERT(GetTupleLength(tuple_size) == read_bytes, "Unexpected behavior in tuple deserialize.");
+  return true;
+}
+
+bool TablePage::GetTupleView(const RowId &rid, Schema *schema, RowView *view) {
+  uint32_t slot_num = rid.GetSlotNum();
+  if (slot_num >= GetTupleCount()) {
+    return false;
+  }
+  uint32_t tuple_size = GetTupleSize(slot_num);
+  if (IsDeleted(tuple_size) || IsForward(tuple_size)) {
+    return false;
+  }
+  view->Reset(GetData() + GetTupleOffsetAtSlot(slot_num), schema, rid);
   return true;
 }
 
 bool TablePage::GetFirstTupleRid(RowId *first_rid) {
   // Find and return the first valid tuple.
   for (uint32_t i = 0; i < GetTupleCount(); i++) {
-    if (!IsDeleted(GetTupleSize(i))) {
+    if (!IsDeleted(GetTupleSize(i)) && !IsMovedIn(GetTupleSize(i))) {
       first_rid->Set(GetTablePageId(), i);
       return true;
     }
@@ -180,7 +304,7 @@ bool TablePage::GetNextTupleRid(const RowId &cur_rid, RowId *next_rid) {
   ASSERT(cur_rid.GetPageId() == GetTablePageId(), "Wrong table!");
   // Find and return the first valid tuple after our current slot number.
   for (auto i = cur_rid.GetSlotNum() + 1; i < GetTupleCount(); i++) {
-    if (!IsDeleted(GetTupleSize(i))) {
+    if (!IsDeleted(GetTupleSize(i)) && !IsMovedIn(GetTupleSize(i))) {
       next_rid->Set(GetTablePageId(), i);
       return true;
     }
@@ -171,6 +171,10 @@ const char *GetSyntaxNodeTypeStr(SyntaxNodeType type) {
       return "kNodeTrxCommit";
     case kNodeTrxRollback:
       return "kNodeTrxRollback";
+    case kNodeShowBufferStatus:
+      return "kNodeShowBufferStatus";
+    case kNodeSetVariable:
+      return "kNodeSetVariable";
     default:
       return "error type";
   }
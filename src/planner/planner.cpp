@@ -39,6 +39,10 @@ AbstractPlanNodeRef Planner::PlanSelect(std::shared_ptr<SelectStatement> stateme
   vector<IndexInfo *> available_index;
   context_->GetCatalog()->GetTableIndexes(statement->table_name_, indexes);
   for (auto index : indexes) {
+    // bloom 索引只能帮顺序扫描跳过页面，不能用来查找记录
+    if (index->GetIndexType() == "bloom") {
+      continue;
+    }
     if (index->GetIndexKeySchema()->GetColumns().size() == 1) {
       auto col_id = index->GetIndexKeySchema()->GetColumn(0)->GetTableInd();
       if (std::find(statement->column_in_condition_.begin(), statement->column_in_condition_.end(), col_id) !=
@@ -50,9 +54,28 @@ AbstractPlanNodeRef Planner::PlanSelect(std::shared_ptr<SelectStatement> stateme
   if (available_index.empty() || statement->has_or) {
     return make_shared<SeqScanPlanNode>(out_schema, statement->table_name_, statement->where_);
   }
+  // 叶子中的键和 INCLUDE 列包含了输出和条件用到的所有列时，只扫描索引就能得到结果
+  IndexInfo *covering_index = nullptr;
+  for (auto index : available_index) {
+    if (index->GetIndexType() != "bptree") {
+      continue;
+    }
+    const auto &entry_map = index->GetEntryMapping();
+    auto covered = [&](uint32_t col_id) {
+      return std::find(entry_map.begin(), entry_map.end(), col_id) != entry_map.end();
+    };
+    bool covers = std::all_of(statement->column_in_condition_.begin(), statement->column_in_condition_.end(), covered);
+    for (auto column : out_schema->GetColumns()) {
+      covers = covers && covered(column->GetTableInd());
+    }
+    if (covers) {
+      covering_index = index;
+      break;
+    }
+  }
   return make_shared<IndexScanPlanNode>(out_schema, statement->table_name_, available_index,
                                         available_index.size() != statement->column_in_condition_.size(),
-                                        statement->where_);
+                                        statement->where_, covering_index);
 }
 
 AbstractPlanNodeRef Planner::PlanInsert(std::shared_ptr<InsertStatement> statement) {
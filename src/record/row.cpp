@@ -1,12 +1,16 @@
 #include "record/row.h"
 
+#include "record/row_codec.h"
+
 /**
  * TODO: Student Implement
  */
-uint32_t Row::SerializeTo(char *buf, Schema *schema) const {
+uint32_t Row::SerializeTo(char *buf, Schema *schema, RowFormat format) const {
   ASSERT(schema != nullptr, "Invalid schema before serialize.");
   ASSERT(schema->GetColumnCount() == fields_.size(), "Fields size do not match schema's column size.");
-  // replace with your code here
+  if (format == RowFormat::kV2) {
+    return schema->GetCodec()->serialize_to_(*this, *schema, buf);
+  }
   uint32_t tot = 0;
   uint32_t field_count = fields_.size();
   memcpy(buf + tot, &field_count, sizeof(uint32_t));
@@ -34,29 +38,30 @@ uint32_t Row::DeserializeFrom(char *buf, Schema *schema) {
   uint32_t tot = 0;
   uint32_t field_count;
   memcpy(&field_count, buf + tot, sizeof(uint32_t));
+  if (field_count & FORMAT_V2_MASK) {
+    return schema->GetCodec()->deserialize_from_(this, *schema, buf);
+  }
   tot += sizeof(uint32_t);
 
+  // 只读取位图，buf 可能指向只加了读锁的页面
   char *bitmap = buf + tot;
   uint32_t bitmap_size = (field_count + 7) / 8;
-  memset(bitmap, 0, bitmap_size);
   tot += bitmap_size;
   fields_.clear();
   fields_.resize(field_count);
   for (uint32_t i = 0; i < field_count; ++i) {
-    if (bitmap[i / 8] & (1 << (i % 8))) {
-      tot+=Field::DeserializeFrom(buf + tot, schema->GetColumn(i)->GetType(), &fields_[i],true);
-    }
-    else{
-      tot+=Field::DeserializeFrom(buf + tot, schema->GetColumn(i)->GetType(), &fields_[i],false);
-    }
+    bool is_null = bitmap[i / 8] & (1 << (i % 8));
+    tot += RowCodec::DeserializeField(buf + tot, schema->GetColumn(i)->GetType(), &fields_[i], is_null, arena_);
   }
   return tot;
 }
 
-uint32_t Row::GetSerializedSize(Schema *schema) const {
+uint32_t Row::GetSerializedSize(Schema *schema, RowFormat format) const {
   ASSERT(schema != nullptr, "Invalid schema before serialize.");
   ASSERT(schema->GetColumnCount() == fields_.size(), "Fields size do not match schema's column size.");
-  // replace with your code here
+  if (format == RowFormat::kV2) {
+    return schema->GetCodec()->get_serialized_size_(*this, *schema);
+  }
   uint32_t tot = 0;
   tot+= sizeof(uint32_t);
   tot+= (fields_.size() + 7) / 8;
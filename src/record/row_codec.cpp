@@ -0,0 +1,173 @@
+#include "record/row_codec.h"
+
+/**
+ * Codec kernels, one instantiation per RowLayoutKind. Layout branches are resolved at compile time: an all-fixed
+ * schema never looks at the offset array, a schema without nullable columns only looks at the null bitmap once.
+ */
+template <RowLayoutKind kind>
+struct RowCodecKernel {
+  static constexpr bool kHasVarLength = kind != RowLayoutKind::kAllFixed;
+  static constexpr bool kNullable = kind == RowLayoutKind::kNullable;
+
+  using NullableKernel = RowCodecKernel<RowLayoutKind::kNullable>;
+
+  static uint32_t GetSerializedSize(const Row &row, const Schema &schema) {
+    uint32_t size = schema.GetFixedRowSize();
+    if constexpr (kHasVarLength) {
+      for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+        if (schema.IsFixedLength(i)) {
+          continue;
+        }
+        const Field *field = row.GetField(i);
+        if (field->IsNull()) {
+          if constexpr (!kNullable) {
+            return NullableKernel::GetSerializedSize(row, schema);
+          }
+          continue;
+        }
+        size += RowCodec::GetVarLengthSize(*field);
+      }
+    }
+    // 全定长的行大小固定，null 字段也占位
+    return size;
+  }
+
+  static uint32_t SerializeTo(const Row &row, const Schema &schema, char *buf) {
+    uint32_t field_count = schema.GetColumnCount();
+    uint32_t bitmap_size = (field_count + 7) / 8;
+    MACH_WRITE_UINT32(buf, field_count | Row::FORMAT_V2_MASK);
+    char *bitmap = buf + sizeof(uint32_t);
+    memset(bitmap, 0, bitmap_size);
+    char *fixed_area = bitmap + bitmap_size;
+    char *var_offsets = fixed_area + schema.GetFixedAreaSize();
+    uint32_t tot = schema.GetFixedRowSize();
+    for (uint32_t i = 0; i < field_count; i++) {
+      const Field *field = row.GetField(i);
+      if (field->IsNull()) {
+        if constexpr (!kNullable) {
+          return NullableKernel::SerializeTo(row, schema, buf);
+        }
+        bitmap[i / 8] |= (1 << (i % 8));
+      }
+      if (!kHasVarLength || schema.IsFixedLength(i)) {
+        RowCodec::SerializeFixed(*field, fixed_area + schema.GetLayoutSlot(i));
+        continue;
+      }
+      MACH_WRITE_UINT32(var_offsets + schema.GetLayoutSlot(i) * sizeof(uint32_t), tot);
+      if (!kNullable || !field->IsNull()) {
+        tot += RowCodec::SerializeVarLength(*field, buf + tot);
+      }
+    }
+    return tot;
+  }
+
+  static uint32_t DeserializeFrom(Row *row, const Schema &schema, const char *buf) {
+    uint32_t field_count = MACH_READ_UINT32(buf) & ~Row::FORMAT_V2_MASK;
+    uint32_t bitmap_size = (field_count + 7) / 8;
+    const char *bitmap = buf + sizeof(uint32_t);
+    if constexpr (!kNullable) {
+      for (uint32_t i = 0; i < bitmap_size; i++) {
+        if (bitmap[i] != 0) {
+          return NullableKernel::DeserializeFrom(row, schema, buf);
+        }
+      }
+    }
+    const char *fixed_area = bitmap + bitmap_size;
+    const char *var_offsets = fixed_area + schema.GetFixedAreaSize();
+    uint32_t tot = schema.GetFixedRowSize();
+    auto &fields = row->GetFields();
+    fields.resize(field_count);
+    for (uint32_t i = 0; i < field_count; i++) {
+      bool is_null = kNullable && (bitmap[i / 8] & (1 << (i % 8)));
+      TypeId type = schema.GetColumn(i)->GetType();
+      uint32_t slot = schema.GetLayoutSlot(i);
+      if (!kHasVarLength || schema.IsFixedLength(i)) {
+        RowCodec::DeserializeField(fixed_area + slot, type, &fields[i], is_null, row->GetArena());
+      } else {
+        tot += RowCodec::DeserializeField(buf + MACH_READ_UINT32(var_offsets + slot * sizeof(uint32_t)), type,
+                                          &fields[i], is_null, row->GetArena());
+      }
+    }
+    return tot;
+  }
+};
+
+template <RowLayoutKind kind>
+static constexpr RowCodec MakeCodec() {
+  return {kind, RowCodecKernel<kind>::GetSerializedSize, RowCodecKernel<kind>::SerializeTo,
+          RowCodecKernel<kind>::DeserializeFrom};
+}
+
+static constexpr RowCodec codecs[] = {MakeCodec<RowLayoutKind::kAllFixed>(),
+                                      MakeCodec<RowLayoutKind::kFixedVarchar>(),
+                                      MakeCodec<RowLayoutKind::kNullable>()};
+
+const RowCodec *RowCodec::Get(RowLayoutKind kind) { return &codecs[static_cast<int>(kind)]; }
+
+void RowCodec::SerializeFixed(const Field &field, char *buf) {
+  if (field.IsNull()) {
+    memset(buf, 0, sizeof(int32_t));
+  } else if (field.type_id_ == TypeId::kTypeInt) {
+    MACH_WRITE_INT32(buf, field.value_.integer_);
+  } else {
+    MACH_WRITE_TO(float, buf, field.value_.float_);
+  }
+}
+
+uint32_t RowCodec::SerializeVarLength(const Field &field, char *buf) {
+  if (field.IsExternal()) {
+    MACH_WRITE_UINT32(buf, field.len_ | TypeChar::EXTERNAL_MASK);
+    MACH_WRITE_TO(page_id_t, buf + sizeof(uint32_t), field.overflow_page_id_);
+    return sizeof(uint32_t) + sizeof(page_id_t);
+  }
+  MACH_WRITE_UINT32(buf, field.len_);
+  memcpy(buf + sizeof(uint32_t), field.value_.chars_, field.len_);
+  return sizeof(uint32_t) + field.len_;
+}
+
+uint32_t RowCodec::GetVarLengthSize(const Field &field) {
+  return sizeof(uint32_t) + (field.IsExternal() ? sizeof(page_id_t) : field.len_);
+}
+
+template <typename... Args>
+static Field *NewField(MemoryArena *arena, Args &&... args) {
+  if (arena != nullptr) {
+    return arena->New<Field>(std::forward<Args>(args)...);
+  }
+  return new Field(std::forward<Args>(args)...);
+}
+
+uint32_t RowCodec::DeserializeField(const char *buf, TypeId type, Field **field, bool is_null, MemoryArena *arena) {
+  if (is_null) {
+    *field = NewField(arena, type);
+    return 0;
+  }
+  switch (type) {
+    case TypeId::kTypeInt:
+      *field = NewField(arena, type, MACH_READ_INT32(buf));
+      return sizeof(int32_t);
+    case TypeId::kTypeFloat:
+      *field = NewField(arena, type, MACH_READ_FROM(float, buf));
+      return sizeof(float);
+    case TypeId::kTypeChar: {
+      uint32_t len = MACH_READ_UINT32(buf);
+      if (len & TypeChar::EXTERNAL_MASK) {
+        *field =
+            NewField(arena, type, len & ~TypeChar::EXTERNAL_MASK, MACH_READ_FROM(page_id_t, buf + sizeof(uint32_t)));
+        return sizeof(uint32_t) + sizeof(page_id_t);
+      }
+      if (arena == nullptr) {
+        *field = new Field(type, const_cast<char *>(buf + sizeof(uint32_t)), len, true);
+      } else {
+        // 值也拷进 arena，字段不持有它
+        char *data = static_cast<char *>(arena->Allocate(len, 1));
+        memcpy(data, buf + sizeof(uint32_t), len);
+        *field = arena->New<Field>(type, data, len, false);
+      }
+      return sizeof(uint32_t) + len;
+    }
+    default:
+      ASSERT(false, "Unsupported type.");
+      return 0;
+  }
+}
@@ -0,0 +1,107 @@
+#include "record/row_view.h"
+
+#include "record/row_codec.h"
+
+void RowView::Reset(const char *data, Schema *schema, RowId rid) {
+  data_ = data;
+  schema_ = schema;
+  rid_ = rid;
+  uint32_t header = MACH_READ_UINT32(data);
+  format_ = (header & Row::FORMAT_V2_MASK) ? RowFormat::kV2 : RowFormat::kV1;
+  field_count_ = header & ~Row::FORMAT_V2_MASK;
+  offsets_valid_ = false;
+}
+
+bool RowView::IsNull(uint32_t idx) const {
+  ASSERT(idx < field_count_, "Failed to access field");
+  const char *bitmap = data_ + sizeof(uint32_t);
+  return bitmap[idx / 8] & (1 << (idx % 8));
+}
+
+bool RowView::IsExternal(uint32_t idx) const {
+  if (schema_->GetColumn(idx)->GetType() != TypeId::kTypeChar || IsNull(idx)) {
+    return false;
+  }
+  return MACH_READ_UINT32(data_ + GetFieldOffset(idx)) & TypeChar::EXTERNAL_MASK;
+}
+
+Field RowView::GetField(uint32_t idx) const {
+  TypeId type = schema_->GetColumn(idx)->GetType();
+  if (IsNull(idx)) {
+    return Field(type);
+  }
+  const char *buf = data_ + GetFieldOffset(idx);
+  switch (type) {
+    case TypeId::kTypeInt:
+      return Field(type, MACH_READ_INT32(buf));
+    case TypeId::kTypeFloat:
+      return Field(type, MACH_READ_FROM(float, buf));
+    case TypeId::kTypeChar: {
+      uint32_t len = MACH_READ_UINT32(buf);
+      if (len & TypeChar::EXTERNAL_MASK) {
+        return Field(type, len & ~TypeChar::EXTERNAL_MASK, MACH_READ_FROM(page_id_t, buf + sizeof(uint32_t)));
+      }
+      // 不拷贝，直接借用页面中的字节
+      return Field(type, const_cast<char *>(buf + sizeof(uint32_t)), len, false);
+    }
+    default:
+      ASSERT(false, "Unsupported type.");
+      return Field(type);
+  }
+}
+
+void RowView::Materialize(Row *row) const {
+  std::vector<uint32_t> columns(field_count_);
+  for (uint32_t i = 0; i < field_count_; i++) {
+    columns[i] = i;
+  }
+  Materialize(row, columns);
+}
+
+void RowView::Materialize(Row *row, const std::vector<uint32_t> &columns) const {
+  row->destroy();
+  row->SetRowId(rid_);
+  auto &fields = row->GetFields();
+  fields.reserve(columns.size());
+  for (auto idx : columns) {
+    Field *field = nullptr;
+    // Deserialize copies the value into the arena of the row, the row owns its fields
+    RowCodec::DeserializeField(data_ + GetFieldOffset(idx), schema_->GetColumn(idx)->GetType(), &field, IsNull(idx),
+                               row->GetArena());
+    fields.push_back(field);
+  }
+}
+
+uint32_t RowView::GetFieldOffset(uint32_t idx) const {
+  if (format_ == RowFormat::kV1) {
+    ComputeOffsets();
+    return offsets_[idx];
+  }
+  uint32_t fixed_area = sizeof(uint32_t) + (field_count_ + 7) / 8;
+  if (schema_->IsFixedLength(idx)) {
+    return fixed_area + schema_->GetLayoutSlot(idx);
+  }
+  uint32_t var_offsets = fixed_area + schema_->GetFixedAreaSize();
+  return MACH_READ_UINT32(data_ + var_offsets + schema_->GetLayoutSlot(idx) * sizeof(uint32_t));
+}
+
+void RowView::ComputeOffsets() const {
+  if (offsets_valid_) {
+    return;
+  }
+  offsets_.resize(field_count_);
+  uint32_t offset = sizeof(uint32_t) + (field_count_ + 7) / 8;
+  for (uint32_t i = 0; i < field_count_; i++) {
+    offsets_[i] = offset;
+    if (IsNull(i)) {
+      continue;
+    }
+    if (schema_->GetColumn(i)->GetType() != TypeId::kTypeChar) {
+      offset += Type::GetTypeSize(schema_->GetColumn(i)->GetType());
+      continue;
+    }
+    uint32_t len = MACH_READ_UINT32(data_ + offset);
+    offset += sizeof(uint32_t) + ((len & TypeChar::EXTERNAL_MASK) ? sizeof(page_id_t) : len);
+  }
+  offsets_valid_ = true;
+}
@@ -1,5 +1,29 @@
 #include "record/schema.h"
 
+#include "record/row_codec.h"
+
+void Schema::ComputeLayout() {
+  bool nullable = false;
+  layout_slots_.reserve(columns_.size());
+  for (auto column : columns_) {
+    nullable |= column->IsNullable();
+    if (column->GetType() == TypeId::kTypeChar) {
+      layout_slots_.push_back({false, var_length_count_++});
+    } else {
+      layout_slots_.push_back({true, fixed_area_size_});
+      fixed_area_size_ += Type::GetTypeSize(column->GetType());
+    }
+  }
+  fixed_row_size_ =
+      sizeof(uint32_t) + (columns_.size() + 7) / 8 + fixed_area_size_ + var_length_count_ * sizeof(uint32_t);
+  if (nullable) {
+    layout_kind_ = RowLayoutKind::kNullable;
+  } else {
+    layout_kind_ = var_length_count_ == 0 ? RowLayoutKind::kAllFixed : RowLayoutKind::kFixedVarchar;
+  }
+  codec_ = RowCodec::Get(layout_kind_);
+}
+
 /**
  * TODO: Student Implement
  */
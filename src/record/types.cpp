@@ -226,6 +226,14 @@ CmpBool TypeFloat::CompareGreaterThanEquals(const Field &left, const Field &righ
 
 // ==============================TypeChar=============================
 uint32_t TypeChar::SerializeTo(const Field &field, char *buf) const {
+  if (field.IsExternal()) {
+    // 行内只保留长度（带 EXTERNAL 标记）和第一个溢出页的页号
+    uint32_t len = GetLength(field) | EXTERNAL_MASK;
+    page_id_t page_id = field.GetOverflowPageId();
+    memcpy(buf, &len, sizeof(uint32_t));
+    memcpy(buf + sizeof(uint32_t), &page_id, sizeof(page_id_t));
+    return sizeof(uint32_t) + sizeof(page_id_t);
+  }
   if (!field.IsNull()) {
     uint32_t len = GetLength(field);
     memcpy(buf, &len, sizeof(uint32_t));
@@ -241,6 +249,10 @@ uint32_t TypeChar::DeserializeFrom(char *storage, Field **field, bool is_null) c
     return 0;
   }
   uint32_t len = MACH_READ_UINT32(storage);
+  if (len & EXTERNAL_MASK) {
+    *field = new Field(TypeId::kTypeChar, len & ~EXTERNAL_MASK, MACH_READ_FROM(page_id_t, storage + sizeof(uint32_t)));
+    return sizeof(uint32_t) + sizeof(page_id_t);
+  }
   *field = new Field(TypeId::kTypeChar, storage + sizeof(uint32_t), len, true);
   return len + sizeof(uint32_t);
 }
@@ -249,6 +261,9 @@ uint32_t TypeChar::GetSerializedSize(const Field &field, bool is_null) const {
   if (is_null) {
     return 0;
   }
+  if (field.IsExternal()) {
+    return sizeof(uint32_t) + sizeof(page_id_t);
+  }
   uint32_t len = GetLength(field);
   return len + sizeof(uint32_t);
 }
@@ -2,13 +2,35 @@
 
 #include <sys/stat.h>
 
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
 #include <stdexcept>
+#include <type_traits>
 
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
 
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+/**
+ * BitmapPage is instantiated for every supported page size, pick the one matching the file so that the bit
+ * operations still work on a compile-time page size.
+ */
+template <typename Func>
+static auto VisitBitmapPage(uint32_t page_size, char *data, Func &&func) {
+  switch (page_size) {
+    case 8192:
+      return func(reinterpret_cast<BitmapPage<8192> *>(data));
+    case 16384:
+      return func(reinterpret_cast<BitmapPage<16384> *>(data));
+    case 32768:
+      return func(reinterpret_cast<BitmapPage<32768> *>(data));
+    default:
+      return func(reinterpret_cast<BitmapPage<PAGE_SIZE> *>(data));
+  }
+}
+
+DiskManager::DiskManager(const std::string &db_file, uint32_t page_size) : file_name_(db_file) {
+  ASSERT(IsValidPageSize(page_size), "Unsupported page size.");
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
   db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
   // directory or file does not exist
@@ -25,12 +47,52 @@ DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
       throw std::exception();
     }
   }
-  ReadPhysicalPage(META_PAGE_ID, meta_data_);
+  LoadMetaPage(page_size);
+}
+
+void DiskManager::LoadMetaPage(uint32_t page_size) {
+  // 元数据页头部总在文件开头，先按最小页大小读出，才能知道整页有多大
+  char header[PAGE_SIZE];
+  page_size_ = PAGE_SIZE;
+  ReadPhysicalPage(META_PAGE_ID, header);
+  auto *header_page = reinterpret_cast<DiskFileMetaPage *>(header);
+  bool legacy = false;
+  if (header_page->IsTagged()) {
+    ASSERT(IsValidPageSize(header_page->GetPageSize()), "Corrupted meta page.");
+    page_size_ = header_page->GetPageSize();
+  } else if (GetFileSize(file_name_) > 0) {
+    // 旧格式的文件没有记录页大小，只可能是 PAGE_SIZE
+    legacy = true;
+  } else {
+    page_size_ = page_size;
+  }
+  bitmap_size_ = VisitBitmapPage(page_size_, nullptr, [](auto *bitmap) {
+    return std::remove_pointer_t<decltype(bitmap)>::GetMaxSupportedSize();
+  });
+  uint64_t max_pages = static_cast<uint64_t>(DiskFileMetaPage::GetMaxExtentNums(page_size_)) * bitmap_size_;
+  max_valid_page_id_ = static_cast<page_id_t>(std::min<uint64_t>(max_pages, INT32_MAX));
+
+  meta_data_.reset(new char[page_size_]());
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_.get());
+  if (header_page->IsTagged()) {
+    ReadPhysicalPage(META_PAGE_ID, meta_data_.get());
+    return;
+  }
+  meta_page->magic_ = DiskFileMetaPage::MAGIC;
+  meta_page->page_size_ = page_size_;
+  if (legacy) {
+    auto *legacy_fields = reinterpret_cast<uint32_t *>(header);
+    meta_page->num_allocated_pages_ = legacy_fields[0];
+    meta_page->num_extents_ = legacy_fields[1];
+    ASSERT(meta_page->num_extents_ <= DiskFileMetaPage::GetMaxExtentNums(page_size_), "Legacy file too large.");
+    memcpy(meta_page->extent_used_page_, header + DiskFileMetaPage::SIZE_LEGACY_HEADER,
+           meta_page->num_extents_ * sizeof(uint32_t));
+  }
 }
 
 void DiskManager::Close() {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-  WritePhysicalPage(META_PAGE_ID, meta_data_);
+  WritePhysicalPage(META_PAGE_ID, meta_data_.get());
   if (!closed) {
     db_io_.close();
     closed = true;
@@ -52,11 +114,11 @@ void DiskManager::WritePage(page_id_t logical_page_id, const char *page_data) {
  */
 page_id_t DiskManager::AllocatePage() {
   // 获取元数据页指针，将元数据区域转换为 DiskFileMetaPage 类型
-  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_.get());
   
   // 检查已分配的页面数量是否达到最大有效页面 ID
   // 如果达到最大有效页面 ID，则无法再分配新页面，返回无效页面 ID
-  if (meta_page->GetAllocatedPages() >= MAX_VALID_PAGE_ID) return INVALID_PAGE_ID;
+  if (meta_page->GetAllocatedPages() >= static_cast<uint32_t>(max_valid_page_id_)) return INVALID_PAGE_ID;
 
   // 查找可分配页面的扩展区（extent）
   // 获取当前元数据页中扩展区的数量
@@ -65,7 +127,7 @@ page_id_t DiskManager::AllocatePage() {
   for(extent_index = 0 ; extent_index < extent_num ; extent_index++){
     // 检查当前扩展区是否还有可用页面
     // 如果扩展区内已使用的页面数小于位图大小，说明该扩展区还有可用页面，跳出循环
-    if(meta_page->extent_used_page_[extent_index]<BITMAP_SIZE)
+    if(meta_page->extent_used_page_[extent_index]<bitmap_size_)
       break;
   }
 
@@ -76,20 +138,18 @@ page_id_t DiskManager::AllocatePage() {
   }
 
   // 计算要操作的物理页号
-  // 每个扩展区内有 BITMAP_SIZE 个数据页和一个位图页，再加上元数据页就是物理页
-  uint32_t physical_pageID = extent_index * (BITMAP_SIZE + 1) + 1;
+  // 每个扩展区内有 bitmap_size_ 个数据页和一个位图页，再加上元数据页就是物理页
+  uint32_t physical_pageID = extent_index * (bitmap_size_ + 1) + 1;
   // 定义一个字符数组用于存储从物理页读取的数据
-  char str[PAGE_SIZE]={'\0'};
+  char str[MAX_PAGE_SIZE];
   // 从物理页读取数据到字符数组中
   ReadPhysicalPage(physical_pageID, str);
 
   // 处理位图页
-  // 将读取的数据转换为 BitmapPage 类型的指针
-  BitmapPage<PAGE_SIZE> *bit_map = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(str);
   // 用于存储在当前位图页中分配的页面偏移量
   uint32_t page_offset = 0;
-  // 在位图页中分配一个页面，并获取分配页面的偏移量
-  bit_map->AllocatePage(page_offset);
+  // 按文件的页大小解释位图页，在其中分配一个页面，并获取分配页面的偏移量
+  VisitBitmapPage(page_size_, str, [&](auto *bit_map) { return bit_map->AllocatePage(page_offset); });
   // 将更新后的位图页数据写回到物理页
   WritePhysicalPage(physical_pageID, str);
   
@@ -105,7 +165,7 @@ page_id_t DiskManager::AllocatePage() {
   else {
     meta_page->num_extents_ = extent_num;
   }
-  return  extent_index * BITMAP_SIZE + page_offset;
+  return  extent_index * bitmap_size_ + page_offset;
 }
 
 /**
@@ -113,37 +173,35 @@ page_id_t DiskManager::AllocatePage() {
  */
 void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
   // 获取元数据页指针，将元数据区域转换为 DiskFileMetaPage 类型，以便后续操作元数据
-  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_.get());
   
   // 计算对应的物理页面 ID
   // 这里的计算逻辑是根据逻辑页面 ID 来确定其在物理存储中的位置，通过一些计算得到物理页面 ID
-  // 具体是逻辑页面 ID 加上 1 再加上逻辑页面 ID 除以 BITMAP_SIZE 减去逻辑页面 ID 对 BITMAP_SIZE 取模的结果
-  uint32_t physical_pageID = logical_page_id + 1 + logical_page_id / BITMAP_SIZE - logical_page_id % BITMAP_SIZE;
-  // 定义一个字符数组 str，大小为 PAGE_SIZE，用于存储从物理页读取的数据，初始化为全 0
-  char str[PAGE_SIZE]={'\0'};
+  // 具体是逻辑页面 ID 加上 1 再加上逻辑页面 ID 除以 bitmap_size_ 减去逻辑页面 ID 对 bitmap_size_ 取模的结果
+  uint32_t physical_pageID = logical_page_id + 1 + logical_page_id / bitmap_size_ - logical_page_id % bitmap_size_;
+  // 定义一个字符数组 str，用于存储从物理页读取的数据，按最大页大小分配
+  char str[MAX_PAGE_SIZE];
   // 从计算得到的物理页面 ID 对应的物理页中读取数据到字符数组 str 中
   ReadPhysicalPage(physical_pageID, str);
 
   // 处理位图页
-  // 将读取到的数据（字符数组 str）转换为 BitmapPage 类型的指针 bit_map，以便操作位图页
-  BitmapPage<PAGE_SIZE>* bit_map = reinterpret_cast<BitmapPage<PAGE_SIZE>*>(str);
   // 计算在当前位图页中的页面偏移量
-  // 这里是通过逻辑页面 ID 对 BITMAP_SIZE 取模来确定在当前位图页中的偏移位置
-  uint32_t page_offset = logical_page_id % BITMAP_SIZE;
+  // 这里是通过逻辑页面 ID 对 bitmap_size_ 取模来确定在当前位图页中的偏移位置
+  uint32_t page_offset = logical_page_id % bitmap_size_;
 
   // 调用 BitmapPage 类的 DeAllocatePage 函数，传入计算得到的页面偏移量 page_offset，用于释放页面
-  bit_map->DeAllocatePage(page_offset);
+  VisitBitmapPage(page_size_, str, [&](auto *bit_map) { return bit_map->DeAllocatePage(page_offset); });
 
   // 将更新后的位图页数据（存储在字符数组 str 中）写回到计算得到的物理页面
   // 这里写回的物理页面 ID 与之前读取数据的物理页面 ID 相同
-  WritePhysicalPage(logical_page_id + 1 + logical_page_id / BITMAP_SIZE - logical_page_id % BITMAP_SIZE, str);
+  WritePhysicalPage(logical_page_id + 1 + logical_page_id / bitmap_size_ - logical_page_id % bitmap_size_, str);
 
   // 更新元数据页中已分配页面的数量，将其减 1，表示释放了一个页面
   meta_page->num_allocated_pages_--;
 
   // 更新元数据页中对应扩展区已使用页面的数量
-  // 通过逻辑页面 ID 除以 BITMAP_SIZE 确定所属扩展区，然后将该扩展区已使用页面数量减 1
-  meta_page->extent_used_page_[logical_page_id / BITMAP_SIZE]--;
+  // 通过逻辑页面 ID 除以 bitmap_size_ 确定所属扩展区，然后将该扩展区已使用页面数量减 1
+  meta_page->extent_used_page_[logical_page_id / bitmap_size_]--;
 }
 
 /**
@@ -151,73 +209,94 @@ void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
  */
 bool DiskManager::IsPageFree(page_id_t logical_page_id) {
 // 检查逻辑页面 ID 是否大于最大有效页面 ID
-if (logical_page_id > MAX_VALID_PAGE_ID) {
+if (logical_page_id > max_valid_page_id_) {
   // 如果大于最大有效页面 ID，直接返回 false，表明该页面相关操作无法正常进行
   return false;
 }
 
-// 定义一个字符数组 str，用于存储从物理页读取的数据，其大小为 PAGE_SIZE，初始化为全 0
-char str[PAGE_SIZE] = {'\0'};
+// 定义一个字符数组 str，用于存储从物理页读取的数据，按最大页大小分配
+char str[MAX_PAGE_SIZE];
 
-// 计算逻辑页面 ID 相关的物理页面 ID，具体计算方式为逻辑页面 ID 加上 1 加上逻辑页面 ID 除以 BITMAP_SIZE 减去逻辑页面 ID 对 BITMAP_SIZE 取模的结果
+// 计算逻辑页面 ID 相关的物理页面 ID，具体计算方式为逻辑页面 ID 加上 1 加上逻辑页面 ID 除以 bitmap_size_ 减去逻辑页面 ID 对 bitmap_size_ 取模的结果
 // 这里的计算是为了确定逻辑页面在物理存储中的对应位置
-uint32_t physical_pageID = logical_page_id + 1 + logical_page_id / BITMAP_SIZE - logical_page_id % BITMAP_SIZE;
+uint32_t physical_pageID = logical_page_id + 1 + logical_page_id / bitmap_size_ - logical_page_id % bitmap_size_;
 
 // 从计算得到的物理页面 ID 对应的物理页中读取数据到字符数组 str 中
 // 假设 ReadPhysicalPage 函数用于从指定物理页读取数据到传入的字符数组中
 ReadPhysicalPage(physical_pageID, str);
 
 // 处理位图页
-// 将读取到数据的字符数组 str 转换为 BitmapPage 类型的指针 bit_map
-// 这样转换是为了能够使用 BitmapPage 类中的相关方法来处理位图页数据
-BitmapPage<PAGE_SIZE>* bit_map = reinterpret_cast<BitmapPage<PAGE_SIZE>*>(str);
-
-// 调用 BitmapPage 类的 IsPageFree 方法，传入逻辑页面 ID 对 BITMAP_SIZE 取模的结果
+// 按文件的页大小解释位图页，调用 BitmapPage 类的 IsPageFree 方法，传入逻辑页面 ID 对 bitmap_size_ 取模的结果
 // 该方法用于判断对应位置的页面是否空闲，并返回判断结果
-return bit_map->IsPageFree(logical_page_id % BITMAP_SIZE);
+uint32_t page_offset = logical_page_id % bitmap_size_;
+return VisitBitmapPage(page_size_, str, [&](auto *bit_map) { return bit_map->IsPageFree(page_offset); });
 }
 
 /**
  * TODO: Student Implement
  */
 page_id_t DiskManager::MapPageId(page_id_t logical_page_id) {
-  return logical_page_id + 1 + logical_page_id / BITMAP_SIZE + 1;
+  return logical_page_id + 1 + logical_page_id / bitmap_size_ + 1;
 }
 
-int DiskManager::GetFileSize(const std::string &file_name) {
+int64_t DiskManager::GetFileSize(const std::string &file_name) {
   struct stat stat_buf;
   int rc = stat(file_name.c_str(), &stat_buf);
   return rc == 0 ? stat_buf.st_size : -1;
 }
 
+DiskIOStats DiskManager::GetIOStats() const {
+  DiskIOStats stats;
+  stats.pages_read_ = pages_read_.load(std::memory_order_relaxed);
+  stats.pages_written_ = pages_written_.load(std::memory_order_relaxed);
+  stats.bytes_read_ = bytes_read_.load(std::memory_order_relaxed);
+  stats.bytes_written_ = bytes_written_.load(std::memory_order_relaxed);
+  stats.io_wait_ns_ = io_wait_ns_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void DiskManager::ResetIOStats() {
+  pages_read_.store(0, std::memory_order_relaxed);
+  pages_written_.store(0, std::memory_order_relaxed);
+  bytes_read_.store(0, std::memory_order_relaxed);
+  bytes_written_.store(0, std::memory_order_relaxed);
+  io_wait_ns_.store(0, std::memory_order_relaxed);
+}
+
 void DiskManager::ReadPhysicalPage(page_id_t physical_pageID, char *page_data) {
-  int offset = physical_pageID * PAGE_SIZE;
+  auto start = std::chrono::steady_clock::now();
+  size_t offset = static_cast<size_t>(physical_pageID) * page_size_;
   // check if read beyond file length
-  if (offset >= GetFileSize(file_name_)) {
+  if (static_cast<int64_t>(offset) >= GetFileSize(file_name_)) {
 #ifdef ENABLE_BPM_DEBUG
     LOG(INFO) << "Read less than a page" << std::endl;
 #endif
-    memset(page_data, 0, PAGE_SIZE);
+    memset(page_data, 0, page_size_);
   } else {
     // set read cursor to offset
     db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
+    db_io_.read(page_data, page_size_);
+    // if file ends before reading a whole page
     int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
+    if (read_count < static_cast<int>(page_size_)) {
 #ifdef ENABLE_BPM_DEBUG
       LOG(INFO) << "Read less than a page" << std::endl;
 #endif
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+      memset(page_data + read_count, 0, page_size_ - read_count);
     }
+    pages_read_.fetch_add(1, std::memory_order_relaxed);
+    bytes_read_.fetch_add(read_count, std::memory_order_relaxed);
   }
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  io_wait_ns_.fetch_add(elapsed.count(), std::memory_order_relaxed);
 }
 
 void DiskManager::WritePhysicalPage(page_id_t physical_pageID, const char *page_data) {
-  size_t offset = static_cast<size_t>(physical_pageID) * PAGE_SIZE;
+  auto start = std::chrono::steady_clock::now();
+  size_t offset = static_cast<size_t>(physical_pageID) * page_size_;
   // set write cursor to offset
   db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
+  db_io_.write(page_data, page_size_);
   // check for I/O error
   if (db_io_.bad()) {
     LOG(ERROR) << "I/O error while writing";
@@ -225,4 +304,8 @@ void DiskManager::WritePhysicalPage(page_id_t physical_pageID, const char *page_
   }
   // needs to flush to keep disk file in sync
   db_io_.flush();
+  pages_written_.fetch_add(1, std::memory_order_relaxed);
+  bytes_written_.fetch_add(page_size_, std::memory_order_relaxed);
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  io_wait_ns_.fetch_add(elapsed.count(), std::memory_order_relaxed);
 }
\ No newline at end of file
@@ -1,135 +1,429 @@
 #include "storage/table_heap.h"
 
+#include <limits>
+#include <memory>
+
 /**
  * TODO: Student Implement
  */
 bool TableHeap::InsertTuple(Row &row, Txn *txn) {
-  uint32_t  tuple_size = row.GetSerializedSize(schema_);
-  if (tuple_size > PAGE_SIZE) {
-    return false; 
+  Row stored;
+  if (!PrepareStoredRow(row, nullptr, &stored)) {
+    return false;
   }
-  // Step1: Find the page which can insert the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
-  // If the page could not be found, then abort the recovery.
-  if (page == nullptr) {
+  if (!InsertTupleImpl(stored, txn, INVALID_PAGE_ID, false)) {
+    FreeOverflowValues(stored, nullptr);
     return false;
   }
-  // Step2: Insert the tuple into the page.
-  page->WLatch();
-  bool result = page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
-  page->WUnlatch();
-  // Step3: If the page is full, then create a new page and link it to the old page.
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
-  while (!result) {
-    page_id_t new_page_id=page->GetNextPageId();
-    if (new_page_id != INVALID_PAGE_ID) {
-      page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(new_page_id));
-      page->WLatch();
-      result = page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
-      page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
-    } else {
-      page_id_t new_page_id_;
-      buffer_pool_manager_->NewPage(new_page_id_);
-      auto new_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(new_page_id_));
-      new_page->WLatch();
-      new_page->Init(new_page_id_, page->GetPageId(),log_manager_,txn);
-      page->WLatch();
-      page->SetNextPageId(new_page_id_);
-      page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
-      result = new_page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
-      new_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(new_page->GetPageId(), true);
-      break;
+  row.SetRowId(stored.GetRowId());
+  return true;
+}
+
+bool TableHeap::InsertTupleImpl(Row &row, Txn *txn, page_id_t skip_page_id, bool moved_in) {
+  uint32_t tuple_size = row.GetSerializedSize(schema_, RowFormat::kV2);
+  if (tuple_size > TablePage::MaxRowSize(buffer_pool_manager_->GetPageSize())) {
+    return false;
+  }
+  auto try_insert = [&](WritePageGuard &guard) {
+    auto page = guard.As<TablePage>();
+    bool inserted =
+        guard.PageId() != skip_page_id && page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+    if (inserted) {
+      if (moved_in) {
+        page->MarkMovedIn(row.GetRowId());
+      } else {
+        WidenZoneMap(guard.PageId(), row);
+      }
+      guard.SetDirty();
+    }
+    UpdateFreeSpaceHint(guard.PageId(), page);
+    return inserted;
+  };
+  // A relocated row first tries the page the free space hints point to.
+  if (moved_in) {
+    page_id_t hint_page_id = FindPageWithSpace(TablePage::InsertSpace(tuple_size), skip_page_id);
+    if (hint_page_id != INVALID_PAGE_ID) {
+      WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(hint_page_id);
+      if (guard.IsValid() && try_insert(guard)) {
+        return true;
+      }
     }
   }
-  if (result) {
-    // Step4: If the tuple is inserted successfully, then return true.
-    return true;
-  } else {
-    // Step5: If the tuple is not inserted successfully, then return false.
-    return false;
+  // Step1: Go straight to the last page, the page directory knows it without walking the chain.
+  page_id_t page_id = page_directory_.GetLastPageId();
+  bool tried_hint = moved_in;
+  while (true) {
+    WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(page_id);
+    // If the page could not be found, then abort the recovery.
+    if (!guard.IsValid()) {
+      return false;
+    }
+    // Step2: Insert the tuple into the page.
+    if (try_insert(guard)) {
+      return true;
+    }
+    page_id_t next_page_id = guard.As<TablePage>()->GetNextPageId();
+    if (next_page_id != INVALID_PAGE_ID) {
+      // 另一个插入刚在它后面链上了新页面
+      page_id = next_page_id;
+      continue;
+    }
+    // Step3: The last page is full, reuse the room deletes left in an older page before growing the heap.
+    if (!tried_hint) {
+      tried_hint = true;
+      guard.Drop();
+      page_id_t hint_page_id = FindPageWithSpace(TablePage::InsertSpace(tuple_size), page_id);
+      if (hint_page_id != INVALID_PAGE_ID) {
+        WritePageGuard hint_guard = buffer_pool_manager_->FetchPageWrite(hint_page_id);
+        if (hint_guard.IsValid() && try_insert(hint_guard)) {
+          return true;
+        }
+      }
+      page_id = page_directory_.GetLastPageId();
+      continue;
+    }
+    // Step4: Create a new page and link it after the last one.
+    page_id_t new_page_id;
+    WritePageGuard new_guard = buffer_pool_manager_->NewPageGuarded(new_page_id).UpgradeWrite();
+    if (!new_guard.IsValid()) {
+      return false;
+    }
+    auto new_page = new_guard.AsMut<TablePage>();
+    new_page->Init(new_page_id, guard.PageId(), log_manager_, txn);
+    {
+      std::lock_guard<std::mutex> lock(zone_map_latch_);
+      zone_maps_.insert_or_assign(new_page_id, ZoneMap(schema_, true));
+    }
+    guard.AsMut<TablePage>()->SetNextPageId(new_page_id);
+    // 持有旧的尾页时登记，追加按页链的顺序到达目录
+    page_directory_.Append(guard.PageId(), new_page_id);
+    guard.Drop();
+    return try_insert(new_guard);
   }
 }
 
 bool TableHeap::MarkDelete(const RowId &rid, Txn *txn) {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
   // If the page could not be found, then abort the recovery.
-  if (page == nullptr) {
+  if (!guard.IsValid()) {
     return false;
   }
-  // Otherwise, mark the tuple as deleted.
-  page->WLatch();
-  page->MarkDelete(rid, txn, lock_manager_, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  // Otherwise, mark the tuple (or the forwarding stub of a relocated row) as deleted.
+  guard.AsMut<TablePage>()->MarkDelete(rid, txn, lock_manager_, log_manager_);
   return true;
 }
 
 /**
  * TODO: Student Implement
  */
-bool TableHeap::UpdateTuple(Row &row, const RowId &rid, Txn *txn) { 
+bool TableHeap::UpdateTuple(Row &row, const RowId &rid, Txn *txn) {
+  // 旧值引用的溢出页在更新成功后释放，未变的长值直接沿用
+  Row old_stored(rid);
+  if (!GetStoredTuple(&old_stored, txn)) {
+    return false;
+  }
+  Row stored;
+  if (!PrepareStoredRow(row, &old_stored, &stored)) {
+    return false;
+  }
+  if (!UpdateStoredTuple(stored, rid, txn)) {
+    FreeOverflowValues(stored, &old_stored);
+    return false;
+  }
+  FreeOverflowValues(old_stored, &stored);
+  row.SetRowId(rid);
+  return true;
+}
+
+bool TableHeap::UpdateStoredTuple(Row &row, const RowId &rid, Txn *txn) {
   // Step1: Find the page which contains the tuple.
-  auto old_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  
-  // Step2: Update the tuple in the page.
-  old_page->WLatch();
-  Row old_row = Row(rid);
-  bool result = old_page->UpdateTuple(row, &old_row, schema_, txn, lock_manager_, log_manager_);
-  old_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(old_page->GetPageId(), true);
-  return result;
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  if (!guard.IsValid()) {
+    return false;
+  }
+  auto page = guard.AsMut<TablePage>();
+  if (!page->HasTuple(rid)) {
+    return false;
+  }
+  RowId target;
+  bool forwarded = page->GetForwardRowId(rid, &target);
+  if (!forwarded) {
+    // Step2: Update the tuple in the page.
+    Row old_row = Row(rid);
+    if (page->UpdateTuple(row, &old_row, schema_, txn, lock_manager_, log_manager_)) {
+      UpdateFreeSpaceHint(rid.GetPageId(), page);
+      WidenZoneMap(rid.GetPageId(), row);
+      row.SetRowId(rid);
+      return true;
+    }
+  }
+  // 先放开原页面，下面查找新页面时可能会遍历到它
+  guard.Drop();
+  if (forwarded) {
+    // Step3: The row was relocated before, try to update it where it lives now.
+    WritePageGuard target_guard = buffer_pool_manager_->FetchPageWrite(target.GetPageId());
+    if (!target_guard.IsValid()) {
+      return false;
+    }
+    auto target_page = target_guard.AsMut<TablePage>();
+    Row old_row = Row(target);
+    if (target_page->UpdateTuple(row, &old_row, schema_, txn, lock_manager_, log_manager_)) {
+      UpdateFreeSpaceHint(target.GetPageId(), target_page);
+      // 值写好之后才放宽原页面的 zone map，正在补建它的扫描不会漏掉新值
+      WidenZoneMap(rid.GetPageId(), row);
+      row.SetRowId(rid);
+      return true;
+    }
+  }
+  // Step4: Move the row to a page with enough room and leave a forwarding stub at rid.
+  if (!InsertTupleImpl(row, txn, rid.GetPageId(), true)) {
+    return false;
+  }
+  RowId new_target = row.GetRowId();
+  row.SetRowId(rid);
+  guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  ASSERT(guard.IsValid(), "page not found when relocating a row");
+  page = guard.AsMut<TablePage>();
+  if (!page->SetForwardRowId(rid, new_target)) {
+    // 原页面连转发桩都放不下，撤销搬迁
+    guard.Drop();
+    ApplyDeleteSlot(new_target, txn);
+    return false;
+  }
+  UpdateFreeSpaceHint(rid.GetPageId(), page);
+  WidenZoneMap(rid.GetPageId(), row);
+  guard.Drop();
+  if (forwarded) {
+    // The previous relocated copy is no longer referenced.
+    ApplyDeleteSlot(target, txn);
+  }
+  return true;
 }
 
 /**
  * TODO: Student Implement
  */
 void TableHeap::ApplyDelete(const RowId &rid, Txn *txn) {
-  // Step1: Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  // Step1: Release the overflow pages of the tuple.
+  Row stored(rid);
+  if (GetStoredTuple(&stored, txn, true)) {
+    FreeOverflowValues(stored, nullptr);
+  }
+  // Step2: Find the page which contains the tuple.
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
   // If the page not found, abort the transaction.
-  ASSERT(page!= nullptr,"page not found when delete");
-  // Step2: Delete the tuple from the page.
-  page->WLatch();
-  page->ApplyDelete(rid,txn,log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  ASSERT(guard.IsValid(), "page not found when delete");
+  RowId target;
+  bool forwarded = guard.As<TablePage>()->GetForwardRowId(rid, &target);
+  guard.Drop();
+  // Step3: Delete the tuple from the page, a relocated row also where it lives now.
+  ApplyDeleteSlot(rid, txn);
+  if (forwarded) {
+    ApplyDeleteSlot(target, txn);
+  }
+}
+
+void TableHeap::ApplyDeleteSlot(const RowId &rid, Txn *txn) {
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  ASSERT(guard.IsValid(), "page not found when delete");
+  auto page = guard.AsMut<TablePage>();
+  page->ApplyDelete(rid, txn, log_manager_);
+  UpdateFreeSpaceHint(rid.GetPageId(), page);
 }
 
 void TableHeap::RollbackDelete(const RowId &rid, Txn *txn) {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  assert(page != nullptr);
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  assert(guard.IsValid());
   // Rollback to delete.
-  page->WLatch();
-  page->RollbackDelete(rid, txn, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  guard.AsMut<TablePage>()->RollbackDelete(rid, txn, log_manager_);
 }
 
 /**
  * TODO: Student Implement
  */
-bool TableHeap::GetTuple(Row *row, Txn *txn) { 
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(row->GetRowId().GetPageId()));
-  page->RLatch();
-  bool result = page->GetTuple(row,schema_,txn, lock_manager_);
-  page->RUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetPageId(),false);
+bool TableHeap::GetTuple(Row *row, Txn *txn) {
+  if (!GetStoredTuple(row, txn)) {
+    return false;
+  }
+  LoadOverflowValues(row, {});
+  return true;
+}
+
+bool TableHeap::GetStoredTuple(Row *row, Txn *txn, bool include_deleted) {
+  ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(row->GetRowId().GetPageId());
+  if (!guard.IsValid()) {
+    return false;
+  }
+  auto page = guard.As<TablePage>();
+  RowId target;
+  if (page->GetForwardRowId(row->GetRowId(), &target)) {
+    return (include_deleted || page->HasTuple(row->GetRowId())) && GetForwardedTuple(row, target, txn);
+  }
+  return page->GetTuple(row, schema_, txn, lock_manager_, include_deleted);
+}
+
+bool TableHeap::GetForwardedTuple(Row *row, const RowId &target, Txn *txn) {
+  ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(target.GetPageId());
+  if (!guard.IsValid()) {
+    return false;
+  }
+  RowId rid = row->GetRowId();
+  row->SetRowId(target);
+  bool result = guard.As<TablePage>()->GetTuple(row, schema_, txn, lock_manager_);
+  row->SetRowId(rid);
   return result;
 }
 
+void TableHeap::LoadOverflowValues(Row *row, const std::vector<bool> &columns) {
+  for (uint32_t i = 0; i < row->GetFieldCount(); i++) {
+    Field *field = row->GetField(i);
+    if (!field->IsExternal() || (!columns.empty() && !columns[i])) {
+      continue;
+    }
+    uint32_t len = field->GetLength();
+    std::unique_ptr<char[]> buf(new char[len]);
+    ReadOverflow(field->GetOverflowPageId(), len, buf.get());
+    Field value(TypeId::kTypeChar, buf.get(), len, true);
+    Swap(*field, value);
+  }
+}
+
+bool TableHeap::PrepareStoredRow(const Row &row, const Row *old_row, Row *stored) {
+  uint32_t inline_limit = OverflowPage::GetInlineLimit(buffer_pool_manager_->GetPageSize());
+  std::vector<Field> fields;
+  fields.reserve(row.GetFieldCount());
+  for (uint32_t i = 0; i < row.GetFieldCount(); i++) {
+    Field *field = row.GetField(i);
+    if (field->GetTypeId() != TypeId::kTypeChar || field->IsNull() || field->IsExternal() ||
+        field->GetLength() <= inline_limit) {
+      fields.emplace_back(*field);
+      continue;
+    }
+    uint32_t len = field->GetLength();
+    page_id_t page_id = INVALID_PAGE_ID;
+    // 被更新的行原本就引用了相同的值，共用原来的溢出页
+    if (old_row != nullptr && old_row->GetField(i)->IsExternal() && old_row->GetField(i)->GetLength() == len) {
+      std::unique_ptr<char[]> old_value(new char[len]);
+      ReadOverflow(old_row->GetField(i)->GetOverflowPageId(), len, old_value.get());
+      if (memcmp(old_value.get(), field->GetData(), len) == 0) {
+        page_id = old_row->GetField(i)->GetOverflowPageId();
+      }
+    }
+    if (page_id == INVALID_PAGE_ID) {
+      page_id = WriteOverflow(field->GetData(), len);
+    }
+    if (page_id == INVALID_PAGE_ID) {
+      FreeOverflowValues(Row(fields), old_row);
+      return false;
+    }
+    fields.emplace_back(TypeId::kTypeChar, len, page_id);
+  }
+  *stored = Row(fields);
+  stored->SetRowId(row.GetRowId());
+  return true;
+}
+
+void TableHeap::FreeOverflowValues(const Row &stored, const Row *keep) {
+  for (uint32_t i = 0; i < stored.GetFieldCount(); i++) {
+    Field *field = stored.GetField(i);
+    if (!field->IsExternal()) {
+      continue;
+    }
+    if (keep != nullptr && i < keep->GetFieldCount() &&
+        keep->GetField(i)->GetOverflowPageId() == field->GetOverflowPageId()) {
+      continue;
+    }
+    FreeOverflow(field->GetOverflowPageId());
+  }
+}
+
+page_id_t TableHeap::WriteOverflow(const char *data, uint32_t len) {
+  uint32_t capacity = OverflowPage::GetCapacity(buffer_pool_manager_->GetPageSize());
+  uint32_t page_count = (len + capacity - 1) / capacity;
+  // 从最后一段往前写，每一页写入时就已经知道它的后继
+  page_id_t next_page_id = INVALID_PAGE_ID;
+  for (uint32_t i = page_count; i > 0; i--) {
+    uint32_t offset = (i - 1) * capacity;
+    page_id_t page_id;
+    WritePageGuard guard = buffer_pool_manager_->NewPageGuarded(page_id).UpgradeWrite();
+    if (!guard.IsValid()) {
+      FreeOverflow(next_page_id);
+      return INVALID_PAGE_ID;
+    }
+    guard.AsMut<OverflowPage>()->Init(next_page_id, data + offset, std::min(capacity, len - offset));
+    next_page_id = page_id;
+  }
+  return next_page_id;
+}
+
+void TableHeap::ReadOverflow(page_id_t page_id, uint32_t len, char *buf) {
+  uint32_t offset = 0;
+  while (page_id != INVALID_PAGE_ID && offset < len) {
+    ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(page_id);
+    ASSERT(guard.IsValid(), "overflow page not found");
+    auto page = guard.As<OverflowPage>();
+    uint32_t size = std::min(page->GetDataSize(), len - offset);
+    memcpy(buf + offset, page->GetValueData(), size);
+    offset += size;
+    page_id = page->GetNextPageId();
+  }
+  ASSERT(offset == len, "overflow chain shorter than its value");
+}
+
+void TableHeap::FreeOverflow(page_id_t page_id) {
+  while (page_id != INVALID_PAGE_ID) {
+    page_id_t next_page_id;
+    {
+      ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(page_id);
+      ASSERT(guard.IsValid(), "overflow page not found");
+      next_page_id = guard.As<OverflowPage>()->GetNextPageId();
+    }
+    buffer_pool_manager_->DeletePage(page_id);
+    page_id = next_page_id;
+  }
+}
+
+void TableHeap::UpdateFreeSpaceHint(page_id_t page_id, TablePage *page) {
+  uint32_t space = page->GetAvailableSpace();
+  std::lock_guard<std::mutex> lock(hint_latch_);
+  auto [it, inserted] = free_space_hint_.try_emplace(page_id, space);
+  if (!inserted) {
+    if (it->second == space) {
+      return;
+    }
+    pages_by_space_.erase({it->second, page_id});
+    it->second = space;
+  }
+  pages_by_space_.emplace(space, page_id);
+}
+
+page_id_t TableHeap::FindPageWithSpace(uint32_t required_space, page_id_t skip_page_id) {
+  std::lock_guard<std::mutex> lock(hint_latch_);
+  auto it = pages_by_space_.lower_bound({required_space, std::numeric_limits<page_id_t>::min()});
+  // 页号各不相同，跳过的页面最多只占一个位置
+  if (it != pages_by_space_.end() && it->second == skip_page_id) {
+    ++it;
+  }
+  return it == pages_by_space_.end() ? INVALID_PAGE_ID : it->second;
+}
+
 void TableHeap::DeleteTable(page_id_t page_id) {
   if (page_id != INVALID_PAGE_ID) {
-    auto temp_table_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));  // 删除table_heap
-    if (temp_table_page->GetNextPageId() != INVALID_PAGE_ID)
-      DeleteTable(temp_table_page->GetNextPageId());
-    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id_t next_page_id;
+    {
+      ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(page_id);  // 删除table_heap
+      next_page_id = guard.As<TablePage>()->GetNextPageId();
+    }
+    if (next_page_id != INVALID_PAGE_ID)
+      DeleteTable(next_page_id);
     buffer_pool_manager_->DeletePage(page_id);
   } else {
+    // 先释放长值占用的溢出页，只读每行的存储形式，不加载这些值
+    for (auto iter = Begin(nullptr, std::vector<bool>(schema_->GetColumnCount(), false)); iter != End(); ++iter) {
+      FreeOverflowValues(*iter, nullptr);
+    }
     DeleteTable(first_page_id_);
   }
 }
@@ -137,12 +431,18 @@ void TableHeap::DeleteTable(page_id_t page_id) {
 /**
  * TODO: Student Implement
  */
-TableIterator TableHeap::Begin(Txn *txn) { 
-  auto tmp_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
+TableIterator TableHeap::Begin(Txn *txn, const std::vector<bool> &columns) {
   RowId rid;
-  tmp_page->GetFirstTupleRid(&rid);
-  buffer_pool_manager_->UnpinPage(tmp_page->GetPageId(), false); 
-  return TableIterator(this, rid, txn);
+  page_id_t page_id = first_page_id_;
+  // 跳过开头的空页，直到找到第一条有效记录
+  while (page_id != INVALID_PAGE_ID) {
+    ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(page_id);
+    if (guard.As<TablePage>()->GetFirstTupleRid(&rid)) {
+      break;
+    }
+    page_id = guard.As<TablePage>()->GetNextPageId();
+  }
+  return TableIterator(this, rid, txn, columns);
 }
 
 /**
@@ -151,3 +451,44 @@ TableIterator TableHeap::Begin(Txn *txn) {
 TableIterator TableHeap::End() { 
   return TableIterator(this, INVALID_ROWID, nullptr);
 }
+
+void TableHeap::WidenZoneMap(page_id_t page_id, const Row &row) {
+  std::lock_guard<std::mutex> lock(zone_map_latch_);
+  auto it = zone_maps_.find(page_id);
+  if (it != zone_maps_.end()) {
+    it->second.Add(row);
+  }
+}
+
+bool TableHeap::PageMayMatch(page_id_t page_id, TablePage *page, const ZoneMapFilter &filter) {
+  {
+    std::lock_guard<std::mutex> lock(zone_map_latch_);
+    auto it = zone_maps_.find(page_id);
+    if (it != zone_maps_.end()) {
+      // 其他扫描正在补建时不裁剪
+      return !it->second.IsComplete() || it->second.MayMatch(filter);
+    }
+    // 先放一个未完成的汇总占位，补建期间对这一页的修改会放宽它
+    zone_maps_.emplace(page_id, ZoneMap(schema_, false));
+  }
+  // 页面被调用者锁住，不会再有行以它为家；搬走的行要到新页面上读
+  ZoneMap built(schema_, true);
+  RowView view;
+  RowId rid;
+  for (bool found = page->GetFirstTupleRid(&rid); found; found = page->GetNextTupleRid(rid, &rid)) {
+    RowId target;
+    if (page->GetForwardRowId(rid, &target)) {
+      ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(target.GetPageId());
+      if (guard.IsValid() && guard.As<TablePage>()->GetTupleView(target, schema_, &view)) {
+        built.Add(view);
+      }
+    } else if (page->GetTupleView(rid, schema_, &view)) {
+      built.Add(view);
+    }
+  }
+  std::lock_guard<std::mutex> lock(zone_map_latch_);
+  ZoneMap &zone_map = zone_maps_.at(page_id);
+  zone_map.Merge(built);
+  zone_map.SetComplete();
+  return zone_map.MayMatch(filter);
+}
@@ -1,21 +1,22 @@
 #include "storage/table_iterator.h"
 
+#include <utility>
+
 #include "common/macros.h"
 #include "storage/table_heap.h"
 
 /**
  * TODO: Student Implement
  */
-TableIterator::TableIterator(TableHeap *table_heap, RowId rid, Txn *txn): table_heap_(table_heap), current_row_id_(rid), txn_(txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RowId rid, Txn *txn, std::vector<bool> columns)
+    : table_heap_(table_heap), current_row_id_(rid), txn_(txn), columns_(std::move(columns)) {
   if(rid == INVALID_ROWID) 
     return;
   ASSERT(table_heap_, "TableHeap is nullptr.");
-  Row* row = new Row(current_row_id_);
-  table_heap_->GetTuple(row, nullptr);
-  ASSERT(row, "Invalid row.");
-  current_row_ = *row;
-  // bool result = table_heap_->GetTuple(&current_row_,txn_);
-  // ASSERT(result, "Failed to fetch tuple at table iterator init");
+  current_row_ = Row(current_row_id_);
+  bool result = table_heap_->GetStoredTuple(&current_row_, txn_);
+  ASSERT(result, "Failed to fetch tuple at table iterator init");
+  table_heap_->LoadOverflowValues(&current_row_, columns_);
 }
 
 TableIterator::TableIterator(const TableIterator &other) {
@@ -23,6 +24,7 @@ TableIterator::TableIterator(const TableIterator &other) {
   current_row_id_ = other.current_row_id_;
   txn_ = other.txn_;
   current_row_=other.current_row_;
+  columns_ = other.columns_;
 }
 
 TableIterator::~TableIterator() {
@@ -50,6 +52,7 @@ TableIterator &TableIterator::operator=(const TableIterator &itr) noexcept {
   current_row_ = itr.current_row_;
   current_row_id_ = itr.current_row_id_;  
   txn_ = itr.txn_;
+  columns_ = itr.columns_;
   return *this;
 }
 
@@ -59,48 +62,37 @@ TableIterator &TableIterator::operator++() {
     return *this;
 
   auto buf_pool = table_heap_->buffer_pool_manager_;
-  page_id_t current_page_id = current_row_id_.GetPageId();
-
-  auto page = reinterpret_cast<TablePage *>(buf_pool->FetchPage(current_page_id));
-
+  // 每一步只 fetch 一次页面：在同一个 guard 下既找下一个 rid 又读出记录
+  ReadPageGuard guard = buf_pool->FetchPageRead(current_row_id_.GetPageId());
+  auto page = guard.As<TablePage>();
   RowId next_row_id;
-  
-
-  if (page->GetNextTupleRid(current_row_id_, &next_row_id)) {
+  bool found = page->GetNextTupleRid(current_row_id_, &next_row_id);
 
-    buf_pool->UnpinPage(current_page_id, false);
-    current_row_id_ = next_row_id;
-
-    Row new_row(current_row_id_);
-    bool result = table_heap_->GetTuple(&new_row, txn_);
-    ASSERT(result, "TableIterator::operator++: GetTuple failed");
-
-    current_row_ = new_row;
-    return *this;
-  }
-
-  page_id_t next_page_id = page->GetNextPageId();
-  buf_pool->UnpinPage(current_page_id, false);
-  while (next_page_id != INVALID_PAGE_ID) {
-    auto page_ = reinterpret_cast<TablePage *>(buf_pool->FetchPage(next_page_id));
-
-    if (page_->GetFirstTupleRid(&next_row_id)) {
-      buf_pool->UnpinPage(next_page_id, false);
-      current_row_id_ = next_row_id;
-
-      Row new_row(current_row_id_);
-      bool result = table_heap_->GetTuple(&new_row, txn_);
-      ASSERT(result, "TableIterator::operator++: GetTuple failed on new page");
-
-      current_row_ = new_row;
+  while (!found) {
+    page_id_t next_page_id = page->GetNextPageId();
+    if (next_page_id == INVALID_PAGE_ID) {
+      current_row_id_ = INVALID_ROWID;
       return *this;
     }
-    page_id_t next_page_id_temp = page_->GetNextPageId(); 
-    buf_pool->UnpinPage(next_page_id, false);
-    next_page_id = next_page_id_temp;
+    guard = buf_pool->FetchPageRead(next_page_id);
+    page = guard.As<TablePage>();
+    found = page->GetFirstTupleRid(&next_row_id);
   }
 
-  current_row_id_ = INVALID_ROWID;
+  current_row_id_ = next_row_id;
+  current_row_ = Row(current_row_id_);
+  RowId target;
+  bool result;
+  if (page->GetForwardRowId(current_row_id_, &target)) {
+    // 记录已搬到别的页面，通过转发桩读取，对外仍使用原来的 rid
+    result = table_heap_->GetForwardedTuple(&current_row_, target, txn_);
+  } else {
+    result = page->GetTuple(&current_row_, table_heap_->schema_, txn_, table_heap_->lock_manager_);
+  }
+  ASSERT(result, "TableIterator::operator++: GetTuple failed");
+  // 放开数据页后再按需读取溢出页
+  guard.Drop();
+  table_heap_->LoadOverflowValues(&current_row_, columns_);
   return *this;
 }
 
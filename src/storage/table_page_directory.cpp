@@ -0,0 +1,88 @@
+#include "storage/table_page_directory.h"
+
+#include <algorithm>
+
+#include "page/table_page.h"
+
+void TablePageDirectory::Init(page_id_t first_page_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  first_page_id_ = first_page_id;
+  page_ids_.assign(1, first_page_id);
+  pending_appends_.clear();
+  built_ = true;
+}
+
+void TablePageDirectory::Load(page_id_t first_page_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  first_page_id_ = first_page_id;
+  page_ids_.clear();
+  pending_appends_.clear();
+  built_ = false;
+}
+
+void TablePageDirectory::Append(page_id_t prev_page_id, page_id_t page_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  if (!built_) {
+    pending_appends_.emplace_back(prev_page_id, page_id);
+    return;
+  }
+  ASSERT(page_ids_.back() == prev_page_id, "Pages must be appended after the last page.");
+  page_ids_.push_back(page_id);
+}
+
+page_id_t TablePageDirectory::GetLastPageId() {
+  std::unique_lock<std::mutex> lock(latch_);
+  EnsureBuilt(lock);
+  return page_ids_.back();
+}
+
+size_t TablePageDirectory::GetPageCount() {
+  std::unique_lock<std::mutex> lock(latch_);
+  EnsureBuilt(lock);
+  return page_ids_.size();
+}
+
+page_id_t TablePageDirectory::GetPageId(size_t index) {
+  std::unique_lock<std::mutex> lock(latch_);
+  EnsureBuilt(lock);
+  return index < page_ids_.size() ? page_ids_[index] : INVALID_PAGE_ID;
+}
+
+std::vector<page_id_t> TablePageDirectory::GetPageIds(size_t begin, size_t end) {
+  std::unique_lock<std::mutex> lock(latch_);
+  EnsureBuilt(lock);
+  end = std::min(end, page_ids_.size());
+  if (begin >= end) {
+    return {};
+  }
+  return std::vector<page_id_t>(page_ids_.begin() + begin, page_ids_.begin() + end);
+}
+
+void TablePageDirectory::EnsureBuilt(std::unique_lock<std::mutex> &lock) {
+  if (built_) {
+    return;
+  }
+  page_id_t page_id = first_page_id_;
+  lock.unlock();
+  std::vector<page_id_t> page_ids;
+  while (page_id != INVALID_PAGE_ID) {
+    page_ids.push_back(page_id);
+    ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(page_id);
+    ASSERT(guard.IsValid(), "Failed to fetch table page.");
+    page_id = guard.As<TablePage>()->GetNextPageId();
+  }
+  lock.lock();
+  if (built_) {
+    // 另一个线程先建好了
+    return;
+  }
+  // 遍历走到末尾之后才链上的页面
+  for (auto &[prev_page_id, new_page_id] : pending_appends_) {
+    if (page_ids.back() == prev_page_id) {
+      page_ids.push_back(new_page_id);
+    }
+  }
+  page_ids_ = std::move(page_ids);
+  pending_appends_.clear();
+  built_ = true;
+}
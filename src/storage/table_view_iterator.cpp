@@ -0,0 +1,111 @@
+#include "storage/table_view_iterator.h"
+
+#include "common/macros.h"
+#include "storage/table_heap.h"
+
+TableViewIterator::TableViewIterator(TableHeap *table_heap, Txn *txn, const ZoneMapFilter *filter,
+                                     PageFilter page_filter)
+    : table_heap_(table_heap), txn_(txn), filter_(filter), page_filter_(std::move(page_filter)) {
+  ASSERT(table_heap_, "TableHeap is nullptr.");
+  if (filter_ != nullptr && filter_->IsEmpty()) {
+    filter_ = nullptr;
+  }
+  page_guard_ = table_heap_->buffer_pool_manager_->FetchPageRead(table_heap_->first_page_id_);
+  ASSERT(page_guard_.IsValid(), "Failed to fetch the first page of table heap.");
+  RowId first_rid;
+  bool found = SeekPage(&first_rid);
+  Seek(found, first_rid);
+}
+
+TableViewIterator::TableViewIterator(TableHeap *table_heap, Txn *txn, std::vector<page_id_t> pages,
+                                     const ZoneMapFilter *filter, PageFilter page_filter)
+    : table_heap_(table_heap),
+      txn_(txn),
+      filter_(filter),
+      page_filter_(std::move(page_filter)),
+      pages_(std::move(pages)),
+      use_pages_(true) {
+  ASSERT(table_heap_, "TableHeap is nullptr.");
+  if (filter_ != nullptr && filter_->IsEmpty()) {
+    filter_ = nullptr;
+  }
+  if (pages_.empty()) {
+    return;
+  }
+  page_guard_ = table_heap_->buffer_pool_manager_->FetchPageRead(pages_[0]);
+  ASSERT(page_guard_.IsValid(), "Failed to fetch table page.");
+  next_page_index_ = 1;
+  RowId first_rid;
+  bool found = SeekPage(&first_rid);
+  Seek(found, first_rid);
+}
+
+TableViewIterator &TableViewIterator::operator++() {
+  if (IsEnd()) {
+    return *this;
+  }
+  forward_guard_.Drop();
+  if (released_) {
+    // 页面在两行之间可能被修改过，重新读取后从放开的那一行之后继续
+    page_guard_ = table_heap_->buffer_pool_manager_->FetchPageRead(rid_.GetPageId());
+    ASSERT(page_guard_.IsValid(), "Failed to fetch table page.");
+    released_ = false;
+  }
+  RowId next_rid;
+  bool found = page_guard_.As<TablePage>()->GetNextTupleRid(rid_, &next_rid);
+  Seek(found, next_rid);
+  return *this;
+}
+
+void TableViewIterator::Release() {
+  forward_guard_.Drop();
+  page_guard_.Drop();
+  released_ = true;
+}
+
+bool TableViewIterator::SeekPage(RowId *first_rid) {
+  auto page = page_guard_.As<TablePage>();
+  if (page_filter_ && !page_filter_(page_guard_.PageId())) {
+    skipped_pages_++;
+    return false;
+  }
+  if (filter_ != nullptr && !table_heap_->PageMayMatch(page_guard_.PageId(), page, *filter_)) {
+    skipped_pages_++;
+    return false;
+  }
+  return page->GetFirstTupleRid(first_rid);
+}
+
+page_id_t TableViewIterator::NextPageId(TablePage *page) {
+  if (!use_pages_) {
+    return page->GetNextPageId();
+  }
+  return next_page_index_ < pages_.size() ? pages_[next_page_index_++] : INVALID_PAGE_ID;
+}
+
+void TableViewIterator::Seek(bool found, RowId next_rid) {
+  auto buf_pool = table_heap_->buffer_pool_manager_;
+  auto page = page_guard_.As<TablePage>();
+  while (!found) {
+    page_id_t next_page_id = NextPageId(page);
+    if (next_page_id == INVALID_PAGE_ID) {
+      rid_ = INVALID_ROWID;
+      page_guard_.Drop();
+      return;
+    }
+    page_guard_ = buf_pool->FetchPageRead(next_page_id);
+    page = page_guard_.As<TablePage>();
+    found = SeekPage(&next_rid);
+  }
+  rid_ = next_rid;
+  RowId target;
+  bool result;
+  if (page->GetForwardRowId(rid_, &target)) {
+    forward_guard_ = buf_pool->FetchPageRead(target.GetPageId());
+    result = forward_guard_.As<TablePage>()->GetTupleView(target, table_heap_->schema_, &view_);
+    view_.SetRowId(rid_);
+  } else {
+    result = page->GetTupleView(rid_, table_heap_->schema_, &view_);
+  }
+  ASSERT(result, "TableViewIterator: GetTupleView failed");
+}
@@ -0,0 +1,114 @@
+#include "storage/zone_map.h"
+
+#include <algorithm>
+#include <cmath>
+
+void ZoneMap::Add(const Row &row) {
+  for (uint32_t i = 0; i < columns_.size(); i++) {
+    AddField(i, *row.GetField(i));
+  }
+}
+
+void ZoneMap::Add(const RowView &view) {
+  for (uint32_t i = 0; i < columns_.size(); i++) {
+    AddField(i, view.GetField(i));
+  }
+}
+
+bool ZoneMap::GetNumericValue(const Field &field, double *value) {
+  if (field.IsNull()) {
+    return false;
+  }
+  switch (field.GetTypeId()) {
+    case TypeId::kTypeInt:
+      *value = field.value_.integer_;
+      return true;
+    case TypeId::kTypeFloat:
+      *value = field.value_.float_;
+      return true;
+    default:
+      return false;
+  }
+}
+
+void ZoneMap::AddField(uint32_t column, const Field &field) {
+  ColumnSummary &summary = columns_[column];
+  if (field.IsNull()) {
+    summary.null_count_++;
+    return;
+  }
+  double value;
+  if (!GetNumericValue(field, &value)) {
+    // 变长的值不做汇总，只记下有非 null 值
+    summary.has_value_ = true;
+    summary.min_ = -HUGE_VAL;
+    summary.max_ = HUGE_VAL;
+    return;
+  }
+  if (!summary.has_value_) {
+    summary.has_value_ = true;
+    summary.min_ = summary.max_ = value;
+    return;
+  }
+  summary.min_ = std::min(summary.min_, value);
+  summary.max_ = std::max(summary.max_, value);
+}
+
+void ZoneMap::Merge(const ZoneMap &other) {
+  for (uint32_t i = 0; i < columns_.size(); i++) {
+    ColumnSummary &summary = columns_[i];
+    const ColumnSummary &that = other.columns_[i];
+    summary.null_count_ += that.null_count_;
+    if (!that.has_value_) {
+      continue;
+    }
+    if (!summary.has_value_) {
+      summary.has_value_ = true;
+      summary.min_ = that.min_;
+      summary.max_ = that.max_;
+      continue;
+    }
+    summary.min_ = std::min(summary.min_, that.min_);
+    summary.max_ = std::max(summary.max_, that.max_);
+  }
+}
+
+bool ZoneMap::MayMatch(const ZoneMapFilter &filter) const {
+  for (const auto &term : filter.GetTerms()) {
+    const ColumnSummary &summary = columns_[term.column_];
+    if (term.op_ == ZoneMapFilter::Op::kIsNull) {
+      if (summary.null_count_ == 0) {
+        return false;
+      }
+      continue;
+    }
+    // null 不满足任何比较
+    if (!summary.has_value_) {
+      return false;
+    }
+    bool may_match = true;
+    switch (term.op_) {
+      case ZoneMapFilter::Op::kEqual:
+        may_match = summary.min_ <= term.value_ && term.value_ <= summary.max_;
+        break;
+      case ZoneMapFilter::Op::kLessThan:
+        may_match = summary.min_ < term.value_;
+        break;
+      case ZoneMapFilter::Op::kLessThanEquals:
+        may_match = summary.min_ <= term.value_;
+        break;
+      case ZoneMapFilter::Op::kGreaterThan:
+        may_match = summary.max_ > term.value_;
+        break;
+      case ZoneMapFilter::Op::kGreaterThanEquals:
+        may_match = summary.max_ >= term.value_;
+        break;
+      default:
+        break;
+    }
+    if (!may_match) {
+      return false;
+    }
+  }
+  return true;
+}
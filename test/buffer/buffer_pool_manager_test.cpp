@@ -71,4 +71,51 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
 
   delete bpm;
   delete disk_manager;
-}
\ No newline at end of file
+}
+TEST(BufferPoolManagerTest, StatsTest) {
+  const std::string db_name = "bpm_stats_test.db";
+  const size_t buffer_pool_size = 3;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  bpm->ResetStats();
+
+  page_id_t page_ids[4];
+  for (int i = 0; i < 3; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_ids[i]));
+    // 只有第一页被修改，其余页面驱逐时不需要写回
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], i == 0));
+  }
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[1]));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[1], false));
+
+  // Scenario: the pool is full, the LRU victim is the dirty page 0.
+  ASSERT_NE(nullptr, bpm->NewPage(page_ids[3]));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[3], false));
+  // Scenario: fetching page 0 again misses and evicts the clean page 2.
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[0]));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[0], false));
+
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(buffer_pool_size, stats.pool_size_);
+  EXPECT_EQ(buffer_pool_size, stats.pages_cached_);
+  EXPECT_EQ(4, stats.new_pages_);
+  EXPECT_EQ(1, stats.fetch_hits_);
+  EXPECT_EQ(1, stats.fetch_misses_);
+  EXPECT_EQ(1, stats.dirty_evictions_);
+  EXPECT_EQ(1, stats.clean_evictions_);
+  EXPECT_DOUBLE_EQ(0.5, stats.HitRatio());
+  EXPECT_GE(stats.disk_.pages_read_, 1);
+  EXPECT_GE(stats.disk_.pages_written_, 1);
+  EXPECT_LE(stats.disk_.bytes_read_, stats.disk_.pages_read_ * PAGE_SIZE);
+
+  bpm->ResetStats();
+  stats = bpm->GetStats();
+  EXPECT_EQ(0, stats.fetch_hits_ + stats.fetch_misses_ + stats.new_pages_);
+  EXPECT_EQ(0, stats.disk_.pages_written_);
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
@@ -0,0 +1,80 @@
+#include "buffer/page_guard.h"
+
+#include <cstdio>
+#include <string>
+#include <utility>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+TEST(PageGuardTest, PinAndMoveTest) {
+  const std::string db_name = "page_guard_test.db";
+  const size_t buffer_pool_size = 5;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  page_id_t page_id;
+  Page *page = nullptr;
+  {
+    BasicPageGuard guard = bpm->NewPageGuarded(page_id);
+    ASSERT_TRUE(guard.IsValid());
+    page = guard.GetPage();
+    EXPECT_EQ(1, page->GetPinCount());
+    std::snprintf(guard.GetDataMut(), PAGE_SIZE, "hello");
+
+    // Moving hands the pin over instead of taking a second one.
+    BasicPageGuard moved(std::move(guard));
+    EXPECT_FALSE(guard.IsValid());
+    EXPECT_EQ(1, page->GetPinCount());
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+  EXPECT_TRUE(page->IsDirty());
+
+  {
+    ReadPageGuard r1 = bpm->FetchPageRead(page_id);
+    ReadPageGuard r2 = bpm->FetchPageRead(page_id);
+    EXPECT_EQ(2, page->GetPinCount());
+    EXPECT_STREQ("hello", r1.GetData());
+    r2.Drop();
+    EXPECT_EQ(1, page->GetPinCount());
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+
+  {
+    WritePageGuard w = bpm->FetchPageWrite(page_id);
+    WritePageGuard other;
+    other = std::move(w);
+    EXPECT_EQ(1, page->GetPinCount());
+    std::snprintf(other.GetDataMut(), PAGE_SIZE, "world");
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+
+  {
+    // The write latch is released on destruction, so a reader can get in afterwards.
+    BasicPageGuard basic = bpm->FetchPageBasic(page_id);
+    ReadPageGuard read = basic.UpgradeRead();
+    EXPECT_FALSE(basic.IsValid());
+    EXPECT_EQ(1, page->GetPinCount());
+    EXPECT_STREQ("world", read.GetData());
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+
+  {
+    // A page latch shared by a reader cannot be taken for writing, the try fails without waiting.
+    ReadPageGuard read = bpm->FetchPageRead(page_id);
+    EXPECT_FALSE(page->TryWLatch());
+    EXPECT_TRUE(page->TryRLatch());
+    page->RUnlatch();
+  }
+  EXPECT_TRUE(page->TryWLatch());
+  page->WUnlatch();
+  // Nothing waited for a latch on this single thread, so no wait time was recorded.
+  EXPECT_EQ(0, bpm->GetStats().latch_wait_ns_);
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
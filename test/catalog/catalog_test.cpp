@@ -89,6 +89,9 @@ TEST(CatalogTest, CatalogIndexTest) {
   ASSERT_EQ(DB_TABLE_NOT_EXIST, r1);
   auto r2 = catalog_01->CreateIndex("table-1", "index-1", bad_index_keys, &txn, index_info, "bptree");
   ASSERT_EQ(DB_COLUMN_NAME_NOT_EXIST, r2);
+  IndexInfo *include_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, catalog_01->CreateIndex("table-1", "index-include", {"id"}, &txn, include_info, "bptree", true,
+                                                {"account", "id"}));
   auto r3 = catalog_01->CreateIndex("table-1", "index-1", index_keys, &txn, index_info, "bptree");
   ASSERT_EQ(DB_SUCCESS, r3);
   for (int i = 0; i < 10; i++) {
@@ -116,6 +119,10 @@ TEST(CatalogTest, CatalogIndexTest) {
   ASSERT_EQ(DB_INDEX_ALREADY_EXIST, r4);
   IndexInfo *index_info_02 = nullptr;
   ASSERT_EQ(DB_SUCCESS, catalog_02->GetIndex("table-1", "index-1", index_info_02));
+  // included columns survive the reload, a column of the key is not stored twice
+  IndexInfo *include_info_02 = nullptr;
+  ASSERT_EQ(DB_SUCCESS, catalog_02->GetIndex("table-1", "index-include", include_info_02));
+  ASSERT_EQ((std::vector<uint32_t>{0, 2}), include_info_02->GetEntryMapping());
   std::vector<RowId> ret_02;
   for (int i = 0; i < 10; i++) {
     std::vector<Field> fields{Field(TypeId::kTypeInt, i),
@@ -126,4 +133,64 @@ TEST(CatalogTest, CatalogIndexTest) {
     ASSERT_EQ(rid.Get(), ret_02[i].Get());
   }
   delete db_02;
-}
\ No newline at end of file
+}
+TEST(CatalogTest, CatalogIndexBuildTest) {
+  auto db_01 = new DBStorageEngine(db_file_name, true);
+  auto &catalog_01 = db_01->catalog_mgr_;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  Txn txn;
+  TableInfo *table_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, catalog_01->CreateTable("table-1", schema.get(), &txn, table_info));
+  const int n = 1000;
+  std::vector<RowId> rids;
+  for (int i = 0; i < n; i++) {
+    // name 只有 10 种取值
+    std::string name = "minisql-" + std::to_string(i % 10);
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i),
+                              Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.length(), true)};
+    Row row(fields);
+    ASSERT_TRUE(table_info->GetTableHeap()->InsertTuple(row, &txn));
+    rids.push_back(row.GetRowId());
+  }
+  // an index created on a populated table holds its rows
+  IndexInfo *index_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, catalog_01->CreateIndex("table-1", "index-id", {"id"}, &txn, index_info, "bptree"));
+  std::vector<RowId> ret;
+  for (int i = 0; i < n; i++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    ret.clear();
+    ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(Row(fields), ret, &txn));
+    ASSERT_EQ(rids[i].Get(), ret[0].Get());
+  }
+  // a B-link tree index must be unique
+  ASSERT_EQ(DB_FAILED, catalog_01->CreateIndex("table-1", "index-blink", {"id"}, &txn, index_info, "blink", false));
+  ASSERT_EQ(DB_SUCCESS, catalog_01->CreateIndex("table-1", "index-blink", {"id"}, &txn, index_info, "blink"));
+  std::vector<Field> fields{Field(TypeId::kTypeInt, n / 2)};
+  ret.clear();
+  ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(Row(fields), ret, &txn));
+  ASSERT_EQ(rids[n / 2].Get(), ret[0].Get());
+  // duplicate keys: the index is not created
+  ASSERT_EQ(DB_FAILED, catalog_01->CreateIndex("table-1", "index-name", {"name"}, &txn, index_info, "bptree"));
+  ASSERT_EQ(DB_INDEX_NOT_FOUND, catalog_01->GetIndex("table-1", "index-name", index_info));
+  // a bloom index is built with one scan of the table, and again from the table when the catalog is reopened
+  IndexBuildStats stats;
+  IndexBuildOptions options;
+  options.stats_ = &stats;
+  ASSERT_EQ(DB_SUCCESS,
+            catalog_01->CreateIndex("table-1", "index-bloom", {"name"}, &txn, index_info, "bloom", false, {}, options));
+  ASSERT_EQ(n, stats.entries_);
+  std::vector<IndexInfo *> indexes;
+  ASSERT_EQ(DB_SUCCESS, catalog_01->GetTableIndexes("table-1", indexes));
+  ASSERT_EQ(3, indexes.size());
+  delete db_01;
+  auto db_02 = new DBStorageEngine(db_file_name, false);
+  ASSERT_EQ(DB_SUCCESS, db_02->catalog_mgr_->GetIndex("table-1", "index-bloom", index_info));
+  std::string name = "minisql-7";
+  std::vector<Field> key_fields{Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.length(), true)};
+  uint64_t hash;
+  ASSERT_TRUE(BloomFilterIndex::HashKey(Row(key_fields), &hash));
+  ASSERT_TRUE(static_cast<BloomFilterIndex *>(index_info->GetIndex())->MayContain(rids[7].GetPageId(), hash));
+  delete db_02;
+}
@@ -1,7 +1,11 @@
 //
 // Created by njz on 2023/1/26.
 //
+#include <algorithm>
+
+#include "executor/executors/seq_scan_executor.h"
 #include "executor/plans/delete_plan.h"
+#include "executor/plans/index_scan_plan.h"
 #include "executor/plans/insert_plan.h"
 #include "executor/plans/seq_scan_plan.h"
 #include "executor/plans/update_plan.h"
@@ -28,7 +32,12 @@ TEST_F(ExecutorTest, SimpleSeqScanTest) {
   ASSERT_EQ(result_set.size(), 500);
   for (const auto &row : result_set) {
     ASSERT_TRUE(row.GetField(0)->CompareLessThan(Field(kTypeInt, 500)));
+    ASSERT_EQ(GetExecutorContext()->GetArena(), row.GetArena());
   }
+  // Scenario: rows come out of the query arena, a handful of blocks instead of allocations per field.
+  auto arena = GetExecutorContext()->GetArena();
+  ASSERT_GT(arena->GetAllocatedBytes(), 500 * 2 * sizeof(Field));
+  ASSERT_LE(arena->GetBlockCount(), arena->GetAllocatedBytes() / MemoryArena::BLOCK_SIZE + 1);
 }
 
 // DELETE FROM table-1 WHERE id == 50;
@@ -141,8 +150,11 @@ TEST_F(ExecutorTest, SimpleUpdateTest) {
   update_attrs.emplace(static_cast<uint32_t>(1), content);
   auto update_plan = std::make_shared<UpdatePlanNode>(schema, scan_plan, "table-1", update_attrs);
 
-  // Execute update for all rows in the table
+  // Execute update for all rows in the table, the rows it reads do not stay in the query arena
+  size_t arena_bytes = GetExecutorContext()->GetArena()->GetAllocatedBytes();
   GetExecutionEngine()->ExecutePlan(update_plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(1, result_set.size());
+  ASSERT_EQ(arena_bytes, GetExecutorContext()->GetArena()->GetAllocatedBytes());
   result_set.clear();
 
   // Execute another sequential scan; no rows should be present in the table
@@ -155,3 +167,96 @@ TEST_F(ExecutorTest, SimpleUpdateTest) {
     ASSERT_TRUE(row.GetField(1)->CompareEquals(Field(kTypeChar, const_cast<char *>("minisql"), 7, false)));
   }
 }
+
+// SELECT id FROM table-1 WHERE id < 500, then UPDATE table-1 SET name = "minisql", scanning on 4 workers
+TEST_F(ExecutorTest, ParallelSeqScanTest) {
+  SessionSettings settings;
+  settings.scan_threads_ = 4;
+  GetExecutorContext()->SetSettings(settings);
+  TableInfo *table_info;
+  GetExecutorContext()->GetCatalog()->GetTable("table-1", table_info);
+  ASSERT_GT(table_info->GetTableHeap()->GetPageCount(), SeqScanExecutor::MORSEL_PAGES);
+  const Schema *schema = table_info->GetSchema();
+  auto col_a = MakeColumnValueExpression(*schema, 0, "id");
+  auto const500 = MakeConstantValueExpression(Field(kTypeInt, 500));
+  auto predicate = MakeComparisonExpression(col_a, const500, "<");
+  auto out_schema = MakeOutputSchema({{"id", col_a}});
+  auto plan = make_shared<SeqScanPlanNode>(out_schema, table_info->GetTableName(), predicate);
+  // Scenario: the workers hand out every matching row once, in any order.
+  SeqScanExecutor executor(GetExecutorContext(), plan.get());
+  executor.Init();
+  ASSERT_GT(executor.GetWorkerCount(), 1);
+  std::vector<int> ids;
+  Row row;
+  RowId rid;
+  while (executor.Next(&row, &rid)) {
+    ASSERT_EQ(1, row.GetFieldCount());
+    ids.push_back(std::stoi(row.GetField(0)->toString()));
+  }
+  std::sort(ids.begin(), ids.end());
+  ASSERT_EQ(500, ids.size());
+  for (int i = 0; i < 500; i++) {
+    ASSERT_EQ(i, ids[i]);
+  }
+  // Scenario: a scan abandoned after its first row stops the workers waiting for room in the queue.
+  {
+    SeqScanExecutor abandoned(GetExecutorContext(), plan.get());
+    abandoned.Init();
+    ASSERT_TRUE(abandoned.Next(&row, &rid));
+  }
+  // Scenario: an update above a parallel scan changes every row exactly once.
+  auto scan_all = make_shared<SeqScanPlanNode>(schema, table_info->GetTableName(), nullptr);
+  std::unordered_map<uint32_t, AbstractExpressionRef> update_attrs{};
+  update_attrs.emplace(1, MakeConstantValueExpression(Field(kTypeChar, const_cast<char *>("minisql"), 7, false)));
+  auto update_plan = std::make_shared<UpdatePlanNode>(schema, scan_all, "table-1", update_attrs);
+  std::vector<Row> result_set{};
+  ASSERT_EQ(DB_SUCCESS, GetExecutionEngine()->ExecutePlan(update_plan, &result_set, GetTxn(), GetExecutorContext()));
+  result_set.clear();
+  GetExecutionEngine()->ExecutePlan(scan_all, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(1000, result_set.size());
+  for (const auto &result : result_set) {
+    ASSERT_TRUE(result.GetField(1)->CompareEquals(Field(kTypeChar, const_cast<char *>("minisql"), 7, false)));
+  }
+}
+
+// SELECT id, account FROM table-1 WHERE id < 500, answered from an index on id that includes account
+TEST_F(ExecutorTest, CoveringIndexScanTest) {
+  TableInfo *table_info;
+  GetExecutorContext()->GetCatalog()->GetTable("table-1", table_info);
+  const Schema *schema = table_info->GetSchema();
+  IndexInfo *index_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, GetExecutorContext()->GetCatalog()->CreateIndex("table-1", "index-id", {"id"}, GetTxn(),
+                                                                         index_info, "bptree", true, {"account"}));
+  ASSERT_EQ(2, index_info->GetIndexEntrySchema()->GetColumnCount());
+  // only a unique index can store included columns
+  IndexInfo *rejected = nullptr;
+  ASSERT_EQ(DB_FAILED, GetExecutorContext()->GetCatalog()->CreateIndex("table-1", "index-name", {"name"}, GetTxn(),
+                                                                        rejected, "bptree", false, {"account"}));
+  auto col_id = MakeColumnValueExpression(*schema, 0, "id");
+  auto col_account = MakeColumnValueExpression(*schema, 0, "account");
+  auto predicate = MakeComparisonExpression(col_id, MakeConstantValueExpression(Field(kTypeInt, 500)), "<");
+  auto out_schema = MakeOutputSchema({{"id", col_id}, {"account", col_account}});
+  std::vector<Row> expected{};
+  auto seq_plan = make_shared<SeqScanPlanNode>(out_schema, table_info->GetTableName(), predicate);
+  GetExecutionEngine()->ExecutePlan(seq_plan, &expected, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(500, expected.size());
+
+  // Scenario: the rows come from the leaves, with far fewer page fetches than rows.
+  auto index_plan = make_shared<IndexScanPlanNode>(out_schema, table_info->GetTableName(),
+                                                   std::vector<IndexInfo *>{index_info}, false, predicate, index_info);
+  auto bpm = GetExecutorContext()->GetBufferPoolManager();
+  auto before = bpm->GetStats();
+  std::vector<Row> result_set{};
+  GetExecutionEngine()->ExecutePlan(index_plan, &result_set, GetTxn(), GetExecutorContext());
+  auto after = bpm->GetStats();
+  ASSERT_LT(after.fetch_hits_ + after.fetch_misses_ - before.fetch_hits_ - before.fetch_misses_, 50);
+  ASSERT_EQ(expected.size(), result_set.size());
+  std::sort(expected.begin(), expected.end(), [](const Row &a, const Row &b) {
+    return a.GetField(0)->CompareLessThan(*b.GetField(0)) == CmpBool::kTrue;
+  });
+  for (size_t i = 0; i < result_set.size(); i++) {
+    ASSERT_EQ(2, result_set[i].GetFieldCount());
+    ASSERT_EQ(CmpBool::kTrue, result_set[i].GetField(0)->CompareEquals(*expected[i].GetField(0)));
+    ASSERT_EQ(CmpBool::kTrue, result_set[i].GetField(1)->CompareEquals(*expected[i].GetField(1)));
+  }
+}
@@ -0,0 +1,133 @@
+#include "index/b_link_tree.h"
+
+#include <atomic>
+#include <thread>
+
+#include "common/instance.h"
+#include "gtest/gtest.h"
+#include "index/comparator.h"
+#include "utils/utils.h"
+
+static const std::string db_name = "b_link_tree_test.db";
+
+TEST(BLinkTreeTests, SampleTest) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {
+      new Column("int", TypeId::kTypeInt, 0, false, false),
+  };
+  Schema *table_schema = new Schema(columns);
+  KeyManager KP(table_schema, 17);
+  // small pages for many splits on every level
+  BLinkTree tree(0, engine.bpm_, KP, 8, 8);
+  const int n = 20000;
+  vector<GenericKey *> keys;
+  for (int i = 0; i < n; i++) {
+    GenericKey *key = KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    KP.SerializeFromKey(key, Row(fields), table_schema);
+    keys.push_back(key);
+  }
+  vector<GenericKey *> shuffled(keys);
+  ShuffleArray(shuffled);
+  for (auto key : shuffled) {
+    ASSERT_TRUE(tree.Insert(key, RowId(0)));
+  }
+  ASSERT_FALSE(tree.Insert(keys[0], RowId(0)));
+  vector<RowId> ans;
+  for (int i = 0; i < n; i++) {
+    ASSERT_TRUE(tree.GetValue(keys[i], ans));
+  }
+  // remove the odd keys, the leaves are not merged
+  for (int i = 1; i < n; i += 2) {
+    ASSERT_TRUE(tree.Remove(keys[i]));
+  }
+  ASSERT_FALSE(tree.Remove(keys[1]));
+  for (int i = 0; i < n; i++) {
+    ASSERT_EQ(i % 2 == 0, tree.GetValue(keys[i], ans));
+  }
+  // scans go along the leaf chain in key order
+  int expected = 100;
+  tree.Scan(keys[99], [&](GenericKey *key, const RowId &) {
+    EXPECT_EQ(0, KP.CompareKeys(key, keys[expected]));
+    expected += 2;
+    return expected < 200;
+  });
+  ASSERT_EQ(200, expected);
+  int count = 0;
+  tree.Scan(nullptr, [&](GenericKey *, const RowId &) { return ++count > 0; });
+  ASSERT_EQ(n / 2, count);
+  ASSERT_TRUE(tree.Check());
+  // the root is kept in the index roots page
+  BLinkTree reopened(0, engine.bpm_, KP, 8, 8);
+  ASSERT_TRUE(reopened.GetValue(keys[n - 2], ans));
+  tree.Destroy();
+  ASSERT_TRUE(tree.IsEmpty());
+  for (auto key : keys) {
+    free(key);
+  }
+}
+
+// Lookups that take no latch run while other threads split the pages they walk through.
+TEST(BLinkTreeTests, ConcurrentInsertLookupTest) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {
+      new Column("int", TypeId::kTypeInt, 0, false, false),
+  };
+  Schema *table_schema = new Schema(columns);
+  KeyManager KP(table_schema, 17);
+  BLinkTree tree(0, engine.bpm_, KP, 8, 8);
+  const int thread_nums = 8;
+  const int n = 40000;
+  vector<GenericKey *> keys;
+  for (int i = 0; i < n; i++) {
+    GenericKey *key = KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    KP.SerializeFromKey(key, Row(fields), table_schema);
+    keys.push_back(key);
+  }
+  // the first half is there before the writers start, the readers must always find it
+  for (int i = 0; i < n / 2; i++) {
+    ASSERT_TRUE(tree.Insert(keys[i], RowId(i)));
+  }
+  std::atomic<bool> done{false};
+  std::atomic<int> errors{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_nums / 2; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = n / 2 + t; i < n; i += thread_nums / 2) {
+        vector<RowId> ans;
+        if (!tree.Insert(keys[i], RowId(i)) || !tree.GetValue(keys[i], ans) || !(ans[0] == RowId(i))) {
+          errors++;
+        }
+      }
+    });
+  }
+  for (int t = 0; t < thread_nums / 2; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = t; !done; i = (i + 7) % (n / 2)) {
+        vector<RowId> ans;
+        if (!tree.GetValue(keys[i], ans) || !(ans[0] == RowId(i))) {
+          errors++;
+        }
+      }
+    });
+  }
+  for (int t = 0; t < thread_nums / 2; t++) {
+    threads[t].join();
+  }
+  done = true;
+  for (int t = thread_nums / 2; t < thread_nums; t++) {
+    threads[t].join();
+  }
+  ASSERT_EQ(0, errors);
+  int64_t expected = 0;
+  tree.Scan(nullptr, [&](GenericKey *, const RowId &rid) {
+    EXPECT_EQ(expected++, rid.Get());
+    return true;
+  });
+  ASSERT_EQ(n, expected);
+  ASSERT_TRUE(tree.Check());
+  for (auto key : keys) {
+    free(key);
+  }
+}
@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "common/instance.h"
+#include "gtest/gtest.h"
+#include "index/b_plus_tree_index.h"
+#include "index/key_sorter.h"
+#include "storage/table_heap.h"
+#include "utils/utils.h"
+
+static const std::string db_name = "bp_tree_bulk_load_test.db";
+
+TEST(BPlusTreeBulkLoadTest, KeySorterSpillTest) {
+  remove(db_name.c_str());
+  auto disk_mgr = new DiskManager(db_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false)};
+  Schema schema(columns);
+  KeyManager KP(&schema, 16);
+  const int n = 20000;
+  std::vector<int> values(n);
+  for (int i = 0; i < n; i++) {
+    values[i] = i / 2;
+  }
+  ShuffleArray(values);
+  // 每段只放得下约 400 个条目，溢出的段多于一次能归并的段数
+  KeySorter sorter(bpm, KP, 10000);
+  GenericKey *key = KP.InitKey();
+  for (int i = 0; i < n; i++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, values[i])};
+    KP.SerializeFromKey(key, Row(fields), &schema);
+    sorter.Add(key, RowId(values[i], i));
+  }
+  free(key);
+  sorter.Finish();
+  ASSERT_GT(sorter.GetSpilledRunCount(), KeySorter::MAX_MERGE_WIDTH);
+  ASSERT_EQ(n, sorter.GetEntryCount());
+  Row row;
+  RowId rid, last_rid;
+  int count = 0;
+  while (sorter.Next(key, rid)) {
+    KP.DeserializeToKey(key, row, &schema);
+    ASSERT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, count / 2)));
+    // 相同的键按 RowId 排序
+    if (count % 2 == 1) {
+      ASSERT_EQ(last_rid.GetPageId(), rid.GetPageId());
+      ASSERT_LT(last_rid.GetSlotNum(), rid.GetSlotNum());
+    }
+    last_rid = rid;
+    count++;
+  }
+  ASSERT_EQ(n, count);
+  ASSERT_TRUE(bpm->CheckAllUnpinned());
+  delete bpm;
+  delete disk_mgr;
+}
+
+TEST(BPlusTreeBulkLoadTest, BuildFromTableTest) {
+  remove(db_name.c_str());
+  auto disk_mgr = new DiskManager(db_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  page_id_t id;
+  ASSERT_TRUE(bpm->NewPage(id) != nullptr && id == CATALOG_META_PAGE_ID);
+  ASSERT_TRUE(bpm->NewPage(id) != nullptr && id == INDEX_ROOTS_PAGE_ID);
+  bpm->UnpinPage(CATALOG_META_PAGE_ID, true);
+  bpm->UnpinPage(INDEX_ROOTS_PAGE_ID, true);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 32, 1, true, false)};
+  TableSchema table_schema(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm, &table_schema, nullptr, nullptr, nullptr);
+  const int n = 20000;
+  std::vector<int> ids(n);
+  for (int i = 0; i < n; i++) {
+    ids[i] = i;
+  }
+  ShuffleArray(ids);
+  std::vector<RowId> rids(n);
+  for (int i = 0; i < n; i++) {
+    std::string name = "name-" + std::to_string(ids[i]);
+    std::vector<Field> fields{Field(TypeId::kTypeInt, ids[i]),
+                              Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.length(), true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids[ids[i]] = row.GetRowId();
+  }
+  IndexBuildOptions options;
+  options.sort_memory_ = 64 << 10;
+  options.fill_factor_ = 70;
+
+  // 有重复的键，建索引失败，索引仍为空
+  auto *name_schema = Schema::ShallowCopySchema(&table_schema, {1});
+  std::string duplicate = "name-7";
+  std::vector<Field> duplicate_fields{
+      Field(TypeId::kTypeInt, n), Field(TypeId::kTypeChar, const_cast<char *>(duplicate.c_str()), 6, true)};
+  Row duplicate_row(duplicate_fields);
+  ASSERT_TRUE(table_heap->InsertTuple(duplicate_row, nullptr));
+  auto *name_index = new BPlusTreeIndex(1, name_schema, 64, bpm);
+  ASSERT_EQ(DB_FAILED, name_index->Build(table_heap, {1}, options, nullptr));
+  ASSERT_TRUE(name_index->GetBeginIterator() == name_index->GetEndIterator());
+  ASSERT_TRUE(table_heap->MarkDelete(duplicate_row.GetRowId(), nullptr));
+  table_heap->ApplyDelete(duplicate_row.GetRowId(), nullptr);
+  ASSERT_TRUE(bpm->CheckAllUnpinned());
+
+  auto *key_schema = Schema::ShallowCopySchema(&table_schema, {0});
+  auto *index = new BPlusTreeIndex(0, key_schema, 16, bpm);
+  ASSERT_EQ(DB_SUCCESS, index->Build(table_heap, {0}, options, nullptr));
+  ASSERT_TRUE(bpm->CheckAllUnpinned());
+  // every row is found, in key order
+  int count = 0;
+  for (auto it = index->GetBeginIterator(); it != index->GetEndIterator(); ++it) {
+    ASSERT_TRUE((*it).second == rids[count]);
+    count++;
+  }
+  ASSERT_EQ(n, count);
+  std::vector<RowId> result;
+  for (int i = 0; i < n; i++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    result.clear();
+    ASSERT_EQ(DB_SUCCESS, index->ScanKey(Row(fields), result, nullptr));
+    ASSERT_TRUE(result[0] == rids[i]);
+  }
+  // the bulk loaded tree keeps working under inserts and removes
+  for (int i = n; i < n + 5000; i++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    ASSERT_EQ(DB_SUCCESS, index->InsertEntry(Row(fields), RowId(i, 0), nullptr));
+  }
+  for (int i = 0; i < n; i += 2) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    ASSERT_EQ(DB_SUCCESS, index->RemoveEntry(Row(fields), rids[i], nullptr));
+  }
+  for (int i = 0; i < n + 5000; i++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    result.clear();
+    ASSERT_EQ(i < n && i % 2 == 0 ? DB_KEY_NOT_FOUND : DB_SUCCESS, index->ScanKey(Row(fields), result, nullptr));
+  }
+  ASSERT_TRUE(bpm->CheckAllUnpinned());
+  delete index;
+  delete name_index;
+  delete key_schema;
+  delete name_schema;
+  delete table_heap;
+  delete bpm;
+  delete disk_mgr;
+}
+
+TEST(BPlusTreeBulkLoadTest, NonUniqueBuildTest) {
+  remove(db_name.c_str());
+  auto disk_mgr = new DiskManager(db_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  page_id_t id;
+  ASSERT_TRUE(bpm->NewPage(id) != nullptr && id == CATALOG_META_PAGE_ID);
+  ASSERT_TRUE(bpm->NewPage(id) != nullptr && id == INDEX_ROOTS_PAGE_ID);
+  bpm->UnpinPage(CATALOG_META_PAGE_ID, true);
+  bpm->UnpinPage(INDEX_ROOTS_PAGE_ID, true);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("grade", TypeId::kTypeInt, 1, false, false)};
+  TableSchema table_schema(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm, &table_schema, nullptr, nullptr, nullptr);
+  // grade 只有 10 个不同的值，每个值 2000 行，posting list 跨越多个页面
+  const int n = 20000, grades = 10;
+  std::vector<std::vector<RowId>> rids(grades);
+  for (int i = 0; i < n; i++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeInt, (i * 7) % grades)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids[(i * 7) % grades].push_back(row.GetRowId());
+  }
+  auto *key_schema = Schema::ShallowCopySchema(&table_schema, {1});
+  IndexBuildOptions options;
+  options.sort_memory_ = 64 << 10;
+  // 唯一索引建不起来
+  auto *unique_index = new BPlusTreeIndex(0, key_schema, 16, bpm);
+  ASSERT_EQ(DB_FAILED, unique_index->Build(table_heap, {1}, options, nullptr));
+  auto *index = new BPlusTreeIndex(1, key_schema, 16, bpm, false);
+  ASSERT_EQ(DB_SUCCESS, index->Build(table_heap, {1}, options, nullptr));
+  ASSERT_TRUE(bpm->CheckAllUnpinned());
+  std::vector<RowId> result;
+  for (int g = 0; g < grades; g++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, g)};
+    result.clear();
+    ASSERT_EQ(DB_SUCCESS, index->ScanKey(Row(fields), result, nullptr));
+    ASSERT_EQ(rids[g].size(), result.size());
+    for (size_t i = 0; i < result.size(); i++) {
+      ASSERT_TRUE(result[i] == rids[g][i]);
+    }
+  }
+  std::vector<Field> fields{Field(TypeId::kTypeInt, 3)};
+  result.clear();
+  ASSERT_EQ(DB_SUCCESS, index->ScanKey(Row(fields), result, nullptr, ">="));
+  ASSERT_EQ(n * 7 / grades, result.size());
+  result.clear();
+  ASSERT_EQ(DB_SUCCESS, index->ScanKey(Row(fields), result, nullptr, "<>"));
+  ASSERT_EQ(n - n / grades, result.size());
+  // 删除一行只影响它自己
+  ASSERT_EQ(DB_SUCCESS, index->InsertEntry(Row(fields), RowId(n, 0), nullptr));
+  ASSERT_EQ(DB_FAILED, index->InsertEntry(Row(fields), RowId(n, 0), nullptr));
+  ASSERT_EQ(DB_SUCCESS, index->RemoveEntry(Row(fields), rids[3][0], nullptr));
+  result.clear();
+  ASSERT_EQ(DB_SUCCESS, index->ScanKey(Row(fields), result, nullptr));
+  ASSERT_EQ(rids[3].size(), result.size());
+  ASSERT_TRUE(result.back() == RowId(n, 0));
+  ASSERT_TRUE(bpm->CheckAllUnpinned());
+  index->Destroy();
+  delete index;
+  delete unique_index;
+  delete key_schema;
+  delete table_heap;
+  delete bpm;
+  delete disk_mgr;
+}
+
+TEST(BPlusTreeBulkLoadTest, ParallelBuildTest) {
+  remove(db_name.c_str());
+  auto disk_mgr = new DiskManager(db_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  page_id_t id;
+  ASSERT_TRUE(bpm->NewPage(id) != nullptr && id == CATALOG_META_PAGE_ID);
+  ASSERT_TRUE(bpm->NewPage(id) != nullptr && id == INDEX_ROOTS_PAGE_ID);
+  bpm->UnpinPage(CATALOG_META_PAGE_ID, true);
+  bpm->UnpinPage(INDEX_ROOTS_PAGE_ID, true);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 32, 1, true, false)};
+  TableSchema table_schema(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm, &table_schema, nullptr, nullptr, nullptr);
+  const int n = 50000;
+  std::vector<int> ids(n);
+  for (int i = 0; i < n; i++) {
+    ids[i] = i;
+  }
+  ShuffleArray(ids);
+  std::vector<RowId> rids(n);
+  for (int i = 0; i < n; i++) {
+    std::string name = "name-" + std::to_string(ids[i]);
+    std::vector<Field> fields{Field(TypeId::kTypeInt, ids[i]),
+                              Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.length(), true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids[ids[i]] = row.GetRowId();
+  }
+  auto *key_schema = Schema::ShallowCopySchema(&table_schema, {0});
+  for (uint32_t threads : {1, 2, 4, 8}) {
+    IndexBuildOptions options;
+    IndexBuildStats stats;
+    options.threads_ = threads;
+    options.sort_memory_ = 128 << 10;
+    options.stats_ = &stats;
+    auto *index = new BPlusTreeIndex(threads, key_schema, 16, bpm);
+    ASSERT_EQ(DB_SUCCESS, index->Build(table_heap, {0}, options, nullptr));
+    ASSERT_EQ(threads, stats.threads_);
+    ASSERT_EQ(n, stats.entries_);
+    ASSERT_GT(stats.spilled_runs_, 0);
+    ASSERT_EQ(4, stats.phases_.size());
+    ASSERT_EQ("scan", stats.phases_[0].first);
+    ASSERT_EQ("sort", stats.phases_[1].first);
+    ASSERT_EQ("merge", stats.phases_[2].first);
+    ASSERT_EQ("load", stats.phases_[3].first);
+    std::cout << threads << " threads:";
+    for (auto &phase : stats.phases_) {
+      std::cout << " " << phase.first << " " << phase.second << " ms";
+    }
+    std::cout << std::endl;
+    int count = 0;
+    for (auto it = index->GetBeginIterator(); it != index->GetEndIterator(); ++it) {
+      ASSERT_TRUE((*it).second == rids[count]);
+      count++;
+    }
+    ASSERT_EQ(n, count);
+    ASSERT_TRUE(bpm->CheckAllUnpinned());
+    index->Destroy();
+    delete index;
+  }
+  delete key_schema;
+  delete table_heap;
+  delete bpm;
+  delete disk_mgr;
+}
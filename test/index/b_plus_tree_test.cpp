@@ -1,5 +1,10 @@
 #include "index/b_plus_tree.h"
 
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <thread>
+
 #include "common/instance.h"
 #include "gtest/gtest.h"
 #include "index/comparator.h"
@@ -266,4 +271,272 @@ TEST(BPlusTreeTests, GeneralSampleTest) {
     tree.Remove(keys[2 * i + 1]);
     ASSERT_FALSE(tree.GetValue(keys[2 * i + 1], ans));
   }
-}
\ No newline at end of file
+}
+// Concurrent inserts, lookups and removes on interleaved keys, so that the threads split and merge the same leaves,
+// while another thread keeps scanning the leaf chain.
+TEST(BPlusTreeTests, ConcurrentStressTest) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {
+      new Column("int", TypeId::kTypeInt, 0, false, false),
+  };
+  Schema *table_schema = new Schema(columns);
+  KeyManager KP(table_schema, 17);
+  // small pages for many splits and merges
+  BPlusTree tree(0, engine.bpm_, KP, 16, 16);
+  const int thread_nums = 8;
+  const int n = 40000;
+  vector<GenericKey *> keys;
+  for (int i = 0; i < n; i++) {
+    GenericKey *key = KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    KP.SerializeFromKey(key, Row(fields), table_schema);
+    keys.push_back(key);
+  }
+  std::atomic<bool> done{false};
+  std::atomic<int> scan_errors{0};
+  // keys come out of the leaf chain in ascending order, the row ids were chosen to follow them
+  std::thread scanner([&]() {
+    while (!done) {
+      int64_t last = -1;
+      for (auto it = tree.Begin(); it != tree.End(); ++it) {
+        int64_t current = (*it).second.Get();
+        if (current <= last) {
+          scan_errors++;
+        }
+        last = current;
+      }
+    }
+  });
+  auto run = [&](auto work) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_nums; t++) {
+      threads.emplace_back([&, t]() {
+        for (int i = t; i < n; i += thread_nums) {
+          work(i);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  };
+  std::atomic<int> errors{0};
+  run([&](int i) {
+    vector<RowId> ans;
+    if (!tree.Insert(keys[i], RowId(i)) || !tree.GetValue(keys[i], ans) || !(ans[0] == RowId(i))) {
+      errors++;
+    }
+  });
+  ASSERT_EQ(0, errors);
+  run([&](int i) {
+    vector<RowId> ans;
+    if (i % 2 == 0) {
+      tree.Remove(keys[i]);
+      if (tree.GetValue(keys[i], ans)) {
+        errors++;
+      }
+    } else if (!tree.GetValue(keys[i], ans)) {
+      errors++;
+    }
+  });
+  done = true;
+  scanner.join();
+  ASSERT_EQ(0, errors);
+  ASSERT_EQ(0, scan_errors);
+  int64_t expected = 1;
+  for (auto it = tree.Begin(); it != tree.End(); ++it) {
+    ASSERT_EQ(expected, (*it).second.Get());
+    expected += 2;
+  }
+  ASSERT_EQ(n + 1, expected);
+  ASSERT_TRUE(tree.Check());
+  for (auto key : keys) {
+    free(key);
+  }
+}
+
+// Throughput of concurrent inserts and point lookups with 1 to 32 threads, each run on a new tree.
+TEST(BPlusTreeTests, ConcurrentThroughputBenchmark) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {
+      new Column("int", TypeId::kTypeInt, 0, false, false),
+  };
+  Schema *table_schema = new Schema(columns);
+  KeyManager KP(table_schema, 17);
+  const int n = 64000;
+  vector<GenericKey *> keys;
+  for (int i = 0; i < n; i++) {
+    GenericKey *key = KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    KP.SerializeFromKey(key, Row(fields), table_schema);
+    keys.push_back(key);
+  }
+  ShuffleArray(keys);
+  for (int thread_nums = 1; thread_nums <= 32; thread_nums *= 2) {
+    BPlusTree tree(thread_nums, engine.bpm_, KP);
+    auto run = [&](auto work) {
+      auto start = std::chrono::steady_clock::now();
+      std::vector<std::thread> threads;
+      for (int t = 0; t < thread_nums; t++) {
+        threads.emplace_back([&, t]() {
+          for (int i = t; i < n; i += thread_nums) {
+            work(i);
+          }
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      return n / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    std::atomic<int> found{0};
+    double insert_ops = run([&](int i) { tree.Insert(keys[i], RowId(i)); });
+    double lookup_ops = run([&](int i) {
+      vector<RowId> ans;
+      if (tree.GetValue(keys[i], ans)) {
+        found++;
+      }
+    });
+    std::cout << thread_nums << " threads: " << static_cast<int64_t>(insert_ops) << " inserts/s, "
+              << static_cast<int64_t>(lookup_ops) << " lookups/s" << std::endl;
+    ASSERT_EQ(n, found);
+    ASSERT_TRUE(tree.Check());
+    tree.Destroy();
+  }
+  for (auto key : keys) {
+    free(key);
+  }
+}
+
+// 非唯一索引：一个键对应很多行时 posting list 跨越多个页面
+TEST(BPlusTreeTests, NonUniqueTest) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {
+      new Column("int", TypeId::kTypeInt, 0, false, false),
+  };
+  Schema *table_schema = new Schema(columns);
+  KeyManager KP(table_schema, 17);
+  BPlusTree tree(0, engine.bpm_, KP, UNDEFINED_SIZE, UNDEFINED_SIZE, false);
+  // 每 50 个键有一个对应 1200 行，其余对应 1 到 3 行
+  const int n = 1000;
+  vector<GenericKey *> keys;
+  vector<std::pair<int, RowId>> entries;
+  for (int i = 0; i < n; i++) {
+    GenericKey *key = KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    KP.SerializeFromKey(key, Row(fields), table_schema);
+    keys.push_back(key);
+    int count = i % 50 == 0 ? 1200 : 1 + i % 3;
+    for (int j = 0; j < count; j++) {
+      entries.emplace_back(i, RowId(j + 1, i));
+    }
+  }
+  ShuffleArray(entries);
+  for (auto &entry : entries) {
+    ASSERT_TRUE(tree.Insert(keys[entry.first], entry.second));
+  }
+  // 相同的键和行号不能重复插入
+  ASSERT_FALSE(tree.Insert(keys[0], RowId(1, 0)));
+  ASSERT_FALSE(tree.Insert(keys[1], RowId(1, 1)));
+  ASSERT_TRUE(tree.Check());
+  for (int i = 0; i < n; i++) {
+    vector<RowId> ans;
+    ASSERT_TRUE(tree.GetValue(keys[i], ans));
+    ASSERT_EQ(i % 50 == 0 ? 1200 : 1 + i % 3, ans.size());
+    for (size_t j = 0; j < ans.size(); j++) {
+      ASSERT_EQ(RowId(j + 1, i), ans[j]);
+    }
+  }
+  // 偶数键删到只剩最后一行，奇数键整个删除
+  ShuffleArray(entries);
+  for (auto &entry : entries) {
+    int count = entry.first % 50 == 0 ? 1200 : 1 + entry.first % 3;
+    if (entry.first % 2 == 0 && entry.second.GetPageId() != count) {
+      tree.Remove(keys[entry.first], entry.second);
+    }
+  }
+  for (int i = 1; i < n; i += 2) {
+    tree.Remove(keys[i]);
+  }
+  ASSERT_TRUE(tree.Check());
+  for (int i = 0; i < n; i++) {
+    vector<RowId> ans;
+    ASSERT_EQ(i % 2 == 0, tree.GetValue(keys[i], ans));
+    if (i % 2 == 0) {
+      ASSERT_EQ(1, ans.size());
+      ASSERT_EQ(RowId(i % 50 == 0 ? 1200 : 1 + i % 3, i), ans[0]);
+    }
+  }
+  // 删除最后一行时键也被删除
+  for (int i = 0; i < n; i += 2) {
+    tree.Remove(keys[i], RowId(i % 50 == 0 ? 1200 : 1 + i % 3, i));
+  }
+  ASSERT_TRUE(tree.IsEmpty() || tree.Begin() == tree.End());
+  ASSERT_TRUE(engine.bpm_->CheckAllUnpinned());
+  for (auto key : keys) {
+    free(key);
+  }
+  delete table_schema;
+}
+
+// 长字符串键：叶子压缩公共前缀、内部页面只存截断后的分隔键，树要比按完整键长度存放时矮
+TEST(BPlusTreeTests, StringKeyTest) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {
+      new Column("name", TypeId::kTypeChar, 255, 0, false, false),
+  };
+  Schema *table_schema = new Schema(columns);
+  KeyManager KP(table_schema, 512);
+  BPlusTree tree(0, engine.bpm_, KP);
+  const int n = 20000;
+  vector<GenericKey *> keys;
+  for (int i = 0; i < n; i++) {
+    char name[32];
+    snprintf(name, sizeof(name), "customer-%06d", i);
+    GenericKey *key = KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeChar, name, strlen(name), true)};
+    KP.SerializeFromKey(key, Row(fields), table_schema);
+    keys.push_back(key);
+  }
+  vector<int> order(n);
+  for (int i = 0; i < n; i++) {
+    order[i] = i;
+  }
+  ShuffleArray(order);
+  for (int i : order) {
+    ASSERT_TRUE(tree.Insert(keys[i], RowId(i)));
+  }
+  ASSERT_TRUE(tree.Check());
+  // 每次查找从根到叶子每层取一个页面。完整的键每页只放得下七个，树会有六层左右；
+  // 只存键实际用到的字节时一个叶子放得下两百个左右，根就是叶子的父节点
+  vector<RowId> ans;
+  auto before = engine.bpm_->GetStats();
+  ASSERT_TRUE(tree.GetValue(keys[n / 2], ans));
+  auto after = engine.bpm_->GetStats();
+  ASSERT_LE(after.fetch_hits_ + after.fetch_misses_ - before.fetch_hits_ - before.fetch_misses_, 2);
+  ASSERT_EQ(RowId(n / 2), ans[0]);
+
+  // 随机删除一半，剩下的键仍然能找到，并且按顺序扫描出来
+  std::set<int> remain(order.begin(), order.end());
+  for (int j = 0; j < n / 2; j++) {
+    tree.Remove(keys[order[j]]);
+    remain.erase(order[j]);
+  }
+  ASSERT_TRUE(tree.Check());
+  auto expect = remain.begin();
+  for (auto it = tree.Begin(); it != tree.End(); ++it, ++expect) {
+    ASSERT_NE(remain.end(), expect);
+    ASSERT_EQ(0, KP.CompareKeys((*it).first, keys[*expect]));
+    ASSERT_EQ(RowId(*expect), (*it).second);
+  }
+  ASSERT_EQ(remain.end(), expect);
+  for (int i = 0; i < n; i++) {
+    ans.clear();
+    ASSERT_EQ(remain.count(i) == 1, tree.GetValue(keys[i], ans));
+  }
+  ASSERT_TRUE(engine.bpm_->CheckAllUnpinned());
+  for (auto key : keys) {
+    free(key);
+  }
+  delete table_schema;
+}
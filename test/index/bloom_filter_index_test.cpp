@@ -0,0 +1,99 @@
+#include "index/bloom_filter_index.h"
+
+#include <string>
+#include <vector>
+
+#include "common/instance.h"
+#include "gtest/gtest.h"
+
+static const std::string db_name = "bloom_filter_index_test.db";
+
+TEST(BloomFilterIndexTest, SkipPageRangesTest) {
+  remove(db_name.c_str());
+  auto disk_mgr = new DiskManager(db_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 32, 1, true, false)};
+  TableSchema table_schema(columns);
+  auto *key_schema = Schema::ShallowCopySchema(&table_schema, {1});
+  TableHeap *table_heap = TableHeap::Create(bpm, &table_schema, nullptr, nullptr, nullptr);
+  auto make_row = [](int id, std::string &name) {
+    name = "name-" + std::to_string(id);
+    std::vector<Field> fields;
+    fields.emplace_back(TypeId::kTypeInt, id);
+    fields.emplace_back(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.length(), true);
+    return Row(fields);
+  };
+  const int row_nums = 4000;
+  std::vector<RowId> rids;
+  std::string name;
+  // 前一半的行在建索引时扫描加入，后一半在插入时加入
+  for (int i = 0; i < row_nums / 2; i++) {
+    Row row = make_row(i, name);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  auto index = new BloomFilterIndex(0, key_schema, &table_schema, table_heap);
+  IndexBuildStats stats;
+  IndexBuildOptions options;
+  options.stats_ = &stats;
+  ASSERT_EQ(DB_SUCCESS, index->Build(table_heap, {1}, options, nullptr));
+  ASSERT_EQ(row_nums / 2, stats.entries_);
+  for (int i = row_nums / 2; i < row_nums; i++) {
+    Row row = make_row(i, name);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+    Row key;
+    row.GetKeyFromRow(&table_schema, key_schema, key);
+    ASSERT_EQ(DB_SUCCESS, index->InsertEntry(key, row.GetRowId(), nullptr));
+  }
+  ASSERT_GT(rids.back().GetPageId() / BloomFilterIndex::PAGES_PER_RANGE,
+            rids.front().GetPageId() / BloomFilterIndex::PAGES_PER_RANGE);
+  // no false negative
+  uint64_t hash;
+  for (int i = 0; i < row_nums; i++) {
+    std::vector<Field> fields;
+    make_row(i, name);
+    fields.emplace_back(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.length(), true);
+    ASSERT_TRUE(BloomFilterIndex::HashKey(Row(fields), &hash));
+    ASSERT_TRUE(index->MayContain(rids[i].GetPageId(), hash));
+  }
+  // a null key matches nothing
+  std::vector<Field> null_fields;
+  null_fields.emplace_back(TypeId::kTypeChar);
+  ASSERT_FALSE(BloomFilterIndex::HashKey(Row(null_fields), &hash));
+  // a scan for one key only reads the page range holding it
+  auto scan = [&](const std::string &target, uint32_t *skipped) {
+    std::vector<Field> fields;
+    fields.emplace_back(TypeId::kTypeChar, const_cast<char *>(target.c_str()), target.length(), true);
+    uint64_t target_hash;
+    EXPECT_TRUE(BloomFilterIndex::HashKey(Row(fields), &target_hash));
+    int found = 0;
+    auto it = table_heap->ViewBegin(nullptr, nullptr,
+                                    [&](page_id_t page_id) { return index->MayContain(page_id, target_hash); });
+    for (; !it.IsEnd(); ++it) {
+      if (it->GetField(1).CompareEquals(fields[0]) == CmpBool::kTrue) {
+        found++;
+      }
+    }
+    *skipped = it.GetSkippedPageCount();
+    return found;
+  };
+  uint32_t skipped;
+  ASSERT_EQ(1, scan("name-1234", &skipped));
+  ASSERT_GT(skipped, 0);
+  ASSERT_EQ(0, scan("missing", &skipped));
+  ASSERT_GT(skipped, 0);
+  // rebuilding starts over from the rows of the table
+  ASSERT_TRUE(table_heap->MarkDelete(rids[1234], nullptr));
+  table_heap->ApplyDelete(rids[1234], nullptr);
+  index->Rebuild();
+  ASSERT_EQ(0, scan("name-1234", &skipped));
+  ASSERT_EQ(1, scan("name-3999", &skipped));
+  delete index;
+  delete key_schema;
+  delete table_heap;
+  delete bpm;
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
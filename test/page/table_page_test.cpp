@@ -0,0 +1,143 @@
+#include "page/table_page.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "record/row_view.h"
+#include "record/schema.h"
+
+static std::shared_ptr<Schema> MakeSchema() {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 16, 1, true, false)};
+  return std::make_shared<Schema>(columns);
+}
+
+static Row MakeRow(int id, const std::string &name = "minisql") {
+  std::vector<Field> fields = {Field(TypeId::kTypeInt, id),
+                               Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.size(), false)};
+  return Row(fields);
+}
+
+static void ExpectRowId(TablePage &page, Schema *schema, const RowId &rid, int id) {
+  Row row(rid);
+  ASSERT_TRUE(page.GetTuple(&row, schema, nullptr, nullptr));
+  ASSERT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, id)));
+}
+
+TEST(PageTests, TablePageFreeSlotTest) {
+  auto schema = MakeSchema();
+  TablePage page;
+  page.Init(0, INVALID_PAGE_ID, nullptr, nullptr);
+  std::vector<RowId> rids;
+  for (int i = 0; i < 10; i++) {
+    Row row = MakeRow(i);
+    ASSERT_TRUE(page.InsertTuple(row, schema.get(), nullptr, nullptr, nullptr));
+    ASSERT_EQ(i, row.GetRowId().GetSlotNum());
+    rids.push_back(row.GetRowId());
+  }
+  for (int slot : {2, 5, 7}) {
+    ASSERT_TRUE(page.MarkDelete(rids[slot], nullptr, nullptr, nullptr));
+    page.ApplyDelete(rids[slot], nullptr, nullptr);
+  }
+  // Scenario: freed slots are handed out again, most recently freed first, before new slots are appended.
+  for (uint32_t expected_slot : {7, 5, 2, 10}) {
+    Row row = MakeRow(100 + expected_slot);
+    ASSERT_TRUE(page.InsertTuple(row, schema.get(), nullptr, nullptr, nullptr));
+    ASSERT_EQ(expected_slot, row.GetRowId().GetSlotNum());
+    ExpectRowId(page, schema.get(), row.GetRowId(), 100 + expected_slot);
+  }
+  for (int slot : {0, 1, 3, 4, 6, 8, 9}) {
+    ExpectRowId(page, schema.get(), rids[slot], slot);
+  }
+}
+
+TEST(PageTests, TablePageVersionUpgradeTest) {
+  auto schema = MakeSchema();
+  TablePage page;
+  // Build a version 0 page by hand: slot 0 is empty, slot 1 holds a row.
+  char *data = page.GetData();
+  Row old_row = MakeRow(1);
+  uint32_t row_size = old_row.GetSerializedSize(schema.get());
+  uint32_t free_space_pointer = PAGE_SIZE - row_size;
+  old_row.SerializeTo(data + free_space_pointer, schema.get());
+  uint32_t header[6] = {3, 0, static_cast<uint32_t>(INVALID_PAGE_ID), static_cast<uint32_t>(INVALID_PAGE_ID),
+                        free_space_pointer, 2};
+  uint32_t slots[4] = {0, 0, free_space_pointer, row_size};
+  memcpy(data, header, sizeof(header));
+  memcpy(data + sizeof(header), slots, sizeof(slots));
+
+  ExpectRowId(page, schema.get(), RowId(3, 1), 1);
+  RowId rid;
+  ASSERT_TRUE(page.GetFirstTupleRid(&rid));
+  ASSERT_EQ(RowId(3, 1), rid);
+
+  // Scenario: the first insert upgrades the page and reuses the empty slot found while building the chain.
+  Row new_row = MakeRow(2);
+  ASSERT_TRUE(page.InsertTuple(new_row, schema.get(), nullptr, nullptr, nullptr));
+  ASSERT_EQ(RowId(3, 0), new_row.GetRowId());
+  ExpectRowId(page, schema.get(), RowId(3, 0), 2);
+  ExpectRowId(page, schema.get(), RowId(3, 1), 1);
+  Row appended = MakeRow(3);
+  ASSERT_TRUE(page.InsertTuple(appended, schema.get(), nullptr, nullptr, nullptr));
+  ASSERT_EQ(RowId(3, 2), appended.GetRowId());
+
+  // Scenario: rows written in the v1 format stay readable and are converted to v2 when rewritten.
+  RowView view;
+  ASSERT_TRUE(page.GetTupleView(RowId(3, 1), schema.get(), &view));
+  ASSERT_EQ(RowFormat::kV1, view.GetFormat());
+  ASSERT_TRUE(page.GetTupleView(RowId(3, 0), schema.get(), &view));
+  ASSERT_EQ(RowFormat::kV2, view.GetFormat());
+  Row updated = MakeRow(4);
+  Row stored(RowId(3, 1));
+  ASSERT_TRUE(page.UpdateTuple(updated, &stored, schema.get(), nullptr, nullptr, nullptr));
+  ASSERT_EQ(CmpBool::kTrue, stored.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, 1)));
+  ASSERT_TRUE(page.GetTupleView(RowId(3, 1), schema.get(), &view));
+  ASSERT_EQ(RowFormat::kV2, view.GetFormat());
+  ExpectRowId(page, schema.get(), RowId(3, 1), 4);
+}
+
+TEST(PageTests, TablePageCompactionTest) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 512, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TablePage page;
+  page.Init(0, INVALID_PAGE_ID, nullptr, nullptr);
+  std::vector<RowId> rids;
+  while (true) {
+    Row row = MakeRow(rids.size(), std::string(100, 'a'));
+    if (!page.InsertTuple(row, schema.get(), nullptr, nullptr, nullptr)) {
+      break;
+    }
+    rids.push_back(row.GetRowId());
+  }
+  ASSERT_GT(rids.size(), 10);
+  for (size_t i = 0; i < rids.size(); i += 2) {
+    ASSERT_TRUE(page.MarkDelete(rids[i], nullptr, nullptr, nullptr));
+    page.ApplyDelete(rids[i], nullptr, nullptr);
+  }
+  // Scenario: a row twice as large only fits once the holes left by the deletes are merged.
+  Row large = MakeRow(-1, std::string(250, 'b'));
+  ASSERT_TRUE(page.InsertTuple(large, schema.get(), nullptr, nullptr, nullptr));
+  ExpectRowId(page, schema.get(), large.GetRowId(), -1);
+  for (size_t i = 1; i < rids.size(); i += 2) {
+    ExpectRowId(page, schema.get(), rids[i], i);
+  }
+
+  // Scenario: a shrinking update leaves a hole, a growing update of another row fits thanks to that hole.
+  Row small = MakeRow(1, "c");
+  Row old_small(rids[1]);
+  ASSERT_TRUE(page.UpdateTuple(small, &old_small, schema.get(), nullptr, nullptr, nullptr));
+  std::string grown_name(150, 'd');
+  Row grown = MakeRow(3, grown_name);
+  Row old_grown(rids[3]);
+  ASSERT_TRUE(page.UpdateTuple(grown, &old_grown, schema.get(), nullptr, nullptr, nullptr));
+  Row result(rids[3]);
+  ASSERT_TRUE(page.GetTuple(&result, schema.get(), nullptr, nullptr));
+  Field expected(TypeId::kTypeChar, const_cast<char *>(grown_name.c_str()), grown_name.size(), false);
+  ASSERT_EQ(CmpBool::kTrue, result.GetField(1)->CompareEquals(expected));
+  for (size_t i = 1; i < rids.size(); i += 2) {
+    ExpectRowId(page, schema.get(), rids[i], i);
+  }
+}
@@ -1,10 +1,13 @@
 #include <cstring>
+#include <memory>
 
 #include "common/instance.h"
 #include "gtest/gtest.h"
 #include "page/table_page.h"
 #include "record/field.h"
 #include "record/row.h"
+#include "record/row_codec.h"
+#include "record/row_view.h"
 #include "record/schema.h"
 
 char *chars[] = {const_cast<char *>(""), const_cast<char *>("hello"), const_cast<char *>("world!"),
@@ -100,4 +103,182 @@ TEST(TupleTest, RowTest) {
   }
   ASSERT_TRUE(table_page.MarkDelete(row.GetRowId(), nullptr, nullptr, nullptr));
   table_page.ApplyDelete(row.GetRowId(), nullptr, nullptr);
-}
\ No newline at end of file
+}
+TEST(TupleTest, RowViewTest) {
+  TablePage table_page;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 2, true, false)};
+  std::vector<Field> fields = {Field(TypeId::kTypeInt, 188), Field(TypeId::kTypeChar),
+                               Field(TypeId::kTypeFloat, 19.99f)};
+  std::vector<Field> fields2 = {Field(TypeId::kTypeInt, 189),
+                                Field(TypeId::kTypeChar, const_cast<char *>("minisql"), strlen("minisql"), false),
+                                Field(TypeId::kTypeFloat, -2.33f)};
+  auto schema = std::make_shared<Schema>(columns);
+  Row row(fields);
+  Row row2(fields2);
+  table_page.Init(0, INVALID_PAGE_ID, nullptr, nullptr);
+  ASSERT_TRUE(table_page.InsertTuple(row, schema.get(), nullptr, nullptr, nullptr));
+  ASSERT_TRUE(table_page.InsertTuple(row2, schema.get(), nullptr, nullptr, nullptr));
+  // Scenario: fields read from the view match the inserted ones, nulls included, char values point into the page.
+  RowView view;
+  ASSERT_TRUE(table_page.GetTupleView(row2.GetRowId(), schema.get(), &view));
+  ASSERT_EQ(row2.GetRowId(), view.GetRowId());
+  ASSERT_EQ(3, view.GetFieldCount());
+  Field name = view.GetField(1);
+  ASSERT_EQ(CmpBool::kTrue, name.CompareEquals(fields2[1]));
+  ASSERT_GT(name.GetData(), table_page.GetData());
+  ASSERT_LT(name.GetData(), table_page.GetData() + PAGE_SIZE);
+  ASSERT_EQ(CmpBool::kTrue, view.GetField(2).CompareEquals(fields2[2]));
+  // Scenario: the same view is pointed at another row, a materialized row keeps its values after the view moves on.
+  Row projected;
+  view.Materialize(&projected, {2, 0});
+  ASSERT_TRUE(table_page.GetTupleView(row.GetRowId(), schema.get(), &view));
+  ASSERT_TRUE(view.IsNull(1));
+  ASSERT_EQ(CmpBool::kTrue, view.GetField(2).CompareEquals(fields[2]));
+  ASSERT_EQ(2, projected.GetFieldCount());
+  ASSERT_EQ(CmpBool::kTrue, projected.GetField(0)->CompareEquals(fields2[2]));
+  ASSERT_EQ(CmpBool::kTrue, projected.GetField(1)->CompareEquals(fields2[0]));
+  Row full;
+  view.Materialize(&full);
+  ASSERT_EQ(row.GetRowId(), full.GetRowId());
+  ASSERT_TRUE(full.GetField(1)->IsNull());
+  ASSERT_EQ(CmpBool::kTrue, full.GetField(0)->CompareEquals(fields[0]));
+}
+
+TEST(TupleTest, RowFormatTest) {
+  std::vector<Column *> columns = {new Column("name", TypeId::kTypeChar, 64, 0, true, false),
+                                   new Column("id", TypeId::kTypeInt, 1, false, false),
+                                   new Column("note", TypeId::kTypeChar, 64, 2, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 3, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  ASSERT_EQ(8, schema->GetFixedAreaSize());
+  ASSERT_EQ(2, schema->GetVarLengthCount());
+  ASSERT_FALSE(schema->IsFixedLength(2));
+  ASSERT_EQ(1, schema->GetLayoutSlot(2));
+  ASSERT_EQ(4, schema->GetLayoutSlot(3));
+  std::vector<std::vector<Field *>> rows = {{&char_fields[1], &int_fields[0], &char_fields[2], &float_fields[0]},
+                                            {&null_fields[2], &null_fields[0], &char_fields[0], &float_fields[1]},
+                                            {&char_fields[3], &int_fields[1], &null_fields[2], &null_fields[1]}};
+  char buf[2][PAGE_SIZE];
+  for (auto &row_fields : rows) {
+    std::vector<Field> fields;
+    for (auto field : row_fields) {
+      fields.emplace_back(*field);
+    }
+    Row row(fields);
+    // Scenario: both formats round trip, v2 adds an offset per char column and keeps room for null fixed columns.
+    uint32_t v1_size = row.SerializeTo(buf[0], schema.get(), RowFormat::kV1);
+    uint32_t v2_size = row.SerializeTo(buf[1], schema.get(), RowFormat::kV2);
+    ASSERT_EQ(row.GetSerializedSize(schema.get(), RowFormat::kV1), v1_size);
+    ASSERT_EQ(row.GetSerializedSize(schema.get(), RowFormat::kV2), v2_size);
+    uint32_t null_fixed = (fields[1].IsNull() ? 4 : 0) + (fields[3].IsNull() ? 4 : 0);
+    ASSERT_EQ(v1_size + 2 * sizeof(uint32_t) + null_fixed, v2_size);
+    for (int format = 0; format < 2; format++) {
+      Row decoded;
+      ASSERT_EQ(format ? v2_size : v1_size, decoded.DeserializeFrom(buf[format], schema.get()));
+      // Scenario: a view reads any field of either format without touching the others.
+      RowView view;
+      view.Reset(buf[format], schema.get(), RowId(0, 0));
+      ASSERT_EQ(format ? RowFormat::kV2 : RowFormat::kV1, view.GetFormat());
+      for (uint32_t i = 4; i-- > 0;) {
+        ASSERT_EQ(fields[i].IsNull(), decoded.GetField(i)->IsNull());
+        ASSERT_EQ(fields[i].IsNull(), view.IsNull(i));
+        if (!fields[i].IsNull()) {
+          ASSERT_EQ(CmpBool::kTrue, decoded.GetField(i)->CompareEquals(fields[i]));
+          ASSERT_EQ(CmpBool::kTrue, view.GetField(i).CompareEquals(fields[i]));
+        }
+      }
+    }
+  }
+}
+
+TEST(TupleTest, RowCodecTest) {
+  std::vector<Column *> fixed_columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                         new Column("account", TypeId::kTypeFloat, 1, false, false)};
+  std::vector<Column *> varchar_columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                           new Column("name", TypeId::kTypeChar, 64, 1, false, false)};
+  std::vector<Column *> nullable_columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                            new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  Schema fixed_schema(fixed_columns);
+  Schema varchar_schema(varchar_columns);
+  Schema nullable_schema(nullable_columns);
+  ASSERT_EQ(RowLayoutKind::kAllFixed, fixed_schema.GetLayoutKind());
+  ASSERT_EQ(RowLayoutKind::kFixedVarchar, varchar_schema.GetLayoutKind());
+  ASSERT_EQ(RowLayoutKind::kNullable, nullable_schema.GetLayoutKind());
+  ASSERT_EQ(RowLayoutKind::kAllFixed, fixed_schema.GetCodec()->kind_);
+  ASSERT_EQ(4 + 1 + 8, fixed_schema.GetFixedRowSize());
+  std::vector<std::pair<Schema *, std::vector<Field *>>> cases = {
+      {&fixed_schema, {&int_fields[1], &float_fields[2]}},
+      {&fixed_schema, {&null_fields[0], &float_fields[3]}},
+      {&varchar_schema, {&int_fields[2], &char_fields[2]}},
+      {&varchar_schema, {&int_fields[3], &null_fields[2]}},
+      {&nullable_schema, {&null_fields[0], &char_fields[1]}}};
+  char buf[PAGE_SIZE];
+  for (auto &test_case : cases) {
+    Schema *schema = test_case.first;
+    std::vector<Field> fields;
+    for (auto field : test_case.second) {
+      fields.emplace_back(*field);
+    }
+    Row row(fields);
+    // Scenario: every codec round trips, a null in a NOT NULL column falls back to the nullable codec.
+    uint32_t size = row.SerializeTo(buf, schema, RowFormat::kV2);
+    ASSERT_EQ(row.GetSerializedSize(schema, RowFormat::kV2), size);
+    if (schema == &fixed_schema) {
+      ASSERT_EQ(fixed_schema.GetFixedRowSize(), size);
+    }
+    Row decoded;
+    ASSERT_EQ(size, decoded.DeserializeFrom(buf, schema));
+    for (uint32_t i = 0; i < fields.size(); i++) {
+      ASSERT_EQ(fields[i].IsNull(), decoded.GetField(i)->IsNull());
+      if (!fields[i].IsNull()) {
+        ASSERT_EQ(CmpBool::kTrue, decoded.GetField(i)->CompareEquals(fields[i]));
+      }
+    }
+  }
+}
+
+TEST(TupleTest, RowMoveTest) {
+  MemoryArena arena;
+  std::vector<Field> fields = {Field(int_fields[0]), Field(char_fields[1])};
+  Row row(fields);
+  Field *name = row.GetField(1);
+  // Scenario: moving a row hands over its fields, nothing is copied.
+  Row moved(std::move(row));
+  ASSERT_EQ(0, row.GetFieldCount());
+  ASSERT_EQ(name, moved.GetField(1));
+  std::vector<Row> rows;
+  rows.push_back(std::move(moved));
+  ASSERT_EQ(name, rows[0].GetField(1));
+  // Scenario: fields appended to an arena row live in the arena, a deep copy goes back to the heap.
+  Row arena_row;
+  arena_row.Reset(&arena);
+  arena_row.AppendField(Field(int_fields[1]));
+  arena_row.AppendField(Field(char_fields[2]));
+  ASSERT_EQ(2 * sizeof(Field), arena.GetAllocatedBytes());
+  Row copy(arena_row);
+  ASSERT_EQ(nullptr, copy.GetArena());
+  ASSERT_EQ(CmpBool::kTrue, copy.GetField(1)->CompareEquals(char_fields[2]));
+  rows.push_back(std::move(arena_row));
+  ASSERT_EQ(&arena, rows[1].GetArena());
+  ASSERT_EQ(CmpBool::kTrue, rows[1].GetField(0)->CompareEquals(int_fields[1]));
+  // Scenario: a copy of a row read into an arena keeps its char values once the arena is gone.
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  Schema schema(columns);
+  char buf[PAGE_SIZE];
+  Row stored(fields);
+  stored.SerializeTo(buf, &schema, RowFormat::kV2);
+  auto query_arena = std::make_unique<MemoryArena>();
+  Row scanned;
+  scanned.Reset(query_arena.get());
+  scanned.DeserializeFrom(buf, &schema);
+  Row heap_copy(scanned);
+  Row assigned;
+  assigned = scanned;
+  scanned.Reset(nullptr);
+  query_arena.reset();
+  ASSERT_EQ(CmpBool::kTrue, heap_copy.GetField(1)->CompareEquals(char_fields[1]));
+  ASSERT_EQ(CmpBool::kTrue, assigned.GetField(1)->CompareEquals(char_fields[1]));
+}
@@ -56,4 +56,73 @@ TEST(DiskManagerTest, FreePageAllocationTest) {
   EXPECT_EQ(extent_nums * DiskManager::BITMAP_SIZE - 5, meta_page->GetAllocatedPages());
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 2, meta_page->GetExtentUsedPage(0));
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 3, meta_page->GetExtentUsedPage(1));
-}
\ No newline at end of file
+}
+TEST(DiskManagerTest, PageSizeTest) {
+  std::string db_name = "disk_page_size_test.db";
+  const uint32_t page_size = 16384;
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name, page_size);
+  EXPECT_EQ(page_size, disk_mgr->GetPageSize());
+  EXPECT_EQ(BitmapPage<page_size>::GetMaxSupportedSize(), disk_mgr->GetBitmapSize());
+  char data[page_size];
+  for (uint32_t i = 0; i < 3; i++) {
+    ASSERT_EQ(i, disk_mgr->AllocatePage());
+    memset(data, 'a' + i, page_size);
+    disk_mgr->WritePage(i, data);
+  }
+  disk_mgr->DeAllocatePage(1);
+  disk_mgr->Close();
+  delete disk_mgr;
+
+  // Scenario: the page size recorded in the meta page wins over the constructor argument.
+  disk_mgr = new DiskManager(db_name);
+  EXPECT_EQ(page_size, disk_mgr->GetPageSize());
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+  EXPECT_EQ(2, meta_page->GetAllocatedPages());
+  EXPECT_FALSE(disk_mgr->IsPageFree(0));
+  EXPECT_TRUE(disk_mgr->IsPageFree(1));
+  disk_mgr->ReadPage(2, data);
+  EXPECT_EQ('c', data[0]);
+  EXPECT_EQ('c', data[page_size - 1]);
+  disk_mgr->Close();
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, LegacyMetaPageTest) {
+  std::string db_name = "disk_legacy_test.db";
+  remove(db_name.c_str());
+  // a file written before the page size was recorded: 2 pages allocated in the first extent
+  char meta[PAGE_SIZE] = {0};
+  char bitmap[PAGE_SIZE] = {0};
+  uint32_t legacy_header[3] = {2, 1, 2};
+  memcpy(meta, legacy_header, sizeof(legacy_header));
+  uint32_t ofs;
+  auto *bitmap_page = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmap);
+  ASSERT_TRUE(bitmap_page->AllocatePage(ofs));
+  ASSERT_TRUE(bitmap_page->AllocatePage(ofs));
+  {
+    std::ofstream out(db_name, std::ios::binary);
+    out.write(meta, PAGE_SIZE);
+    out.write(bitmap, PAGE_SIZE);
+  }
+
+  auto *disk_mgr = new DiskManager(db_name, 8192);
+  EXPECT_EQ(PAGE_SIZE, disk_mgr->GetPageSize());
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+  EXPECT_TRUE(meta_page->IsTagged());
+  EXPECT_EQ(2, meta_page->GetAllocatedPages());
+  EXPECT_EQ(1, meta_page->GetExtentNums());
+  EXPECT_EQ(2, meta_page->GetExtentUsedPage(0));
+  EXPECT_EQ(2, disk_mgr->AllocatePage());
+  disk_mgr->Close();
+  delete disk_mgr;
+
+  disk_mgr = new DiskManager(db_name);
+  meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+  EXPECT_TRUE(meta_page->IsTagged());
+  EXPECT_EQ(3, meta_page->GetAllocatedPages());
+  disk_mgr->Close();
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
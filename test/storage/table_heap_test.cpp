@@ -1,5 +1,6 @@
 #include "storage/table_heap.h"
 
+#include <algorithm>
 #include <unordered_map>
 #include <vector>
 
@@ -61,3 +62,359 @@ TEST(TableHeapTest, TableHeapSampleTest) {
   }
   ASSERT_EQ(size, 0);
 }
+
+TEST(TableHeapTest, LargePageTest) {
+  const std::string db_name = "table_heap_large_page_test.db";
+  remove(db_name.c_str());
+  auto disk_mgr = new DiskManager(db_name, 16384);
+  auto bpm = new BufferPoolManager(64, disk_mgr);
+  const uint32_t name_len = 10000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, name_len, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  // 10000 bytes rows do not fit into a 4KB page, with 16KB pages each page holds one of them
+  std::string name(name_len, 'x');
+  std::vector<RowId> rids;
+  for (int i = 0; i < 5; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name_len, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  for (int i = 0; i < 5; i++) {
+    Row row(rids[i]);
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    ASSERT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, i)));
+  }
+  // a value wider than a page is kept in overflow pages
+  std::string too_wide(TablePage::MaxRowSize(16384), 'y');
+  Fields fields{Field(TypeId::kTypeInt, 5),
+                Field(TypeId::kTypeChar, const_cast<char *>(too_wide.c_str()), too_wide.size(), true)};
+  Row row(fields);
+  ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  Row wide(row.GetRowId());
+  ASSERT_TRUE(table_heap->GetTuple(&wide, nullptr));
+  ASSERT_EQ(too_wide.size(), wide.GetField(1)->GetLength());
+
+  delete table_heap;
+  delete bpm;
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(TableHeapTest, RelocateGrowingRowTest) {
+  const std::string db_name = "table_heap_relocate_test.db";
+  remove(db_name.c_str());
+  auto disk_mgr = new DiskManager(db_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  // values stay below the overflow limit, so a row grows inside its page
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("a", TypeId::kTypeChar, 1000, 1, true, false),
+                                   new Column("b", TypeId::kTypeChar, 1000, 2, true, false),
+                                   new Column("c", TypeId::kTypeChar, 1000, 3, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  auto make_row = [](int id, size_t a, size_t b, size_t c) {
+    std::string va(a, 'a'), vb(b, 'b'), vc(c, 'c');
+    Fields fields{Field(TypeId::kTypeInt, id), Field(TypeId::kTypeChar, const_cast<char *>(va.c_str()), a, true),
+                  Field(TypeId::kTypeChar, const_cast<char *>(vb.c_str()), b, true),
+                  Field(TypeId::kTypeChar, const_cast<char *>(vc.c_str()), c, true)};
+    return Row(fields);
+  };
+  auto row_length = [](const Row &row) {
+    return row.GetField(1)->GetLength() + row.GetField(2)->GetLength() + row.GetField(3)->GetLength();
+  };
+  auto scan = [&]() {
+    std::unordered_map<int64_t, size_t> rows;
+    for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+      EXPECT_TRUE(rows.emplace(it->GetRowId().Get(), row_length(*it)).second);
+    }
+    return rows;
+  };
+  auto scan_views = [&]() {
+    std::unordered_map<int64_t, size_t> rows;
+    for (auto it = table_heap->ViewBegin(nullptr); !it.IsEnd(); ++it) {
+      size_t length = it->GetField(1).GetLength() + it->GetField(2).GetLength() + it->GetField(3).GetLength();
+      EXPECT_TRUE(rows.emplace(it->GetRowId().Get(), length).second);
+    }
+    return rows;
+  };
+  int row_nums = 0;
+  auto insert_filler = [&]() {
+    Row row = make_row(row_nums++, 500, 0, 0);
+    EXPECT_TRUE(table_heap->InsertTuple(row, nullptr));
+    return row.GetRowId();
+  };
+  std::vector<RowId> rids;
+  for (int i = 0; i < 20; i++) {
+    rids.push_back(insert_filler());
+  }
+  auto update_and_check = [&](size_t a, size_t b, size_t c) {
+    Row grown = make_row(0, a, b, c);
+    ASSERT_TRUE(table_heap->UpdateTuple(grown, rids[0], nullptr));
+    ASSERT_EQ(rids[0], grown.GetRowId());
+    Row row(rids[0]);
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    ASSERT_EQ(a + b + c, row_length(row));
+    auto rows = scan();
+    ASSERT_EQ(row_nums, rows.size());
+    ASSERT_EQ(a + b + c, rows[rids[0].Get()]);
+    ASSERT_EQ(rows, scan_views());
+  };
+  // Scenario: a row grows past what its full page holds and is moved to a new page.
+  update_and_check(1000, 1000, 0);
+  // Scenario: once that page is full too, the row grows again and moves once more.
+  page_id_t last_page_id = rids.back().GetPageId();
+  while (insert_filler().GetPageId() <= last_page_id + 1) {
+  }
+  update_and_check(1000, 1000, 1000);
+  update_and_check(100, 0, 0);
+  // Scenario: deleting through the original row id also frees the relocated copy.
+  ASSERT_TRUE(table_heap->MarkDelete(rids[0], nullptr));
+  table_heap->ApplyDelete(rids[0], nullptr);
+  Row deleted(rids[0]);
+  ASSERT_FALSE(table_heap->GetTuple(&deleted, nullptr));
+  ASSERT_EQ(row_nums - 1, scan().size());
+
+  delete table_heap;
+  delete bpm;
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(TableHeapTest, OverflowValueTest) {
+  const std::string db_name = "table_heap_overflow_test.db";
+  remove(db_name.c_str());
+  auto disk_mgr = new DiskManager(db_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("text", TypeId::kTypeChar, 100000, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  auto make_text = [](int i, size_t len) { return std::string(len, static_cast<char>('a' + i % 26)); };
+  auto read_text = [](const Row &row) {
+    Field *text = row.GetField(1);
+    return std::string(text->GetData(), text->GetLength());
+  };
+  // Scenario: values much larger than a page are stored out of line and read back whole.
+  const int row_nums = 20;
+  std::vector<RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    std::string text = make_text(i, 20000 + i);
+    Fields fields{Field(TypeId::kTypeInt, i),
+                  Field(TypeId::kTypeChar, const_cast<char *>(text.c_str()), text.size(), true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  for (int i = 0; i < row_nums; i++) {
+    Row row(rids[i]);
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    ASSERT_EQ(make_text(i, 20000 + i), read_text(row));
+  }
+  // Scenario: a scan that does not read the long column never fetches the overflow pages.
+  auto scan_fetches = [&](const std::vector<bool> &columns) {
+    auto before = bpm->GetStats();
+    int count = 0;
+    for (auto it = table_heap->Begin(nullptr, columns); it != table_heap->End(); ++it) {
+      EXPECT_EQ(columns.empty() || columns[1], !it->GetField(1)->IsExternal());
+      count++;
+    }
+    EXPECT_EQ(row_nums, count);
+    auto after = bpm->GetStats();
+    return after.fetch_hits_ + after.fetch_misses_ - before.fetch_hits_ - before.fetch_misses_;
+  };
+  uint64_t narrow_fetches = scan_fetches({true, false});
+  uint64_t full_fetches = scan_fetches({});
+  // one fetch per row plus the two of Begin(), all of them on table pages
+  ASSERT_LE(narrow_fetches, static_cast<uint64_t>(row_nums + 2));
+  ASSERT_GT(full_fetches, static_cast<uint64_t>(row_nums * 5));
+  // Scenario: updates replace the value, deletes release the overflow pages.
+  std::string text = make_text(1, 30000);
+  Fields fields{Field(TypeId::kTypeInt, 0),
+                Field(TypeId::kTypeChar, const_cast<char *>(text.c_str()), text.size(), true)};
+  Row updated(fields);
+  ASSERT_TRUE(table_heap->UpdateTuple(updated, rids[0], nullptr));
+  Row row(rids[0]);
+  ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+  ASSERT_EQ(text, read_text(row));
+  page_id_t overflow_page_id = table_heap->Begin(nullptr, {true, false})->GetField(1)->GetOverflowPageId();
+  ASSERT_FALSE(disk_mgr->IsPageFree(overflow_page_id));
+  ASSERT_TRUE(table_heap->MarkDelete(rids[0], nullptr));
+  table_heap->ApplyDelete(rids[0], nullptr);
+  ASSERT_TRUE(disk_mgr->IsPageFree(overflow_page_id));
+
+  delete table_heap;
+  delete bpm;
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(TableHeapTest, ZoneMapTest) {
+  const std::string db_name = "table_heap_zone_map_test.db";
+  remove(db_name.c_str());
+  auto disk_mgr = new DiskManager(db_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("ts", TypeId::kTypeFloat, 1, true, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  const int row_nums = 2000;
+  std::string name(50, 'n');
+  std::vector<RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i),
+                  i % 100 == 0 ? Field(TypeId::kTypeFloat) : Field(TypeId::kTypeFloat, i * 0.5f),
+                  Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.size(), false)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  auto id_of = [](const RowView &view) {
+    Row row;
+    view.Materialize(&row, {0});
+    return std::stoi(row.GetField(0)->toString());
+  };
+  // Scans with the filter and returns the ids seen, the caller checks them against the full predicate.
+  uint32_t skipped = 0;
+  auto scan = [&](const ZoneMapFilter &filter) {
+    std::vector<int> ids;
+    auto it = table_heap->ViewBegin(nullptr, &filter);
+    for (; !it.IsEnd(); ++it) {
+      ids.push_back(id_of(*it));
+    }
+    skipped = it.GetSkippedPageCount();
+    return ids;
+  };
+  auto count_if = [](const std::vector<int> &ids, int low) {
+    return std::count_if(ids.begin(), ids.end(), [low](int id) { return id >= low; });
+  };
+  // Scenario: a range on an ordered column skips every page before it.
+  ZoneMapFilter tail;
+  tail.AddTerm(0, ZoneMapFilter::Op::kGreaterThanEquals, 1900);
+  auto ids = scan(tail);
+  ASSERT_EQ(100, count_if(ids, 1900));
+  ASSERT_GT(skipped, 10);
+  ASSERT_LT(ids.size(), 300);
+  // Scenario: equality together with is null, only the page holding id 0 may match.
+  ZoneMapFilter null_ts;
+  null_ts.AddTerm(0, ZoneMapFilter::Op::kEqual, 0);
+  null_ts.AddTerm(1, ZoneMapFilter::Op::kIsNull);
+  ids = scan(null_ts);
+  ASSERT_EQ(rids[0].GetPageId(), rids[ids.size() - 1].GetPageId());
+  ZoneMapFilter no_null;
+  no_null.AddTerm(0, ZoneMapFilter::Op::kEqual, 5);
+  no_null.AddTerm(1, ZoneMapFilter::Op::kLessThan, 0);
+  ASSERT_TRUE(scan(no_null).empty());
+  // Scenario: an update widens the zone map of the row's page, the row is still found.
+  Fields fields{Field(TypeId::kTypeInt, 5000), Field(TypeId::kTypeFloat, 1.0f),
+                Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.size(), false)};
+  Row updated(fields);
+  ASSERT_TRUE(table_heap->UpdateTuple(updated, rids[10], nullptr));
+  ZoneMapFilter updated_filter;
+  updated_filter.AddTerm(0, ZoneMapFilter::Op::kGreaterThan, 4000);
+  ASSERT_EQ(1, count_if(scan(updated_filter), 4001));
+  // Scenario: a heap opened on existing pages builds the zone map of a page when a scan first reaches it.
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  delete table_heap;
+  table_heap = TableHeap::Create(bpm, first_page_id, schema.get(), nullptr, nullptr);
+  // the updated row (id 5000) lives on the first page
+  ASSERT_EQ(101, count_if(scan(tail), 1900));
+  ASSERT_GT(skipped, 10);
+
+  delete table_heap;
+  delete bpm;
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(TableHeapTest, PageDirectoryTest) {
+  const std::string db_name = "table_heap_page_directory_test.db";
+  remove(db_name.c_str());
+  auto disk_mgr = new DiskManager(db_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  std::string name(60, 'n');
+  auto insert = [&](int id) {
+    Fields fields{Field(TypeId::kTypeInt, id),
+                  Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.size(), false)};
+    Row row(fields);
+    EXPECT_TRUE(table_heap->InsertTuple(row, nullptr));
+    return row.GetRowId();
+  };
+  // the directory lists the page chain in order
+  auto check_chain = [&]() {
+    page_id_t page_id = table_heap->GetFirstPageId();
+    size_t count = 0;
+    while (page_id != INVALID_PAGE_ID) {
+      ASSERT_EQ(page_id, table_heap->GetPageId(count++));
+      page_id = bpm->FetchPageRead(page_id).As<TablePage>()->GetNextPageId();
+    }
+    ASSERT_EQ(count, table_heap->GetPageCount());
+    ASSERT_EQ(INVALID_PAGE_ID, table_heap->GetPageId(count));
+  };
+  const int row_nums = 3000;
+  std::vector<RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    rids.push_back(insert(i));
+  }
+  // rows are appended at the tail
+  ASSERT_EQ(table_heap->GetPageId(table_heap->GetPageCount() - 1), rids.back().GetPageId());
+  check_chain();
+  // disjoint ranges hand out every row exactly once
+  auto scan_ranges = [&](size_t step) {
+    std::vector<int> ids;
+    for (size_t begin = 0; begin < table_heap->GetPageCount(); begin += step) {
+      for (auto it = table_heap->ViewRange(nullptr, begin, begin + step); !it.IsEnd(); ++it) {
+        Row row;
+        it->Materialize(&row, {0});
+        ids.push_back(std::stoi(row.GetField(0)->toString()));
+      }
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+  };
+  auto ids = scan_ranges(3);
+  ASSERT_EQ(row_nums, ids.size());
+  for (int i = 0; i < row_nums; i++) {
+    ASSERT_EQ(i, ids[i]);
+  }
+  ASSERT_TRUE(table_heap->ViewRange(nullptr, table_heap->GetPageCount(), table_heap->GetPageCount() + 1).IsEnd());
+  // the room left by deletes is reused once the last page is full
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  ASSERT_TRUE(table_heap->MarkDelete(rids[0], nullptr));
+  table_heap->ApplyDelete(rids[0], nullptr);
+  size_t page_count = table_heap->GetPageCount();
+  int next_id = row_nums;
+  while (table_heap->GetPageCount() == page_count) {
+    RowId rid = insert(next_id++);
+    if (rid.GetPageId() == first_page_id) {
+      break;
+    }
+  }
+  ASSERT_EQ(page_count, table_heap->GetPageCount());
+  // a heap opened on existing pages builds its directory on first use and keeps appending at the tail
+  delete table_heap;
+  table_heap = TableHeap::Create(bpm, first_page_id, schema.get(), nullptr, nullptr);
+  check_chain();
+  for (int i = 0; i < 500; i++) {
+    insert(next_id++);
+  }
+  check_chain();
+  ASSERT_EQ(next_id - 1, scan_ranges(2).size());
+  int count = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    count++;
+  }
+  ASSERT_EQ(next_id - 1, count);
+
+  delete table_heap;
+  delete bpm;
+  delete disk_mgr;
+  remove(db_name.c_str());
+}